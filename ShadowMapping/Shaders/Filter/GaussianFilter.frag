@@ -2,19 +2,23 @@ uniform sampler2D image;
 varying vec2 f_texcoord;
 uniform int width;
 uniform int height;
-uniform int order;
+uniform int numberOfTaps;
 uniform int horizontal;
 uniform int vertical;
-uniform float kernel[33];
+uniform float tapOffsets[65];
+uniform float tapWeights[65];
 
+//The first tap is the center texel and each of the others is read at both sides of it. With the linear taps the offsets fall 
+//between two texels, so the bilinear filter reads both with their own weights in a single fetch
 vec4 blur(vec2 step, vec2 center, vec2 dir)
 {
 
-	vec4 sum = vec4(0.0);
-	int kernelCenter = order/2;
+	vec4 sum = texture2D(image, center) * tapWeights[0];
 
-	for(int sample = -kernelCenter; sample <= kernelCenter; sample++)
-		sum += texture2D(image, vec2(center.s + dir.s * sample * step.s, center.t + dir.t * sample * step.t)) * kernel[kernelCenter + sample];
+	for(int tap = 1; tap < numberOfTaps; tap++) {
+		vec2 offset = dir * step * tapOffsets[tap];
+		sum += (texture2D(image, center + offset) + texture2D(image, center - offset)) * tapWeights[tap];
+	}
 
 	return sum;
 	
@@ -28,8 +32,8 @@ void main()
 	step.t = 1.0/float(height);
 	center.s = f_texcoord.s;
 	center.t = f_texcoord.t;
-	dir.s = horizontal;
-	dir.t = vertical;
+	dir.s = float(horizontal);
+	dir.t = float(vertical);
 	gl_FragColor = blur(step, center, dir);
 	
 }
\ No newline at end of file
@@ -5,7 +5,7 @@ uniform int height;
 uniform int order;
 uniform int horizontal;
 uniform int vertical;
-uniform float kernel[25];
+uniform float kernel[129];
 
 float log_conv ( float x0, vec4 X, float y0, vec4 Y )
 {
@@ -29,10 +29,30 @@ vec4 computeFragmentColor()
 
 }
 
+#ifdef PACKED_GBUFFER
+//Octahedral normal encoding (Cigolle et al. 2014), decoded in GBufferDecode.glsl
+vec2 encodeOctahedron(vec3 normal)
+{
+
+	normal /= abs(normal.x) + abs(normal.y) + abs(normal.z);
+	vec2 encoded = normal.xy;
+	if(normal.z < 0.0) encoded = (1.0 - abs(normal.yx)) * vec2((normal.x >= 0.0) ? 1.0 : -1.0, (normal.y >= 0.0) ? 1.0 : -1.0);
+	return encoded * 0.5 + 0.5;
+
+}
+#endif
+
 void main()
 {	
 
+#ifdef PACKED_GBUFFER
+	//positions are reconstructed from the depth attachment, so only normals and albedo are written
+	float flags = 1.0 + 2.0 * float(gl_FrontFacing);
+	gl_FragData[0] = vec4(encodeOctahedron(GBufferNormal.xyz), 0.0, 0.0);
+	gl_FragData[1] = vec4(computeFragmentColor().rgb, flags / 255.0);
+#else
 	gl_FragData[0] = GBufferVertex;
 	gl_FragData[1] = vec4(GBufferNormal.xyz, float(gl_FrontFacing));
 	gl_FragData[2] = computeFragmentColor();
+#endif
 }
\ No newline at end of file
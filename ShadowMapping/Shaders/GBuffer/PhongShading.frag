@@ -1,7 +1,5 @@
 uniform sampler2D hardShadowMap;
-uniform sampler2D colorMap;
-uniform sampler2D vertexMap;
-uniform sampler2D normalMap;
+#include "GBuffer/GBufferDecode.glsl"
 uniform mat4 MV;
 uniform mat3 normalMatrix;
 uniform vec3 lightPosition;
@@ -27,7 +25,7 @@ vec4 phong(vec4 vertex, vec4 normal, float shadow)
     vec4 Iamb = light_ambient;    
 	vec4 Idiff = light_diffuse * max(dot(normal.xyz,L), 0.0);    
     vec4 Ispec = specShadow * light_specular * pow(max(dot(R,E),0.0), 0.3 * shininess);
-	vec4 fragmentColor = texture2D(colorMap, f_texcoord);
+	vec4 fragmentColor = fetchColor(f_texcoord);
    
 	return shadow * fragmentColor * (Idiff + Ispec + Iamb);  
    
@@ -36,10 +34,10 @@ vec4 phong(vec4 vertex, vec4 normal, float shadow)
 void main()
 {	
 
-	vec4 vertex = texture2D(vertexMap, f_texcoord);
+	vec4 vertex = fetchVertex(f_texcoord);
 	if(vertex.x == 0.0) discard; //Discard background scene
 
-	vec4 normal = texture2D(normalMap, f_texcoord);
+	vec4 normal = fetchNormal(f_texcoord);
 	float hardShadowIntensity = texture2D(hardShadowMap, f_texcoord).r;
 	
 	gl_FragColor = phong(vertex, normal, hardShadowIntensity);
@@ -1,10 +1,10 @@
 uniform sampler2D shadowMap;
-uniform sampler2D vertexMap;
-uniform sampler2D normalMap;
+#include "GBuffer/GBufferDecode.glsl"
 varying vec2 f_texcoord;
 uniform mat4 MV;
 uniform mat4 MVP;
 uniform mat4 lightMVP;
+#include "ShadowMap/Cascades.glsl"
 uniform mat3 normalMatrix;
 uniform vec3 lightPosition;
 uniform vec2 shadowMapStep;
@@ -18,70 +18,17 @@ uniform int SMSR;
 uniform int EDTSM;
 uniform int kernelOrder;
 uniform int penumbraSize;
+uniform sampler2D discontinuityMap;
+uniform int useDiscontinuityMap;
 float newDepth;
-
-vec4 computeDiscontinuity(vec4 shadowCoord) 
-{
-
-	vec4 dir = vec4(0.0, 0.0, 0.0, 0.0);
-	//x = left; y = right; z = bottom; w = top
-	
-	shadowCoord.x -= shadowMapStep.x;
-	float distanceFromLight = texture2D(shadowMap, shadowCoord.st).z;
-	dir.x = (shadowCoord.z <= distanceFromLight) ? 1.0 : 0.0; 
-	
-	shadowCoord.x += 2.0 * shadowMapStep.x;
-	distanceFromLight = texture2D(shadowMap, shadowCoord.st).z;
-	dir.y = (shadowCoord.z <= distanceFromLight) ? 1.0 : 0.0; 
-	
-	shadowCoord.x -= shadowMapStep.x;
-	shadowCoord.y += shadowMapStep.y;
-	distanceFromLight = texture2D(shadowMap, shadowCoord.st).z;
-	dir.z = (shadowCoord.z <= distanceFromLight) ? 1.0 : 0.0; 
-	
-	shadowCoord.y -= 2.0 * shadowMapStep.y;
-	distanceFromLight = texture2D(shadowMap, shadowCoord.st).z;
-	dir.w = (shadowCoord.z <= distanceFromLight) ? 1.0 : 0.0; 
-	
-	return abs(dir - 1.0);
-
-}
+#include "RBSM/SilhouetteSearch.glsl"
 
 float computeRelativeDistance(vec4 shadowCoord, vec2 dir, float c)
 {
 
-	vec4 tempShadowCoord = shadowCoord;
-	float foundSilhouetteEnd = 0.0;
-	float distance = 0.0;
-	vec2 step = dir * shadowMapStep;
-	tempShadowCoord.xy += step;
-	
-	for(int it = 0; it < maxSearch; it++) {
-		
-		float distanceFromLight = texture2D(shadowMap, tempShadowCoord.st).z;
-
-		//To solve incorrect shadowing due to depth accuracy, we use a depth threshold/bias
-		if(abs(tempShadowCoord.z - distanceFromLight) < depthThreshold)
-			tempShadowCoord.z -= depthThreshold;
-
-		float center = (tempShadowCoord.z <= distanceFromLight) ? 1.0 : 0.0; 
-		bool isCenterUmbra = !bool(center);
-		
-		if(isCenterUmbra) {
-			foundSilhouetteEnd = 1.0;
-			break;
-		} else {
-			vec4 d = computeDiscontinuity(tempShadowCoord);
-			if((d.r + d.g + d.b + d.a) == 0.0) break;
-		}
-
-		distance++;
-		tempShadowCoord.xy += step;
-		
-	}
-	
-	distance = distance + (1.0 - c);
-	return mix(-distance, distance, foundSilhouetteEnd);
+	vec2 walk = walkSilhouette(shadowCoord, dir);
+	float distance = walk.x + (1.0 - c);
+	return mix(-distance, distance, walk.y);
 
 }
 
@@ -96,6 +43,25 @@ vec4 computeRelativeDistance(vec4 shadowCoord, vec2 c)
 
 }
 
+//Discontinuity and silhouette walks of the shadow map texel, precomputed by the DiscontinuityMap pre-pass
+vec4 fetchDiscontinuity(vec4 shadowCoord, out vec4 walks)
+{
+
+	vec4 texel = floor(texture2D(discontinuityMap, shadowCoord.st) * 65535.0 + 0.5);
+	walks = mod(texel, 512.0);
+	vec4 d = floor(texel / 512.0);
+	return d.xywz;
+
+}
+
+vec4 readRelativeDistance(vec4 walks, vec4 c)
+{
+
+	vec4 distance = mod(walks, 256.0) + (1.0 - c);
+	return mix(-distance, distance, floor(walks / 256.0));
+
+}
+
 float normalizeRelativeDistance(vec2 dist) {
 
 	float T = 1;
@@ -132,12 +98,17 @@ float computeShadowFromSMSR(vec4 shadowCoord)
 	float shadow = (shadowCoord.z <= distanceFromLight) ? 1.0 : 0.0; 
 	if(shadow == 0.0) return shadowIntensity;
 	
-	vec4 d = computeDiscontinuity(shadowCoord);
+	vec4 walks;
+	vec4 d;
+	if(useDiscontinuityMap == 1) d = fetchDiscontinuity(shadowCoord, walks);
+	else d = computeDiscontinuity(shadowCoord);
 	if((d.r + d.g + d.b + d.a) == 0.0) return 1.0;
 	else if((d.r + d.g) == 2.0 || (d.b + d.a) == 2.0) return shadowIntensity;
 
 	vec2 c = fract(vec2(shadowCoord.x * float(shadowMapWidth), shadowCoord.y * float(shadowMapHeight)));
-	vec4 dist = computeRelativeDistance(shadowCoord, c);
+	vec4 dist;
+	if(useDiscontinuityMap == 1) dist = readRelativeDistance(walks, vec4(1.0 - c.x, c.x, 1.0 - c.y, c.y));
+	else dist = computeRelativeDistance(shadowCoord, c);
 	vec2 r = normalizeRelativeDistance(dist);
 	return revectorizeShadow(r);
 
@@ -165,7 +136,10 @@ float computeShadowFromRPCF(vec4 normalizedLightCoord)
 			if(shadow == 1.0) {
 				
 				vec4 sampleLightCoord = vec4(normalizedLightCoord.x + w * incrWidth, normalizedLightCoord.y + h * incrHeight, normalizedLightCoord.zw);
-				vec4 d = computeDiscontinuity(sampleLightCoord);
+				vec4 walks;
+				vec4 d;
+				if(useDiscontinuityMap == 1) d = fetchDiscontinuity(sampleLightCoord, walks);
+				else d = computeDiscontinuity(sampleLightCoord);
 				
 				if(d.r == 0.0 && d.g == 0.0) {
 						
@@ -174,7 +148,9 @@ float computeShadowFromRPCF(vec4 normalizedLightCoord)
 				} else {
 
 					vec2 subCoord = fract(vec2(sampleLightCoord.x * float(shadowMapWidth), sampleLightCoord.y * float(shadowMapHeight)));
-					vec4 discontinuitySpace = computeRelativeDistance(sampleLightCoord, subCoord);
+					vec4 discontinuitySpace;
+					if(useDiscontinuityMap == 1) discontinuitySpace = readRelativeDistance(walks, vec4(1.0 - subCoord.x, subCoord.x, 1.0 - subCoord.y, subCoord.y));
+					else discontinuitySpace = computeRelativeDistance(sampleLightCoord, subCoord);
 					vec2 r = normalizeRelativeDistance(discontinuitySpace);
 					illuminationCount += revectorizeShadow(r);
 
@@ -215,11 +191,11 @@ float computePreEvaluationBasedOnNormalOrientation(vec4 vertex, vec4 normal)
 void main()
 {	
 
-	vec4 vertex = texture2D(vertexMap, f_texcoord);	
+	vec4 vertex = fetchVertex(f_texcoord);	
 	if(vertex.x == 0.0) discard; //Discard background scene
 
-	vec4 normal = texture2D(normalMap, f_texcoord);
-	vec4 shadowCoord = lightMVP * vertex;
+	vec4 normal = fetchNormal(f_texcoord);
+	vec4 shadowCoord = computeShadowCoord(vertex);
 	vec4 normalizedLightCoord = shadowCoord / shadowCoord.w;
 	float shadow = computePreEvaluationBasedOnNormalOrientation(vertex, normal);
 	float preEvaluatedShadow = shadow;
@@ -0,0 +1,33 @@
+uniform sampler2D shadowMap;
+varying vec2 f_texcoord;
+uniform vec2 shadowMapStep;
+uniform float depthThreshold;
+uniform int maxSearch;
+#include "RBSM/SilhouetteSearch.glsl"
+
+//Light-space pre-pass of ConservativeSMSR.frag. A receiver lit by a shadow map texel lies at the depth of that texel, so its
+//discontinuity and its silhouette walks only depend on the texel and are evaluated once here instead of once per camera
+//pixel. Each channel is one direction (left, right, down and up) and holds an integer in the 16-bit normalized texel: the
+//length of the walk, plus 256 when the walk ends in the umbra, plus 512 when the neighbour in that direction is in shadow.
+//The lengths take 8 bits, so the map is only built for maxSearch up to 255 (MAX_DISCONTINUITY_MAP_SEARCH)
+void main()
+{
+
+	float depth = texture2D(shadowMap, f_texcoord).z;
+	vec4 shadowCoord = vec4(f_texcoord, depth, 1.0);
+	vec4 d = computeDiscontinuity(shadowCoord);
+	vec4 walks = vec4(0.0);
+
+	//the camera pass only walks from texels next to the umbra
+	if((d.r + d.g + d.b + d.a) > 0.0) {
+		vec2 left = walkSilhouette(shadowCoord, vec2(-1, 0));
+		vec2 right = walkSilhouette(shadowCoord, vec2(1, 0));
+		vec2 down = walkSilhouette(shadowCoord, vec2(0, -1));
+		vec2 up = walkSilhouette(shadowCoord, vec2(0, 1));
+		walks = vec4(left.x, right.x, down.x, up.x) + 256.0 * vec4(left.y, right.y, down.y, up.y);
+	}
+
+	//bottom is the neighbour at +y, which the up walk starts from
+	gl_FragColor = (walks + 512.0 * d.xywz)/65535.0;
+
+}
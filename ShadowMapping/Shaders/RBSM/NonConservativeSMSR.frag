@@ -1,10 +1,10 @@
 uniform sampler2D shadowMap;
-uniform sampler2D vertexMap;
-uniform sampler2D normalMap;
+#include "GBuffer/GBufferDecode.glsl"
 varying vec2 f_texcoord;
 uniform mat4 MV;
 uniform mat4 MVP;
 uniform mat4 lightMVP;
+#include "ShadowMap/Cascades.glsl"
 uniform mat3 normalMatrix;
 uniform vec3 lightPosition;
 uniform vec2 shadowMapStep;
@@ -367,11 +367,11 @@ float computePreEvaluationBasedOnNormalOrientation(vec4 vertex, vec4 normal)
 void main()
 {	
 
-	vec4 vertex = texture2D(vertexMap, f_texcoord);	
+	vec4 vertex = fetchVertex(f_texcoord);	
 	if(vertex.x == 0.0) discard; //Discard background scene
 
-	vec4 normal = texture2D(normalMap, f_texcoord);
-	vec4 shadowCoord = lightMVP * vertex;
+	vec4 normal = fetchNormal(f_texcoord);
+	vec4 shadowCoord = computeShadowCoord(vertex);
 	vec4 normalizedLightCoord = shadowCoord / shadowCoord.w;
 	float shadow = computePreEvaluationBasedOnNormalOrientation(vertex, normal);
 	float preEvaluatedShadow = shadow;
@@ -0,0 +1,67 @@
+//Silhouette search of the conservative revectorization, shared by ConservativeSMSR.frag and the DiscontinuityMap pre-pass.
+//Expects shadowMap, shadowMapStep, depthThreshold and maxSearch to be declared by the including shader
+
+vec4 computeDiscontinuity(vec4 shadowCoord)
+{
+
+	vec4 dir = vec4(0.0, 0.0, 0.0, 0.0);
+	//x = left; y = right; z = bottom; w = top
+
+	shadowCoord.x -= shadowMapStep.x;
+	float distanceFromLight = texture2D(shadowMap, shadowCoord.st).z;
+	dir.x = (shadowCoord.z <= distanceFromLight) ? 1.0 : 0.0;
+
+	shadowCoord.x += 2.0 * shadowMapStep.x;
+	distanceFromLight = texture2D(shadowMap, shadowCoord.st).z;
+	dir.y = (shadowCoord.z <= distanceFromLight) ? 1.0 : 0.0;
+
+	shadowCoord.x -= shadowMapStep.x;
+	shadowCoord.y += shadowMapStep.y;
+	distanceFromLight = texture2D(shadowMap, shadowCoord.st).z;
+	dir.z = (shadowCoord.z <= distanceFromLight) ? 1.0 : 0.0;
+
+	shadowCoord.y -= 2.0 * shadowMapStep.y;
+	distanceFromLight = texture2D(shadowMap, shadowCoord.st).z;
+	dir.w = (shadowCoord.z <= distanceFromLight) ? 1.0 : 0.0;
+
+	return abs(dir - 1.0);
+
+}
+
+//Number of lit texels walked along dir (x) and whether the walk ended in the umbra (y)
+vec2 walkSilhouette(vec4 shadowCoord, vec2 dir)
+{
+
+	vec4 tempShadowCoord = shadowCoord;
+	float foundSilhouetteEnd = 0.0;
+	float distance = 0.0;
+	vec2 step = dir * shadowMapStep;
+	tempShadowCoord.xy += step;
+
+	for(int it = 0; it < maxSearch; it++) {
+
+		float distanceFromLight = texture2D(shadowMap, tempShadowCoord.st).z;
+
+		//To solve incorrect shadowing due to depth accuracy, we use a depth threshold/bias
+		if(abs(tempShadowCoord.z - distanceFromLight) < depthThreshold)
+			tempShadowCoord.z -= depthThreshold;
+
+		float center = (tempShadowCoord.z <= distanceFromLight) ? 1.0 : 0.0;
+		bool isCenterUmbra = !bool(center);
+
+		if(isCenterUmbra) {
+			foundSilhouetteEnd = 1.0;
+			break;
+		} else {
+			vec4 d = computeDiscontinuity(tempShadowCoord);
+			if((d.r + d.g + d.b + d.a) == 0.0) break;
+		}
+
+		distance++;
+		tempShadowCoord.xy += step;
+
+	}
+
+	return vec2(distance, foundSilhouetteEnd);
+
+}
@@ -1,6 +1,7 @@
+#extension GL_ARB_gpu_shader5 : enable
 uniform sampler2D shadowMap;
-uniform sampler2D vertexMap;
-uniform sampler2D normalMap;
+uniform sampler2DShadow shadowMapCompare;
+#include "GBuffer/GBufferDecode.glsl"
 uniform mat4 MV;
 uniform mat4 lightMV;
 uniform mat4 lightP;
@@ -16,6 +17,8 @@ uniform int shadowMapWidth;
 uniform int shadowMapHeight;
 uniform int bilinearPCF;
 uniform int tricubicPCF;
+uniform int gatherPCF;
+uniform int optimizedPCF;
 uniform int VSM;
 uniform int ESM;
 uniform int EVSM;
@@ -25,8 +28,10 @@ uniform int zNear;
 uniform int zFar;
 uniform int kernelOrder;
 uniform int penumbraSize;
+uniform float pcfWeights[31]; //MAX_PCF_ORDER
 uniform mat4 MVP;
 uniform mat4 lightMVP;
+#include "ShadowMap/Cascades.glsl"
 varying vec2 f_texcoord;
 
 float linearize(float depth) {
@@ -115,6 +120,69 @@ float PCF(vec3 normalizedShadowCoord)
 
 }
 
+float kernelWeight(int texel)
+{
+
+	return (texel >= 0 && texel < kernelOrder) ? pcfWeights[texel] : 0.0;
+
+}
+
+//Separable PCF over the kernelOrder x kernelOrder texels around the nearest one. Each textureGather returns the depth
+//comparisons of a 2x2 block, so ((kernelOrder + 1)/2)^2 fetches cover the kernel, whose last row and column weigh zero
+float PCFGather(vec3 normalizedShadowCoord)
+{
+
+	vec2 texSize = vec2(shadowMapWidth, shadowMapHeight);
+	vec2 center = floor(normalizedShadowCoord.st * texSize);
+	float radius = float(kernelOrder/2);
+	float illumination = 0.0;
+
+	for(int y = 0; y < kernelOrder; y += 2) {
+		float wy0 = kernelWeight(y);
+		float wy1 = kernelWeight(y + 1);
+		for(int x = 0; x < kernelOrder; x += 2) {
+			float wx0 = kernelWeight(x);
+			float wx1 = kernelWeight(x + 1);
+			//the corner shared by the four texels of the block
+			vec2 blockCoord = (center + vec2(x, y) - radius + 1.0)/texSize;
+			vec4 lit = textureGather(shadowMapCompare, blockCoord, normalizedShadowCoord.z);
+			illumination += dot(lit, vec4(wx0 * wy1, wx1 * wy1, wx1 * wy0, wx0 * wy0));
+		}
+	}
+
+	return mix(shadowIntensity, 1.0, illumination);
+
+}
+
+//Optimized PCF: the kernel is centered on the lookup position and interpolated between the texels around it, so it spans
+//kernelOrder + 1 texels per axis. Each pair of texels is read by one bilinear depth comparison placed between them in the
+//proportion of their weights, which takes ((kernelOrder + 1)/2)^2 fetches and varies smoothly with the sub-texel position
+float PCFOptimized(vec3 normalizedShadowCoord)
+{
+
+	vec2 texSize = vec2(shadowMapWidth, shadowMapHeight);
+	vec2 position = normalizedShadowCoord.st * texSize - 0.5;
+	vec2 base = floor(position);
+	vec2 fraction = position - base;
+	float radius = float(kernelOrder/2);
+	float illumination = 0.0;
+
+	for(int y = 0; y < kernelOrder; y += 2) {
+		float wy0 = mix(kernelWeight(y), kernelWeight(y - 1), fraction.y);
+		float wy1 = mix(kernelWeight(y + 1), kernelWeight(y), fraction.y);
+		for(int x = 0; x < kernelOrder; x += 2) {
+			float wx0 = mix(kernelWeight(x), kernelWeight(x - 1), fraction.x);
+			float wx1 = mix(kernelWeight(x + 1), kernelWeight(x), fraction.x);
+			vec2 tapPosition = base + vec2(x, y) - radius + vec2(wx1/(wx0 + wx1), wy1/(wy0 + wy1));
+			float lit = texture(shadowMapCompare, vec3((tapPosition + 0.5)/texSize, normalizedShadowCoord.z));
+			illumination += (wx0 + wx1) * (wy0 + wy1) * lit;
+		}
+	}
+
+	return mix(shadowIntensity, 1.0, illumination);
+
+}
+
 float chebyshevUpperBound(vec2 moments, float distanceToLight)
 {
 	
@@ -240,15 +308,16 @@ float computePreEvaluationBasedOnNormalOrientation(vec4 vertex, vec4 normal)
 void main()
 {	
 
-	vec4 vertex = texture2D(vertexMap, f_texcoord);	
+	vec4 vertex = fetchVertex(f_texcoord);	
 	if(vertex.x == 0.0) discard; //Discard background scene
 
-	vec4 normal = texture2D(normalMap, f_texcoord);
-	vec4 shadowCoord = lightMVP * vertex;
+	vec4 normal = fetchNormal(f_texcoord);
+	vec4 shadowCoord = computeShadowCoord(vertex);
 	vec4 normalizedShadowCoord = shadowCoord / shadowCoord.w;
 	float shadow = computePreEvaluationBasedOnNormalOrientation(vertex, normal);
+	bool shadowTested = (shadowCoord.w > 0.0 && shadow == 1.0);
 	
-	if(shadowCoord.w > 0.0 && shadow == 1.0) {
+	if(shadowTested) {
 
 		if(naive == 1) {
 			float distanceFromLight = texture2D(shadowMap, vec2(normalizedShadowCoord.st)).z;		
@@ -262,12 +331,18 @@ void main()
 			shadow = exponentialVarianceShadowMapping(normalizedShadowCoord.xyz);
 		else if(MSM == 1)
 			shadow = hamburger4MSM(normalizedShadowCoord.xyz);
+		else if(gatherPCF == 1)
+			shadow = PCFGather(normalizedShadowCoord.xyz);
+		else if(optimizedPCF == 1)
+			shadow = PCFOptimized(normalizedShadowCoord.xyz);
 		else
 			shadow = PCF(normalizedShadowCoord.xyz);
 
 	}
 	
 	//shadow = linearize(texture2D(shadowMap, vec2(gl_FragCoord.x/1024.0, gl_FragCoord.y/1024.0)).z);
-	gl_FragColor = vec4(shadow, 0.0, 0.0, 1.0);
+	gl_FragData[0] = vec4(shadow, 0.0, 0.0, 1.0);
+	//the lookup position, for the CPU reference of the PCF benchmark
+	gl_FragData[1] = vec4(normalizedShadowCoord.xyz, float(shadowTested));
 	
 }
\ No newline at end of file
@@ -0,0 +1,40 @@
+#include "GBuffer/GBufferDecode.glsl"
+uniform mat4 cameraMV;
+uniform mat4 lightMVP;
+uniform vec3 cascadeSplits;
+uniform vec2 gBufferSize;
+varying vec2 f_texcoord;
+
+//Reduces each 16x16 tile of the G-buffer to the light clip space bounds (min x, min y, max x, max y) of the receivers
+//of each cascade, one render target per cascade. Cascades without receivers in the tile keep an empty box
+void main()
+{
+
+	vec2 tileOrigin = floor(f_texcoord * gBufferSize / 16.0) * 16.0;
+	vec4 bounds[4];
+	for(int cascade = 0; cascade < 4; cascade++)
+		bounds[cascade] = vec4(1.0e30, 1.0e30, -1.0e30, -1.0e30);
+
+	for(int y = 0; y < 16; y++) {
+		for(int x = 0; x < 16; x++) {
+
+			vec4 vertex = fetchVertex((tileOrigin + vec2(x, y) + 0.5)/gBufferSize);
+			if(vertex.x == 0.0) continue; //Background scene
+
+			vec4 lightCoord = lightMVP * vertex;
+			if(lightCoord.w <= 0.0) continue;
+			vec2 normalizedLightCoord = lightCoord.xy / lightCoord.w;
+
+			float depth = -(cameraMV * vertex).z;
+			int cascade = int(dot(vec3(greaterThan(vec3(depth), cascadeSplits)), vec3(1.0)));
+			bounds[cascade] = vec4(min(bounds[cascade].xy, normalizedLightCoord), max(bounds[cascade].zw, normalizedLightCoord));
+
+		}
+	}
+
+	gl_FragData[0] = bounds[0];
+	gl_FragData[1] = bounds[1];
+	gl_FragData[2] = bounds[2];
+	gl_FragData[3] = bounds[3];
+
+}
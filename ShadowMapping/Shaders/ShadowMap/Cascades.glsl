@@ -0,0 +1,17 @@
+//Shadow map lookup shared by the shaders that sample the light-space maps. With cascadedShadowMaps the shadow map is a 2x2
+//atlas whose quadrants cover consecutive ranges of camera depth, each one with its own cropped light projection.
+//Expects MV and lightMVP to be declared by the including shader
+uniform mat4 cascadeMVP[4];
+uniform vec3 cascadeSplits;
+uniform int cascadedShadowMaps;
+
+vec4 computeShadowCoord(vec4 vertex)
+{
+
+	if(cascadedShadowMaps == 0) return lightMVP * vertex;
+
+	float depth = -(MV * vertex).z;
+	int cascade = int(dot(vec3(greaterThan(vec3(depth), cascadeSplits)), vec3(1.0)));
+	return cascadeMVP[cascade] * vertex;
+
+}
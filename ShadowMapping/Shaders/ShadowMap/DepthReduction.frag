@@ -0,0 +1,30 @@
+#include "GBuffer/GBufferDecode.glsl"
+uniform mat4 cameraMV;
+uniform vec2 gBufferSize;
+varying vec2 f_texcoord;
+
+//Reduces each 16x16 tile of the G-buffer to the range of camera depths of its receivers (min in red, max in green).
+//Alpha marks the tiles with receivers
+void main()
+{
+
+	vec2 tileOrigin = floor(f_texcoord * gBufferSize / 16.0) * 16.0;
+	vec4 range = vec4(1.0e30, 0.0, 0.0, 0.0);
+
+	for(int y = 0; y < 16; y++) {
+		for(int x = 0; x < 16; x++) {
+
+			vec4 vertex = fetchVertex((tileOrigin + vec2(x, y) + 0.5)/gBufferSize);
+			if(vertex.x == 0.0) continue; //Background scene
+
+			float depth = -(cameraMV * vertex).z;
+			range.x = min(range.x, depth);
+			range.y = max(range.y, depth);
+			range.w = 1.0;
+
+		}
+	}
+
+	gl_FragColor = range;
+
+}
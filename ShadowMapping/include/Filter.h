@@ -4,6 +4,27 @@
 #include <malloc.h>
 #include <math.h>
 #include <stdio.h>
+#include <string.h>
+#include <xmmintrin.h>
+
+#define MAX_CACHED_KERNELS 16
+#define MAX_FILTER_TAPS 65
+#define MAX_FILTER_ORDER (2 * (MAX_FILTER_TAPS - 1) + 1)
+
+//Symmetric 1D kernel. The taps hold one side of it: tap 0 is the center texel and each of the others is read at +offset and -offset.
+//The linear taps merge pairs of neighbouring texels into a single bilinear fetch placed between them
+typedef struct FilterKernel
+{
+	int order;
+	float sigma; //0 for the binomial kernel
+	float kernel[MAX_FILTER_ORDER];
+	float tapOffsets[MAX_FILTER_TAPS];
+	float tapWeights[MAX_FILTER_TAPS];
+	float linearTapOffsets[MAX_FILTER_TAPS];
+	float linearTapWeights[MAX_FILTER_TAPS];
+	int numberOfTaps;
+	int numberOfLinearTaps;
+} FilterKernel;
 
 class Filter
 {
@@ -11,27 +32,42 @@ class Filter
 public:
 	Filter();
 	~Filter();
-	
-	void buildGaussianKernel(int order);
+
+	void buildGaussianKernel(int order, float sigma = 0);
 	void buildBilateralKernel(int order);
+	void filterImage(float *source, float *destination, int width, int height, bool horizontal, bool linearSampling);
+	void filterLogImage(float *source, float *destination, int width, int height, bool horizontal);
+	float percentageCloserFilter(float *depthMap, int width, int height, float s, float t, float depth, bool subTexel);
 
 	int getOrder() { return order; }
 	float* getKernel() { return kernel; }
+	int getNumberOfTaps(bool linearSampling) { return (linearSampling) ? currentKernel->numberOfLinearTaps : currentKernel->numberOfTaps; }
+	float* getTapOffsets(bool linearSampling) { return (linearSampling) ? currentKernel->linearTapOffsets : currentKernel->tapOffsets; }
+	float* getTapWeights(bool linearSampling) { return (linearSampling) ? currentKernel->linearTapWeights : currentKernel->tapWeights; }
 	float getSigmaSpace() { return sigmaSpace; }
 	float getSigmaColor() { return sigmaColor; }
 	int getIterations() { return iterations; }
+	float getWeight(int texel) { return (texel >= 0 && texel < order) ? kernel[texel] : 0.0f; }
 
 	void setSigmaSpace(float sigmaSpace) { this->sigmaSpace = sigmaSpace; }
 	void setSigmaColor(float sigmaColor) { this->sigmaColor = sigmaColor; }
 	void setIterations(int iterations) { this->iterations = iterations; }
 
 private:
+	void computeTaps(FilterKernel *filterKernel);
+	__m128 sampleLinear(float *image, int width, int height, int x, int y, float offset, bool horizontal);
+
 	int order;
 	float *kernel;
+	float *bilateralKernel;
+	FilterKernel *currentKernel;
+	FilterKernel cachedKernels[MAX_CACHED_KERNELS];
+	int numberOfCachedKernels;
+	int nextCachedKernel;
 	float sigmaSpace;
 	float sigmaColor;
 	int iterations;
 
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -5,19 +5,22 @@
 #include <sstream>
 #include <iostream>
 #include "Mesh.h"
+#include "IO\TextureLoader.h"
 
 class SceneLoader
 {
 
 public:
-	SceneLoader(char *filename, Mesh *mesh);
+	SceneLoader(char *filename, Mesh *mesh, bool compressTextures = false);
 	void load();
 	float* getCameraPosition() { return cameraPosition; }
 	float* getCameraAt() { return cameraAt; }
 	float* getLightPosition() { return lightPosition; }
 	float* getLightAt() { return lightAt; }
 	float getDepthThreshold() { return depthThreshold; }
+	int getNumberOfCachedTextures() { return numberOfCachedTextures; }
 private:
+	void prefetchTextures(TextureLoader *textureLoader);
 	Mesh *mesh;
 	std::fstream file;
 	float cameraPosition[3];
@@ -25,6 +28,8 @@ private:
 	float lightPosition[3];
 	float lightAt[3];
 	float depthThreshold;
+	bool compressTextures;
+	int numberOfCachedTextures;
 };
 
 #endif
\ No newline at end of file
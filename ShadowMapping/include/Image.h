@@ -2,23 +2,56 @@
 #define IMAGE_H
 
 #include <malloc.h>
+#include <string.h>
+#include <stdio.h>
+#include <limits.h>
+#include <sys/stat.h>
+#include <direct.h>
 #include <fstream>
 #include <opencv2\opencv.hpp>
 
+#define MAX_MIPMAP_LEVELS 16
+#define BC1_BLOCK_SIZE 8
+#define IMAGE_CACHE_VERSION 1
+#define IMAGE_CACHE_DIRECTORY "TextureCache"
+
 class Image
 {
 public:
 	Image(int width, int height, int channels);
 	Image(char *filename);
+	Image(Image *image);
 	~Image();
-	
+
+	void generateMipmaps();
+	void compress();
+	void saveCache(char *filename);
+	static Image* loadCache(char *filename, bool compressed);
+
 	unsigned char* getData() { return data; }
 	int getWidth() { return width; }
 	int getHeight() { return height; }
-	
+
+	unsigned char* getMipmaps() { return mipmaps; }
+	unsigned char* getLevel(int level) { return mipmaps + levelOffset[level]; }
+	int getLevelWidth(int level) { return (width >> level) > 0 ? (width >> level) : 1; }
+	int getLevelHeight(int level) { return (height >> level) > 0 ? (height >> level) : 1; }
+	int getLevelSize(int level) { return levelOffset[level + 1] - levelOffset[level]; }
+	int getMipmapsSize() { return levelOffset[numberOfLevels]; }
+	int getNumberOfLevels() { return numberOfLevels; }
+	bool isCompressed() { return compressed; }
+
 private:
+	Image();
+	int computeLevelSize(int level, bool compressed);
+	void compressBlock(unsigned char *source, int sourceWidth, int sourceHeight, int x, int y, unsigned char *block);
+
 	unsigned char *data;
+	unsigned char *mipmaps;
+	int levelOffset[MAX_MIPMAP_LEVELS + 1];
+	int numberOfLevels;
 	int width;
 	int height;
+	bool compressed;
 };
 #endif
\ No newline at end of file
@@ -25,6 +25,7 @@ public:
 	void computeCentroid(float *centroid);
 	void loadOBJFile(char *filename);
 	void loadTexture(char *filename, int ID);
+	void loadTexture(Image *image, int ID);
 	void loadColorFromOBJFile(char *filename);
 	void translate(float x, float y, float z);
 	void scale(float x, float y, float z);
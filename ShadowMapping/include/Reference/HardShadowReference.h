@@ -0,0 +1,79 @@
+#ifndef HARDSHADOWREFERENCE_H
+#define HARDSHADOWREFERENCE_H
+
+#include <malloc.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <xmmintrin.h>
+#include <GL/glew.h>
+#include "Viewers/ShadowParams.h"
+#include "Viewers/MomentQuantization.h"
+#include "Filter.h"
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_inverse.hpp"
+
+//Four camera pixels in structure-of-arrays layout, one SSE lane each
+typedef struct PixelQuad
+{
+	__m128 x;
+	__m128 y;
+	__m128 z;
+	__m128 w;
+} PixelQuad;
+
+//CPU evaluation of the hard shadow techniques of Shadow.frag. It reads the maps the GL path renders: the G-buffer vertex and
+//normal maps and either the depth map (naive and PCF) or the filtered moment map (VSM, ESM, EVSM and MSM), and writes the red
+//channel of the hard shadow map. Four neighbouring pixels of a row are evaluated per SSE vector and the rows are spread over
+//the OpenMP threads. The shadow map lookups are scalar, like the GL_NEAREST depth fetches and the bilinear moment fetches of
+//the shaders, and the rest of each technique runs in the vector lanes
+class HardShadowReference
+{
+
+public:
+	HardShadowReference();
+
+	void computeHardShadows(ShadowParams shadowParams, float *shadows);
+
+	void setGBuffer(float *vertexMap, float *normalMap, int width, int height);
+	void setShadowMap(float *shadowMap, int width, int height, int numberOfChannels);
+	void setCamera(glm::mat4 MV, glm::mat3 normalMatrix, glm::vec3 lightPosition, float zNear, float zFar);
+	void setFilter(Filter *filter) { this->filter = filter; }
+
+protected:
+	void loadPixels(float *image, int x, int y, int numberOfPixels, PixelQuad *pixels);
+	__m128 computePreEvaluation(PixelQuad *vertex, PixelQuad *normal, float shadowIntensity);
+	void computeShadowCoords(PixelQuad *vertex, ShadowParams *shadowParams, PixelQuad *shadowCoord);
+	__m128 linearize(__m128 depth);
+	float fetchNearest(float s, float t);
+	void fetchBilinear(float s, float t, float *texel);
+	float textureBicubic(float s, float t);
+	void fetchMoments(PixelQuad *normalizedShadowCoord, int numberOfPixels, PixelQuad *moments);
+	__m128 naive(PixelQuad *normalizedShadowCoord, ShadowParams *shadowParams, int numberOfPixels);
+	__m128 PCF(PixelQuad *normalizedShadowCoord, ShadowParams *shadowParams, int numberOfPixels);
+	__m128 separablePCF(PixelQuad *normalizedShadowCoord, ShadowParams *shadowParams, int numberOfPixels);
+	__m128 chebyshevUpperBound(__m128 mean, __m128 meanSquare, __m128 distanceToLight, float shadowIntensity);
+	__m128 varianceShadowMapping(PixelQuad *normalizedShadowCoord, ShadowParams *shadowParams, int numberOfPixels);
+	__m128 exponentialShadowMapping(PixelQuad *normalizedShadowCoord, ShadowParams *shadowParams, int numberOfPixels);
+	__m128 exponentialVarianceShadowMapping(PixelQuad *normalizedShadowCoord, ShadowParams *shadowParams, int numberOfPixels);
+	__m128 hamburger4MSM(PixelQuad *normalizedShadowCoord, ShadowParams *shadowParams, int numberOfPixels);
+
+	float *vertexMap;
+	float *normalMap;
+	float *shadowMap;
+	int width;
+	int height;
+	int shadowMapWidth;
+	int shadowMapHeight;
+	int numberOfChannels;
+	glm::mat4 MV;
+	glm::mat3 normalMatrix;
+	glm::vec3 lightPosition;
+	glm::mat4 mQuantizationInverse;
+	float zNear;
+	float zFar;
+	Filter *filter;
+
+};
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef REVECTORIZATIONREFERENCE_H
+#define REVECTORIZATIONREFERENCE_H
+
+#include <omp.h>
+#include "Reference/HardShadowReference.h"
+
+#define MAX_BATCH_SAMPLES (1 << 20)
+
+//Shadow map lookups of one batch of rows in structure-of-arrays layout. A pixel has one sample for SMSR and EDTSM and one per
+//kernel tap for the revectorization-based PCF
+typedef struct RevectorizationBatch
+{
+	float *s;
+	float *t;
+	float *z;
+	unsigned char *lit; //depth test of the sample
+	unsigned char *neighbours; //depth tests of the left, right, bottom and top texels, one bit each
+	int *search; //index in the search list, -1 when the sample is not revectorized
+	int *searchList; //samples on a shadow silhouette, in sample order
+	float *searchDistances; //left, right, down and up relative distances of each search
+	float *pixelShadow; //pre-evaluated shadow, 0 for the background
+	unsigned char *pixelTested;
+	int *rowSearches;
+} RevectorizationBatch;
+
+//CPU evaluation of the revectorization-based shadow mapping of the RBSM shaders: the conservative and the non-conservative SMSR,
+//the revectorization-based PCF of both and the revectorization-based filtering. It reads the G-buffer and the depth map of
+//HardShadowReference and writes the red channel of the hard shadow map. Each batch of rows runs in three stages, timed apart:
+//the discontinuity detection of every sample, the edge walks of the samples on a silhouette, which are gathered in a compact
+//list so the threads share them evenly, and the revectorization of the samples into the pixel shadows. With useDiscontinuityMap,
+//the conservative modes read the discontinuities and the walks of DiscontinuityMap.frag, evaluated once per texel beforehand
+class RevectorizationReference : public HardShadowReference
+{
+
+public:
+	RevectorizationReference();
+	~RevectorizationReference();
+
+	void computeRevectorizedShadows(ShadowParams shadowParams, float *shadows);
+
+	double getDiscontinuityTime() { return discontinuityTime; }
+	double getSearchTime() { return searchTime; }
+	double getRevectorizationTime() { return revectorizationTime; }
+	int getNumberOfSamples() { return numberOfSamples; }
+	int getNumberOfSearches() { return numberOfSearches; }
+	int getNumberOfPixels() { return numberOfPixels; }
+	int getNumberOfFetches() { return fetches; }
+	double getDiscontinuityMapTime() { return discontinuityMapTime; }
+	int getDiscontinuityMapFetches() { return discontinuityMapFetches; }
+	unsigned short *getDiscontinuityMap() { return discontinuityMap; }
+
+private:
+	void allocateBatch(RevectorizationBatch *batch, int numberOfPixels, int numberOfSamples);
+	void freeBatch(RevectorizationBatch *batch);
+	void detectDiscontinuities(RevectorizationBatch *batch, ShadowParams *shadowParams, int firstRow, int numberOfRows);
+	int gatherSearches(RevectorizationBatch *batch, int numberOfRows);
+	void searchDiscontinuities(RevectorizationBatch *batch, int searches);
+	int revectorizeShadows(RevectorizationBatch *batch, int firstRow, int numberOfRows, float *shadows);
+	float testDepth(float s, float t, float z, int *fetches);
+	unsigned char testNeighbours(float s, float t, float z, int *fetches);
+	bool needsSearch(unsigned char lit, unsigned char neighbours);
+	void computeDiscontinuity(unsigned char lit, unsigned char neighbours, float *discontinuity);
+	bool hasDiscontinuity(float s, float t, float z, float discType, int *fetches);
+	bool continuesDiscontinuity(float s, float t, float z, int dirX, int dirY, float *discontinuity, float *newDepth, int *fetches);
+	float computeDiscontinuityLength(float s, float t, float z, float *discontinuity, int dirX, int dirY, float subCoord, int *fetches);
+	float walkSilhouette(float s, float t, float z, int dirX, int dirY, bool *foundSilhouetteEnd, int *fetches);
+	float computeRelativeDistance(float s, float t, float z, int dirX, int dirY, float subCoord, int *fetches);
+	unsigned short *lookupDiscontinuityMap(float s, float t);
+	unsigned char readNeighbours(unsigned short *texel, int *fetches);
+	void computeDiscontinuityMap();
+	float estimateRelativePosition(float x, float y, float shadow);
+	float revectorizeShadow(float *r, float shadow);
+	float computeShadow(RevectorizationBatch *batch, int sample);
+
+	bool conservative;
+	bool filtered;
+	bool kernel;
+	float shadowMapStep[2];
+	float depthThreshold;
+	float shadowIntensity;
+	int maxSearch;
+	int samplesPerPixel;
+	double discontinuityTime;
+	double searchTime;
+	double revectorizationTime;
+	int numberOfPixels;
+	int numberOfSamples;
+	int numberOfSearches;
+	int fetches; //shadow map and discontinuity map lookups of the camera pass
+	double discontinuityMapTime;
+	int discontinuityMapFetches;
+	unsigned short *discontinuityMap; //left, right, down and up per texel, encoded as in DiscontinuityMap.frag
+
+};
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef MOMENTQUANTIZATION_H
+#define MOMENTQUANTIZATION_H
+
+#include "glm/glm.hpp"
+
+//Optimized quantization of the moment shadow maps (Peters and Klein 2015), uploaded to the MSM shaders by 
+//MyGLGeometryViewer::configureMoments and inverted by HardShadowReference.
+//The quantized moments are mQuantization * b + tQuantization, where tQuantization only has an x component
+#define MSM_QUANTIZATION_OFFSET 0.0359558848f
+
+//column-major, as uploaded to the mQuantization uniform
+inline glm::mat4 computeMomentQuantization()
+{
+
+	glm::mat4 mQuantization;
+	mQuantization[0][0] = -2.07224649;	mQuantization[0][1] = 32.2370378;	mQuantization[0][2] = -68.5710746;	mQuantization[0][3] = 39.3703274;
+	mQuantization[1][0] = 13.7948857;	mQuantization[1][1] = -59.4683976;	mQuantization[1][2] = 82.035975;	mQuantization[1][3] = -35.3649032;
+	mQuantization[2][0] = 0.105877704;	mQuantization[2][1] = -1.90774663;	mQuantization[2][2] = 9.34965551;	mQuantization[2][3] = -6.65434907;
+	mQuantization[3][0] = 9.79240621;	mQuantization[3][1] = -33.76521106;	mQuantization[3][2] = 47.9456097;	mQuantization[3][3] = -23.9728048;
+	return glm::transpose(mQuantization);
+
+}
+
+#endif
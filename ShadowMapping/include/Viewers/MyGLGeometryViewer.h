@@ -5,6 +5,7 @@
 #include <GL/glew.h>
 #include <GL/glut.h>
 #include "Viewers/ShadowParams.h"
+#include "Viewers/MomentQuantization.h"
 #include "Mesh.h"
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
@@ -24,6 +25,7 @@ public:
 	void configurePhong(glm::vec3 lightPosition, glm::vec3 cameraPosition);
 	void configureShadow(ShadowParams shadowParams);
 	void configureMoments(ShadowParams shadowParams);
+	void configureCascades(ShadowParams shadowParams);
 	void configureRevectorization(ShadowParams shadowParams, int imageWidth, int imageHeight);
 	void drawPlane(float x, float y, float z);
 	void drawMesh(GLuint *VBOs, int numberOfIndices, int numberOfTexCoords, int numberOfColors, bool textureFromImage, GLuint *textures, int numberOfTextures);
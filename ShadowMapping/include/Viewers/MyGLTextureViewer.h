@@ -6,6 +6,8 @@
 #include <GL/glew.h>
 #include <GL/glut.h>
 #include <stdio.h>
+#include <string.h>
+#include "Image.h"
 
 class MyGLTextureViewer
 {
@@ -13,13 +15,18 @@ class MyGLTextureViewer
 public:
 	void loadDepthComponentTexture(float *data, GLuint *texVBO, int index, int imageWidth, int imageHeight);
 	void loadRGTexture(float *data, GLuint *texVBO, int index, int imageWidth, int imageHeight, GLint param = GL_LINEAR_MIPMAP_LINEAR);
+	void loadRGTexture(unsigned short *data, GLuint *texVBO, int index, int imageWidth, int imageHeight, GLint param = GL_NEAREST);
 	void loadRGBTexture(const unsigned char *data, GLuint *texVBO, int index, int imageWidth, int imageHeight);
+	void loadRGBTexture(Image *image, GLuint *texVBO, int index);
 	void loadRGBTexture(float *data, GLuint *texVBO, int index, int imageWidth, int imageHeight, GLint param = GL_LINEAR_MIPMAP_LINEAR);
 	void loadRGBATexture(float *data, GLuint *texVBO, int index, int imageWidth, int imageHeight, GLint param = GL_LINEAR_MIPMAP_LINEAR);
+	void loadRGBATexture(unsigned char *data, GLuint *texVBO, int index, int imageWidth, int imageHeight, GLint param = GL_NEAREST);
+	void loadRGBATexture(unsigned short *data, GLuint *texVBO, int index, int imageWidth, int imageHeight, GLint param = GL_NEAREST);
 	void loadFrameBufferTexture(int x, int y, int width, int height, unsigned char *frameBuffer);
 	void loadQuad();
 	void configureSeparableFilter(int order, float *kernel, bool horizontal, bool vertical, float sigmaSpace = 0, float sigmaColor = 0);
 	void configureSeparableFilter(int order, bool horizontal, bool vertical, float shadowIntensity = 0);
+	void configureSeparableFilter(int numberOfTaps, float *tapOffsets, float *tapWeights, bool horizontal, bool vertical);
 	void drawTextureQuad();
 	void drawTextureOnShader(GLuint texture, int imageWidth, int imageHeight);
 	void drawTexturesForBilateralFiltering(GLuint lightDepthTexture, GLuint eyeDepthTexture, GLuint shadowTexture, int imageWidth, int imageHeight);
@@ -0,0 +1,45 @@
+#ifndef SHADOWMAPCACHE_H
+#define SHADOWMAPCACHE_H
+
+#include <assert.h>
+#include "glm/glm.hpp"
+
+//shared by the ShadowMapping and SoftShadowMapping caches. A key with more parameters never hits
+#define MAX_SHADOW_MAP_KEY_PARAMETERS 64
+
+typedef struct ShadowMapKey
+{
+	glm::vec3 lightEye;
+	glm::vec3 lightAt;
+	glm::vec3 lightUp;
+	int geometryVersion;
+	int numberOfParameters;
+	bool overflow;
+	float parameters[MAX_SHADOW_MAP_KEY_PARAMETERS];
+} ShadowMapKey;
+
+class ShadowMapCache
+{
+
+public:
+	ShadowMapCache();
+	void beginKey(glm::vec3 lightEye, glm::vec3 lightAt, glm::vec3 lightUp, int geometryVersion);
+	void addParameter(float parameter);
+	bool lookup();
+	void invalidate() { valid = false; }
+	void resetCounters() { hits = 0; misses = 0; }
+	void setEnabled(bool enabled) { this->enabled = enabled; valid = false; }
+	bool isEnabled() { return enabled; }
+	int getHits() { return hits; }
+	int getMisses() { return misses; }
+private:
+	bool isEqual(ShadowMapKey *a, ShadowMapKey *b);
+	ShadowMapKey cachedKey;
+	ShadowMapKey currentKey;
+	bool valid;
+	bool enabled;
+	int hits;
+	int misses;
+};
+
+#endif
@@ -3,11 +3,18 @@
 
 #include "glm/glm.hpp"
 
+#define NUMBER_OF_CASCADES 4
+#define MAX_PCF_ORDER 31 //size of the weight table of the gathered and optimized PCF
+#define MAX_DISCONTINUITY_MAP_SEARCH 255 //the discontinuity map stores the walk lengths in 8 bits
+
 typedef struct ShadowParams
 {
 	glm::mat4 lightMVP;
 	glm::mat4 lightMV;
 	glm::mat4 lightP;
+	glm::mat4 inverseGBufferMVP; //packedGBuffer
+	glm::mat4 cascadeMVP[NUMBER_OF_CASCADES]; //cropped light transforms, one per atlas quadrant
+	glm::vec3 cascadeSplits; //camera depths between consecutive cascades
 	int shadowMapWidth;
 	int shadowMapHeight;
 	int maxSearch; //SMSR
@@ -17,6 +24,8 @@ typedef struct ShadowParams
 	float shadowIntensity;
 	bool tricubicPCF;
 	bool bilinearPCF;
+	bool gatherPCF;
+	bool optimizedPCF;
 	bool VSM;
 	bool ESM;
 	bool EVSM;
@@ -29,11 +38,16 @@ typedef struct ShadowParams
 	bool EDTSM;
 	bool useHardShadowMap;
 	bool conservative;
+	bool useDiscontinuityMap; //conservative SMSR
+	bool cascadedShadowMaps;
 	GLuint shadowMap;
+	GLuint shadowMapSampler; //depth comparison sampler of the gathered and optimized PCF
 	GLuint vertexMap;
 	GLuint normalMap;
 	GLuint colorMap;
 	GLuint hardShadowMap;
+	GLuint discontinuityMap; //discontinuities and silhouette walks of each shadow map texel, built by DiscontinuityMap.frag
+	float *pcfWeights; //kernelOrder weights of the separable PCF kernel
 } ShadowParams;
 
 #endif
\ No newline at end of file
@@ -38,7 +38,7 @@ extern GLuint FragmentShaderObject;
 
 extern GLuint 	shaderVS; 
 extern GLuint 	shaderFS; 
-extern GLuint 	shaderProg[15];   // handles to objects
+extern GLuint 	shaderProg[20];   // handles to objects
 extern GLint  	linked;
 
 
@@ -87,6 +87,14 @@ static int shaderSize(char *fileName, EShaderType shaderType) ;
 // ***********************************************************************
 static int readShader(char *fileName, EShaderType shaderType, char *shaderText, int size) ;
 
+// ***********************************************************************
+//
+// Replaces every #include "<file>" line of the shader source with the
+// contents of Shaders/<file>.
+//
+// ***********************************************************************
+static GLchar *resolveIncludes(GLchar *source);
+
 // ***********************************************************************
 // ***********************************************************************
 
@@ -115,6 +123,17 @@ void getGlVersion( int *major, int *minor );
 // ** 
 // ***********************************************************************
 
+// ***********************************************************************
+// ** Preprocessor lines (e.g. "#define NAME\n") prepended to the shaders
+// ** compiled by the following calls to initShader. The string is not copied.
+// ***********************************************************************
+
+void setShaderDefines(const char *defines);
+
+// ***********************************************************************
+// ** 
+// ***********************************************************************
+
 void initShader(char* shaderName, int id );
 
 
@@ -2,58 +2,221 @@
 
 Filter::Filter() {
 
+	order = 0;
 	kernel = 0;
+	bilateralKernel = 0;
+	currentKernel = 0;
+	numberOfCachedKernels = 0;
+	nextCachedKernel = 0;
 	sigmaSpace = 0;
 	sigmaColor = 0;
 
 }
 
 Filter::~Filter() {
-	
-	delete [] kernel;
+
+	free(bilateralKernel);
 
 }
 
-void Filter::buildGaussianKernel(int order) {
+void Filter::buildGaussianKernel(int order, float sigma) {
 
-	if(kernel != 0)
-		delete [] kernel;
+	if(order > MAX_FILTER_ORDER) order = MAX_FILTER_ORDER;
+
+	//kernels are cached per (order, sigma), so changing the kernel size back and forth does not rebuild them
+	for(int cached = 0; cached < numberOfCachedKernels; cached++) {
+		if(cachedKernels[cached].order == order && cachedKernels[cached].sigma == sigma) {
+			currentKernel = &cachedKernels[cached];
+			this->order = order;
+			kernel = currentKernel->kernel;
+			return;
+		}
+	}
+
+	FilterKernel *filterKernel = &cachedKernels[nextCachedKernel];
+	nextCachedKernel = (nextCachedKernel + 1) % MAX_CACHED_KERNELS;
+	if(numberOfCachedKernels < MAX_CACHED_KERNELS) numberOfCachedKernels++;
+	filterKernel->order = order;
+	filterKernel->sigma = sigma;
+
+	//binomial weights come from the Pascal's triangle recurrence in double precision, which stays exact far beyond the
+	//orders an int holds. Both kernels are normalized by their sum
+	int kernelCenter = order/2;
+	double weights[MAX_FILTER_ORDER];
+	double coefficient = 1.0, sum = 0.0;
+	for(int j = 0; j < order; j++) {
+		if(sigma <= 0.0f) {
+			if(j > 0) coefficient = coefficient * (order - j) / j;
+			weights[j] = coefficient;
+		} else
+			weights[j] = exp(-0.5 * (j - kernelCenter) * (j - kernelCenter) / ((double)sigma * sigma));
+		sum += weights[j];
+	}
 
-	this->order = order;
-	kernel = (float*)malloc(order * sizeof(float));
-	int *gaussianWeights = (int*)malloc(order * sizeof(int));
-	float norm = powf(2, order - 1);
-	int coef;
-	
-	//first, we compute the gaussian kernel weights based on the Pascal's triangle
-	for(int j = 0; j <= order - 1; j++) {
-			
-		if(j == 0) coef = 1;
-		else coef = coef * (order - 1 - j + 1)/j;
-
-		gaussianWeights[j] = coef;
-			
-	}
-
-	//next, we normalize then based on the kernel size
 	for(int k = 0; k < order; k++)
-		kernel[k] = gaussianWeights[k] / norm;
+		filterKernel->kernel[k] = (float)(weights[k] / sum);
+
+	computeTaps(filterKernel);
+	currentKernel = filterKernel;
+	this->order = order;
+	kernel = filterKernel->kernel;
+
+}
+
+void Filter::computeTaps(FilterKernel *filterKernel) {
+
+	int kernelCenter = filterKernel->order/2;
+	float *weights = filterKernel->kernel + kernelCenter;
 
-	delete [] gaussianWeights;
+	filterKernel->numberOfTaps = kernelCenter + 1;
+	for(int tap = 0; tap <= kernelCenter; tap++) {
+		filterKernel->tapOffsets[tap] = (float)tap;
+		filterKernel->tapWeights[tap] = weights[tap];
+	}
+
+	//http://rastergrid.com/blog/2010/09/efficient-gaussian-blur-with-linear-sampling/
+	//texels i and i + 1 are read by one bilinear fetch at the offset that splits the weight between them in their proportion
+	filterKernel->linearTapOffsets[0] = 0.0f;
+	filterKernel->linearTapWeights[0] = weights[0];
+	filterKernel->numberOfLinearTaps = 1;
+	for(int texel = 1; texel <= kernelCenter; texel += 2) {
+		int tap = filterKernel->numberOfLinearTaps++;
+		if(texel == kernelCenter) {
+			filterKernel->linearTapOffsets[tap] = (float)texel;
+			filterKernel->linearTapWeights[tap] = weights[texel];
+		} else {
+			float weight = weights[texel] + weights[texel + 1];
+			filterKernel->linearTapOffsets[tap] = (weight > 0.0f) ? (texel * weights[texel] + (texel + 1) * weights[texel + 1]) / weight : (float)texel;
+			filterKernel->linearTapWeights[tap] = weight;
+		}
+	}
 
 }
 
 void Filter::buildBilateralKernel(int order) {
-	
-	if(kernel != 0)
-		delete [] kernel;
+
+	free(bilateralKernel);
 
 	this->order = order;
-	kernel = (float*)malloc(order * sizeof(float));
+	bilateralKernel = (float*)malloc(order * sizeof(float));
+	kernel = bilateralKernel;
+	currentKernel = 0;
 	int kernelCenter = order/2;
 
 	for(int i = 0; i <= kernelCenter; i++) {
-		kernel[kernelCenter - i] = kernel[kernelCenter + 1] = 0.39894f * exp((-0.5f * i * i)/(sigmaSpace * sigmaSpace)) / sigmaSpace;
+		kernel[kernelCenter - i] = kernel[kernelCenter + i] = 0.39894f * exp((-0.5f * i * i)/(sigmaSpace * sigmaSpace)) / sigmaSpace;
+	}
+
+}
+
+static __m128 fetchTexel(float *image, int width, int height, int x, int y) {
+
+	//texels outside of the image read as zero, like the clamp-to-border maps on the GPU
+	if(x < 0 || y < 0 || x >= width || y >= height)
+		return _mm_setzero_ps();
+	return _mm_loadu_ps(image + (y * width + x) * 4);
+
+}
+
+__m128 Filter::sampleLinear(float *image, int width, int height, int x, int y, float offset, bool horizontal) {
+
+	float position = ((horizontal) ? x : y) + offset;
+	int first = (int)floorf(position);
+	__m128 fraction = _mm_set1_ps(position - first);
+	__m128 a = (horizontal) ? fetchTexel(image, width, height, first, y) : fetchTexel(image, width, height, x, first);
+	__m128 b = (horizontal) ? fetchTexel(image, width, height, first + 1, y) : fetchTexel(image, width, height, x, first + 1);
+	return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), fraction));
+
+}
+
+void Filter::filterImage(float *source, float *destination, int width, int height, bool horizontal, bool linearSampling) {
+
+	//one pass of the separable filter over an RGBA float image, with the same taps the shaders read. Each texel is an SSE vector
+	int numberOfTaps = getNumberOfTaps(linearSampling);
+	float *tapOffsets = getTapOffsets(linearSampling);
+	float *tapWeights = getTapWeights(linearSampling);
+
+	#pragma omp parallel for
+	for(int y = 0; y < height; y++) {
+		for(int x = 0; x < width; x++) {
+
+			__m128 sum = _mm_mul_ps(fetchTexel(source, width, height, x, y), _mm_set1_ps(tapWeights[0]));
+			for(int tap = 1; tap < numberOfTaps; tap++) {
+				__m128 pair = _mm_add_ps(sampleLinear(source, width, height, x, y, tapOffsets[tap], horizontal),
+					sampleLinear(source, width, height, x, y, -tapOffsets[tap], horizontal));
+				sum = _mm_add_ps(sum, _mm_mul_ps(pair, _mm_set1_ps(tapWeights[tap])));
+			}
+			_mm_storeu_ps(destination + (y * width + x) * 4, sum);
+
+		}
+	}
+
+}
+
+static float fetchRed(float *image, int width, int height, int x, int y) {
+
+	if(x < 0 || y < 0 || x >= width || y >= height)
+		return 0.0f;
+	return image[(y * width + x) * 4];
+
+}
+
+void Filter::filterLogImage(float *source, float *destination, int width, int height, bool horizontal) {
+
+	//one pass of the log-space convolution of LogGaussianFilter.frag over the red channel of an RGBA image, which is written
+	//to the four channels. Each weight is folded in as X + log(x0 + y0 * exp(Y - X)), one fetch per weight. exp and log have
+	//no SSE form, so only the rows run in parallel
+	int kernelCenter = order/2;
+
+	#pragma omp parallel for
+	for(int y = 0; y < height; y++) {
+		for(int x = 0; x < width; x++) {
+
+			float sample[2];
+			for(int i = 0; i < 2; i++)
+				sample[i] = (horizontal) ? fetchRed(source, width, height, x + i - kernelCenter, y) : fetchRed(source, width, height, x, y + i - kernelCenter);
+			float sum = sample[0] + logf(kernel[0] + kernel[1] * expf(sample[1] - sample[0]));
+
+			for(int i = 2; i < order; i++) {
+				float value = (horizontal) ? fetchRed(source, width, height, x + i - kernelCenter, y) : fetchRed(source, width, height, x, y + i - kernelCenter);
+				sum = sum + logf(1.0f + kernel[i] * expf(value - sum));
+			}
+			_mm_storeu_ps(destination + (y * width + x) * 4, _mm_set1_ps(sum));
+
+		}
+	}
+
+}
+
+float Filter::percentageCloserFilter(float *depthMap, int width, int height, float s, float t, float depth, bool subTexel) {
+
+	//reference for the separable PCF of Shadow.frag, with one depth comparison per texel. Without subTexel the kernel is centered
+	//on the nearest texel, as the gathered PCF. With it the kernel is centered on the lookup position and interpolated between the
+	//texels around it, one texel wider, as the bilinear comparisons of the optimized PCF. Returns the lit fraction
+	float x = s * width, y = t * height;
+	if(subTexel) {
+		x -= 0.5f;
+		y -= 0.5f;
 	}
+	int baseX = (int)floorf(x), baseY = (int)floorf(y);
+	float fractionX = (subTexel) ? x - baseX : 0.0f;
+	float fractionY = (subTexel) ? y - baseY : 0.0f;
+	int support = (subTexel) ? order + 1 : order;
+	int radius = order/2;
+	float lit = 0.0f;
+
+	for(int j = 0; j < support; j++) {
+		float weightY = (1.0f - fractionY) * getWeight(j) + fractionY * getWeight(j - 1);
+		int texelY = baseY + j - radius;
+		for(int i = 0; i < support; i++) {
+			float weightX = (1.0f - fractionX) * getWeight(i) + fractionX * getWeight(i - 1);
+			int texelX = baseX + i - radius;
+			//texels outside of the map read as zero, like the clamp-to-border depth map on the GPU
+			float texelDepth = (texelX < 0 || texelY < 0 || texelX >= width || texelY >= height) ? 0.0f : depthMap[texelY * width + texelX];
+			if(depth <= texelDepth) lit += weightX * weightY;
+		}
+	}
+
+	return lit;
 
-}
\ No newline at end of file
+}
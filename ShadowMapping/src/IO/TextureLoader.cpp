@@ -0,0 +1,91 @@
+#include "IO\TextureLoader.h"
+
+class TextureDecodeBody : public cv::ParallelLoopBody
+{
+
+public:
+	TextureDecodeBody(TextureLoader *loader) { this->loader = loader; }
+	void operator()(const cv::Range &range) const {
+		for(int index = range.start; index < range.end; index++)
+			loader->loadImage(index);
+	}
+private:
+	TextureLoader *loader;
+};
+
+TextureLoader::TextureLoader(bool useCompression, bool useCache)
+{
+
+	this->useCompression = useCompression;
+	this->useCache = useCache;
+	this->cacheHits = 0;
+
+}
+
+TextureLoader::~TextureLoader()
+{
+
+	for(int index = 0; index < images.size(); index++)
+		delete images[index];
+
+}
+
+void TextureLoader::request(char *filename)
+{
+
+	for(int index = 0; index < filenames.size(); index++)
+		if(filenames[index] == filename)
+			return;
+
+	filenames.push_back(std::string(filename));
+	images.push_back(NULL);
+	fromCache.push_back(0);
+
+}
+
+void TextureLoader::loadImage(int index)
+{
+
+	char *filename = (char*)filenames[index].c_str();
+	Image *image = NULL;
+
+	if(useCache)
+		image = Image::loadCache(filename, useCompression);
+
+	if(image != NULL) {
+		fromCache[index] = 1;
+	} else {
+		image = new Image(filename);
+		image->generateMipmaps();
+		if(useCompression)
+			image->compress();
+		if(useCache)
+			image->saveCache(filename);
+	}
+
+	images[index] = image;
+
+}
+
+void TextureLoader::decode()
+{
+
+	//each texture is decoded, filtered and (optionally) compressed by its own worker
+	cv::parallel_for_(cv::Range(0, (int)filenames.size()), TextureDecodeBody(this));
+
+	cacheHits = 0;
+	for(int index = 0; index < fromCache.size(); index++)
+		if(fromCache[index]) cacheHits++;
+
+}
+
+Image* TextureLoader::getImage(char *filename)
+{
+
+	for(int index = 0; index < filenames.size(); index++)
+		if(filenames[index] == filename)
+			return images[index];
+
+	return NULL;
+
+}
@@ -1,28 +1,351 @@
 #include "Image.h"
 
+Image::Image() {
+
+	data = NULL;
+	mipmaps = NULL;
+	numberOfLevels = 0;
+	levelOffset[0] = 0;
+	width = 0;
+	height = 0;
+	compressed = false;
+
+}
+
 Image::Image(int width, int height, int channels) {
 
 	data = (unsigned char*)malloc(width * height * channels * sizeof(unsigned char));
+	mipmaps = NULL;
+	numberOfLevels = 0;
+	levelOffset[0] = 0;
+	compressed = false;
 	this->width = width;
 	this->height = height;
 
 }
 
 Image::Image(char *filename) {
-	
-	cv::Mat img = cv::imread(filename);
-	cv::cvtColor(img, img, CV_BGR2RGB);
-	data = (unsigned char*)malloc(img.cols * img.rows * img.channels() * sizeof(unsigned char));
+
+	cv::Mat img = cv::imread(filename, CV_LOAD_IMAGE_COLOR);
+	mipmaps = NULL;
+	numberOfLevels = 0;
+	levelOffset[0] = 0;
+	compressed = false;
+
+	if(img.empty()) {
+		printf("Could not load texture %s\n", filename);
+		this->width = 1;
+		this->height = 1;
+		data = (unsigned char*)malloc(3 * sizeof(unsigned char));
+		memset(data, 255, 3 * sizeof(unsigned char));
+		return;
+	}
+
 	this->width = img.cols;
 	this->height = img.rows;
-	
-	for(int pixel = 0; pixel < this->width * this->height * 3; pixel++)
-		data[pixel] = img.ptr<unsigned char>()[pixel];
+	data = (unsigned char*)malloc(img.cols * img.rows * 3 * sizeof(unsigned char));
+
+	//the destination header wraps our own buffer, so the color conversion writes the pixels in place
+	cv::Mat rgb(img.rows, img.cols, CV_8UC3, data);
+	cv::cvtColor(img, rgb, CV_BGR2RGB);
+
+}
+
+Image::Image(Image *image) {
+
+	width = image->getWidth();
+	height = image->getHeight();
+	numberOfLevels = image->numberOfLevels;
+	compressed = image->compressed;
+	memcpy(levelOffset, image->levelOffset, (MAX_MIPMAP_LEVELS + 1) * sizeof(int));
+
+	mipmaps = NULL;
+	if(image->mipmaps != NULL) {
+		mipmaps = (unsigned char*)malloc(image->getMipmapsSize() * sizeof(unsigned char));
+		memcpy(mipmaps, image->mipmaps, image->getMipmapsSize() * sizeof(unsigned char));
+	}
+
+	if(image->data == NULL) {
+		data = NULL;
+	} else if(image->data == image->mipmaps) {
+		data = mipmaps;
+	} else {
+		data = (unsigned char*)malloc(width * height * 3 * sizeof(unsigned char));
+		memcpy(data, image->data, width * height * 3 * sizeof(unsigned char));
+	}
 
 }
 
 Image::~Image() {
 
-	delete [] data;
+	if(data != mipmaps)
+		free(data);
+	free(mipmaps);
+
+}
+
+int Image::computeLevelSize(int level, bool compressed) {
+
+	if(compressed)
+		return ((getLevelWidth(level) + 3)/4) * ((getLevelHeight(level) + 3)/4) * BC1_BLOCK_SIZE;
+	else
+		return getLevelWidth(level) * getLevelHeight(level) * 3;
+
+}
+
+void Image::generateMipmaps() {
+
+	if(mipmaps != NULL || data == NULL)
+		return;
+
+	int size = (width > height) ? width : height;
+	numberOfLevels = 1;
+	while((size >> numberOfLevels) > 0 && numberOfLevels < MAX_MIPMAP_LEVELS)
+		numberOfLevels++;
+
+	levelOffset[0] = 0;
+	for(int level = 0; level < numberOfLevels; level++)
+		levelOffset[level + 1] = levelOffset[level] + computeLevelSize(level, false);
+
+	mipmaps = (unsigned char*)malloc(levelOffset[numberOfLevels] * sizeof(unsigned char));
+	memcpy(mipmaps, data, width * height * 3 * sizeof(unsigned char));
+	free(data);
+	data = mipmaps;
+
+	//2x2 box filter over the previous level. Odd dimensions clamp the last row/column
+	for(int level = 1; level < numberOfLevels; level++) {
+
+		unsigned char *source = getLevel(level - 1);
+		unsigned char *destination = getLevel(level);
+		int sourceWidth = getLevelWidth(level - 1);
+		int sourceHeight = getLevelHeight(level - 1);
+		int levelWidth = getLevelWidth(level);
+		int levelHeight = getLevelHeight(level);
+
+		for(int y = 0; y < levelHeight; y++) {
+
+			int y0 = (2 * y < sourceHeight) ? 2 * y : sourceHeight - 1;
+			int y1 = (2 * y + 1 < sourceHeight) ? 2 * y + 1 : sourceHeight - 1;
+
+			for(int x = 0; x < levelWidth; x++) {
+
+				int x0 = (2 * x < sourceWidth) ? 2 * x : sourceWidth - 1;
+				int x1 = (2 * x + 1 < sourceWidth) ? 2 * x + 1 : sourceWidth - 1;
+
+				for(int c = 0; c < 3; c++) {
+					int sum = source[(y0 * sourceWidth + x0) * 3 + c] + source[(y0 * sourceWidth + x1) * 3 + c] +
+						source[(y1 * sourceWidth + x0) * 3 + c] + source[(y1 * sourceWidth + x1) * 3 + c];
+					destination[(y * levelWidth + x) * 3 + c] = (unsigned char)((sum + 2) / 4);
+				}
+
+			}
+
+		}
+
+	}
+
+}
+
+static unsigned short packRGB565(int r, int g, int b) {
+
+	return (unsigned short)(((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3));
+
+}
+
+static void unpackRGB565(unsigned short color, int *rgb) {
+
+	rgb[0] = ((color >> 11) & 31) * 255 / 31;
+	rgb[1] = ((color >> 5) & 63) * 255 / 63;
+	rgb[2] = (color & 31) * 255 / 31;
+
+}
+
+void Image::compressBlock(unsigned char *source, int sourceWidth, int sourceHeight, int x, int y, unsigned char *block) {
+
+	int texels[16][3];
+	int minColor[3] = {255, 255, 255};
+	int maxColor[3] = {0, 0, 0};
+
+	for(int j = 0; j < 4; j++) {
+		for(int i = 0; i < 4; i++) {
+			int sx = (x + i < sourceWidth) ? x + i : sourceWidth - 1;
+			int sy = (y + j < sourceHeight) ? y + j : sourceHeight - 1;
+			for(int c = 0; c < 3; c++) {
+				texels[j * 4 + i][c] = source[(sy * sourceWidth + sx) * 3 + c];
+				if(texels[j * 4 + i][c] < minColor[c]) minColor[c] = texels[j * 4 + i][c];
+				if(texels[j * 4 + i][c] > maxColor[c]) maxColor[c] = texels[j * 4 + i][c];
+			}
+		}
+	}
+
+	//range fit along the bounding box diagonal, inset to reduce the error at the extremes
+	for(int c = 0; c < 3; c++) {
+		int inset = (maxColor[c] - minColor[c]) / 16;
+		minColor[c] = (minColor[c] + inset < 255) ? minColor[c] + inset : 255;
+		maxColor[c] = (maxColor[c] - inset > 0) ? maxColor[c] - inset : 0;
+	}
+
+	unsigned short color0 = packRGB565(maxColor[0], maxColor[1], maxColor[2]);
+	unsigned short color1 = packRGB565(minColor[0], minColor[1], minColor[2]);
+	unsigned int indices = 0;
+
+	if(color0 < color1) {
+		unsigned short temp = color0;
+		color0 = color1;
+		color1 = temp;
+	}
+
+	if(color0 != color1) {
+
+		int palette[4][3];
+		unpackRGB565(color0, palette[0]);
+		unpackRGB565(color1, palette[1]);
+		for(int c = 0; c < 3; c++) {
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+
+		for(int texel = 0; texel < 16; texel++) {
+			int bestIndex = 0;
+			int bestDistance = INT_MAX;
+			for(int index = 0; index < 4; index++) {
+				int dr = texels[texel][0] - palette[index][0];
+				int dg = texels[texel][1] - palette[index][1];
+				int db = texels[texel][2] - palette[index][2];
+				int distance = dr * dr + dg * dg + db * db;
+				if(distance < bestDistance) {
+					bestDistance = distance;
+					bestIndex = index;
+				}
+			}
+			indices |= bestIndex << (2 * texel);
+		}
+
+	}
+
+	block[0] = color0 & 0xFF; block[1] = color0 >> 8;
+	block[2] = color1 & 0xFF; block[3] = color1 >> 8;
+	block[4] = indices & 0xFF; block[5] = (indices >> 8) & 0xFF;
+	block[6] = (indices >> 16) & 0xFF; block[7] = (indices >> 24) & 0xFF;
+
+}
+
+void Image::compress() {
+
+	if(compressed)
+		return;
+
+	generateMipmaps();
+	if(mipmaps == NULL)
+		return;
+
+	int compressedOffset[MAX_MIPMAP_LEVELS + 1];
+	compressedOffset[0] = 0;
+	for(int level = 0; level < numberOfLevels; level++)
+		compressedOffset[level + 1] = compressedOffset[level] + computeLevelSize(level, true);
+
+	unsigned char *blocks = (unsigned char*)malloc(compressedOffset[numberOfLevels] * sizeof(unsigned char));
+	for(int level = 0; level < numberOfLevels; level++) {
+
+		int levelWidth = getLevelWidth(level);
+		int levelHeight = getLevelHeight(level);
+		unsigned char *block = blocks + compressedOffset[level];
+
+		for(int y = 0; y < levelHeight; y += 4)
+			for(int x = 0; x < levelWidth; x += 4, block += BC1_BLOCK_SIZE)
+				compressBlock(getLevel(level), levelWidth, levelHeight, x, y, block);
+
+	}
+
+	//BC1 levels replace the RGB chain, so the uncompressed base level is no longer kept
+	free(mipmaps);
+	mipmaps = blocks;
+	data = NULL;
+	memcpy(levelOffset, compressedOffset, (MAX_MIPMAP_LEVELS + 1) * sizeof(int));
+	compressed = true;
+
+}
+
+static long long getModificationTime(char *filename) {
+
+	struct stat status;
+	if(stat(filename, &status) != 0)
+		return -1;
+	return (long long)status.st_mtime;
+
+}
+
+static void getCacheFilename(char *filename, char *cacheFilename) {
+
+	//the caches live in their own directory, so the asset folders are never written. The source path is flattened into the name
+	int length = sprintf(cacheFilename, "%s/", IMAGE_CACHE_DIRECTORY);
+	for(char *c = filename; *c != '\0' && length < 500; c++)
+		cacheFilename[length++] = (*c == '/' || *c == '\\' || *c == ':') ? '_' : *c;
+	sprintf(cacheFilename + length, ".cache");
+
+}
+
+Image* Image::loadCache(char *filename, bool compressed) {
+
+	char cacheFilename[512];
+	getCacheFilename(filename, cacheFilename);
+	FILE *file = fopen(cacheFilename, "rb");
+	if(file == NULL)
+		return NULL;
+
+	int header[5];
+	long long modificationTime;
+	if(fread(header, sizeof(int), 5, file) != 5 || fread(&modificationTime, sizeof(long long), 1, file) != 1 ||
+		header[0] != IMAGE_CACHE_VERSION || header[4] != (int)compressed || header[3] <= 0 || header[3] > MAX_MIPMAP_LEVELS ||
+		modificationTime != getModificationTime(filename)) {
+		fclose(file);
+		return NULL;
+	}
+
+	Image *image = new Image();
+	image->width = header[1];
+	image->height = header[2];
+	image->numberOfLevels = header[3];
+	image->compressed = compressed;
+
+	if(fread(image->levelOffset, sizeof(int), image->numberOfLevels + 1, file) != image->numberOfLevels + 1) {
+		fclose(file);
+		delete image;
+		return NULL;
+	}
+
+	image->mipmaps = (unsigned char*)malloc(image->getMipmapsSize() * sizeof(unsigned char));
+	if(fread(image->mipmaps, sizeof(unsigned char), image->getMipmapsSize(), file) != image->getMipmapsSize()) {
+		fclose(file);
+		delete image;
+		return NULL;
+	}
+
+	image->data = (compressed) ? NULL : image->mipmaps;
+	fclose(file);
+	return image;
+
+}
+
+void Image::saveCache(char *filename) {
+
+	if(mipmaps == NULL)
+		return;
+
+	//a read-only install cannot create the directory, and the texture is then simply decoded again next time
+	char cacheFilename[512];
+	_mkdir(IMAGE_CACHE_DIRECTORY);
+	getCacheFilename(filename, cacheFilename);
+	FILE *file = fopen(cacheFilename, "wb");
+	if(file == NULL)
+		return;
+
+	int header[5] = {IMAGE_CACHE_VERSION, width, height, numberOfLevels, (int)compressed};
+	long long modificationTime = getModificationTime(filename);
+	fwrite(header, sizeof(int), 5, file);
+	fwrite(&modificationTime, sizeof(long long), 1, file);
+	fwrite(levelOffset, sizeof(int), numberOfLevels + 1, file);
+	fwrite(mipmaps, sizeof(unsigned char), getMipmapsSize(), file);
+	fclose(file);
 
 }
\ No newline at end of file
@@ -77,10 +77,8 @@ void Mesh::addObject(Mesh *mesh)
 		for(int index = 0; index < indicesSize; index++)
 			indices[index] = mesh->getIndices()[index];
 	
-		for(int tex = 0; tex < numberOfTextures; tex++) {
-			textures[tex] = new Image(mesh->getTexture()[tex]->getWidth(), mesh->getTexture()[tex]->getHeight(), 3);
-			memcpy(textures[tex]->getData(), mesh->getTexture()[tex]->getData(), mesh->getTexture()[tex]->getWidth() * mesh->getTexture()[tex]->getHeight() * 3 * sizeof(unsigned char));
-		}
+		for(int tex = 0; tex < numberOfTextures; tex++)
+			textures[tex] = new Image(mesh->getTexture()[tex]);
 
 		if(numberOfTextures > 0) isTextureFromImage = true;
 
@@ -114,10 +112,9 @@ void Mesh::addObject(Mesh *mesh)
 		for(int index = 0; index < indicesSize; index++)
 			prevIndices[index] = indices[index];
 	
-		for(int tex = 0; tex < prevNumberOfTextures; tex++) {
-			prevTextures[tex] = new Image(textures[tex]->getWidth(), textures[tex]->getHeight(), 3);
-			memcpy(prevTextures[tex]->getData(), textures[tex]->getData(), textures[tex]->getWidth() * textures[tex]->getHeight() * 3 * sizeof(unsigned char));
-		}
+		//the images already owned by the scene are moved, not copied
+		for(int tex = 0; tex < prevNumberOfTextures; tex++)
+			prevTextures[tex] = textures[tex];
 
 		delete [] pointCloud;
 		delete [] normalVector;
@@ -154,10 +151,8 @@ void Mesh::addObject(Mesh *mesh)
 		for(int index = 0; index < prevIndicesSize; index++)
 			indices[index] = prevIndices[index];
 	
-		for(int tex = 0; tex < prevNumberOfTextures; tex++) {
-			textures[tex] = new Image(prevTextures[tex]->getWidth(), prevTextures[tex]->getHeight(), 3);
-			memcpy(textures[tex]->getData(), prevTextures[tex]->getData(), prevTextures[tex]->getWidth() * prevTextures[tex]->getHeight() * 3 * sizeof(unsigned char));
-		}
+		for(int tex = 0; tex < prevNumberOfTextures; tex++)
+			textures[tex] = prevTextures[tex];
 
 		for(int point = prevPointCloudSize; point < pointCloudSize; point++)
 			pointCloud[point] = mesh->getPointCloud()[point - prevPointCloudSize];
@@ -174,10 +169,8 @@ void Mesh::addObject(Mesh *mesh)
 		for(int index = prevIndicesSize; index < indicesSize; index++)
 			indices[index] = mesh->getIndices()[index - prevIndicesSize] + prevPointCloudSize/3;
 	
-		for(int tex = prevNumberOfTextures; tex < numberOfTextures; tex++) {
-			textures[tex] = new Image(mesh->getTexture()[tex - prevNumberOfTextures]->getWidth(), mesh->getTexture()[tex - prevNumberOfTextures]->getHeight(), 3);
-			memcpy(textures[tex]->getData(), mesh->getTexture()[tex - prevNumberOfTextures]->getData(), mesh->getTexture()[tex - prevNumberOfTextures]->getWidth() * mesh->getTexture()[tex - prevNumberOfTextures]->getHeight() * 3 * sizeof(unsigned char));
-		}
+		for(int tex = prevNumberOfTextures; tex < numberOfTextures; tex++)
+			textures[tex] = new Image(mesh->getTexture()[tex - prevNumberOfTextures]);
 
 		if(numberOfTextures > 0) isTextureFromImage = true;
 
@@ -324,6 +317,18 @@ void Mesh::loadTexture(char *filename, int ID) {
 	
 }
 
+void Mesh::loadTexture(Image *image, int ID) {
+
+	textures = (Image**)malloc(sizeof(Image));
+	textures[0] = image;
+	numberOfTextures++;
+	isTextureFromImage = true;
+	
+	for(int coord = 0; coord < textureCoordsSize/3; coord++) 
+		textureCoords[coord * 3 + 2] = ID;
+	
+}
+
 void Mesh::loadColorFromOBJFile(char *filename) {
 
 	FILE* file;
@@ -0,0 +1,451 @@
+#include "Reference\HardShadowReference.h"
+
+static __m128 select(__m128 mask, __m128 a, __m128 b) {
+
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+
+}
+
+static __m128 dot3(__m128 ax, __m128 ay, __m128 az, __m128 bx, __m128 by, __m128 bz) {
+
+	return _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_mul_ps(az, bz));
+
+}
+
+static void transform(glm::mat4 &m, PixelQuad *v, PixelQuad *result) {
+
+	//glm matrices are column-major, as the GLSL ones they are uploaded to
+	__m128 *rows[4] = {&result->x, &result->y, &result->z, &result->w};
+	for(int row = 0; row < 4; row++)
+		*rows[row] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(m[0][row]), v->x), _mm_mul_ps(_mm_set1_ps(m[1][row]), v->y)),
+			_mm_add_ps(_mm_mul_ps(_mm_set1_ps(m[2][row]), v->z), _mm_mul_ps(_mm_set1_ps(m[3][row]), v->w)));
+
+}
+
+HardShadowReference::HardShadowReference() {
+
+	vertexMap = 0;
+	normalMap = 0;
+	shadowMap = 0;
+	filter = 0;
+	width = height = 0;
+	shadowMapWidth = shadowMapHeight = 0;
+	numberOfChannels = 1;
+	zNear = 1.0f;
+	zFar = 1000.0f;
+
+	mQuantizationInverse = glm::inverse(computeMomentQuantization());
+
+}
+
+void HardShadowReference::setGBuffer(float *vertexMap, float *normalMap, int width, int height) {
+
+	this->vertexMap = vertexMap;
+	this->normalMap = normalMap;
+	this->width = width;
+	this->height = height;
+
+}
+
+void HardShadowReference::setShadowMap(float *shadowMap, int width, int height, int numberOfChannels) {
+
+	this->shadowMap = shadowMap;
+	this->shadowMapWidth = width;
+	this->shadowMapHeight = height;
+	this->numberOfChannels = numberOfChannels;
+
+}
+
+void HardShadowReference::setCamera(glm::mat4 MV, glm::mat3 normalMatrix, glm::vec3 lightPosition, float zNear, float zFar) {
+
+	this->MV = MV;
+	this->normalMatrix = normalMatrix;
+	this->lightPosition = lightPosition;
+	//the shaders receive the planes as integers
+	this->zNear = (float)(int)zNear;
+	this->zFar = (float)(int)zFar;
+
+}
+
+void HardShadowReference::loadPixels(float *image, int x, int y, int numberOfPixels, PixelQuad *pixels) {
+
+	//RGBA texels are transposed to one vector per channel. Lanes past the end of the row read as background
+	__m128 texels[4];
+	for(int lane = 0; lane < 4; lane++)
+		texels[lane] = (lane < numberOfPixels) ? _mm_loadu_ps(image + (y * width + x + lane) * 4) : _mm_setzero_ps();
+	_MM_TRANSPOSE4_PS(texels[0], texels[1], texels[2], texels[3]);
+	pixels->x = texels[0];
+	pixels->y = texels[1];
+	pixels->z = texels[2];
+	pixels->w = texels[3];
+
+}
+
+__m128 HardShadowReference::computePreEvaluation(PixelQuad *vertex, PixelQuad *normal, float shadowIntensity) {
+
+	PixelQuad eyeVertex;
+	transform(MV, vertex, &eyeVertex);
+
+	__m128 nx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(normalMatrix[0][0]), normal->x), _mm_mul_ps(_mm_set1_ps(normalMatrix[1][0]), normal->y)),
+		_mm_mul_ps(_mm_set1_ps(normalMatrix[2][0]), normal->z));
+	__m128 ny = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(normalMatrix[0][1]), normal->x), _mm_mul_ps(_mm_set1_ps(normalMatrix[1][1]), normal->y)),
+		_mm_mul_ps(_mm_set1_ps(normalMatrix[2][1]), normal->z));
+	__m128 nz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(normalMatrix[0][2]), normal->x), _mm_mul_ps(_mm_set1_ps(normalMatrix[1][2]), normal->y)),
+		_mm_mul_ps(_mm_set1_ps(normalMatrix[2][2]), normal->z));
+	__m128 lx = _mm_sub_ps(_mm_set1_ps(lightPosition[0]), eyeVertex.x);
+	__m128 ly = _mm_sub_ps(_mm_set1_ps(lightPosition[1]), eyeVertex.y);
+	__m128 lz = _mm_sub_ps(_mm_set1_ps(lightPosition[2]), eyeVertex.z);
+
+	//only the sign of N.L matters, so neither vector is normalized. Back faces flip the normal
+	__m128 NdotL = dot3(nx, ny, nz, lx, ly, lz);
+	__m128 backFace = _mm_cmpeq_ps(normal->w, _mm_setzero_ps());
+	NdotL = select(backFace, _mm_sub_ps(_mm_setzero_ps(), NdotL), NdotL);
+	return select(_mm_cmpgt_ps(NdotL, _mm_setzero_ps()), _mm_set1_ps(1.0f), _mm_set1_ps(shadowIntensity));
+
+}
+
+void HardShadowReference::computeShadowCoords(PixelQuad *vertex, ShadowParams *shadowParams, PixelQuad *shadowCoord) {
+
+	glm::mat4 bias;
+	bias[0][0] = 0.5;	bias[1][1] = 0.5;	bias[2][2] = 0.5;
+	bias[3][0] = 0.5;	bias[3][1] = 0.5;	bias[3][2] = 0.5;
+
+	if(!shadowParams->cascadedShadowMaps) {
+		glm::mat4 lightMVP = bias * shadowParams->lightMVP;
+		transform(lightMVP, vertex, shadowCoord);
+		return;
+	}
+
+	//each lane picks the cascade of its camera depth, with the atlas transform of MyGLGeometryViewer::configureCascades
+	PixelQuad eyeVertex;
+	transform(MV, vertex, &eyeVertex);
+	float depth[4];
+	_mm_storeu_ps(depth, _mm_sub_ps(_mm_setzero_ps(), eyeVertex.z));
+
+	float coefficients[16][4];
+	for(int lane = 0; lane < 4; lane++) {
+		int cascade = 0;
+		for(int split = 0; split < NUMBER_OF_CASCADES - 1; split++)
+			if(depth[lane] > shadowParams->cascadeSplits[split]) cascade++;
+		glm::mat4 atlas;
+		atlas[0][0] = 0.25;	atlas[1][1] = 0.25;	atlas[2][2] = 0.5;
+		atlas[3][0] = 0.25 + 0.5 * (cascade % 2);	atlas[3][1] = 0.25 + 0.5 * (cascade / 2);	atlas[3][2] = 0.5;
+		glm::mat4 cascadeMVP = atlas * shadowParams->cascadeMVP[cascade];
+		for(int coefficient = 0; coefficient < 16; coefficient++)
+			coefficients[coefficient][lane] = cascadeMVP[coefficient / 4][coefficient % 4];
+	}
+
+	__m128 *rows[4] = {&shadowCoord->x, &shadowCoord->y, &shadowCoord->z, &shadowCoord->w};
+	for(int row = 0; row < 4; row++)
+		*rows[row] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(coefficients[row]), vertex->x), _mm_mul_ps(_mm_loadu_ps(coefficients[4 + row]), vertex->y)),
+			_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(coefficients[8 + row]), vertex->z), _mm_mul_ps(_mm_loadu_ps(coefficients[12 + row]), vertex->w)));
+
+}
+
+__m128 HardShadowReference::linearize(__m128 depth) {
+
+	__m128 n = _mm_set1_ps(zNear);
+	__m128 f = _mm_set1_ps(zFar);
+	return _mm_div_ps(_mm_mul_ps(_mm_set1_ps(2.0f), n), _mm_sub_ps(_mm_add_ps(f, n), _mm_mul_ps(depth, _mm_sub_ps(f, n))));
+
+}
+
+float HardShadowReference::fetchNearest(float s, float t) {
+
+	//GL_NEAREST with a zero border, the depth map of Shadow.frag
+	int x = (int)floorf(s * shadowMapWidth);
+	int y = (int)floorf(t * shadowMapHeight);
+	if(x < 0 || y < 0 || x >= shadowMapWidth || y >= shadowMapHeight)
+		return 0.0f;
+	return shadowMap[(y * shadowMapWidth + x) * numberOfChannels];
+
+}
+
+void HardShadowReference::fetchBilinear(float s, float t, float *texel) {
+
+	//GL_LINEAR on the base level with a zero border, the filtered moment maps. The moment maps are mipmapped on the GPU,
+	//so magnified lookups match and minified ones differ by the mip filter
+	float x = s * shadowMapWidth - 0.5f, y = t * shadowMapHeight - 0.5f;
+	int baseX = (int)floorf(x), baseY = (int)floorf(y);
+	float fractionX = x - baseX, fractionY = y - baseY;
+	float weights[4] = {(1.0f - fractionX) * (1.0f - fractionY), fractionX * (1.0f - fractionY), (1.0f - fractionX) * fractionY, fractionX * fractionY};
+
+	for(int channel = 0; channel < 4; channel++) texel[channel] = 0.0f;
+	for(int corner = 0; corner < 4; corner++) {
+		int texelX = baseX + corner % 2, texelY = baseY + corner / 2;
+		if(texelX < 0 || texelY < 0 || texelX >= shadowMapWidth || texelY >= shadowMapHeight) continue;
+		float *value = shadowMap + (texelY * shadowMapWidth + texelX) * numberOfChannels;
+		for(int channel = 0; channel < numberOfChannels && channel < 4; channel++)
+			texel[channel] += weights[corner] * value[channel];
+	}
+
+}
+
+float HardShadowReference::textureBicubic(float s, float t) {
+
+	//the B-spline lookup of Shadow.frag with its four fetches, which the GL_NEAREST depth map reads as point samples
+	float x = s * shadowMapWidth - 0.5f, y = t * shadowMapHeight - 0.5f;
+	float fx = x - floorf(x), fy = y - floorf(y);
+	x -= fx;
+	y -= fy;
+
+	float cubicX[4], cubicY[4];
+	float *cubics[2] = {cubicX, cubicY};
+	float fractions[2] = {fx, fy};
+	for(int axis = 0; axis < 2; axis++) {
+		float n[4], v = fractions[axis];
+		for(int i = 0; i < 4; i++) n[i] = (i + 1.0f - v) * (i + 1.0f - v) * (i + 1.0f - v);
+		cubics[axis][0] = n[0] / 6.0f;
+		cubics[axis][1] = (n[1] - 4.0f * n[0]) / 6.0f;
+		cubics[axis][2] = (n[2] - 4.0f * n[1] + 6.0f * n[0]) / 6.0f;
+		cubics[axis][3] = (6.0f - n[0] - (n[1] - 4.0f * n[0]) - (n[2] - 4.0f * n[1] + 6.0f * n[0])) / 6.0f;
+	}
+
+	float sx0 = cubicX[0] + cubicX[1], sx1 = cubicX[2] + cubicX[3];
+	float sy0 = cubicY[0] + cubicY[1], sy1 = cubicY[2] + cubicY[3];
+	float offsetX0 = (x - 0.5f + cubicX[1] / sx0) / shadowMapWidth, offsetX1 = (x + 1.5f + cubicX[3] / sx1) / shadowMapWidth;
+	float offsetY0 = (y - 0.5f + cubicY[1] / sy0) / shadowMapHeight, offsetY1 = (y + 1.5f + cubicY[3] / sy1) / shadowMapHeight;
+
+	float sample0 = fetchNearest(offsetX0, offsetY0);
+	float sample1 = fetchNearest(offsetX1, offsetY0);
+	float sample2 = fetchNearest(offsetX0, offsetY1);
+	float sample3 = fetchNearest(offsetX1, offsetY1);
+	float weightX = sx0 / (sx0 + sx1);
+	float weightY = sy0 / (sy0 + sy1);
+	float top = sample3 + (sample2 - sample3) * weightX;
+	float bottom = sample1 + (sample0 - sample1) * weightX;
+	return top + (bottom - top) * weightY;
+
+}
+
+void HardShadowReference::fetchMoments(PixelQuad *normalizedShadowCoord, int numberOfPixels, PixelQuad *moments) {
+
+	float s[4], t[4];
+	_mm_storeu_ps(s, normalizedShadowCoord->x);
+	_mm_storeu_ps(t, normalizedShadowCoord->y);
+	__m128 texels[4];
+	for(int lane = 0; lane < 4; lane++) {
+		float texel[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+		if(lane < numberOfPixels) fetchBilinear(s[lane], t[lane], texel);
+		texels[lane] = _mm_loadu_ps(texel);
+	}
+	_MM_TRANSPOSE4_PS(texels[0], texels[1], texels[2], texels[3]);
+	moments->x = texels[0];
+	moments->y = texels[1];
+	moments->z = texels[2];
+	moments->w = texels[3];
+
+}
+
+__m128 HardShadowReference::naive(PixelQuad *normalizedShadowCoord, ShadowParams *shadowParams, int numberOfPixels) {
+
+	float s[4], t[4], distanceFromLight[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+	_mm_storeu_ps(s, normalizedShadowCoord->x);
+	_mm_storeu_ps(t, normalizedShadowCoord->y);
+	for(int lane = 0; lane < numberOfPixels; lane++)
+		distanceFromLight[lane] = fetchNearest(s[lane], t[lane]);
+	__m128 lit = _mm_cmple_ps(normalizedShadowCoord->z, _mm_loadu_ps(distanceFromLight));
+	return select(lit, _mm_set1_ps(1.0f), _mm_set1_ps(shadowParams->shadowIntensity));
+
+}
+
+__m128 HardShadowReference::PCF(PixelQuad *normalizedShadowCoord, ShadowParams *shadowParams, int numberOfPixels) {
+
+	//the stepped loop of Shadow.frag, with the same float accumulation so both take the same number of taps
+	float s[4], t[4];
+	_mm_storeu_ps(s, normalizedShadowCoord->x);
+	_mm_storeu_ps(t, normalizedShadowCoord->y);
+	float incrWidth = 1.0f / shadowParams->shadowMapWidth;
+	float incrHeight = 1.0f / shadowParams->shadowMapHeight;
+	float offset = (float)shadowParams->penumbraSize;
+	float stepSize = 2 * offset / (float)shadowParams->kernelOrder;
+	__m128 illuminationCount = _mm_setzero_ps();
+	__m128 shadowIntensity = _mm_set1_ps(shadowParams->shadowIntensity);
+	int count = 0;
+
+	for(float w = -offset; w < offset; w += stepSize) {
+		for(float h = -offset; h < offset; h += stepSize) {
+
+			float distanceFromLight[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+			for(int lane = 0; lane < numberOfPixels; lane++) {
+				if(shadowParams->tricubicPCF) distanceFromLight[lane] = textureBicubic(s[lane] + w * incrWidth, t[lane] + h * incrHeight);
+				else distanceFromLight[lane] = fetchNearest(s[lane] + w * incrWidth, t[lane] + h * incrHeight);
+			}
+			__m128 lit = _mm_cmple_ps(normalizedShadowCoord->z, _mm_loadu_ps(distanceFromLight));
+			illuminationCount = _mm_add_ps(illuminationCount, select(lit, _mm_set1_ps(1.0f), shadowIntensity));
+			count++;
+
+		}
+	}
+
+	return _mm_div_ps(illuminationCount, _mm_set1_ps((float)count));
+
+}
+
+__m128 HardShadowReference::separablePCF(PixelQuad *normalizedShadowCoord, ShadowParams *shadowParams, int numberOfPixels) {
+
+	//the gathered and the optimized PCF weigh one comparison per texel with the Filter kernel
+	float s[4], t[4], depth[4], lit[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+	_mm_storeu_ps(s, normalizedShadowCoord->x);
+	_mm_storeu_ps(t, normalizedShadowCoord->y);
+	_mm_storeu_ps(depth, normalizedShadowCoord->z);
+	for(int lane = 0; lane < numberOfPixels; lane++)
+		lit[lane] = filter->percentageCloserFilter(shadowMap, shadowMapWidth, shadowMapHeight, s[lane], t[lane], depth[lane], shadowParams->optimizedPCF);
+	__m128 shadowIntensity = _mm_set1_ps(shadowParams->shadowIntensity);
+	return _mm_add_ps(shadowIntensity, _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(1.0f), shadowIntensity), _mm_loadu_ps(lit)));
+
+}
+
+__m128 HardShadowReference::chebyshevUpperBound(__m128 mean, __m128 meanSquare, __m128 distanceToLight, float shadowIntensity) {
+
+	__m128 lit = _mm_cmple_ps(distanceToLight, mean);
+	__m128 variance = _mm_sub_ps(meanSquare, _mm_mul_ps(mean, mean));
+	__m128 d = _mm_sub_ps(distanceToLight, mean);
+	__m128 pMax = _mm_max_ps(_mm_div_ps(variance, _mm_add_ps(variance, _mm_mul_ps(d, d))), _mm_setzero_ps());
+	__m128 intensity = _mm_set1_ps(shadowIntensity);
+	pMax = _mm_add_ps(_mm_mul_ps(pMax, _mm_sub_ps(_mm_set1_ps(1.0f), intensity)), intensity);
+	return select(lit, _mm_set1_ps(1.0f), pMax);
+
+}
+
+__m128 HardShadowReference::varianceShadowMapping(PixelQuad *normalizedShadowCoord, ShadowParams *shadowParams, int numberOfPixels) {
+
+	PixelQuad moments;
+	fetchMoments(normalizedShadowCoord, numberOfPixels, &moments);
+	return chebyshevUpperBound(moments.x, moments.y, linearize(normalizedShadowCoord->z), shadowParams->shadowIntensity);
+
+}
+
+__m128 HardShadowReference::exponentialShadowMapping(PixelQuad *normalizedShadowCoord, ShadowParams *shadowParams, int numberOfPixels) {
+
+	const float c = 80.0f;
+	PixelQuad moments;
+	fetchMoments(normalizedShadowCoord, numberOfPixels, &moments);
+	float e2[4], z[4], shadow[4];
+	_mm_storeu_ps(e2, moments.x);
+	_mm_storeu_ps(z, linearize(normalizedShadowCoord->z));
+	//SSE has no exponential, so each lane calls expf
+	for(int lane = 0; lane < 4; lane++)
+		shadow[lane] = expf(-c * z[lane]) * expf(c * e2[lane]);
+	return _mm_min_ps(_mm_max_ps(_mm_loadu_ps(shadow), _mm_set1_ps(shadowParams->shadowIntensity)), _mm_set1_ps(1.0f));
+
+}
+
+__m128 HardShadowReference::exponentialVarianceShadowMapping(PixelQuad *normalizedShadowCoord, ShadowParams *shadowParams, int numberOfPixels) {
+
+	const float c = 60.0f;
+	PixelQuad moments;
+	fetchMoments(normalizedShadowCoord, numberOfPixels, &moments);
+	__m128 depth = linearize(normalizedShadowCoord->z);
+	__m128 variance = chebyshevUpperBound(moments.x, moments.y, depth, shadowParams->shadowIntensity);
+
+	float e2[4], z[4], shadow[4];
+	_mm_storeu_ps(e2, moments.z);
+	_mm_storeu_ps(z, depth);
+	for(int lane = 0; lane < 4; lane++)
+		shadow[lane] = expf(-c * z[lane]) * expf(c * e2[lane]);
+	__m128 exponential = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(shadow), _mm_set1_ps(shadowParams->shadowIntensity)), _mm_set1_ps(1.0f));
+	return _mm_min_ps(variance, exponential);
+
+}
+
+__m128 HardShadowReference::hamburger4MSM(PixelQuad *normalizedShadowCoord, ShadowParams *shadowParams, int numberOfPixels) {
+
+	const __m128 one = _mm_set1_ps(1.0f), zero = _mm_setzero_ps();
+	const float bias = 0.00003f;
+	PixelQuad quantized, b;
+	fetchMoments(normalizedShadowCoord, numberOfPixels, &quantized);
+	quantized.x = _mm_sub_ps(quantized.x, _mm_set1_ps(MSM_QUANTIZATION_OFFSET));
+	transform(mQuantizationInverse, &quantized, &b);
+	__m128 *moments[4] = {&b.x, &b.y, &b.z, &b.w};
+	for(int moment = 0; moment < 4; moment++)
+		*moments[moment] = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(1.0f - bias), *moments[moment]), _mm_set1_ps(bias * 0.5f));
+
+	__m128 z0 = linearize(normalizedShadowCoord->z);
+
+	//Cholesky decomposition (LDLT) of the Hankel matrix, solved for c
+	__m128 L10 = b.x;
+	__m128 L20 = b.y;
+	__m128 D11 = _mm_sub_ps(b.y, _mm_mul_ps(L10, L10));
+	__m128 L21 = _mm_div_ps(_mm_sub_ps(b.z, _mm_mul_ps(L20, L10)), D11);
+	__m128 D22 = _mm_sub_ps(_mm_sub_ps(b.w, _mm_mul_ps(L20, L20)), _mm_mul_ps(_mm_mul_ps(L21, L21), D11));
+	__m128 y1 = _mm_sub_ps(z0, L10);
+	__m128 y2 = _mm_sub_ps(_mm_sub_ps(_mm_mul_ps(z0, z0), L20), _mm_mul_ps(L21, y1));
+	y1 = _mm_div_ps(y1, D11);
+	y2 = _mm_div_ps(y2, D22);
+	__m128 cz = y2;
+	__m128 cy = _mm_sub_ps(y1, _mm_mul_ps(L21, cz));
+	__m128 cx = _mm_sub_ps(_mm_sub_ps(one, _mm_mul_ps(L10, cy)), _mm_mul_ps(L20, cz));
+
+	//roots of c.x + c.y * z + c.z * z^2
+	__m128 p = _mm_div_ps(cy, cz);
+	__m128 q = _mm_div_ps(cx, cz);
+	__m128 r = _mm_sqrt_ps(_mm_sub_ps(_mm_mul_ps(_mm_mul_ps(p, p), _mm_set1_ps(0.25f)), q));
+	__m128 halfP = _mm_mul_ps(p, _mm_set1_ps(-0.5f));
+	__m128 z1 = _mm_sub_ps(halfP, r);
+	__m128 z2 = _mm_add_ps(halfP, r);
+
+	__m128 intensity = _mm_set1_ps(shadowParams->shadowIntensity);
+	__m128 between = _mm_div_ps(_mm_add_ps(_mm_sub_ps(_mm_mul_ps(z0, z2), _mm_mul_ps(b.x, _mm_add_ps(z0, z2))), b.y),
+		_mm_mul_ps(_mm_sub_ps(z2, z1), _mm_sub_ps(z0, z1)));
+	between = _mm_max_ps(_mm_min_ps(_mm_sub_ps(one, _mm_max_ps(_mm_min_ps(between, one), zero)), one), intensity);
+	__m128 beyond = _mm_div_ps(_mm_add_ps(_mm_sub_ps(_mm_mul_ps(z1, z2), _mm_mul_ps(b.x, _mm_add_ps(z1, z2))), b.y),
+		_mm_mul_ps(_mm_sub_ps(z0, z1), _mm_sub_ps(z0, z2)));
+	beyond = _mm_max_ps(_mm_min_ps(_mm_sub_ps(one, _mm_max_ps(_mm_min_ps(_mm_sub_ps(one, beyond), one), zero)), one), intensity);
+
+	return select(_mm_cmple_ps(z0, z1), one, select(_mm_cmple_ps(z0, z2), between, beyond));
+
+}
+
+void HardShadowReference::computeHardShadows(ShadowParams shadowParams, float *shadows) {
+
+	//MyGLGeometryViewer::configureShadow falls back to the bilinear loop for kernels wider than the weight table
+	bool separable = (shadowParams.gatherPCF || shadowParams.optimizedPCF) && shadowParams.kernelOrder <= MAX_PCF_ORDER && filter;
+	if((shadowParams.gatherPCF || shadowParams.optimizedPCF) && !separable)
+		shadowParams.bilinearPCF = true;
+
+	#pragma omp parallel for schedule(dynamic)
+	for(int y = 0; y < height; y++) {
+		for(int x = 0; x < width; x += 4) {
+
+			int numberOfPixels = (width - x < 4) ? width - x : 4;
+			PixelQuad vertex, normal, shadowCoord, normalizedShadowCoord;
+			loadPixels(vertexMap, x, y, numberOfPixels, &vertex);
+			loadPixels(normalMap, x, y, numberOfPixels, &normal);
+			__m128 background = _mm_cmpeq_ps(vertex.x, _mm_setzero_ps());
+
+			computeShadowCoords(&vertex, &shadowParams, &shadowCoord);
+			normalizedShadowCoord.x = _mm_div_ps(shadowCoord.x, shadowCoord.w);
+			normalizedShadowCoord.y = _mm_div_ps(shadowCoord.y, shadowCoord.w);
+			normalizedShadowCoord.z = _mm_div_ps(shadowCoord.z, shadowCoord.w);
+			normalizedShadowCoord.w = _mm_set1_ps(1.0f);
+			__m128 shadow = computePreEvaluation(&vertex, &normal, shadowParams.shadowIntensity);
+			__m128 tested = _mm_andnot_ps(background, _mm_and_ps(_mm_cmpgt_ps(shadowCoord.w, _mm_setzero_ps()), _mm_cmpeq_ps(shadow, _mm_set1_ps(1.0f))));
+
+			if(_mm_movemask_ps(tested)) {
+				//lanes that are not tested look up the map origin instead of their undefined coordinates
+				normalizedShadowCoord.x = _mm_and_ps(tested, normalizedShadowCoord.x);
+				normalizedShadowCoord.y = _mm_and_ps(tested, normalizedShadowCoord.y);
+				normalizedShadowCoord.z = _mm_and_ps(tested, normalizedShadowCoord.z);
+				__m128 filtered;
+				if(shadowParams.naive) filtered = naive(&normalizedShadowCoord, &shadowParams, numberOfPixels);
+				else if(shadowParams.VSM) filtered = varianceShadowMapping(&normalizedShadowCoord, &shadowParams, numberOfPixels);
+				else if(shadowParams.ESM) filtered = exponentialShadowMapping(&normalizedShadowCoord, &shadowParams, numberOfPixels);
+				else if(shadowParams.EVSM) filtered = exponentialVarianceShadowMapping(&normalizedShadowCoord, &shadowParams, numberOfPixels);
+				else if(shadowParams.MSM) filtered = hamburger4MSM(&normalizedShadowCoord, &shadowParams, numberOfPixels);
+				else if(separable) filtered = separablePCF(&normalizedShadowCoord, &shadowParams, numberOfPixels);
+				else filtered = PCF(&normalizedShadowCoord, &shadowParams, numberOfPixels);
+				shadow = select(tested, filtered, shadow);
+			}
+
+			//the background is discarded by the shader and keeps the clear color
+			shadow = _mm_andnot_ps(background, shadow);
+			float result[4];
+			_mm_storeu_ps(result, shadow);
+			for(int lane = 0; lane < numberOfPixels; lane++)
+				shadows[y * width + x + lane] = result[lane];
+
+		}
+	}
+
+}
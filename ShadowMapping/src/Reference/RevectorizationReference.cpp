@@ -0,0 +1,593 @@
+#include "Reference\RevectorizationReference.h"
+
+#define LEFT 1
+#define RIGHT 2
+#define BOTTOM 4
+#define TOP 8
+#define ALL_NEIGHBOURS (LEFT | RIGHT | BOTTOM | TOP)
+
+RevectorizationReference::RevectorizationReference() : HardShadowReference() {
+
+	conservative = filtered = kernel = false;
+	shadowMapStep[0] = shadowMapStep[1] = 0.0f;
+	depthThreshold = 0.0f;
+	shadowIntensity = 0.0f;
+	maxSearch = 0;
+	samplesPerPixel = 1;
+	discontinuityTime = searchTime = revectorizationTime = discontinuityMapTime = 0.0;
+	numberOfPixels = numberOfSamples = numberOfSearches = 0;
+	fetches = discontinuityMapFetches = 0;
+	discontinuityMap = 0;
+
+}
+
+RevectorizationReference::~RevectorizationReference() {
+
+	free(discontinuityMap);
+
+}
+
+void RevectorizationReference::allocateBatch(RevectorizationBatch *batch, int numberOfPixels, int numberOfSamples) {
+
+	batch->s = (float*)malloc(numberOfSamples * sizeof(float));
+	batch->t = (float*)malloc(numberOfSamples * sizeof(float));
+	batch->z = (float*)malloc(numberOfSamples * sizeof(float));
+	batch->lit = (unsigned char*)malloc(numberOfSamples * sizeof(unsigned char));
+	batch->neighbours = (unsigned char*)malloc(numberOfSamples * sizeof(unsigned char));
+	batch->search = (int*)malloc(numberOfSamples * sizeof(int));
+	batch->searchList = (int*)malloc(numberOfSamples * sizeof(int));
+	batch->searchDistances = (float*)malloc(numberOfSamples * 4 * sizeof(float));
+	batch->pixelShadow = (float*)malloc(numberOfPixels * sizeof(float));
+	batch->pixelTested = (unsigned char*)malloc(numberOfPixels * sizeof(unsigned char));
+	batch->rowSearches = (int*)malloc(height * sizeof(int));
+
+}
+
+void RevectorizationReference::freeBatch(RevectorizationBatch *batch) {
+
+	free(batch->s);
+	free(batch->t);
+	free(batch->z);
+	free(batch->lit);
+	free(batch->neighbours);
+	free(batch->search);
+	free(batch->searchList);
+	free(batch->searchDistances);
+	free(batch->pixelShadow);
+	free(batch->pixelTested);
+	free(batch->rowSearches);
+
+}
+
+float RevectorizationReference::testDepth(float s, float t, float z, int *fetches) {
+
+	(*fetches)++;
+	return (z <= fetchNearest(s, t)) ? 1.0f : 0.0f;
+
+}
+
+unsigned char RevectorizationReference::testNeighbours(float s, float t, float z, int *fetches) {
+
+	//the coordinate walks around the texel as in getDisc and computeDiscontinuity, so the lookups round the same way
+	unsigned char neighbours = 0;
+	s -= shadowMapStep[0];
+	if(testDepth(s, t, z, fetches) == 1.0f) neighbours |= LEFT;
+	s += 2.0f * shadowMapStep[0];
+	if(testDepth(s, t, z, fetches) == 1.0f) neighbours |= RIGHT;
+	s -= shadowMapStep[0];
+	t += shadowMapStep[1];
+	if(testDepth(s, t, z, fetches) == 1.0f) neighbours |= BOTTOM;
+	t -= 2.0f * shadowMapStep[1];
+	if(testDepth(s, t, z, fetches) == 1.0f) neighbours |= TOP;
+	return neighbours;
+
+}
+
+bool RevectorizationReference::needsSearch(unsigned char lit, unsigned char neighbours) {
+
+	if(conservative) {
+		//only lit samples next to the umbra are revectorized, and SMSR keeps the umbra of texels between two shadowed neighbours
+		unsigned char umbra = ~neighbours & ALL_NEIGHBOURS;
+		if(!lit) return false;
+		if(kernel) return (umbra & (LEFT | RIGHT)) != 0;
+		return umbra != 0 && (umbra & (LEFT | RIGHT)) != (LEFT | RIGHT) && (umbra & (BOTTOM | TOP)) != (BOTTOM | TOP);
+	}
+
+	//neighbours whose depth test differs from the center, and SMSR inverts isolated texels instead of searching
+	unsigned char discontinuity = neighbours ^ ((lit) ? ALL_NEIGHBOURS : 0);
+	if(!kernel && discontinuity == ALL_NEIGHBOURS) return false;
+	return discontinuity != 0;
+
+}
+
+void RevectorizationReference::computeDiscontinuity(unsigned char lit, unsigned char neighbours, float *discontinuity) {
+
+	//the (r, g, b) color of computeDiscontinuity: 0.5 for left and bottom, 0.25 for right and top, 0.75 for both, and the entering
+	//or exiting discontinuity type
+	unsigned char changed = neighbours ^ ((lit) ? ALL_NEIGHBOURS : 0);
+	discontinuity[0] = (2.0f * ((changed & LEFT) ? 1.0f : 0.0f) + ((changed & RIGHT) ? 1.0f : 0.0f)) / 4.0f;
+	discontinuity[1] = (2.0f * ((changed & BOTTOM) ? 1.0f : 0.0f) + ((changed & TOP) ? 1.0f : 0.0f)) / 4.0f;
+	discontinuity[2] = (lit) ? 0.0f : 1.0f;
+
+}
+
+bool RevectorizationReference::hasDiscontinuity(float s, float t, float z, float discType, int *fetches) {
+
+	//getDisc for the end of an edge: whether any of the four neighbours is in the state discType
+	s -= shadowMapStep[0];
+	if(testDepth(s, t, z, fetches) == discType) return true;
+	s += 2.0f * shadowMapStep[0];
+	if(testDepth(s, t, z, fetches) == discType) return true;
+	s -= shadowMapStep[0];
+	t += shadowMapStep[1];
+	if(testDepth(s, t, z, fetches) == discType) return true;
+	t -= 2.0f * shadowMapStep[1];
+	return testDepth(s, t, z, fetches) == discType;
+
+}
+
+bool RevectorizationReference::continuesDiscontinuity(float s, float t, float z, int dirX, int dirY, float *discontinuity, float *newDepth, int *fetches) {
+
+	//getDisc along an edge: the neighbours across the search direction that the starting texel had a discontinuity with.
+	//For exiting discontinuities the depth is biased by each comparison close to the map, and the last one is kept in newDepth
+	float offsets[4][2] = {{-shadowMapStep[0], 0.0f}, {shadowMapStep[0], 0.0f}, {0.0f, shadowMapStep[1]}, {0.0f, -shadowMapStep[1]}};
+	*newDepth = z;
+
+	for(int neighbour = 0; neighbour < 4; neighbour++) {
+
+		bool horizontal = neighbour < 2;
+		if((horizontal && dirX != 0) || (!horizontal && dirY != 0)) continue;
+		float color = discontinuity[(horizontal) ? 0 : 1];
+		//the first neighbour of each axis is marked with 0.5 and the second one with 0.25
+		if(color != 0.75f && color != ((neighbour % 2 == 0) ? 0.5f : 0.25f)) continue;
+
+		float distanceFromLight = fetchNearest(s + offsets[neighbour][0], t + offsets[neighbour][1]);
+		(*fetches)++;
+		if(discontinuity[2] == 1.0f && fabsf(z - distanceFromLight) < depthThreshold) {
+			z -= depthThreshold;
+			*newDepth = z;
+		}
+		float lit = (z <= distanceFromLight) ? 1.0f : 0.0f;
+		if(lit == discontinuity[2]) return true;
+
+	}
+
+	return false;
+
+}
+
+float RevectorizationReference::computeDiscontinuityLength(float s, float t, float z, float *discontinuity, int dirX, int dirY, float subCoord, int *fetches) {
+
+	//computeDiscontinuityLength of the non-conservative and filtered shaders: walks the edge until its end, where the sign tells
+	//whether the edge closes there, or until the discontinuity stops
+	float stepS = dirX * shadowMapStep[0], stepT = dirY * shadowMapStep[1];
+	float foundEdgeEnd = 0.0f, dist = 0.0f, newDepth = z;
+	s += stepS;
+	t += stepT;
+
+	for(int it = 0; it < maxSearch; it++) {
+
+		float distanceFromLight = fetchNearest(s, t);
+		(*fetches)++;
+		if(discontinuity[2] == 0.0f && fabsf(z - distanceFromLight) < depthThreshold)
+			z -= depthThreshold;
+
+		float center = (z <= distanceFromLight) ? 1.0f : 0.0f;
+		if(center == discontinuity[2]) {
+			foundEdgeEnd = (hasDiscontinuity(s, t, z, discontinuity[2], fetches)) ? 1.0f : 0.0f;
+			break;
+		} else if(!continuesDiscontinuity(s, t, z, dirX, dirY, discontinuity, &newDepth, fetches))
+			break;
+
+		dist++;
+		s += stepS;
+		t += stepT;
+		if(discontinuity[2] == 1.0f)
+			z = newDepth;
+
+	}
+
+	float length = dist + (1.0f - subCoord);
+	return (foundEdgeEnd == 1.0f) ? length : -length;
+
+}
+
+float RevectorizationReference::walkSilhouette(float s, float t, float z, int dirX, int dirY, bool *foundSilhouetteEnd, int *fetches) {
+
+	//walkSilhouette of the conservative shader: the number of lit texels on the silhouette until the umbra or until no
+	//neighbour is in shadow anymore
+	float stepS = dirX * shadowMapStep[0], stepT = dirY * shadowMapStep[1];
+	float distance = 0.0f;
+	*foundSilhouetteEnd = false;
+	s += stepS;
+	t += stepT;
+
+	for(int it = 0; it < maxSearch; it++) {
+
+		float distanceFromLight = fetchNearest(s, t);
+		(*fetches)++;
+		if(fabsf(z - distanceFromLight) < depthThreshold)
+			z -= depthThreshold;
+
+		if(!(z <= distanceFromLight)) {
+			*foundSilhouetteEnd = true;
+			break;
+		} else if(testNeighbours(s, t, z, fetches) == ALL_NEIGHBOURS)
+			break;
+
+		distance++;
+		s += stepS;
+		t += stepT;
+
+	}
+
+	return distance;
+
+}
+
+float RevectorizationReference::computeRelativeDistance(float s, float t, float z, int dirX, int dirY, float subCoord, int *fetches) {
+
+	bool foundSilhouetteEnd;
+	float distance = walkSilhouette(s, t, z, dirX, dirY, &foundSilhouetteEnd, fetches) + (1.0f - subCoord);
+	return (foundSilhouetteEnd) ? distance : -distance;
+
+}
+
+unsigned short* RevectorizationReference::lookupDiscontinuityMap(float s, float t) {
+
+	//GL_NEAREST with a zero border, which reads as a texel without discontinuities
+	static unsigned short border[4] = {0, 0, 0, 0};
+	int x = (int)floorf(s * shadowMapWidth);
+	int y = (int)floorf(t * shadowMapHeight);
+	if(x < 0 || y < 0 || x >= shadowMapWidth || y >= shadowMapHeight)
+		return border;
+	return discontinuityMap + (y * shadowMapWidth + x) * 4;
+
+}
+
+unsigned char RevectorizationReference::readNeighbours(unsigned short *texel, int *fetches) {
+
+	//the left, right, down and up channels flag the shadowed neighbours; down is the top neighbour at -y
+	(*fetches)++;
+	unsigned char umbra = 0;
+	if(texel[0] >= 512) umbra |= LEFT;
+	if(texel[1] >= 512) umbra |= RIGHT;
+	if(texel[2] >= 512) umbra |= TOP;
+	if(texel[3] >= 512) umbra |= BOTTOM;
+	return ~umbra & ALL_NEIGHBOURS;
+
+}
+
+void RevectorizationReference::computeDiscontinuityMap() {
+
+	//DiscontinuityMap.frag: the discontinuity and the silhouette walks of a receiver at the depth of each texel. The walks are
+	//stored as lengths plus 256 when they end in the umbra, and the shadowed neighbours add 512 to their direction
+	discontinuityMap = (unsigned short*)malloc(shadowMapWidth * shadowMapHeight * 4 * sizeof(unsigned short));
+	int fetches = 0;
+	double time = omp_get_wtime();
+
+	#pragma omp parallel for schedule(dynamic) reduction(+:fetches)
+	for(int y = 0; y < shadowMapHeight; y++) {
+		for(int x = 0; x < shadowMapWidth; x++) {
+
+			float s = (x + 0.5f) / shadowMapWidth, t = (y + 0.5f) / shadowMapHeight;
+			float z = fetchNearest(s, t);
+			int texelFetches = 1;
+			unsigned char umbra = ~testNeighbours(s, t, z, &texelFetches) & ALL_NEIGHBOURS;
+			unsigned short *texel = discontinuityMap + (y * shadowMapWidth + x) * 4;
+			int directions[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+			unsigned char neighbours[4] = {LEFT, RIGHT, TOP, BOTTOM};
+
+			for(int direction = 0; direction < 4; direction++) {
+				texel[direction] = (umbra & neighbours[direction]) ? 512 : 0;
+				if(!umbra) continue;
+				bool foundSilhouetteEnd;
+				texel[direction] += (unsigned short)walkSilhouette(s, t, z, directions[direction][0], directions[direction][1], &foundSilhouetteEnd, &texelFetches);
+				if(foundSilhouetteEnd) texel[direction] += 256;
+			}
+			fetches += texelFetches;
+
+		}
+	}
+
+	discontinuityMapTime = omp_get_wtime() - time;
+	discontinuityMapFetches = fetches;
+
+}
+
+float RevectorizationReference::estimateRelativePosition(float x, float y, float shadow) {
+
+	float T = 1.0f;
+	if(x < 0.0f && y < 0.0f) T = 0.0f;
+	if(x > 0.0f && y > 0.0f) T = -2.0f;
+
+	float edgeLength = fminf(fabsf(x) + fabsf(y), (float)maxSearch);
+	float position = fabsf(fmaxf(T * x, T * y));
+	if(conservative) return position / edgeLength;
+	if(filtered) return (T * position) / edgeLength;
+	return (fmaxf(T, 2.0f * shadow - 1.0f) * position) / edgeLength;
+
+}
+
+float RevectorizationReference::revectorizeShadow(float *r, float shadow) {
+
+	if(conservative)
+		return (r[0] * r[1] > 0.0f && 1.0f - r[0] > r[1]) ? shadowIntensity : 1.0f;
+
+	if(filtered) {
+		if(r[0] * r[1] < 0.0f) return (1.0f - shadow) + (2.0f * shadow - 1.0f) * fmaxf(r[0], r[1]);
+		else if(r[0] * r[1] == 0.0f) return shadow;
+		float value = (1.0f - shadow) + (2.0f * shadow - 1.0f) * (r[0] + r[1]);
+		return fminf(fmaxf(value, 0.0f), 1.0f);
+	}
+
+	if((r[0] * r[1] == 2.0f * shadow) ||
+		((fabsf(r[0]) * fabsf(r[1]) > 0.0f) && ((1.0f - shadow) + (2.0f * shadow - 1.0f) * (fabsf(r[0]) + fabsf(r[1])) < 0.5f)))
+		return 0.0f;
+	return 1.0f;
+
+}
+
+float RevectorizationReference::computeShadow(RevectorizationBatch *batch, int sample) {
+
+	float shadow = (batch->lit[sample]) ? 1.0f : 0.0f;
+	int search = batch->search[sample];
+
+	if(conservative) {
+		if(shadow == 0.0f) return shadowIntensity;
+		if(search < 0) {
+			//SMSR keeps the umbra of texels with a shadowed neighbour that are not searched
+			unsigned char umbra = ~batch->neighbours[sample] & ALL_NEIGHBOURS;
+			return (!kernel && umbra != 0) ? shadowIntensity : 1.0f;
+		}
+	}
+
+	float value = shadow;
+	if(search >= 0) {
+		float *distances = batch->searchDistances + search * 4;
+		float r[2] = {estimateRelativePosition(distances[0], distances[1], shadow), estimateRelativePosition(distances[2], distances[3], shadow)};
+		value = revectorizeShadow(r, shadow);
+		if(conservative) return value;
+	} else if(!kernel && (batch->neighbours[sample] ^ ((shadow == 1.0f) ? ALL_NEIGHBOURS : 0)) == ALL_NEIGHBOURS)
+		value = 1.0f - shadow;
+
+	return value * (1.0f - shadowIntensity) + shadowIntensity;
+
+}
+
+void RevectorizationReference::detectDiscontinuities(RevectorizationBatch *batch, ShadowParams *shadowParams, int firstRow, int numberOfRows) {
+
+	//the kernel taps of computeShadowFromAccurateRPCF and computeShadowFromRPCF, with the same float accumulation. SMSR takes
+	//the single tap at offset 0
+	float incrWidth = 1.0f / (float)shadowParams->shadowMapWidth;
+	float incrHeight = 1.0f / (float)shadowParams->shadowMapHeight;
+	float offset = (kernel) ? (float)shadowParams->penumbraSize : 0.0f;
+	float stepSize = (kernel) ? 2 * offset / (float)shadowParams->kernelOrder : 1.0f;
+
+	int fetches = 0;
+
+	#pragma omp parallel for schedule(dynamic) reduction(+:fetches)
+	for(int row = 0; row < numberOfRows; row++) {
+
+		int y = firstRow + row;
+		int searches = 0;
+		for(int x = 0; x < width; x += 4) {
+
+			int numberOfPixels = (width - x < 4) ? width - x : 4;
+			PixelQuad vertex, normal, shadowCoord;
+			loadPixels(vertexMap, x, y, numberOfPixels, &vertex);
+			loadPixels(normalMap, x, y, numberOfPixels, &normal);
+			__m128 background = _mm_cmpeq_ps(vertex.x, _mm_setzero_ps());
+			computeShadowCoords(&vertex, shadowParams, &shadowCoord);
+			__m128 shadow = computePreEvaluation(&vertex, &normal, shadowParams->shadowIntensity);
+			__m128 tested = _mm_andnot_ps(background, _mm_and_ps(_mm_cmpgt_ps(shadowCoord.w, _mm_setzero_ps()), _mm_cmpeq_ps(shadow, _mm_set1_ps(1.0f))));
+
+			float s[4], t[4], z[4], preEvaluation[4];
+			_mm_storeu_ps(s, _mm_div_ps(shadowCoord.x, shadowCoord.w));
+			_mm_storeu_ps(t, _mm_div_ps(shadowCoord.y, shadowCoord.w));
+			_mm_storeu_ps(z, _mm_div_ps(shadowCoord.z, shadowCoord.w));
+			_mm_storeu_ps(preEvaluation, _mm_andnot_ps(background, shadow));
+			int testedLanes = _mm_movemask_ps(tested);
+
+			for(int lane = 0; lane < numberOfPixels; lane++) {
+
+				int pixel = row * width + x + lane;
+				batch->pixelShadow[pixel] = preEvaluation[lane];
+				batch->pixelTested[pixel] = (testedLanes >> lane) & 1;
+				if(!batch->pixelTested[pixel]) continue;
+
+				int sample = pixel * samplesPerPixel;
+				for(float w = -offset; w <= offset; w += stepSize) {
+					for(float h = -offset; h <= offset; h += stepSize) {
+
+						float sampleS = s[lane] + w * incrWidth;
+						float sampleT = t[lane] + h * incrHeight;
+						batch->s[sample] = sampleS;
+						batch->t[sample] = sampleT;
+						batch->z[sample] = z[lane];
+						batch->lit[sample] = (unsigned char)testDepth(sampleS, sampleT, z[lane], &fetches);
+						//the conservative shader only looks around lit samples
+						if(conservative && !batch->lit[sample])
+							batch->neighbours[sample] = 0;
+						else if(discontinuityMap)
+							batch->neighbours[sample] = readNeighbours(lookupDiscontinuityMap(sampleS, sampleT), &fetches);
+						else
+							batch->neighbours[sample] = testNeighbours(sampleS, sampleT, z[lane], &fetches);
+						if(needsSearch(batch->lit[sample], batch->neighbours[sample])) searches++;
+						sample++;
+
+					}
+				}
+
+			}
+
+		}
+		batch->rowSearches[row] = searches;
+
+	}
+
+	this->fetches += fetches;
+
+}
+
+int RevectorizationReference::gatherSearches(RevectorizationBatch *batch, int numberOfRows) {
+
+	//exclusive prefix sum of the searches of each row, so every row writes its part of the list in sample order
+	int searches = 0;
+	for(int row = 0; row < numberOfRows; row++) {
+		int rowSearches = batch->rowSearches[row];
+		batch->rowSearches[row] = searches;
+		searches += rowSearches;
+	}
+
+	#pragma omp parallel for
+	for(int row = 0; row < numberOfRows; row++) {
+		int search = batch->rowSearches[row];
+		for(int pixel = row * width; pixel < (row + 1) * width; pixel++) {
+			if(!batch->pixelTested[pixel]) continue;
+			for(int sample = pixel * samplesPerPixel; sample < (pixel + 1) * samplesPerPixel; sample++) {
+				if(needsSearch(batch->lit[sample], batch->neighbours[sample])) {
+					batch->search[sample] = search;
+					batch->searchList[search++] = sample;
+				} else
+					batch->search[sample] = -1;
+			}
+		}
+	}
+
+	return searches;
+
+}
+
+void RevectorizationReference::searchDiscontinuities(RevectorizationBatch *batch, int searches) {
+
+	//the edge walks are the expensive and uneven part, so the list is handed out in small chunks
+	int fetches = 0;
+
+	#pragma omp parallel for schedule(dynamic, 64) reduction(+:fetches)
+	for(int search = 0; search < searches; search++) {
+
+		int sample = batch->searchList[search];
+		float s = batch->s[sample], t = batch->t[sample], z = batch->z[sample];
+		float x = s * (float)shadowMapWidth, y = t * (float)shadowMapHeight;
+		float subX = x - floorf(x), subY = y - floorf(y);
+		float *distances = batch->searchDistances + search * 4;
+
+		if(discontinuityMap) {
+			//the walks come with the texel read by the discontinuity detection
+			unsigned short *texel = lookupDiscontinuityMap(s, t);
+			float subCoords[4] = {1.0f - subX, subX, 1.0f - subY, subY};
+			for(int direction = 0; direction < 4; direction++) {
+				float distance = (float)(texel[direction] % 256) + (1.0f - subCoords[direction]);
+				distances[direction] = ((texel[direction] % 512) >= 256) ? distance : -distance;
+			}
+		} else if(conservative) {
+			distances[0] = computeRelativeDistance(s, t, z, -1, 0, 1.0f - subX, &fetches);
+			distances[1] = computeRelativeDistance(s, t, z, 1, 0, subX, &fetches);
+			distances[2] = computeRelativeDistance(s, t, z, 0, -1, 1.0f - subY, &fetches);
+			distances[3] = computeRelativeDistance(s, t, z, 0, 1, subY, &fetches);
+		} else {
+			float discontinuity[3];
+			computeDiscontinuity(batch->lit[sample], batch->neighbours[sample], discontinuity);
+			distances[0] = computeDiscontinuityLength(s, t, z, discontinuity, -1, 0, 1.0f - subX, &fetches);
+			distances[1] = computeDiscontinuityLength(s, t, z, discontinuity, 1, 0, subX, &fetches);
+			distances[2] = computeDiscontinuityLength(s, t, z, discontinuity, 0, -1, 1.0f - subY, &fetches);
+			distances[3] = computeDiscontinuityLength(s, t, z, discontinuity, 0, 1, subY, &fetches);
+		}
+
+	}
+
+	this->fetches += fetches;
+
+}
+
+int RevectorizationReference::revectorizeShadows(RevectorizationBatch *batch, int firstRow, int numberOfRows, float *shadows) {
+
+	int testedPixels = 0;
+
+	#pragma omp parallel for reduction(+:testedPixels)
+	for(int row = 0; row < numberOfRows; row++) {
+		for(int x = 0; x < width; x++) {
+
+			int pixel = row * width + x;
+			float shadow = batch->pixelShadow[pixel];
+			if(batch->pixelTested[pixel]) {
+				float illuminationCount = 0.0f;
+				for(int sample = pixel * samplesPerPixel; sample < (pixel + 1) * samplesPerPixel; sample++)
+					illuminationCount += computeShadow(batch, sample);
+				shadow = illuminationCount / (float)samplesPerPixel;
+				testedPixels++;
+			}
+			//the background is discarded by the shaders and keeps the clear color
+			shadows[(firstRow + row) * width + x] = shadow;
+
+		}
+	}
+
+	return testedPixels;
+
+}
+
+void RevectorizationReference::computeRevectorizedShadows(ShadowParams shadowParams, float *shadows) {
+
+	//RSMSS and RPCFPlusRSMSS run FilteredRBSM.frag, the others the conservative or the non-conservative SMSR shader
+	filtered = shadowParams.RSMSS || shadowParams.RPCFPlusRSMSS;
+	conservative = shadowParams.conservative && !filtered;
+	kernel = filtered || shadowParams.RPCFPlusSMSR;
+	shadowMapStep[0] = (float)(1.0 / shadowParams.shadowMapWidth);
+	shadowMapStep[1] = (float)(1.0 / shadowParams.shadowMapHeight);
+	depthThreshold = shadowParams.depthThreshold;
+	shadowIntensity = shadowParams.shadowIntensity;
+	maxSearch = shadowParams.maxSearch;
+
+	samplesPerPixel = 1;
+	if(kernel) {
+		float offset = (float)shadowParams.penumbraSize;
+		float stepSize = 2 * offset / (float)shadowParams.kernelOrder;
+		int taps = 0;
+		for(float w = -offset; w <= offset; w += stepSize) taps++;
+		samplesPerPixel = taps * taps;
+	}
+
+	int rowsPerBatch = MAX_BATCH_SAMPLES / (width * samplesPerPixel);
+	if(rowsPerBatch < 1) rowsPerBatch = 1;
+	if(rowsPerBatch > height) rowsPerBatch = height;
+	RevectorizationBatch batch;
+	allocateBatch(&batch, rowsPerBatch * width, rowsPerBatch * width * samplesPerPixel);
+
+	discontinuityTime = searchTime = revectorizationTime = discontinuityMapTime = 0.0;
+	numberOfPixels = numberOfSamples = numberOfSearches = 0;
+	fetches = discontinuityMapFetches = 0;
+
+	//the discontinuity map only describes receivers lit by a texel, which are the only ones the conservative shader looks around.
+	//Its walks are stored in 8 bits, so longer searches run per sample as in the camera pass
+	free(discontinuityMap);
+	discontinuityMap = 0;
+	if(shadowParams.useDiscontinuityMap && conservative && maxSearch <= MAX_DISCONTINUITY_MAP_SEARCH)
+		computeDiscontinuityMap();
+
+	for(int firstRow = 0; firstRow < height; firstRow += rowsPerBatch) {
+
+		int numberOfRows = (height - firstRow < rowsPerBatch) ? height - firstRow : rowsPerBatch;
+
+		double time = omp_get_wtime();
+		detectDiscontinuities(&batch, &shadowParams, firstRow, numberOfRows);
+		int searches = gatherSearches(&batch, numberOfRows);
+		discontinuityTime += omp_get_wtime() - time;
+
+		time = omp_get_wtime();
+		searchDiscontinuities(&batch, searches);
+		searchTime += omp_get_wtime() - time;
+
+		time = omp_get_wtime();
+		int testedPixels = revectorizeShadows(&batch, firstRow, numberOfRows, shadows);
+		numberOfPixels += testedPixels;
+		numberOfSamples += testedPixels * samplesPerPixel;
+		revectorizationTime += omp_get_wtime() - time;
+		numberOfSearches += searches;
+
+	}
+
+	freeBatch(&batch);
+
+}
@@ -33,6 +33,8 @@ void MyGLGeometryViewer::configureGBuffer(ShadowParams shadowParams) {
 	glUniform1i(normalMap, 9);
 	GLuint colorMap = glGetUniformLocation(shaderProg, "colorMap");
 	glUniform1i(colorMap, 10);
+	GLuint inverseGBufferMVPID = glGetUniformLocation(shaderProg, "inverseGBufferMVP");
+	glUniformMatrix4fv(inverseGBufferMVPID, 1, GL_FALSE, &shadowParams.inverseGBufferMVP[0][0]);
 	if(shadowParams.useHardShadowMap) {
 		GLuint hardShadowMap = glGetUniformLocation(shaderProg, "hardShadowMap");
 		glUniform1i(hardShadowMap, 11);
@@ -142,6 +144,11 @@ void MyGLGeometryViewer::configureShadow(ShadowParams shadowParams)
 	bias[2][0] = 0;		bias[2][1] = 0;		bias[2][2] = 0.5;	bias[2][3] = 0.0;
 	bias[3][0] = 0.5;	bias[3][1] = 0.5;	bias[3][2] = 0.5;	bias[3][3] = 1.0;
 
+	//kernels wider than the weight table fall back to the bilinear PCF loop
+	bool separablePCF = (shadowParams.gatherPCF || shadowParams.optimizedPCF) && shadowParams.kernelOrder <= MAX_PCF_ORDER;
+	if((shadowParams.gatherPCF || shadowParams.optimizedPCF) && !separablePCF)
+		shadowParams.bilinearPCF = true;
+
 	shadowParams.lightMVP = bias * shadowParams.lightMVP;
 	GLuint lightMVPID = glGetUniformLocation(shaderProg, "lightMVP");
 	glUniformMatrix4fv(lightMVPID, 1, GL_FALSE, &shadowParams.lightMVP[0][0]);
@@ -161,11 +168,20 @@ void MyGLGeometryViewer::configureShadow(ShadowParams shadowParams)
 	glUniform1i(shadowMapBilinearID, shadowParams.bilinearPCF);
 	GLuint shadowMapTriCubicID = glGetUniformLocation(shaderProg, "tricubicPCF");
 	glUniform1i(shadowMapTriCubicID, shadowParams.tricubicPCF);
+	GLuint shadowMapGatherID = glGetUniformLocation(shaderProg, "gatherPCF");
+	glUniform1i(shadowMapGatherID, separablePCF && shadowParams.gatherPCF);
+	GLuint shadowMapOptimizedID = glGetUniformLocation(shaderProg, "optimizedPCF");
+	glUniform1i(shadowMapOptimizedID, separablePCF && shadowParams.optimizedPCF);
+	if(separablePCF) {
+		GLuint pcfWeightsID = glGetUniformLocation(shaderProg, "pcfWeights");
+		glUniform1fv(pcfWeightsID, shadowParams.kernelOrder, shadowParams.pcfWeights);
+	}
 	GLuint shadowMapESMID = glGetUniformLocation(shaderProg, "ESM");
 	glUniform1i(shadowMapESMID, shadowParams.ESM);
 	GLuint shadowMapEVSMID = glGetUniformLocation(shaderProg, "EVSM");
 	glUniform1i(shadowMapEVSMID, shadowParams.EVSM);
 	configureMoments(shadowParams);
+	configureCascades(shadowParams);
 	GLuint shadowMapNaiveID = glGetUniformLocation(shaderProg, "naive");
 	glUniform1i(shadowMapNaiveID, shadowParams.naive);
 	GLuint kernelOrderID = glGetUniformLocation(shaderProg, "kernelOrder");
@@ -174,12 +190,19 @@ void MyGLGeometryViewer::configureShadow(ShadowParams shadowParams)
 	glUniform1i(penumbraSizeID, shadowParams.penumbraSize);
 	GLuint shadowMap = glGetUniformLocation(shaderProg, "shadowMap");
 	glUniform1i(shadowMap, 0);
+	GLuint shadowMapCompare = glGetUniformLocation(shaderProg, "shadowMapCompare");
+	glUniform1i(shadowMapCompare, 12);
 
 	configureLinearization();
 
 	glActiveTexture(GL_TEXTURE0);
 	glBindTexture(GL_TEXTURE_2D, shadowParams.shadowMap);
 
+	//the same depth map, read through a sampler object that compares it with the lookup depth
+	glActiveTexture(GL_TEXTURE12);
+	glBindTexture(GL_TEXTURE_2D, shadowParams.shadowMap);
+	glBindSampler(12, shadowParams.shadowMapSampler);
+
 	glActiveTexture(GL_TEXTURE0);
 	glDisable(GL_TEXTURE_2D);
 
@@ -188,15 +211,8 @@ void MyGLGeometryViewer::configureShadow(ShadowParams shadowParams)
 void MyGLGeometryViewer::configureMoments(ShadowParams shadowParams)
 {
 
-	glm::mat4 mQuantization, mQuantizationInverse;
-	
-	mQuantization[0][0] = -2.07224649;	mQuantization[0][1] = 32.2370378;	mQuantization[0][2] = -68.5710746;	mQuantization[0][3] = 39.3703274;
-	mQuantization[1][0] = 13.7948857;	mQuantization[1][1] = -59.4683976;	mQuantization[1][2] = 82.035975;	mQuantization[1][3] = -35.3649032;
-	mQuantization[2][0] = 0.105877704;	mQuantization[2][1] = -1.90774663;	mQuantization[2][2] = 9.34965551;	mQuantization[2][3] = -6.65434907;
-	mQuantization[3][0] = 9.79240621;	mQuantization[3][1] = -33.76521106;	mQuantization[3][2] = 47.9456097;	mQuantization[3][3] = -23.9728048;
-	
-	mQuantization = glm::transpose(mQuantization);
-	mQuantizationInverse = glm::inverse(mQuantization);
+	glm::mat4 mQuantization = computeMomentQuantization();
+	glm::mat4 mQuantizationInverse = glm::inverse(mQuantization);
 	
 	GLuint shadowMapVSMID = glGetUniformLocation(shaderProg, "VSM");
 	glUniform1i(shadowMapVSMID, shadowParams.VSM);
@@ -205,7 +221,7 @@ void MyGLGeometryViewer::configureMoments(ShadowParams shadowParams)
 
 	if(shadowParams.MSM) {
 		GLuint tQuantizationID = glGetUniformLocation(shaderProg, "tQuantization");
-		glUniform4f(tQuantizationID, 0.0359558848, 0.0, 0.0, 0.0);
+		glUniform4f(tQuantizationID, MSM_QUANTIZATION_OFFSET, 0.0, 0.0, 0.0);
 		GLuint mQuantizationID = glGetUniformLocation(shaderProg, "mQuantization");
 		glUniformMatrix4fv(mQuantizationID, 1, GL_FALSE, &mQuantization[0][0]);
 		GLuint mQuantizationInverseID = glGetUniformLocation(shaderProg, "mQuantizationInverse");
@@ -214,6 +230,32 @@ void MyGLGeometryViewer::configureMoments(ShadowParams shadowParams)
 
 }
 
+void MyGLGeometryViewer::configureCascades(ShadowParams shadowParams)
+{
+
+	GLuint cascadedShadowMapsID = glGetUniformLocation(shaderProg, "cascadedShadowMaps");
+	glUniform1i(cascadedShadowMapsID, shadowParams.cascadedShadowMaps);
+
+	if(shadowParams.cascadedShadowMaps) {
+		
+		//each cascade is stored in a quadrant of the shadow map, so the bias also scales and offsets into the atlas
+		glm::mat4 cascadeMVP[NUMBER_OF_CASCADES];
+		for(int cascade = 0; cascade < NUMBER_OF_CASCADES; cascade++) {
+			glm::mat4 atlas;
+			atlas[0][0] = 0.25;	atlas[1][1] = 0.25;	atlas[2][2] = 0.5;
+			atlas[3][0] = 0.25 + 0.5 * (cascade % 2);	atlas[3][1] = 0.25 + 0.5 * (cascade / 2);	atlas[3][2] = 0.5;
+			cascadeMVP[cascade] = atlas * shadowParams.cascadeMVP[cascade];
+		}
+
+		GLuint cascadeMVPID = glGetUniformLocation(shaderProg, "cascadeMVP");
+		glUniformMatrix4fv(cascadeMVPID, NUMBER_OF_CASCADES, GL_FALSE, &cascadeMVP[0][0][0]);
+		GLuint cascadeSplitsID = glGetUniformLocation(shaderProg, "cascadeSplits");
+		glUniform3f(cascadeSplitsID, shadowParams.cascadeSplits[0], shadowParams.cascadeSplits[1], shadowParams.cascadeSplits[2]);
+
+	}
+
+}
+
 void MyGLGeometryViewer::configureRevectorization(ShadowParams shadowParams, int imageWidth, int imageHeight)
 {
 
@@ -261,13 +303,21 @@ void MyGLGeometryViewer::configureRevectorization(ShadowParams shadowParams, int
 	glUniform1i(RPCFSubCoordID, shadowParams.RPCFPlusRSMSS);
 	GLuint EDTSMID = glGetUniformLocation(shaderProg, "EDTSM");
 	glUniform1i(EDTSMID, shadowParams.EDTSM);
+	GLuint useDiscontinuityMapID = glGetUniformLocation(shaderProg, "useDiscontinuityMap");
+	glUniform1i(useDiscontinuityMapID, shadowParams.useDiscontinuityMap);
+	configureCascades(shadowParams);
 	GLuint shadowID = glGetUniformLocation(shaderProg, "shadowMap");
 	glUniform1i(shadowID, 7);
+	GLuint discontinuityMapID = glGetUniformLocation(shaderProg, "discontinuityMap");
+	glUniform1i(discontinuityMapID, 13);
 	
 	glActiveTexture(GL_TEXTURE7);
 	glBindTexture(GL_TEXTURE_2D, shadowParams.shadowMap);
 	glGenerateMipmap(GL_TEXTURE_2D);
 
+	glActiveTexture(GL_TEXTURE13);
+	glBindTexture(GL_TEXTURE_2D, shadowParams.discontinuityMap);
+
 	glActiveTexture(GL_TEXTURE7);
 	glDisable(GL_TEXTURE_2D);
 
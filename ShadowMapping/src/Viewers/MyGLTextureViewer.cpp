@@ -55,6 +55,45 @@ void MyGLTextureViewer::loadRGBTexture(const unsigned char *data, GLuint *texVBO
 	
 }
 
+void MyGLTextureViewer::loadRGBTexture(Image *image, GLuint *texVBO, int index)
+{
+
+	if(image->getMipmaps() == NULL) {
+		loadRGBTexture(image->getData(), texVBO, index, image->getWidth(), image->getHeight());
+		return;
+	}
+
+	//the whole mip chain is staged in a single pixel unpack buffer, so the driver can copy it asynchronously
+	GLuint pixelBuffer;
+	glGenBuffers(1, &pixelBuffer);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer);
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, image->getMipmapsSize(), NULL, GL_STREAM_DRAW);
+	void *pixels = glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
+	memcpy(pixels, image->getMipmaps(), image->getMipmapsSize());
+	glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+	glBindTexture(GL_TEXTURE_2D, texVBO[index]);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, image->getNumberOfLevels() - 1);
+	glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+
+	for(int level = 0; level < image->getNumberOfLevels(); level++) {
+		GLvoid *offset = (GLvoid*)(image->getLevel(level) - image->getMipmaps());
+		if(image->isCompressed())
+			glCompressedTexImage2D(GL_TEXTURE_2D, level, GL_COMPRESSED_RGB_S3TC_DXT1_EXT, image->getLevelWidth(level), image->getLevelHeight(level), 0, image->getLevelSize(level), offset);
+		else
+			glTexImage2D(GL_TEXTURE_2D, level, GL_RGB8, image->getLevelWidth(level), image->getLevelHeight(level), 0, GL_RGB, GL_UNSIGNED_BYTE, offset);
+	}
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	glDeleteBuffers(1, &pixelBuffer);
+
+}
+
 void MyGLTextureViewer::loadRGBTexture(float *data, GLuint *texVBO, int index, int imageWidth, int imageHeight, GLint params)
 {
 
@@ -88,6 +127,45 @@ void MyGLTextureViewer::loadRGBATexture(float *data, GLuint *texVBO, int index,
 	
 }
 
+void MyGLTextureViewer::loadRGTexture(unsigned short *data, GLuint *texVBO, int index, int imageWidth, int imageHeight, GLint param)
+{
+
+	glBindTexture(GL_TEXTURE_2D, texVBO[index]);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, param);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, param);
+	glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16, imageWidth, imageHeight, 0, GL_RG, GL_UNSIGNED_SHORT, data);
+	
+}
+
+void MyGLTextureViewer::loadRGBATexture(unsigned char *data, GLuint *texVBO, int index, int imageWidth, int imageHeight, GLint param)
+{
+
+	glBindTexture(GL_TEXTURE_2D, texVBO[index]);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, param);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, param);
+	glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, imageWidth, imageHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+	
+}
+
+void MyGLTextureViewer::loadRGBATexture(unsigned short *data, GLuint *texVBO, int index, int imageWidth, int imageHeight, GLint param)
+{
+
+	glBindTexture(GL_TEXTURE_2D, texVBO[index]);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, param);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, param);
+	glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16, imageWidth, imageHeight, 0, GL_RGBA, GL_UNSIGNED_SHORT, data);
+	
+}
+
 void MyGLTextureViewer::loadFrameBufferTexture(int x, int y, int width, int height, unsigned char *frameBuffer) {
 
 	glReadPixels(x, y, width, height, GL_RGB, GL_UNSIGNED_BYTE, frameBuffer);
@@ -169,6 +247,28 @@ void MyGLTextureViewer::configureSeparableFilter(int order, bool horizontal, boo
 
 }
 
+void MyGLTextureViewer::configureSeparableFilter(int numberOfTaps, float *tapOffsets, float *tapWeights, bool horizontal, bool vertical)
+{
+
+	glUseProgram(shaderProg);
+
+	GLuint numberOfTapsID = glGetUniformLocation(shaderProg, "numberOfTaps");
+	glUniform1i(numberOfTapsID, numberOfTaps);
+	
+	GLuint horizontalID = glGetUniformLocation(shaderProg, "horizontal");
+	glUniform1i(horizontalID, (int)horizontal);
+	
+	GLuint verticalID = glGetUniformLocation(shaderProg, "vertical");
+	glUniform1i(verticalID, (int)vertical);
+
+	GLuint tapOffsetsID = glGetUniformLocation(shaderProg, "tapOffsets");
+	glUniform1fv(tapOffsetsID, numberOfTaps, tapOffsets);
+
+	GLuint tapWeightsID = glGetUniformLocation(shaderProg, "tapWeights");
+	glUniform1fv(tapWeightsID, numberOfTaps, tapWeights);
+
+}
+
 void MyGLTextureViewer::drawTextureQuad() 
 {
 
@@ -0,0 +1,67 @@
+#include "Viewers\ShadowMapCache.h"
+
+ShadowMapCache::ShadowMapCache()
+{
+
+	valid = false;
+	enabled = true;
+	hits = 0;
+	misses = 0;
+	currentKey.numberOfParameters = 0;
+	currentKey.overflow = false;
+
+}
+
+void ShadowMapCache::beginKey(glm::vec3 lightEye, glm::vec3 lightAt, glm::vec3 lightUp, int geometryVersion)
+{
+
+	currentKey.lightEye = lightEye;
+	currentKey.lightAt = lightAt;
+	currentKey.lightUp = lightUp;
+	currentKey.geometryVersion = geometryVersion;
+	currentKey.numberOfParameters = 0;
+	currentKey.overflow = false;
+
+}
+
+void ShadowMapCache::addParameter(float parameter)
+{
+
+	//a dropped parameter could match a stale key, so an overflowing key is never looked up
+	assert(currentKey.numberOfParameters < MAX_SHADOW_MAP_KEY_PARAMETERS);
+	if(currentKey.numberOfParameters < MAX_SHADOW_MAP_KEY_PARAMETERS)
+		currentKey.parameters[currentKey.numberOfParameters++] = parameter;
+	else
+		currentKey.overflow = true;
+
+}
+
+bool ShadowMapCache::isEqual(ShadowMapKey *a, ShadowMapKey *b)
+{
+
+	if(a->lightEye != b->lightEye || a->lightAt != b->lightAt || a->lightUp != b->lightUp)
+		return false;
+	if(a->geometryVersion != b->geometryVersion || a->numberOfParameters != b->numberOfParameters)
+		return false;
+	for(int p = 0; p < a->numberOfParameters; p++)
+		if(a->parameters[p] != b->parameters[p])
+			return false;
+	return true;
+
+}
+
+bool ShadowMapCache::lookup()
+{
+
+	//a hit means the light-space maps rendered for the cached key are still in their textures
+	if(enabled && valid && !currentKey.overflow && isEqual(&currentKey, &cachedKey)) {
+		hits++;
+		return true;
+	}
+
+	cachedKey = currentKey;
+	valid = enabled;
+	misses++;
+	return false;
+
+}
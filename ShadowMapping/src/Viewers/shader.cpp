@@ -1,5 +1,10 @@
 #include "Viewers\shader.h"
 
+//
+// Preprocessor lines prepended to every shader compiled by initShader
+//
+static const GLchar *shaderDefines = "";
+
 // ***********************************************************************
 // ***********************************************************************
 //
@@ -187,6 +192,63 @@ static int readShader(char *fileName, EShaderType shaderType, char *shaderText,
     return count;
 }
 
+// ***********************************************************************
+//
+// Replaces every #include "<file>" line of the shader source with the
+// contents of Shaders/<file>, so common GLSL functions are kept in a
+// single file. Included files may include other files. The source
+// buffer is released and the expanded buffer is returned.
+//
+// ***********************************************************************
+static GLchar *resolveIncludes(GLchar *source) {
+
+    FILE *fh;
+    char name[256];
+    char *directive, *begin, *end, *lineEnd;
+    GLchar *expanded;
+    int includeSize, prefixSize, count;
+
+    directive = strstr(source, "#include");
+    if (directive == NULL)
+        return source;
+
+    begin = strchr(directive, '"');
+    end = (begin != NULL) ? strchr(begin + 1, '"') : NULL;
+    if (end == NULL)
+    {
+        printf("ERROR: malformed #include directive\n");
+        exit(1);
+    }
+
+    strcpy(name, "Shaders/");
+    strncat(name, begin + 1, end - begin - 1);
+
+    fh = fopen(name, "r");
+    if (!fh)
+    {
+        printf("Cannot read the include file %s\n", name);
+        exit(0);
+    }
+    fseek(fh, 0, SEEK_END);
+    includeSize = (int) ftell(fh);
+    fseek(fh, 0, SEEK_SET);
+
+    lineEnd = strchr(end, '\n');
+    if (lineEnd == NULL)
+        lineEnd = end + strlen(end);
+    prefixSize = (int) (directive - source);
+
+    expanded = (GLchar *) malloc(prefixSize + includeSize + strlen(lineEnd) + 2);
+    memcpy(expanded, source, prefixSize);
+    count = (int) fread(expanded + prefixSize, 1, includeSize, fh);
+    fclose(fh);
+    expanded[prefixSize + count] = '\n';
+    strcpy(expanded + prefixSize + count + 1, lineEnd);
+
+    free(source);
+    return resolveIncludes(expanded);
+}
+
 // ***********************************************************************
 // ***********************************************************************
 
@@ -223,6 +285,9 @@ int readShaderSource(char *fileName, GLchar **vertexShader, GLchar **fragmentSha
         return 0;
     }
 
+    *vertexShader = resolveIncludes(*vertexShader);
+    *fragmentShader = resolveIncludes(*fragmentShader);
+
     return 1;
 }
 
@@ -242,8 +307,10 @@ int installShaders(	const GLchar *shVertex,
 
     // Load source code strings into shaders
 
-    glShaderSource(shaderVS, 1, &shVertex, NULL);
-    glShaderSource(shaderFS, 1, &shFragment, NULL);
+    const GLchar *vertexSources[2] = {shaderDefines, shVertex};
+    const GLchar *fragmentSources[2] = {shaderDefines, shFragment};
+    glShaderSource(shaderVS, 2, vertexSources, NULL);
+    glShaderSource(shaderFS, 2, fragmentSources, NULL);
 
     // Compile the vertex shader, and print out
     // the compiler log file.
@@ -327,6 +394,15 @@ void getGlVersion( int *major, int *minor ) {
 /// ** 
 /// ***********************************************************************
 
+void setShaderDefines(const char *defines) {
+
+    shaderDefines = defines;
+}
+
+/// ***********************************************************************
+/// ** 
+/// ***********************************************************************
+
 void initShader(char* shaderName, int id ) {
 	
 int success = 0;
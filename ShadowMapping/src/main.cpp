@@ -26,6 +26,7 @@
 #include <GL/glew.h>
 #include <GL/glut.h>
 #include <stdio.h>
+#include <string.h>
 #include <cuda_gl_interop.h>
 #include <cuda.h>
 #include <cuda_runtime_api.h>
@@ -33,10 +34,13 @@
 #include "Viewers\MyGLGeometryViewer.h"
 #include "Viewers\shader.h"
 #include "Viewers\ShadowParams.h"
+#include "Viewers\ShadowMapCache.h"
 #include "IO\SceneLoader.h"
 #include "EDT\pba2D.h"
 #include "Mesh.h"
 #include "Filter.h"
+#include "Reference\HardShadowReference.h"
+#include "Reference\RevectorizationReference.h"
 #include <time.h>
 
 enum 
@@ -45,15 +49,18 @@ enum
 	SHADOW_MAP_COLOR = 1,
 	FILTER_X_MAP_DEPTH = 2,
 	FILTER_X_MAP_COLOR = 3,
-	FILTER_Y_MAP_DEPTH = 4,
-	FILTER_Y_MAP_COLOR = 5,
+	PREFILTER_X_MAP_COLOR = 4,
+	PREFILTER_Y_MAP_COLOR = 5,
 	GBUFFER_MAP_DEPTH = 6,
 	VERTEX_MAP_COLOR = 7,
 	NORMAL_MAP_COLOR = 8,
 	TEXTURE_MAP_COLOR = 9,
 	HARD_SHADOW_DEPTH = 10,
 	HARD_SHADOW_COLOR = 11,
-	POSITION_MAP_COLOR = 12
+	POSITION_MAP_COLOR = 12,
+	DEPTH_REDUCTION_MAP_COLOR = 13,
+	CASCADE_BOUNDS_MAP_COLOR = 14,
+	DISCONTINUITY_MAP_COLOR = 18
 };
 
 enum
@@ -71,16 +78,23 @@ enum
 	NON_CONSERVATIVE_RBSM_SHADER = 10,
 	FILTERED_RBSM_SHADER = 11,
 	GBUFFER_SHADER = 12,
-	PHONG_SHADING_SHADER = 13
+	PHONG_SHADING_SHADER = 13,
+	DEPTH_REDUCTION_SHADER = 14,
+	CASCADE_BOUNDS_REDUCTION_SHADER = 15,
+	DISCONTINUITY_MAP_SHADER = 16
 };
 
 enum
 {
 	SHADOW_FRAMEBUFFER = 0,
 	FILTER_X_FRAMEBUFFER = 1,
-	FILTER_Y_FRAMEBUFFER = 2,
+	PREFILTER_X_FRAMEBUFFER = 2,
 	GBUFFER_FRAMEBUFFER = 3,
-	HARD_SHADOW_FRAMEBUFFER = 4
+	HARD_SHADOW_FRAMEBUFFER = 4,
+	DEPTH_REDUCTION_FRAMEBUFFER = 5,
+	CASCADE_BOUNDS_FRAMEBUFFER = 6,
+	DISCONTINUITY_MAP_FRAMEBUFFER = 7,
+	PREFILTER_Y_FRAMEBUFFER = 8
 };
 
 //Window size
@@ -99,10 +113,16 @@ char fileName[1000];
 MyGLTextureViewer myGLTextureViewer;
 MyGLGeometryViewer myGLGeometryViewer;
 ShadowParams shadowParams;
+ShadowMapCache shadowMapCache;
 
 Mesh *scene;
 SceneLoader *sceneLoader;
 Filter *gaussianFilter;
+bool linearSamplingFilter = true;
+bool prefilterBenchmark = false;
+bool pcfBenchmark = false;
+bool referenceComparison = false;
+bool revectorizationComparison = false;
 
 GLuint textures[20];
 GLuint sceneVBO[5];
@@ -122,7 +142,7 @@ glm::mat4 lightP;
 GLuint ProgramObject = 0;
 GLuint VertexShaderObject = 0;
 GLuint FragmentShaderObject = 0;
-GLuint shaderVS, shaderFS, shaderProg[15];
+GLuint shaderVS, shaderFS, shaderProg[20];
 GLint  linked;
 
 float translationVector[3] = {0.0, 0.0, 0.0};
@@ -141,6 +161,28 @@ bool stop = false;
 bool temp = false;
 int vel = 1;
 float animation = -1800;
+bool compressTextures = false;
+bool packedGBuffer = false;
+int geometryVersion = 0;
+
+//Cascaded shadow maps. The cascades are the quadrants of the shadow map, fitted to the receivers of the G-buffer
+bool cascadedShadowMaps = false;
+bool cascadeBenchmark = false;
+float cascadeSplitLambda = 0.5;
+int cascadeBorder = 16;
+glm::mat4 cascadeCrop[NUMBER_OF_CASCADES];
+
+//Receiver mask. Shadow map tiles that no G-buffer pixel projects into are not rasterized
+const int receiverMaskTiles = 32;
+bool receiverMaskOn = false;
+bool receiverMaskBenchmark = false;
+unsigned char receiverTiles[receiverMaskTiles * receiverMaskTiles];
+int receiverMaskVersion = 0;
+int skippedReceiverTiles = 0;
+
+//Discontinuity map. The conservative SMSR reads the discontinuities and silhouette walks of each shadow map texel from a pre-pass
+bool discontinuityMapOn = false;
+bool discontinuityMapBenchmark = false;
 
 //Euclidean Distance Transform
 cudaGraphicsResource_t CUDAGraphicsResource[3];
@@ -170,6 +212,12 @@ void calculateFPS()
         frameCount = 0;
 	
 		printf("FPS: %f\n", fps);
+		if(shadowMapCache.isEnabled()) {
+			printf("Shadow map cache: %d hits, %d misses\n", shadowMapCache.getHits(), shadowMapCache.getMisses());
+			shadowMapCache.resetCounters();
+		}
+		if(receiverMaskOn)
+			printf("Receiver mask: %.1f%% of the shadow map tiles skipped\n", 100.0f * skippedReceiverTiles / (receiverMaskTiles * receiverMaskTiles));
 	}
 
 }
@@ -218,10 +266,49 @@ void updateLight()
 
 }
 
-void displaySceneFromLightPOV()
+bool isShadowMapCached()
 {
 
-	glViewport(0, 0, shadowMapWidth, shadowMapHeight);
+	//the light-space maps only depend on the light pose, the scene transformation and the light-side technique parameters
+	updateLight();
+	shadowMapCache.beginKey(lightEye, lightAt, lightUp, geometryVersion);
+	shadowMapCache.addParameter(shadowParams.VSM);
+	shadowMapCache.addParameter(shadowParams.ESM);
+	shadowMapCache.addParameter(shadowParams.EVSM);
+	shadowMapCache.addParameter(shadowParams.MSM);
+	shadowMapCache.addParameter(gaussianFilter->getOrder());
+	shadowMapCache.addParameter(shadowMapWidth);
+	shadowMapCache.addParameter(shadowMapHeight);
+	shadowMapCache.addParameter(windowWidth);
+	shadowMapCache.addParameter(windowHeight);
+	for(int axis = 0; axis < 3; axis++) {
+		shadowMapCache.addParameter(translationVector[axis]);
+		shadowMapCache.addParameter(rotationAngles[axis]);
+	}
+	shadowMapCache.addParameter(shadowParams.cascadedShadowMaps);
+	shadowMapCache.addParameter(receiverMaskOn ? receiverMaskVersion : -1);
+	shadowMapCache.addParameter(shadowParams.useDiscontinuityMap ? shadowParams.maxSearch : -1);
+	shadowMapCache.addParameter(shadowParams.depthThreshold);
+	if(shadowParams.cascadedShadowMaps) {
+		for(int cascade = 0; cascade < NUMBER_OF_CASCADES; cascade++) {
+			shadowMapCache.addParameter(cascadeCrop[cascade][0][0]);
+			shadowMapCache.addParameter(cascadeCrop[cascade][1][1]);
+			shadowMapCache.addParameter(cascadeCrop[cascade][3][0]);
+			shadowMapCache.addParameter(cascadeCrop[cascade][3][1]);
+		}
+	}
+
+	return shadowMapCache.lookup();
+
+}
+
+void displaySceneFromLightPOV(int cascade)
+{
+
+	if(cascade < 0) 
+		glViewport(0, 0, shadowMapWidth, shadowMapHeight);
+	else
+		glViewport((cascade % 2) * shadowMapWidth/2, (cascade / 2) * shadowMapHeight/2, shadowMapWidth/2, shadowMapHeight/2);
 	
 	updateLight();
 	
@@ -264,6 +351,8 @@ void displaySceneFromLightPOV()
 	lightMVP = projection * view * model;
 	lightMV = view * model;
 	lightP = projection;
+	if(cascade >= 0)
+		myGLGeometryViewer.setProjectionMatrix(cascadeCrop[cascade] * projection);
 
 	displayScene();
 	glUseProgram(0);
@@ -313,12 +402,14 @@ void displaySceneFromGBuffer(GLuint shader)
 	myGLTextureViewer.setShaderProg(shader);
 
 	if(shadowParams.useHardShadowMap) shadowParams.hardShadowMap = textures[HARD_SHADOW_COLOR];
-	if(shadowParams.VSM || shadowParams.ESM || shadowParams.EVSM || shadowParams.MSM) shadowParams.shadowMap = textures[FILTER_Y_MAP_COLOR];
+	if(shadowParams.VSM || shadowParams.ESM || shadowParams.EVSM || shadowParams.MSM) shadowParams.shadowMap = textures[PREFILTER_Y_MAP_COLOR];
 	else shadowParams.shadowMap = textures[SHADOW_MAP_DEPTH];
-	shadowParams.vertexMap = textures[VERTEX_MAP_COLOR];
+	shadowParams.vertexMap = (packedGBuffer) ? textures[GBUFFER_MAP_DEPTH] : textures[VERTEX_MAP_COLOR];
 	shadowParams.normalMap = textures[NORMAL_MAP_COLOR];
 	shadowParams.colorMap = textures[TEXTURE_MAP_COLOR];
+	shadowParams.discontinuityMap = textures[DISCONTINUITY_MAP_COLOR];
 	shadowParams.kernelOrder = gaussianFilter->getOrder();
+	shadowParams.pcfWeights = gaussianFilter->getKernel();
 	shadowParams.lightMVP = lightMVP;
 	shadowParams.lightMV = lightMV;
 	shadowParams.lightP = lightP;
@@ -347,6 +438,42 @@ void displaySceneFromGBuffer(GLuint shader)
 
 }
 
+//scissored clears over the runs of shadow map tiles whose receiver mask equals receivers. The tile edges are rounded from the
+//normalized grid the mask is marked on, so the tiles cover the whole map at any size
+void clearReceiverTiles(bool receivers, GLbitfield buffers)
+{
+
+	glEnable(GL_SCISSOR_TEST);
+	for(int y = 0; y < receiverMaskTiles; y++) {
+		int firstRow = y * shadowMapHeight / receiverMaskTiles;
+		int lastRow = (y + 1) * shadowMapHeight / receiverMaskTiles;
+		for(int x = 0; x < receiverMaskTiles; x++) {
+			if((receiverTiles[y * receiverMaskTiles + x] != 0) != receivers) continue;
+			int run = x;
+			while(run < receiverMaskTiles && (receiverTiles[y * receiverMaskTiles + run] != 0) == receivers) run++;
+			int firstColumn = x * shadowMapWidth / receiverMaskTiles;
+			int lastColumn = run * shadowMapWidth / receiverMaskTiles;
+			glScissor(firstColumn, firstRow, lastColumn - firstColumn, lastRow - firstRow);
+			glClear(buffers);
+			x = run;
+		}
+	}
+	glDisable(GL_SCISSOR_TEST);
+
+}
+
+//what the light pass of the filtered techniques writes for a texel at the far plane, whose linearized depth is 1
+glm::vec4 computeFarPlaneMoments()
+{
+
+	if(shadowParams.VSM) return glm::vec4(1.0f, 1.0f, 0.0f, 0.0f);
+	if(shadowParams.MSM) return computeMomentQuantization() * glm::vec4(1.0f) + glm::vec4(MSM_QUANTIZATION_OFFSET, 0.0f, 0.0f, 0.0f);
+	if(shadowParams.ESM) return glm::vec4(1.0f, 0.0f, 0.0f, 1.0f);
+	if(shadowParams.EVSM) return glm::vec4(1.0f);
+	return glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+
+}
+
 void renderShadowMap() 
 {
 
@@ -354,8 +481,30 @@ void renderShadowMap()
 	//when used to store depth, should be cleared to 1.0 to run properly
 	glClearColor(0.0f, 0.0f, 0.0f, 1.0);
 	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[SHADOW_FRAMEBUFFER]);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	displaySceneFromLightPOV();
+	if(receiverMaskOn) {
+		
+		//texels outside of the receiver tiles keep the near plane depth while the scene is drawn, so the early depth test 
+		//discards whatever covers them
+		glClearDepth(0.0);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		glClearDepth(1.0);
+		clearReceiverTiles(true, GL_DEPTH_BUFFER_BIT);
+
+	} else
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	if(shadowParams.cascadedShadowMaps) {
+		for(int cascade = 0; cascade < NUMBER_OF_CASCADES; cascade++)
+			displaySceneFromLightPOV(cascade);
+	} else
+		displaySceneFromLightPOV(-1);
+	//the skipped tiles then read as the far plane, unoccluded, since the silhouette walks, the PCF kernels and the coarser 
+	//moment mip levels reach past the halo around the receivers
+	if(receiverMaskOn) {
+		glm::vec4 farPlaneMoments = computeFarPlaneMoments();
+		glClearColor(farPlaneMoments.x, farPlaneMoments.y, farPlaneMoments.z, farPlaneMoments.w);
+		clearReceiverTiles(false, GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		glClearColor(0.0f, 0.0f, 0.0f, 1.0);
+	}
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);	
 
 }
@@ -369,30 +518,252 @@ void renderGBuffer()
 	displaySceneFromCameraPOV(shaderProg[GBUFFER_SHADER]);
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
+	//the packed layout reconstructs positions with the same transform the G-buffer was rasterized with
+	shadowParams.inverseGBufferMVP = glm::inverse(myGLGeometryViewer.getProjectionMatrix() * myGLGeometryViewer.getViewMatrix() * 
+		myGLGeometryViewer.getModelMatrix());
+
+}
+
+void computeReceiverTransforms(glm::mat4 *cameraMV, glm::mat4 *lightViewProjection)
+{
+
+	updateLight();
+	glm::mat4 model = glm::translate(glm::vec3(translationVector[0], translationVector[1], translationVector[2]));
+	model *= glm::rotate(rotationAngles[0], glm::vec3(1, 0, 0));
+	model *= glm::rotate(rotationAngles[1], glm::vec3(0, 1, 0));
+	model *= glm::rotate(rotationAngles[2], glm::vec3(0, 0, 1));
+	*cameraMV = glm::lookAt(cameraEye, cameraAt, cameraUp) * model;
+	*lightViewProjection = glm::perspective(myGLGeometryViewer.fov, (GLfloat)shadowMapWidth/shadowMapHeight, myGLGeometryViewer.zNear, 
+		myGLGeometryViewer.zFar) * glm::lookAt(lightEye, lightAt, lightUp) * model;
+
+}
+
+void drawReceiverReduction(int shader, int frameBufferIndex, glm::mat4 cameraMV, glm::mat4 lightViewProjection, glm::vec3 splits)
+{
+
+	//each texel of the reductions holds the receivers of a 16x16 G-buffer tile
+	shadowParams.vertexMap = (packedGBuffer) ? textures[GBUFFER_MAP_DEPTH] : textures[VERTEX_MAP_COLOR];
+	shadowParams.normalMap = textures[NORMAL_MAP_COLOR];
+	shadowParams.colorMap = textures[TEXTURE_MAP_COLOR];
+
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[frameBufferIndex]);
+	glViewport(0, 0, windowWidth / 16, windowHeight / 16);
+	glUseProgram(shaderProg[shader]);
+	myGLGeometryViewer.setShaderProg(shaderProg[shader]);
+	myGLTextureViewer.setShaderProg(shaderProg[shader]);
+	myGLGeometryViewer.configureGBuffer(shadowParams);
+	glActiveTexture(GL_TEXTURE0);
+	glUniformMatrix4fv(glGetUniformLocation(shaderProg[shader], "cameraMV"), 1, GL_FALSE, &cameraMV[0][0]);
+	glUniformMatrix4fv(glGetUniformLocation(shaderProg[shader], "lightMVP"), 1, GL_FALSE, &lightViewProjection[0][0]);
+	glUniform3f(glGetUniformLocation(shaderProg[shader], "cascadeSplits"), splits[0], splits[1], splits[2]);
+	glUniform2f(glGetUniformLocation(shaderProg[shader], "gBufferSize"), (float)windowWidth, (float)windowHeight);
+	myGLTextureViewer.drawTextureQuad();
+
+}
+
+void fitShadowCascades()
+{
+
+	glm::mat4 cameraMV, lightViewProjection;
+	computeReceiverTransforms(&cameraMV, &lightViewProjection);
+
+	int tilesX = windowWidth / 16;
+	int tilesY = windowHeight / 16;
+	float *tileBounds = (float*)malloc(tilesX * tilesY * 4 * sizeof(float));
+	drawReceiverReduction(DEPTH_REDUCTION_SHADER, DEPTH_REDUCTION_FRAMEBUFFER, cameraMV, lightViewProjection, shadowParams.cascadeSplits);
+	glReadPixels(0, 0, tilesX, tilesY, GL_RGBA, GL_FLOAT, tileBounds);
+
+	float minDepth = 1.0e30f, maxDepth = 0.0f;
+	for(int tile = 0; tile < tilesX * tilesY; tile++) {
+		if(tileBounds[tile * 4 + 3] > 0.0f) {
+			minDepth = glm::min(minDepth, tileBounds[tile * 4]);
+			maxDepth = glm::max(maxDepth, tileBounds[tile * 4 + 1]);
+		}
+	}
+
+	//without receivers there is nothing to fit and the single shadow map is kept
+	if(maxDepth <= 0.0f) {
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glUseProgram(0);
+		free(tileBounds);
+		shadowParams.cascadedShadowMaps = false;
+		return;
+	}
+
+	//practical split scheme over the depth range of the receivers, instead of the one of the camera frustum
+	minDepth = glm::max(minDepth, myGLGeometryViewer.zNear);
+	maxDepth = glm::max(maxDepth, minDepth);
+	for(int split = 1; split < NUMBER_OF_CASCADES; split++) {
+		float fraction = (float)split / NUMBER_OF_CASCADES;
+		float logarithmicSplit = minDepth * powf(maxDepth / minDepth, fraction);
+		float uniformSplit = minDepth + (maxDepth - minDepth) * fraction;
+		shadowParams.cascadeSplits[split - 1] = cascadeSplitLambda * logarithmicSplit + (1.0f - cascadeSplitLambda) * uniformSplit;
+	}
+
+	drawReceiverReduction(CASCADE_BOUNDS_REDUCTION_SHADER, CASCADE_BOUNDS_FRAMEBUFFER, cameraMV, lightViewProjection, shadowParams.cascadeSplits);
+
+	int quadrantWidth = shadowMapWidth / 2;
+	int quadrantHeight = shadowMapHeight / 2;
+	for(int cascade = 0; cascade < NUMBER_OF_CASCADES; cascade++) {
+
+		glReadBuffer(GL_COLOR_ATTACHMENT0 + cascade);
+		glReadPixels(0, 0, tilesX, tilesY, GL_RGBA, GL_FLOAT, tileBounds);
+
+		float bounds[4] = {1.0e30f, 1.0e30f, -1.0e30f, -1.0e30f};
+		for(int tile = 0; tile < tilesX * tilesY; tile++) {
+			bounds[0] = glm::min(bounds[0], tileBounds[tile * 4]);
+			bounds[1] = glm::min(bounds[1], tileBounds[tile * 4 + 1]);
+			bounds[2] = glm::max(bounds[2], tileBounds[tile * 4 + 2]);
+			bounds[3] = glm::max(bounds[3], tileBounds[tile * 4 + 3]);
+		}
+
+		//a cascade without receivers keeps the whole light frustum, and receivers outside of it are never shadowed
+		if(bounds[0] > bounds[2] || bounds[1] > bounds[3]) {
+			bounds[0] = -1.0f; bounds[1] = -1.0f; bounds[2] = 1.0f; bounds[3] = 1.0f;
+		}
+		for(int side = 0; side < 4; side++)
+			bounds[side] = glm::clamp(bounds[side], -1.0f, 1.0f);
+
+		//the border keeps the texels read by the filter kernels and the revectorization search inside the quadrant
+		float extentX = glm::max(bounds[2] - bounds[0], 1.0e-3f) * quadrantWidth / (quadrantWidth - 2 * cascadeBorder);
+		float extentY = glm::max(bounds[3] - bounds[1], 1.0e-3f) * quadrantHeight / (quadrantHeight - 2 * cascadeBorder);
+		float centerX = 0.5f * (bounds[0] + bounds[2]);
+		float centerY = 0.5f * (bounds[1] + bounds[3]);
+
+		cascadeCrop[cascade] = glm::mat4(1.0f);
+		cascadeCrop[cascade][0][0] = 2.0f / extentX;
+		cascadeCrop[cascade][1][1] = 2.0f / extentY;
+		cascadeCrop[cascade][3][0] = -2.0f * centerX / extentX;
+		cascadeCrop[cascade][3][1] = -2.0f * centerY / extentY;
+		shadowParams.cascadeMVP[cascade] = cascadeCrop[cascade] * lightViewProjection;
+
+	}
+
+	glReadBuffer(GL_COLOR_ATTACHMENT0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glUseProgram(0);
+	free(tileBounds);
+	shadowParams.cascadedShadowMaps = true;
+
+}
+
+void buildReceiverMask()
+{
+
+	int tilesX = windowWidth / 16;
+	int tilesY = windowHeight / 16;
+	float *tileBounds = (float*)malloc(tilesX * tilesY * 4 * sizeof(float));
+	unsigned char previousTiles[receiverMaskTiles * receiverMaskTiles];
+	memcpy(previousTiles, receiverTiles, sizeof(receiverTiles));
+	memset(receiverTiles, 0, sizeof(receiverTiles));
+
+	//the cascade fit has already reduced the receivers of each cascade, otherwise all of them are reduced into the first one
+	if(!shadowParams.cascadedShadowMaps) {
+		glm::mat4 cameraMV, lightViewProjection;
+		computeReceiverTransforms(&cameraMV, &lightViewProjection);
+		drawReceiverReduction(CASCADE_BOUNDS_REDUCTION_SHADER, CASCADE_BOUNDS_FRAMEBUFFER, cameraMV, lightViewProjection, glm::vec3(1.0e30f));
+	} else
+		glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[CASCADE_BOUNDS_FRAMEBUFFER]);
+
+	int numberOfCascades = (shadowParams.cascadedShadowMaps) ? NUMBER_OF_CASCADES : 1;
+	for(int cascade = 0; cascade < numberOfCascades; cascade++) {
+
+		glm::mat4 crop = (shadowParams.cascadedShadowMaps) ? cascadeCrop[cascade] : glm::mat4(1.0f);
+		float scale = (shadowParams.cascadedShadowMaps) ? 0.5f : 1.0f;
+		float originX = (shadowParams.cascadedShadowMaps) ? 0.5f * (cascade % 2) : 0.0f;
+		float originY = (shadowParams.cascadedShadowMaps) ? 0.5f * (cascade / 2) : 0.0f;
+
+		glReadBuffer(GL_COLOR_ATTACHMENT0 + cascade);
+		glReadPixels(0, 0, tilesX, tilesY, GL_RGBA, GL_FLOAT, tileBounds);
+
+		for(int tile = 0; tile < tilesX * tilesY; tile++) {
+
+			float *bounds = &tileBounds[tile * 4];
+			if(bounds[0] > bounds[2] || bounds[1] > bounds[3]) continue;
+
+			//light clip space bounds to shadow map tiles, grown by one tile so the occluders next to the receivers are kept
+			int firstX = (int)floor((originX + scale * (glm::clamp(crop[0][0] * bounds[0] + crop[3][0], -1.0f, 1.0f) * 0.5f + 0.5f)) * receiverMaskTiles) - 1;
+			int firstY = (int)floor((originY + scale * (glm::clamp(crop[1][1] * bounds[1] + crop[3][1], -1.0f, 1.0f) * 0.5f + 0.5f)) * receiverMaskTiles) - 1;
+			int lastX = (int)floor((originX + scale * (glm::clamp(crop[0][0] * bounds[2] + crop[3][0], -1.0f, 1.0f) * 0.5f + 0.5f)) * receiverMaskTiles) + 1;
+			int lastY = (int)floor((originY + scale * (glm::clamp(crop[1][1] * bounds[3] + crop[3][1], -1.0f, 1.0f) * 0.5f + 0.5f)) * receiverMaskTiles) + 1;
+			for(int y = glm::max(firstY, 0); y <= glm::min(lastY, receiverMaskTiles - 1); y++)
+				for(int x = glm::max(firstX, 0); x <= glm::min(lastX, receiverMaskTiles - 1); x++)
+					receiverTiles[y * receiverMaskTiles + x] = 1;
+
+		}
+
+	}
+
+	glReadBuffer(GL_COLOR_ATTACHMENT0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glUseProgram(0);
+	free(tileBounds);
+
+	skippedReceiverTiles = 0;
+	for(int tile = 0; tile < receiverMaskTiles * receiverMaskTiles; tile++)
+		if(!receiverTiles[tile]) skippedReceiverTiles++;
+	if(memcmp(previousTiles, receiverTiles, sizeof(receiverTiles)) != 0)
+		receiverMaskVersion++;
+
 }
 
+void buildDiscontinuityMap()
+{
+
+	//a receiver lit by a texel lies at the depth of that texel, so the walks of DiscontinuityMap.frag only depend on the shadow map
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[DISCONTINUITY_MAP_FRAMEBUFFER]);
+	glViewport(0, 0, shadowMapWidth, shadowMapHeight);
+	glUseProgram(shaderProg[DISCONTINUITY_MAP_SHADER]);
+	myGLTextureViewer.setShaderProg(shaderProg[DISCONTINUITY_MAP_SHADER]);
+	glActiveTexture(GL_TEXTURE7);
+	glBindTexture(GL_TEXTURE_2D, textures[SHADOW_MAP_DEPTH]);
+	glUniform1i(glGetUniformLocation(shaderProg[DISCONTINUITY_MAP_SHADER], "shadowMap"), 7);
+	glUniform2f(glGetUniformLocation(shaderProg[DISCONTINUITY_MAP_SHADER], "shadowMapStep"), 1.0f/shadowMapWidth, 1.0f/shadowMapHeight);
+	glUniform1f(glGetUniformLocation(shaderProg[DISCONTINUITY_MAP_SHADER], "depthThreshold"), shadowParams.depthThreshold);
+	glUniform1i(glGetUniformLocation(shaderProg[DISCONTINUITY_MAP_SHADER], "maxSearch"), shadowParams.maxSearch);
+	myGLTextureViewer.drawTextureQuad();
+	glActiveTexture(GL_TEXTURE0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glUseProgram(0);
+
+}
+
+void configureShadowMapFilter(bool horizontal, bool vertical)
+{
+
+	//the log-space convolution of ESM is not linear in the texels, so it keeps one fetch per kernel weight
+	if(shadowParams.VSM || shadowParams.MSM || shadowParams.EVSM)
+		myGLTextureViewer.configureSeparableFilter(gaussianFilter->getNumberOfTaps(linearSamplingFilter), gaussianFilter->getTapOffsets(linearSamplingFilter), 
+			gaussianFilter->getTapWeights(linearSamplingFilter), horizontal, vertical);
+	else
+		myGLTextureViewer.configureSeparableFilter(gaussianFilter->getOrder(), gaussianFilter->getKernel(), horizontal, vertical);
+
+}
+
+//The prefilter runs at the shadow map resolution, so every tap offset is measured in texels of the map it reads and
+//the linear taps land between the two texels they merge
 void filterShadowMap()
 {
 
 	if(shadowParams.VSM || shadowParams.MSM || shadowParams.EVSM) myGLTextureViewer.setShaderProg(shaderProg[GAUSSIAN_FILTER_SHADER]);
 	else myGLTextureViewer.setShaderProg(shaderProg[LOG_GAUSSIAN_FILTER_SHADER]);
 		
-	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[FILTER_X_FRAMEBUFFER]);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	glViewport(0, 0, windowWidth, windowHeight);
-	myGLTextureViewer.configureSeparableFilter(gaussianFilter->getOrder(), gaussianFilter->getKernel(), true, false);
-	myGLTextureViewer.drawTextureOnShader(textures[SHADOW_MAP_COLOR], windowWidth, windowHeight);
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[PREFILTER_X_FRAMEBUFFER]);
+	glClear(GL_COLOR_BUFFER_BIT);
+	glViewport(0, 0, shadowMapWidth, shadowMapHeight);
+	configureShadowMapFilter(true, false);
+	myGLTextureViewer.drawTextureOnShader(textures[SHADOW_MAP_COLOR], shadowMapWidth, shadowMapHeight);
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);		
 		
-	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[FILTER_Y_FRAMEBUFFER]);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	glViewport(0, 0, windowWidth, windowHeight);
-	myGLTextureViewer.configureSeparableFilter(gaussianFilter->getOrder(), gaussianFilter->getKernel(), false, true);
-	myGLTextureViewer.drawTextureOnShader(textures[FILTER_X_MAP_COLOR], windowWidth, windowHeight);
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[PREFILTER_Y_FRAMEBUFFER]);
+	glClear(GL_COLOR_BUFFER_BIT);
+	glViewport(0, 0, shadowMapWidth, shadowMapHeight);
+	configureShadowMapFilter(false, true);
+	myGLTextureViewer.drawTextureOnShader(textures[PREFILTER_X_MAP_COLOR], shadowMapWidth, shadowMapHeight);
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);		
 		
 	//we must build the mip-map version of the final blurred map in order to VSM run correctly
-	glBindTexture(GL_TEXTURE_2D, textures[FILTER_Y_MAP_COLOR]);
+	glBindTexture(GL_TEXTURE_2D, textures[PREFILTER_Y_MAP_COLOR]);
 	glGenerateMipmap(GL_TEXTURE_2D);
 
 }
@@ -456,40 +827,254 @@ void shadeScene()
 
 }
 
-void display()
+void renderHardShadows()
 {
-	
-	renderShadowMap();
-	if(shadowParams.VSM || shadowParams.ESM || shadowParams.EVSM || shadowParams.MSM) filterShadowMap();
+
+	//the cascades are fitted to the G-buffer, so it is rendered before the shadow map
 	renderGBuffer();
+	if(cascadedShadowMaps) 
+		fitShadowCascades();
+	else
+		shadowParams.cascadedShadowMaps = false;
+	if(receiverMaskOn)
+		buildReceiverMask();
+
+	//only the conservative shader reads the map, the other ones need the depth of the shadowed receivers. Longer walks than the
+	//map can store fall back to the search in the camera pass
+	shadowParams.useDiscontinuityMap = discontinuityMapOn && shadowParams.conservative && 
+		(shadowParams.SMSR || shadowParams.RPCFPlusSMSR || shadowParams.EDTSM) && shadowParams.maxSearch <= MAX_DISCONTINUITY_MAP_SEARCH;
+	if(!isShadowMapCached()) {
+		renderShadowMap();
+		if(shadowParams.VSM || shadowParams.ESM || shadowParams.EVSM || shadowParams.MSM) filterShadowMap();
+		if(shadowParams.useDiscontinuityMap) buildDiscontinuityMap();
+	}
 	computeHardShadows();
 	if(shadowParams.EDTSM) filterHardShadowsUsingEDT();
-	shadeScene();
-	
-	glutSwapBuffers();
-	glutPostRedisplay();
 
 }
 
-void idle()
+void allocateShadowMap(int width, int height)
 {
-	
-	calculateFPS();
 
-	if(animationOn) {
-		if(!stop)
-			animation += 6;
-		if(animation == 1800)
-			animation = -1800;
+	shadowMapWidth = width;
+	shadowMapHeight = height;
+	shadowParams.shadowMapWidth = width;
+	shadowParams.shadowMapHeight = height;
+	myGLTextureViewer.loadRGBATexture((float*)NULL, textures, SHADOW_MAP_COLOR, width, height);
+	myGLTextureViewer.loadDepthComponentTexture(NULL, textures, SHADOW_MAP_DEPTH, width, height);
+	myGLTextureViewer.loadRGBATexture((unsigned short*)NULL, textures, DISCONTINUITY_MAP_COLOR, width, height);
+	myGLTextureViewer.loadRGBATexture((float*)NULL, textures, PREFILTER_X_MAP_COLOR, width, height);
+	myGLTextureViewer.loadRGBATexture((float*)NULL, textures, PREFILTER_Y_MAP_COLOR, width, height);
+
+}
+
+float computeShadowError(float *shadows, float *reference, int size)
+{
+
+	double error = 0.0;
+	int numberOfPixels = 0;
+
+	//the background is never written, so only pixels covered by geometry are compared
+	for(int pixel = 0; pixel < size; pixel++) {
+		if(reference[pixel] > 0.0f || shadows[pixel] > 0.0f) {
+			error += (shadows[pixel] - reference[pixel]) * (shadows[pixel] - reference[pixel]);
+			numberOfPixels++;
+		}
 	}
 
-}	
+	return (numberOfPixels > 0) ? (float)sqrt(error / numberOfPixels) : 0.0f;
+
+}
+
+void benchmarkCascadedShadowMaps()
+{
+
+	int previousShadowMapWidth = shadowMapWidth;
+	int previousShadowMapHeight = shadowMapHeight;
+	bool previousCascadedShadowMaps = cascadedShadowMaps;
+	float *reference = (float*)malloc(windowWidth * windowHeight * sizeof(float));
+	float *shadows = (float*)malloc(windowWidth * windowHeight * sizeof(float));
+
+	//the reference is a single shadow map with four times the texels of the configured one
+	cascadedShadowMaps = false;
+	allocateShadowMap(previousShadowMapWidth * 2, previousShadowMapHeight * 2);
+	renderHardShadows();
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[HARD_SHADOW_FRAMEBUFFER]);
+	glReadPixels(0, 0, windowWidth, windowHeight, GL_RED, GL_FLOAT, reference);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	printf("%-14s%-10s%14s%14s\n", "Shadow map", "Layout", "Texels", "RMS error");
+	float singleError = 0.0;
+	int smallestWidth = 0, smallestHeight = 0;
+	for(int run = 0; run < 4; run++) {
+
+		//the first run keeps the single map at the configured size, the others split it in cascades at 1, 1/2 and 1/4 of it
+		int divisor = (run == 0) ? 1 : 1 << (run - 1);
+		cascadedShadowMaps = (run > 0);
+		allocateShadowMap(previousShadowMapWidth / divisor, previousShadowMapHeight / divisor);
+		renderHardShadows();
+		glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[HARD_SHADOW_FRAMEBUFFER]);
+		glReadPixels(0, 0, windowWidth, windowHeight, GL_RED, GL_FLOAT, shadows);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		float error = computeShadowError(shadows, reference, windowWidth * windowHeight);
+		if(run == 0) singleError = error;
+		else if(error <= singleError) {
+			smallestWidth = shadowMapWidth;
+			smallestHeight = shadowMapHeight;
+		}
+		char size[32];
+		sprintf(size, "%dx%d", shadowMapWidth, shadowMapHeight);
+		printf("%-14s%-10s%14d%14f\n", size, (shadowParams.cascadedShadowMaps) ? "Cascaded" : "Single", shadowMapWidth * shadowMapHeight, error);
+
+	}
+
+	if(smallestWidth > 0)
+		printf("Cascaded %dx%d shadow map matches the single %dx%d one\n", smallestWidth, smallestHeight, previousShadowMapWidth, previousShadowMapHeight);
+	else
+		printf("No cascaded shadow map size matches the single shadow map error\n");
+
+	free(reference);
+	free(shadows);
+	cascadedShadowMaps = previousCascadedShadowMaps;
+	allocateShadowMap(previousShadowMapWidth, previousShadowMapHeight);
+	shadowMapCache.invalidate();
+
+}
+
+void benchmarkReceiverMask()
+{
+
+	const int numberOfFrames = 20;
+	bool previousReceiverMaskOn = receiverMaskOn;
+	double lightPassTime[2];
+	GLuint query;
+	GLuint64 elapsedTime;
+	glGenQueries(1, &query);
+
+	renderGBuffer();
+	if(cascadedShadowMaps) 
+		fitShadowCascades();
+	else
+		shadowParams.cascadedShadowMaps = false;
+	buildReceiverMask();
+
+	//the shadow map is rendered from the same G-buffer, with the whole light frustum and then with the receiver tiles only
+	for(int run = 0; run < 2; run++) {
+
+		receiverMaskOn = (run == 1);
+		lightPassTime[run] = 0.0;
+		for(int frame = 0; frame < numberOfFrames; frame++) {
+			glBeginQuery(GL_TIME_ELAPSED, query);
+			renderShadowMap();
+			glEndQuery(GL_TIME_ELAPSED);
+			glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsedTime);
+			lightPassTime[run] += elapsedTime / 1000000.0;
+		}
+		lightPassTime[run] /= numberOfFrames;
+
+	}
+
+	int numberOfTiles = receiverMaskTiles * receiverMaskTiles;
+	printf("Receiver mask: %d of %d shadow map tiles skipped (%.1f%%)\n", skippedReceiverTiles, numberOfTiles, 100.0f * skippedReceiverTiles / numberOfTiles);
+	printf("Light pass: %f ms full, %f ms masked (%.1f%% saved)\n", lightPassTime[0], lightPassTime[1], 
+		(lightPassTime[0] > 0.0) ? 100.0 * (lightPassTime[0] - lightPassTime[1]) / lightPassTime[0] : 0.0);
+
+	glDeleteQueries(1, &query);
+	receiverMaskOn = previousReceiverMaskOn;
+	shadowMapCache.invalidate();
+
+}
+
+void benchmarkShadowMapPrefilter()
+{
+
+	const int numberOfFrames = 20;
+	const char *techniqueNames[3] = {"VSM", "EVSM", "MSM"};
+	ShadowParams previousShadowParams = shadowParams;
+	int previousShadowMapWidth = shadowMapWidth;
+	int previousShadowMapHeight = shadowMapHeight;
+	bool previousLinearSamplingFilter = linearSamplingFilter;
+	bool previousReceiverMaskOn = receiverMaskOn;
+	GLuint query;
+	GLuint64 elapsedTime;
+	glGenQueries(1, &query);
+
+	receiverMaskOn = false;
+	//the prefilter works on the texel grid of the shadow map, so its result does not depend on the window size
+	printf("Window %dx%d\n", windowWidth, windowHeight);
+	printf("%-12s%-8s%10s%10s%14s%14s%14s\n", "Shadow map", "Filter", "Fetches", "Linear", "Per-tap ms", "Linear ms", "CPU error");
+	for(int size = 1024; size <= 2048; size *= 2) {
+
+		allocateShadowMap(size, size);
+		float *shadowMap = (float*)malloc(size * size * 4 * sizeof(float));
+		float *filteredMap = (float*)malloc(size * size * 4 * sizeof(float));
+		float *referenceMap = (float*)malloc(size * size * 4 * sizeof(float));
+
+		for(int technique = 0; technique < 3; technique++) {
+
+			shadowParams.cascadedShadowMaps = false;
+			shadowParams.ESM = false;
+			shadowParams.VSM = (technique == 0);
+			shadowParams.EVSM = (technique == 1);
+			shadowParams.MSM = (technique == 2);
+			renderShadowMap();
+
+			double prefilterTime[2];
+			for(int run = 0; run < 2; run++) {
+				linearSamplingFilter = (run == 1);
+				prefilterTime[run] = 0.0;
+				for(int frame = 0; frame < numberOfFrames; frame++) {
+					glBeginQuery(GL_TIME_ELAPSED, query);
+					filterShadowMap();
+					glEndQuery(GL_TIME_ELAPSED);
+					glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsedTime);
+					prefilterTime[run] += elapsedTime / 1000000.0;
+				}
+				prefilterTime[run] /= numberOfFrames;
+			}
+
+			//the CPU filter reads the same taps, so it checks the linear sampling result of the last run
+			glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[SHADOW_FRAMEBUFFER]);
+			glReadPixels(0, 0, size, size, GL_RGBA, GL_FLOAT, shadowMap);
+			glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[PREFILTER_Y_FRAMEBUFFER]);
+			glReadPixels(0, 0, size, size, GL_RGBA, GL_FLOAT, filteredMap);
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+			gaussianFilter->filterImage(shadowMap, referenceMap, size, size, true, true);
+			gaussianFilter->filterImage(referenceMap, shadowMap, size, size, false, true);
+			float maxError = 0.0f;
+			for(int texel = 0; texel < size * size * 4; texel++)
+				maxError = glm::max(maxError, fabsf(filteredMap[texel] - shadowMap[texel]));
+
+			char mapSize[32];
+			sprintf(mapSize, "%dx%d", size, size);
+			printf("%-12s%-8s%10d%10d%14f%14f%14f\n", mapSize, techniqueNames[technique], 2 * gaussianFilter->getNumberOfTaps(false) - 1, 
+				2 * gaussianFilter->getNumberOfTaps(true) - 1, prefilterTime[0], prefilterTime[1], maxError);
+
+		}
+
+		free(shadowMap);
+		free(filteredMap);
+		free(referenceMap);
+
+	}
+
+	glDeleteQueries(1, &query);
+	allocateShadowMap(previousShadowMapWidth, previousShadowMapHeight);
+	shadowParams = previousShadowParams;
+	linearSamplingFilter = previousLinearSamplingFilter;
+	receiverMaskOn = previousReceiverMaskOn;
+	shadowMapCache.invalidate();
+
+}
 
 void resetShadowParams()
 {
 	
 	shadowParams.bilinearPCF = false;
 	shadowParams.tricubicPCF = false;
+	shadowParams.gatherPCF = false;
+	shadowParams.optimizedPCF = false;
 	shadowParams.VSM = false;
 	shadowParams.ESM = false;
 	shadowParams.EVSM = false;
@@ -503,6 +1088,419 @@ void resetShadowParams()
 
 }
 
+void benchmarkPCF()
+{
+
+	const int numberOfFrames = 20;
+	const char *pcfNames[4] = {"Bilinear", "Tricubic", "Gather", "Optimized"};
+	ShadowParams previousShadowParams = shadowParams;
+	int previousOrder = gaussianFilter->getOrder();
+	int size = windowWidth * windowHeight;
+	float *shadows = (float*)malloc(size * sizeof(float));
+	float *reference = (float*)malloc(size * sizeof(float));
+	float *lookups = (float*)malloc(size * 4 * sizeof(float));
+	float *depthMap = (float*)malloc(shadowMapWidth * shadowMapHeight * sizeof(float));
+	GLuint query;
+	GLuint64 elapsedTime;
+	glGenQueries(1, &query);
+
+	//the loops take kernelOrder x kernelOrder taps over kernelOrder + 1 texels, the footprint of the optimized PCF
+	resetShadowParams();
+	shadowParams.bilinearPCF = true;
+	renderHardShadows();
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[SHADOW_FRAMEBUFFER]);
+	glReadPixels(0, 0, shadowMapWidth, shadowMapHeight, GL_DEPTH_COMPONENT, GL_FLOAT, depthMap);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	printf("%-8s%-12s%10s%14s%14s\n", "Order", "PCF", "Taps", "Time (ms)", "CPU error");
+	for(int order = 3; order <= 15; order += 2) {
+
+		gaussianFilter->buildGaussianKernel(order);
+		shadowParams.penumbraSize = (order + 1)/2;
+		for(int pcf = 0; pcf < 4; pcf++) {
+
+			resetShadowParams();
+			shadowParams.bilinearPCF = (pcf == 0);
+			shadowParams.tricubicPCF = (pcf == 1);
+			shadowParams.gatherPCF = (pcf == 2);
+			shadowParams.optimizedPCF = (pcf == 3);
+
+			double pcfTime = 0.0;
+			for(int frame = 0; frame < numberOfFrames; frame++) {
+				glBeginQuery(GL_TIME_ELAPSED, query);
+				computeHardShadows();
+				glEndQuery(GL_TIME_ELAPSED);
+				glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsedTime);
+				pcfTime += elapsedTime / 1000000.0;
+			}
+			pcfTime /= numberOfFrames;
+
+			//a bicubic lookup is four bilinear fetches, and a gather or a bilinear comparison reads a 2x2 block
+			int taps = (pcf == 0) ? order * order : (pcf == 1) ? 4 * order * order : ((order + 1)/2) * ((order + 1)/2);
+			char error[32] = "-";
+			if(pcf >= 2) {
+				glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[HARD_SHADOW_FRAMEBUFFER]);
+				glReadPixels(0, 0, windowWidth, windowHeight, GL_RED, GL_FLOAT, shadows);
+				glReadBuffer(GL_COLOR_ATTACHMENT1);
+				glReadPixels(0, 0, windowWidth, windowHeight, GL_RGBA, GL_FLOAT, lookups);
+				glReadBuffer(GL_COLOR_ATTACHMENT0);
+				glBindFramebuffer(GL_FRAMEBUFFER, 0);
+				for(int pixel = 0; pixel < size; pixel++) {
+					float *lookup = lookups + pixel * 4;
+					if(lookup[3] == 0.0f) reference[pixel] = shadows[pixel];
+					else {
+						float lit = gaussianFilter->percentageCloserFilter(depthMap, shadowMapWidth, shadowMapHeight, lookup[0], lookup[1], lookup[2], pcf == 3);
+						reference[pixel] = shadowParams.shadowIntensity + (1.0f - shadowParams.shadowIntensity) * lit;
+					}
+				}
+				sprintf(error, "%f", computeShadowError(shadows, reference, size));
+			}
+			printf("%-8d%-12s%10d%14f%14s\n", order, pcfNames[pcf], taps, pcfTime, error);
+
+		}
+
+	}
+
+	free(shadows);
+	free(reference);
+	free(lookups);
+	free(depthMap);
+	glDeleteQueries(1, &query);
+	gaussianFilter->buildGaussianKernel(previousOrder);
+	shadowParams = previousShadowParams;
+	shadowMapCache.invalidate();
+
+}
+
+void compareHardShadowReference()
+{
+
+	if(packedGBuffer) {
+		printf("The CPU reference reads the unpacked G-buffer\n");
+		return;
+	}
+	if(shadowParams.SMSR || shadowParams.RSMSS || shadowParams.RPCFPlusSMSR || shadowParams.RPCFPlusRSMSS || shadowParams.EDTSM) {
+		printf("The CPU reference covers the techniques of Shadow.frag\n");
+		return;
+	}
+
+	bool momentMap = shadowParams.VSM || shadowParams.ESM || shadowParams.EVSM || shadowParams.MSM;
+	int size = windowWidth * windowHeight;
+	int mapWidth = shadowMapWidth;
+	int mapHeight = shadowMapHeight;
+	float *vertexMap = (float*)malloc(size * 4 * sizeof(float));
+	float *normalMap = (float*)malloc(size * 4 * sizeof(float));
+	float *shadowMap = (float*)malloc(mapWidth * mapHeight * 4 * sizeof(float));
+	float *shadows = (float*)malloc(size * sizeof(float));
+	float *reference = (float*)malloc(size * sizeof(float));
+
+	shadowMapCache.invalidate();
+	renderHardShadows();
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[HARD_SHADOW_FRAMEBUFFER]);
+	glReadPixels(0, 0, windowWidth, windowHeight, GL_RED, GL_FLOAT, shadows);
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[GBUFFER_FRAMEBUFFER]);
+	glReadPixels(0, 0, windowWidth, windowHeight, GL_RGBA, GL_FLOAT, vertexMap);
+	glReadBuffer(GL_COLOR_ATTACHMENT1);
+	glReadPixels(0, 0, windowWidth, windowHeight, GL_RGBA, GL_FLOAT, normalMap);
+	glReadBuffer(GL_COLOR_ATTACHMENT0);
+	//the moment techniques read the prefiltered map, which filterShadowMap renders at the shadow map size
+	if(momentMap) {
+		glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[PREFILTER_Y_FRAMEBUFFER]);
+		glReadPixels(0, 0, mapWidth, mapHeight, GL_RGBA, GL_FLOAT, shadowMap);
+	} else {
+		glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[SHADOW_FRAMEBUFFER]);
+		glReadPixels(0, 0, mapWidth, mapHeight, GL_DEPTH_COMPONENT, GL_FLOAT, shadowMap);
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	//the prefilter shares the texel grid of the shadow map, so the ESM one is checked at any window size
+	if(shadowParams.ESM) {
+		float *exponentialMap = (float*)malloc(mapWidth * mapHeight * 4 * sizeof(float));
+		float *filteredMap = (float*)malloc(mapWidth * mapHeight * 4 * sizeof(float));
+		glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[SHADOW_FRAMEBUFFER]);
+		glReadPixels(0, 0, mapWidth, mapHeight, GL_RGBA, GL_FLOAT, exponentialMap);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		gaussianFilter->filterLogImage(exponentialMap, filteredMap, mapWidth, mapHeight, true);
+		gaussianFilter->filterLogImage(filteredMap, exponentialMap, mapWidth, mapHeight, false);
+		float maxError = 0.0f;
+		for(int texel = 0; texel < mapWidth * mapHeight; texel++)
+			maxError = glm::max(maxError, fabsf(exponentialMap[texel * 4] - shadowMap[texel * 4]));
+		printf("Log-space prefilter max error: %f\n", maxError);
+		free(exponentialMap);
+		free(filteredMap);
+	}
+
+	HardShadowReference hardShadowReference;
+	hardShadowReference.setGBuffer(vertexMap, normalMap, windowWidth, windowHeight);
+	hardShadowReference.setShadowMap(shadowMap, mapWidth, mapHeight, (momentMap) ? 4 : 1);
+	hardShadowReference.setCamera(myGLGeometryViewer.getViewMatrix() * myGLGeometryViewer.getModelMatrix(), myGLGeometryViewer.normalMatrix, lightEye, 
+		myGLGeometryViewer.zNear, myGLGeometryViewer.zFar);
+	hardShadowReference.setFilter(gaussianFilter);
+	double referenceTime = cpu_time();
+	hardShadowReference.computeHardShadows(shadowParams, reference);
+	referenceTime = cpu_time() - referenceTime;
+
+	float maxError = 0.0f;
+	int numberOfMismatches = 0;
+	for(int pixel = 0; pixel < size; pixel++) {
+		float error = fabsf(shadows[pixel] - reference[pixel]);
+		maxError = glm::max(maxError, error);
+		if(error > 1.0f/255.0f) numberOfMismatches++;
+	}
+	printf("CPU reference: %f s, RMS error %f, max error %f, %d pixels off by more than 1/255\n", referenceTime, 
+		computeShadowError(shadows, reference, size), maxError, numberOfMismatches);
+
+	free(vertexMap);
+	free(normalMap);
+	free(shadowMap);
+	free(shadows);
+	free(reference);
+
+}
+
+void compareRevectorizationReference()
+{
+
+	if(packedGBuffer) {
+		printf("The CPU reference reads the unpacked G-buffer\n");
+		return;
+	}
+	if(!(shadowParams.SMSR || shadowParams.RSMSS || shadowParams.RPCFPlusSMSR || shadowParams.RPCFPlusRSMSS || shadowParams.EDTSM)) {
+		printf("The CPU reference covers the techniques of the RBSM shaders\n");
+		return;
+	}
+
+	int size = windowWidth * windowHeight;
+	float *vertexMap = (float*)malloc(size * 4 * sizeof(float));
+	float *normalMap = (float*)malloc(size * 4 * sizeof(float));
+	float *shadowMap = (float*)malloc(shadowMapWidth * shadowMapHeight * sizeof(float));
+	float *shadows = (float*)malloc(size * sizeof(float));
+	float *reference = (float*)malloc(size * sizeof(float));
+
+	shadowMapCache.invalidate();
+	renderHardShadows();
+	//EDTSM filters the hard shadows in place, so they are revectorized again
+	if(shadowParams.EDTSM) computeHardShadows();
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[HARD_SHADOW_FRAMEBUFFER]);
+	glReadPixels(0, 0, windowWidth, windowHeight, GL_RED, GL_FLOAT, shadows);
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[GBUFFER_FRAMEBUFFER]);
+	glReadPixels(0, 0, windowWidth, windowHeight, GL_RGBA, GL_FLOAT, vertexMap);
+	glReadBuffer(GL_COLOR_ATTACHMENT1);
+	glReadPixels(0, 0, windowWidth, windowHeight, GL_RGBA, GL_FLOAT, normalMap);
+	glReadBuffer(GL_COLOR_ATTACHMENT0);
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[SHADOW_FRAMEBUFFER]);
+	glReadPixels(0, 0, shadowMapWidth, shadowMapHeight, GL_DEPTH_COMPONENT, GL_FLOAT, shadowMap);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	RevectorizationReference revectorizationReference;
+	revectorizationReference.setGBuffer(vertexMap, normalMap, windowWidth, windowHeight);
+	revectorizationReference.setShadowMap(shadowMap, shadowMapWidth, shadowMapHeight, 1);
+	revectorizationReference.setCamera(myGLGeometryViewer.getViewMatrix() * myGLGeometryViewer.getModelMatrix(), myGLGeometryViewer.normalMatrix, lightEye, 
+		myGLGeometryViewer.zNear, myGLGeometryViewer.zFar);
+	revectorizationReference.computeRevectorizedShadows(shadowParams, reference);
+
+	float maxError = 0.0f;
+	int numberOfMismatches = 0;
+	for(int pixel = 0; pixel < size; pixel++) {
+		float error = fabsf(shadows[pixel] - reference[pixel]);
+		maxError = glm::max(maxError, error);
+		if(error > 1.0f/255.0f) numberOfMismatches++;
+	}
+	printf("CPU revectorization (maxSearch %d): %d samples, %d edge searches, %.2f fetches per pixel\n", shadowParams.maxSearch, 
+		revectorizationReference.getNumberOfSamples(), revectorizationReference.getNumberOfSearches(), 
+		(float)revectorizationReference.getNumberOfFetches() / glm::max(revectorizationReference.getNumberOfPixels(), 1));
+	printf("Discontinuity detection %f s, edge search %f s, revectorization %f s\n", revectorizationReference.getDiscontinuityTime(), 
+		revectorizationReference.getSearchTime(), revectorizationReference.getRevectorizationTime());
+	printf("RMS error %f, max error %f, %d pixels off by more than 1/255\n", computeShadowError(shadows, reference, size), maxError, numberOfMismatches);
+
+	if(revectorizationReference.getDiscontinuityMap()) {
+		int texels = shadowMapWidth * shadowMapHeight;
+		unsigned short *discontinuityMap = (unsigned short*)malloc(texels * 4 * sizeof(unsigned short));
+		glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[DISCONTINUITY_MAP_FRAMEBUFFER]);
+		glReadPixels(0, 0, shadowMapWidth, shadowMapHeight, GL_RGBA, GL_UNSIGNED_SHORT, discontinuityMap);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		int numberOfTexelMismatches = 0;
+		for(int texel = 0; texel < texels; texel++)
+			if(memcmp(discontinuityMap + texel * 4, revectorizationReference.getDiscontinuityMap() + texel * 4, 4 * sizeof(unsigned short)) != 0)
+				numberOfTexelMismatches++;
+		printf("Discontinuity map %f s, %d of %d texels differ\n", revectorizationReference.getDiscontinuityMapTime(), numberOfTexelMismatches, texels);
+		free(discontinuityMap);
+	}
+
+	free(vertexMap);
+	free(normalMap);
+	free(shadowMap);
+	free(shadows);
+	free(reference);
+
+}
+
+void benchmarkDiscontinuityMap()
+{
+
+	if(packedGBuffer) {
+		printf("The fetch counts of the CPU reference read the unpacked G-buffer\n");
+		return;
+	}
+	if(!shadowParams.conservative || !(shadowParams.SMSR || shadowParams.RPCFPlusSMSR || shadowParams.EDTSM)) {
+		printf("The discontinuity map is read by the conservative SMSR, RPCF and EDTSM\n");
+		return;
+	}
+
+	const int numberOfFrames = 20;
+	const int maxSearches[3] = {16, 32, 64};
+	bool previousDiscontinuityMapOn = discontinuityMapOn;
+	int previousMaxSearch = shadowParams.maxSearch;
+	int size = windowWidth * windowHeight;
+	float *vertexMap = (float*)malloc(size * 4 * sizeof(float));
+	float *normalMap = (float*)malloc(size * 4 * sizeof(float));
+	float *shadowMap = (float*)malloc(shadowMapWidth * shadowMapHeight * sizeof(float));
+	float *shadows[2] = {(float*)malloc(size * sizeof(float)), (float*)malloc(size * sizeof(float))};
+	float *reference = (float*)malloc(size * sizeof(float));
+	GLuint query;
+	GLuint64 elapsedTime;
+	glGenQueries(1, &query);
+
+	//the fetches per pixel are counted by the CPU reference, which follows the lookups of the shader
+	discontinuityMapOn = false;
+	shadowMapCache.invalidate();
+	renderHardShadows();
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[GBUFFER_FRAMEBUFFER]);
+	glReadPixels(0, 0, windowWidth, windowHeight, GL_RGBA, GL_FLOAT, vertexMap);
+	glReadBuffer(GL_COLOR_ATTACHMENT1);
+	glReadPixels(0, 0, windowWidth, windowHeight, GL_RGBA, GL_FLOAT, normalMap);
+	glReadBuffer(GL_COLOR_ATTACHMENT0);
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[SHADOW_FRAMEBUFFER]);
+	glReadPixels(0, 0, shadowMapWidth, shadowMapHeight, GL_DEPTH_COMPONENT, GL_FLOAT, shadowMap);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	RevectorizationReference revectorizationReference;
+	revectorizationReference.setGBuffer(vertexMap, normalMap, windowWidth, windowHeight);
+	revectorizationReference.setShadowMap(shadowMap, shadowMapWidth, shadowMapHeight, 1);
+	revectorizationReference.setCamera(myGLGeometryViewer.getViewMatrix() * myGLGeometryViewer.getModelMatrix(), myGLGeometryViewer.normalMatrix, lightEye, 
+		myGLGeometryViewer.zNear, myGLGeometryViewer.zFar);
+
+	printf("%-11s%14s%14s%14s%14s%14s%14s%12s\n", "MaxSearch", "Fetches", "Map fetches", "Texel fetches", "Time (ms)", "Map (ms)", "Pre-pass (ms)", "RMS");
+	for(int run = 0; run < 3; run++) {
+
+		shadowParams.maxSearch = maxSearches[run];
+		double cameraPassTime[2], prePassTime = 0.0;
+		float fetches[2], prePassFetches = 0.0f;
+		for(int variant = 0; variant < 2; variant++) {
+
+			//the map is rebuilt with the shadow map, since maxSearch is part of the cache key
+			discontinuityMapOn = (variant == 1);
+			renderHardShadows();
+
+			cameraPassTime[variant] = 0.0;
+			for(int frame = 0; frame < numberOfFrames; frame++) {
+				glBeginQuery(GL_TIME_ELAPSED, query);
+				computeHardShadows();
+				glEndQuery(GL_TIME_ELAPSED);
+				glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsedTime);
+				cameraPassTime[variant] += elapsedTime / 1000000.0;
+			}
+			cameraPassTime[variant] /= numberOfFrames;
+			glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[HARD_SHADOW_FRAMEBUFFER]);
+			glReadPixels(0, 0, windowWidth, windowHeight, GL_RED, GL_FLOAT, shadows[variant]);
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+			if(variant == 1) {
+				for(int frame = 0; frame < numberOfFrames; frame++) {
+					glBeginQuery(GL_TIME_ELAPSED, query);
+					buildDiscontinuityMap();
+					glEndQuery(GL_TIME_ELAPSED);
+					glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsedTime);
+					prePassTime += elapsedTime / 1000000.0;
+				}
+				prePassTime /= numberOfFrames;
+			}
+
+			revectorizationReference.computeRevectorizedShadows(shadowParams, reference);
+			fetches[variant] = (float)revectorizationReference.getNumberOfFetches() / glm::max(revectorizationReference.getNumberOfPixels(), 1);
+			if(variant == 1) prePassFetches = (float)revectorizationReference.getDiscontinuityMapFetches() / (shadowMapWidth * shadowMapHeight);
+
+		}
+
+		//the fetches of the pre-pass are per shadow map texel, the others per tested pixel
+		printf("%-11d%14.2f%14.2f%14.2f%14f%14f%14f%12f\n", maxSearches[run], fetches[0], fetches[1], prePassFetches, cameraPassTime[0], 
+			cameraPassTime[1], prePassTime, computeShadowError(shadows[1], shadows[0], size));
+
+	}
+
+	free(vertexMap);
+	free(normalMap);
+	free(shadowMap);
+	free(shadows[0]);
+	free(shadows[1]);
+	free(reference);
+	glDeleteQueries(1, &query);
+	discontinuityMapOn = previousDiscontinuityMapOn;
+	shadowParams.maxSearch = previousMaxSearch;
+	shadowMapCache.invalidate();
+
+}
+
+void display()
+{
+	
+	if(referenceComparison) {
+		compareHardShadowReference();
+		referenceComparison = false;
+	}
+
+	if(revectorizationComparison) {
+		compareRevectorizationReference();
+		revectorizationComparison = false;
+	}
+
+	if(pcfBenchmark) {
+		benchmarkPCF();
+		pcfBenchmark = false;
+	}
+
+	if(prefilterBenchmark) {
+		benchmarkShadowMapPrefilter();
+		prefilterBenchmark = false;
+	}
+
+	if(receiverMaskBenchmark) {
+		benchmarkReceiverMask();
+		receiverMaskBenchmark = false;
+	}
+
+	if(cascadeBenchmark) {
+		benchmarkCascadedShadowMaps();
+		cascadeBenchmark = false;
+	}
+
+	if(discontinuityMapBenchmark) {
+		benchmarkDiscontinuityMap();
+		discontinuityMapBenchmark = false;
+	}
+
+	renderHardShadows();
+	shadeScene();
+	
+	glutSwapBuffers();
+	glutPostRedisplay();
+
+}
+
+void idle()
+{
+	
+	calculateFPS();
+
+	if(animationOn) {
+		if(!stop)
+			animation += 6;
+		if(animation == 1800)
+			animation = -1800;
+	}
+
+}	
+
 void keyboard(unsigned char key, int x, int y) 
 {
 
@@ -541,8 +1539,10 @@ void specialKeyboard(int key, int x, int y)
 			lightTranslationVector[1] += 5 * vel;
 		if(shadowIntensityOn)
 			shadowParams.shadowIntensity += 0.05;
-		if(changeKernelSizeOn)
-			gaussianFilter->buildGaussianKernel(gaussianFilter->getOrder() + 2);
+		if(changeKernelSizeOn) {
+			if(gaussianFilter->getOrder() + 2 <= MAX_FILTER_ORDER)
+				gaussianFilter->buildGaussianKernel(gaussianFilter->getOrder() + 2);
+		}
 		if(changePenumbraSizeOn)
 			shadowParams.penumbraSize++;
 		break;
@@ -689,6 +1689,14 @@ void shadowFilteringMenu(int id) {
 			resetShadowParams();
 			shadowParams.MSM = true;
 			break;
+		case 6:
+			resetShadowParams();
+			shadowParams.gatherPCF = true;
+			break;
+		case 7:
+			resetShadowParams();
+			shadowParams.optimizedPCF = true;
+			break;
 	}
 
 }
@@ -777,6 +1785,41 @@ void otherFunctionsMenu(int id) {
 			printf("Global Translation: %f %f %f\n", translationVector[0], translationVector[1], translationVector[2]);
 			printf("Global Rotation: %f %f %f\n", rotationAngles[0], rotationAngles[1], rotationAngles[2]);
 			break;
+		case 5:
+			shadowMapCache.setEnabled(!shadowMapCache.isEnabled());
+			break;
+		case 6:
+			cascadedShadowMaps = !cascadedShadowMaps;
+			break;
+		case 7:
+			cascadeBenchmark = true;
+			break;
+		case 8:
+			receiverMaskOn = !receiverMaskOn;
+			break;
+		case 9:
+			receiverMaskBenchmark = true;
+			break;
+		case 10:
+			prefilterBenchmark = true;
+			break;
+		case 11:
+			pcfBenchmark = true;
+			break;
+		case 12:
+			referenceComparison = true;
+			break;
+		case 13:
+			revectorizationComparison = true;
+			break;
+		case 14:
+			discontinuityMapOn = !discontinuityMapOn;
+			if(discontinuityMapOn && shadowParams.maxSearch > MAX_DISCONTINUITY_MAP_SEARCH)
+				printf("The discontinuity map holds walks up to %d texels, the search runs in the camera pass\n", MAX_DISCONTINUITY_MAP_SEARCH);
+			break;
+		case 15:
+			discontinuityMapBenchmark = true;
+			break;
 	}
 
 }
@@ -804,6 +1847,8 @@ void createMenu() {
 		glutAddMenuEntry("Exponential Shadow Mapping", 3);
 		glutAddMenuEntry("Exponential Variance Shadow Mapping", 4);
 		glutAddMenuEntry("Moment Shadow Mapping", 5);
+		glutAddMenuEntry("Gathered Percentage-Closer Filtering", 6);
+		glutAddMenuEntry("Optimized Percentage-Closer Filtering", 7);
 
 	shadowRevectorizationBasedFilteringMenuID = glutCreateMenu(shadowRevectorizationBasedFilteringMenu);
 		glutAddMenuEntry("Conservative Revectorization-based Shadow Mapping", 0);
@@ -825,6 +1870,17 @@ void createMenu() {
 		glutAddMenuEntry("Change Kernel Size [On/Off]", 2);
 		glutAddMenuEntry("Change Penumbra Size [On/Off]", 3);
 		glutAddMenuEntry("Print Data", 4);
+		glutAddMenuEntry("Shadow Map Cache [On/Off]", 5);
+		glutAddMenuEntry("Cascaded Shadow Maps [On/Off]", 6);
+		glutAddMenuEntry("Benchmark Cascaded Shadow Maps", 7);
+		glutAddMenuEntry("Receiver Mask [On/Off]", 8);
+		glutAddMenuEntry("Benchmark Receiver Mask", 9);
+		glutAddMenuEntry("Benchmark Shadow Map Prefiltering", 10);
+		glutAddMenuEntry("Benchmark Percentage-Closer Filtering", 11);
+		glutAddMenuEntry("Compare CPU Hard Shadow Reference", 12);
+		glutAddMenuEntry("Compare CPU Revectorization Reference", 13);
+		glutAddMenuEntry("Discontinuity Map [On/Off]", 14);
+		glutAddMenuEntry("Benchmark Discontinuity Map", 15);
 		
 	glutCreateMenu(mainMenu);
 		glutAddMenuEntry("Shadow Mapping", 0);
@@ -850,10 +1906,22 @@ void initGL(char *configurationFile) {
 		glGenBuffers(5, sceneVBO);
 	if(sceneTextures[0] == 0)
 		glGenTextures(4, sceneTextures);
+	if(shadowParams.shadowMapSampler == 0) {
+		glGenSamplers(1, &shadowParams.shadowMapSampler);
+		glSamplerParameteri(shadowParams.shadowMapSampler, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glSamplerParameteri(shadowParams.shadowMapSampler, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glSamplerParameteri(shadowParams.shadowMapSampler, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+		glSamplerParameteri(shadowParams.shadowMapSampler, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+		glSamplerParameteri(shadowParams.shadowMapSampler, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+		glSamplerParameteri(shadowParams.shadowMapSampler, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+	}
 
+	double loadingTime = cpu_time();
 	scene = new Mesh();
-	sceneLoader = new SceneLoader(configurationFile, scene);
+	sceneLoader = new SceneLoader(configurationFile, scene, compressTextures);
 	sceneLoader->load();
+	geometryVersion++;
+	printf("Scene loaded in %f s (%d of %d textures from cache)\n", cpu_time() - loadingTime, sceneLoader->getNumberOfCachedTextures(), scene->getNumberOfTextures());
 
 	gaussianFilter = new Filter();
 	gaussianFilter->buildGaussianKernel(7);
@@ -874,27 +1942,42 @@ void initGL(char *configurationFile) {
 	resetShadowParams();
 	shadowParams.naive = true;
 	shadowParams.conservative = false;
+	shadowParams.useDiscontinuityMap = false;
+	shadowParams.cascadedShadowMaps = false;
 	shadowParams.shadowIntensity = 0.25;
 	
 	myGLTextureViewer.loadQuad();
 	createMenu();
 
+	double uploadTime = cpu_time();
 	if(scene->textureFromImage())
 		for(int num = 0; num < scene->getNumberOfTextures(); num++)
-			myGLTextureViewer.loadRGBTexture(scene->getTexture()[num]->getData(), sceneTextures, num, scene->getTexture()[num]->getWidth(), scene->getTexture()[num]->getHeight());
+			myGLTextureViewer.loadRGBTexture(scene->getTexture()[num], sceneTextures, num);
+	glFinish();
+	printf("Textures uploaded in %f s\n", cpu_time() - uploadTime);
 	
 	myGLTextureViewer.loadRGBATexture((float*)NULL, textures, SHADOW_MAP_COLOR, shadowMapWidth, shadowMapHeight);
 	myGLTextureViewer.loadRGBATexture((float*)NULL, textures, FILTER_X_MAP_COLOR, windowWidth, windowHeight);
-	myGLTextureViewer.loadRGBATexture((float*)NULL, textures, FILTER_Y_MAP_COLOR, windowWidth, windowHeight);
-	myGLTextureViewer.loadRGBATexture((float*)NULL, textures, VERTEX_MAP_COLOR, windowWidth, windowHeight, GL_NEAREST);
-	myGLTextureViewer.loadRGBATexture((float*)NULL, textures, NORMAL_MAP_COLOR, windowWidth, windowHeight, GL_NEAREST);
-	myGLTextureViewer.loadRGBATexture((float*)NULL, textures, TEXTURE_MAP_COLOR, windowWidth, windowHeight, GL_NEAREST);
+	myGLTextureViewer.loadRGBATexture((float*)NULL, textures, PREFILTER_X_MAP_COLOR, shadowMapWidth, shadowMapHeight);
+	myGLTextureViewer.loadRGBATexture((float*)NULL, textures, PREFILTER_Y_MAP_COLOR, shadowMapWidth, shadowMapHeight);
+	if(packedGBuffer) {
+		//positions are reconstructed from the G-buffer depth, so 12 bytes per pixel are kept instead of 52
+		myGLTextureViewer.loadRGTexture((unsigned short*)NULL, textures, NORMAL_MAP_COLOR, windowWidth, windowHeight, GL_NEAREST);
+		myGLTextureViewer.loadRGBATexture((unsigned char*)NULL, textures, TEXTURE_MAP_COLOR, windowWidth, windowHeight, GL_NEAREST);
+	} else {
+		myGLTextureViewer.loadRGBATexture((float*)NULL, textures, VERTEX_MAP_COLOR, windowWidth, windowHeight, GL_NEAREST);
+		myGLTextureViewer.loadRGBATexture((float*)NULL, textures, NORMAL_MAP_COLOR, windowWidth, windowHeight, GL_NEAREST);
+		myGLTextureViewer.loadRGBATexture((float*)NULL, textures, TEXTURE_MAP_COLOR, windowWidth, windowHeight, GL_NEAREST);
+	}
 	myGLTextureViewer.loadRGBATexture((float*)NULL, textures, HARD_SHADOW_COLOR, windowWidth, windowHeight, GL_NEAREST);
 	myGLTextureViewer.loadRGBATexture((float*)NULL, textures, POSITION_MAP_COLOR, windowWidth, windowHeight, GL_NEAREST);
+	myGLTextureViewer.loadRGBATexture((float*)NULL, textures, DEPTH_REDUCTION_MAP_COLOR, windowWidth/16, windowHeight/16, GL_NEAREST);
+	for(int cascade = 0; cascade < NUMBER_OF_CASCADES; cascade++)
+		myGLTextureViewer.loadRGBATexture((float*)NULL, textures, CASCADE_BOUNDS_MAP_COLOR + cascade, windowWidth/16, windowHeight/16, GL_NEAREST);
+	myGLTextureViewer.loadRGBATexture((unsigned short*)NULL, textures, DISCONTINUITY_MAP_COLOR, shadowMapWidth, shadowMapHeight);
 	
 	myGLTextureViewer.loadDepthComponentTexture(NULL, textures, SHADOW_MAP_DEPTH, shadowMapWidth, shadowMapHeight);
 	myGLTextureViewer.loadDepthComponentTexture(NULL, textures, FILTER_X_MAP_DEPTH, windowWidth, windowHeight);
-	myGLTextureViewer.loadDepthComponentTexture(NULL, textures, FILTER_Y_MAP_DEPTH, windowWidth, windowHeight);
 	myGLTextureViewer.loadDepthComponentTexture(NULL, textures, GBUFFER_MAP_DEPTH, windowWidth, windowHeight);
 	myGLTextureViewer.loadDepthComponentTexture(NULL, textures, HARD_SHADOW_DEPTH, windowWidth, windowHeight);
 	
@@ -912,23 +1995,35 @@ void initGL(char *configurationFile) {
 	if(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE)
 		printf("FBO OK\n");
 
-	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[FILTER_Y_FRAMEBUFFER]);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, textures[FILTER_Y_MAP_DEPTH], 0);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[FILTER_Y_MAP_COLOR], 0);
+	//the shadow map prefilter has no depth attachment, it only draws a full-screen quad
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[PREFILTER_X_FRAMEBUFFER]);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[PREFILTER_X_MAP_COLOR], 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	if(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE)
+		printf("FBO OK\n");
+
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[PREFILTER_Y_FRAMEBUFFER]);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[PREFILTER_Y_MAP_COLOR], 0);
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 	if(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE)
 		printf("FBO OK\n");
 
 	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[GBUFFER_FRAMEBUFFER]);
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, textures[GBUFFER_MAP_DEPTH], 0);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[VERTEX_MAP_COLOR], 0);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, textures[NORMAL_MAP_COLOR], 0);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, textures[TEXTURE_MAP_COLOR], 0);
 	GLenum GBufferTemp[3];
 	GBufferTemp[0] = GL_COLOR_ATTACHMENT0;
 	GBufferTemp[1] = GL_COLOR_ATTACHMENT1;
 	GBufferTemp[2] = GL_COLOR_ATTACHMENT2;
-	glDrawBuffers(3, GBufferTemp);
+	if(packedGBuffer) {
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[NORMAL_MAP_COLOR], 0);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, textures[TEXTURE_MAP_COLOR], 0);
+		glDrawBuffers(2, GBufferTemp);
+	} else {
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[VERTEX_MAP_COLOR], 0);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, textures[NORMAL_MAP_COLOR], 0);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, textures[TEXTURE_MAP_COLOR], 0);
+		glDrawBuffers(3, GBufferTemp);
+	}
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 	
 	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[HARD_SHADOW_FRAMEBUFFER]);
@@ -943,10 +2038,28 @@ void initGL(char *configurationFile) {
 	if(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE)
 		printf("FBO OK\n");
 
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[DEPTH_REDUCTION_FRAMEBUFFER]);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[DEPTH_REDUCTION_MAP_COLOR], 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[CASCADE_BOUNDS_FRAMEBUFFER]);
+	GLenum CascadeBoundsTemp[NUMBER_OF_CASCADES];
+	for(int cascade = 0; cascade < NUMBER_OF_CASCADES; cascade++) {
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + cascade, GL_TEXTURE_2D, textures[CASCADE_BOUNDS_MAP_COLOR + cascade], 0);
+		CascadeBoundsTemp[cascade] = GL_COLOR_ATTACHMENT0 + cascade;
+	}
+	glDrawBuffers(NUMBER_OF_CASCADES, CascadeBoundsTemp);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[DISCONTINUITY_MAP_FRAMEBUFFER]);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[DISCONTINUITY_MAP_COLOR], 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
 	cudaGLSetGLDevice(0);
 	cudaGraphicsGLRegisterImage( &CUDAGraphicsResource[0], textures[HARD_SHADOW_COLOR], GL_TEXTURE_2D, 0);
 	cudaGraphicsGLRegisterImage( &CUDAGraphicsResource[1], textures[POSITION_MAP_COLOR], GL_TEXTURE_2D, 0);
-	cudaGraphicsGLRegisterImage( &CUDAGraphicsResource[2], textures[VERTEX_MAP_COLOR], GL_TEXTURE_2D, 0);
+	if(!packedGBuffer)
+		cudaGraphicsGLRegisterImage( &CUDAGraphicsResource[2], textures[VERTEX_MAP_COLOR], GL_TEXTURE_2D, 0);
 
 	pba2DInitialization(windowWidth, windowHeight);
 	
@@ -966,6 +2079,14 @@ int main(int argc, char **argv) {
 	glutSpecialFunc(specialKeyboard);
 
 	glewInit();
+	for(int arg = 2; arg < argc; arg++) {
+		if(strcmp(argv[arg], "-bc1") == 0)
+			compressTextures = true;
+		else if(strcmp(argv[arg], "-packed") == 0)
+			packedGBuffer = true;
+	}
+	if(packedGBuffer)
+		setShaderDefines("#define PACKED_GBUFFER\n");
 	initGL(argv[1]);
 
 	initShader("Shaders/Scene", SCENE_SHADER);
@@ -982,6 +2103,9 @@ int main(int argc, char **argv) {
 	initShader("Shaders/RBSM/FilteredRBSM", FILTERED_RBSM_SHADER);
 	initShader("Shaders/GBuffer/GBuffer", GBUFFER_SHADER);
 	initShader("Shaders/GBuffer/PhongShading", PHONG_SHADING_SHADER);
+	initShader("Shaders/ShadowMap/DepthReduction", DEPTH_REDUCTION_SHADER);
+	initShader("Shaders/ShadowMap/CascadeBoundsReduction", CASCADE_BOUNDS_REDUCTION_SHADER);
+	initShader("Shaders/RBSM/DiscontinuityMap", DISCONTINUITY_MAP_SHADER);
 	glUseProgram(0); 
 
 	glutMainLoop();
@@ -989,6 +2113,7 @@ int main(int argc, char **argv) {
 	delete scene;
 	delete sceneLoader;
 	delete gaussianFilter;
+	glDeleteSamplers(1, &shadowParams.shadowMapSampler);
 	pba2DDeinitialization();
 	cudaFree(GPUNormalizedEDTImage);
 	return 0;
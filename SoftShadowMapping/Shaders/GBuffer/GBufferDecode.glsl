@@ -0,0 +1,87 @@
+//G-buffer access shared by every shader that reads the vertex, normal and color maps.
+//With PACKED_GBUFFER the vertex map is the G-buffer depth, the normal map holds an octahedral
+//encoded normal (RG16) and the color map holds the albedo with a flags byte (RGBA8) in alpha:
+//bit 0 is set where geometry was rasterized and bit 1 where it was front facing
+uniform sampler2D vertexMap;
+uniform sampler2D normalMap;
+uniform sampler2D colorMap;
+
+#ifdef PACKED_GBUFFER
+
+uniform mat4 inverseGBufferMVP;
+
+vec2 signNotZero(vec2 v)
+{
+
+	return vec2((v.x >= 0.0) ? 1.0 : -1.0, (v.y >= 0.0) ? 1.0 : -1.0);
+
+}
+
+vec3 decodeOctahedron(vec2 encoded)
+{
+
+	encoded = encoded * 2.0 - 1.0;
+	vec3 normal = vec3(encoded.xy, 1.0 - abs(encoded.x) - abs(encoded.y));
+	if(normal.z < 0.0) normal.xy = (1.0 - abs(normal.yx)) * signNotZero(normal.xy);
+	return normalize(normal);
+
+}
+
+float fetchFlags(vec2 coord)
+{
+
+	return floor(texture2D(colorMap, coord).a * 255.0 + 0.5);
+
+}
+
+vec4 fetchVertex(vec2 coord)
+{
+
+	float depth = texture2D(vertexMap, coord).r;
+	if(depth >= 1.0) return vec4(0.0); //Background scene, as in the full layout
+
+	vec4 vertex = inverseGBufferMVP * vec4(vec3(coord, depth) * 2.0 - 1.0, 1.0);
+	return vec4(vertex.xyz / vertex.w, 1.0);
+
+}
+
+vec4 fetchNormal(vec2 coord)
+{
+
+	float frontFacing = step(2.0, fetchFlags(coord));
+	return vec4(decodeOctahedron(texture2D(normalMap, coord).rg), frontFacing);
+
+}
+
+vec4 fetchColor(vec2 coord)
+{
+
+	vec4 color = texture2D(colorMap, coord);
+	return vec4(color.rgb, mod(floor(color.a * 255.0 + 0.5), 2.0));
+
+}
+
+#else
+
+vec4 fetchVertex(vec2 coord)
+{
+
+	return texture2D(vertexMap, coord);
+
+}
+
+vec4 fetchNormal(vec2 coord)
+{
+
+	return texture2D(normalMap, coord);
+
+}
+
+vec4 fetchColor(vec2 coord)
+{
+
+	return texture2D(colorMap, coord);
+
+}
+
+#endif
@@ -1,7 +1,6 @@
 #extension GL_EXT_texture_array : enable
 uniform sampler2DArray shadowMapArray;
-uniform sampler2D vertexMap;
-uniform sampler2D normalMap;
+#include "GBuffer/GBufferDecode.glsl"
 uniform mat4 MV;
 uniform mat4 lightMVP;
 uniform mat3 normalMatrix;
@@ -69,10 +68,10 @@ vec4 computeDiscontinuity(vec4 normalizedLightCoord, float distanceFromLight, in
 void main()
 {	
 
-	vec4 vertex = texture2D(vertexMap, f_texcoord);
+	vec4 vertex = fetchVertex(f_texcoord);
 	if(vertex.x == 0.0) discard; //Discard background scene
 
-	vec4 normal = texture2D(normalMap, f_texcoord);
+	vec4 normal = fetchNormal(f_texcoord);
 	vec4 shadowCoord = lightMVP * vertex;
 	vec4 normalizedShadowCoord = shadowCoord / shadowCoord.w;
 	vec4 discontinuity = vec4(0.0);
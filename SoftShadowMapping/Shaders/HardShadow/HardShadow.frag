@@ -1,7 +1,6 @@
 uniform sampler2D shadowMap;
 uniform sampler2D softShadowMap;
-uniform sampler2D vertexMap;
-uniform sampler2D normalMap;
+#include "GBuffer/GBufferDecode.glsl"
 uniform mat4 MV;
 uniform mat4 MVP;
 uniform mat4 lightMVP;
@@ -35,10 +34,10 @@ float computePreEvaluationBasedOnNormalOrientation(vec4 vertex, vec4 normal)
 void main()
 {	
 
-    vec4 vertex = texture2D(vertexMap, f_texcoord);
+    vec4 vertex = fetchVertex(f_texcoord);
 	if(vertex.x == 0.0) discard; //Discard background scene
 
-	vec4 normal = texture2D(normalMap, f_texcoord);
+	vec4 normal = fetchNormal(f_texcoord);
 	vec4 shadowCoord = lightMVP * vertex;
 	vec4 normalizedShadowCoord = shadowCoord / shadowCoord.w;
 	vec2 shadow = vec2(0.0); //we store hard and projected shadow maps
@@ -1,6 +1,5 @@
 uniform sampler2D shadowMap;
-uniform sampler2D vertexMap;
-uniform sampler2D normalMap;
+#include "GBuffer/GBufferDecode.glsl"
 varying vec2 f_texcoord;
 uniform mat4 MV;
 uniform mat4 MVP;
@@ -318,10 +317,10 @@ float computePreEvaluationBasedOnNormalOrientation(vec4 vertex, vec4 normal)
 void main()
 {	
 
-	vec4 vertex = texture2D(vertexMap, f_texcoord);	
+	vec4 vertex = fetchVertex(f_texcoord);	
 	if(vertex.x == 0.0) discard; //Discard background scene
 
-	vec4 normal = texture2D(normalMap, f_texcoord);
+	vec4 normal = fetchNormal(f_texcoord);
 	vec4 shadowCoord = lightMVP * vertex;
 	vec4 normalizedLightCoord = shadowCoord / shadowCoord.w;
 	float shadow = computePreEvaluationBasedOnNormalOrientation(vertex, normal);
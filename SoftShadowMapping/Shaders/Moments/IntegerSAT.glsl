@@ -0,0 +1,19 @@
+#extension GL_EXT_gpu_shader4 : enable
+//Fixed-point moments of the integer summed-area table: 32-bit two's complement values with 16 fractional bits. Their sums 
+//wrap around, which leaves the box sums exact as long as they fit 31 bits, i.e. for up to 65536 texels of moments in [-0.5, 0.5].
+//Must be included first, the extension directive has to come before any declaration
+const float fixedPointScale = 65536.0;
+
+uvec2 toFixedPoint(vec2 moments)
+{
+
+	return uvec2(ivec2(floor(moments * fixedPointScale + 0.5)));
+
+}
+
+vec2 fromFixedPoint(uvec2 sum)
+{
+
+	return vec2(ivec2(sum)) / fixedPointScale;
+
+}
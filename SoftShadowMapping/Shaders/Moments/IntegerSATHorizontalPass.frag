@@ -0,0 +1,26 @@
+#include "Moments/IntegerSAT.glsl"
+uniform sampler2D momentMap;
+uniform usampler2D image;
+uniform int iteration;
+varying out uvec4 fixedPointSum;
+
+uvec2 fetchMoments(ivec2 texel)
+{
+
+	//texels left of the map add nothing, like the clamp-to-border reads of the float passes
+	if(texel.x < 0) return uvec2(0);
+	//the first pass reads the float moments and converts them
+	if(iteration == 0) return toFixedPoint(texelFetch2D(momentMap, texel, 0).xy);
+	return texelFetch2D(image, texel, 0).xy;
+
+}
+
+void main()
+{	
+
+	ivec2 texel = ivec2(gl_FragCoord.xy);
+	uvec2 currentPixel = fetchMoments(texel);
+	uvec2 leftPixel = fetchMoments(texel - ivec2(1 << iteration, 0));
+	fixedPointSum = uvec4(currentPixel + leftPixel, 0u, 0u);
+	
+}
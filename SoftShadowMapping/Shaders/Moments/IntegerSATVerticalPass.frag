@@ -0,0 +1,15 @@
+#include "Moments/IntegerSAT.glsl"
+uniform usampler2D image;
+uniform int iteration;
+varying out uvec4 fixedPointSum;
+
+void main()
+{	
+
+	ivec2 texel = ivec2(gl_FragCoord.xy);
+	ivec2 top = texel - ivec2(0, 1 << iteration);
+	uvec2 currentPixel = texelFetch2D(image, texel, 0).xy;
+	uvec2 topPixel = (top.y >= 0) ? texelFetch2D(image, top, 0).xy : uvec2(0);
+	fixedPointSum = uvec4(currentPixel + topPixel, 0u, 0u);
+
+}
@@ -1,3 +1,4 @@
+#extension GL_EXT_gpu_shader4 : enable
 uniform sampler2D image;
 varying vec2 f_texcoord;
 uniform int width;
@@ -5,19 +6,20 @@ uniform int height;
 uniform int iteration;
 
 void main()
-{	
+{
 
-	vec2 step = vec2(1.0/width, 1.0/height);
+	//the four children of the texel are read exactly, so the bounds hold for every depth under it
+	ivec2 texel = 2 * ivec2(gl_FragCoord.xy);
 	vec2 shadowValues[4];
 	float minShadowValue, maxShadowValue;
-	shadowValues[0] = texture2DLod(image, vec2(f_texcoord.s - step.s, f_texcoord.t - step.t), iteration - 1).xy;
-	shadowValues[1] = texture2DLod(image, vec2(f_texcoord.s - step.s, f_texcoord.t + step.t), iteration - 1).xy;
-	shadowValues[2] = texture2DLod(image, vec2(f_texcoord.s + step.s, f_texcoord.t - step.t), iteration - 1).xy;
-	shadowValues[3] = texture2DLod(image, vec2(f_texcoord.s + step.s, f_texcoord.t + step.t), iteration - 1).xy;
-	
+	shadowValues[0] = texelFetch2D(image, texel, iteration - 1).xy;
+	shadowValues[1] = texelFetch2D(image, texel + ivec2(0, 1), iteration - 1).xy;
+	shadowValues[2] = texelFetch2D(image, texel + ivec2(1, 0), iteration - 1).xy;
+	shadowValues[3] = texelFetch2D(image, texel + ivec2(1, 1), iteration - 1).xy;
+
 	minShadowValue = min(shadowValues[0].x, min(shadowValues[1].x, min(shadowValues[2].x, shadowValues[3].x)));
 	maxShadowValue = max(shadowValues[0].y, max(shadowValues[1].y, max(shadowValues[2].y, shadowValues[3].y)));
 
 	gl_FragColor = vec4(minShadowValue, maxShadowValue, 0.0, 1.0);
-	
+
 }
\ No newline at end of file
@@ -1,6 +1,6 @@
 #extension GL_EXT_texture_array : enable
 uniform sampler2DArray shadowMapArray;
-uniform sampler2D vertexMap;
+#include "GBuffer/GBufferDecode.glsl"
 uniform mat4 lightMVPs[4];
 uniform int shadowMapIndices[4];
 varying vec2 f_texcoord;
@@ -8,7 +8,7 @@ varying vec2 f_texcoord;
 void main()
 {	
 
-    vec4 vertex = texture2D(vertexMap, f_texcoord);
+    vec4 vertex = fetchVertex(f_texcoord);
 	if(vertex.x == 0.0) discard; //Discard background scene
 	
 	vec4 shadowCoord[4];
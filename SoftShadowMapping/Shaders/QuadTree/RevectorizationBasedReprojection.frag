@@ -1,7 +1,7 @@
 #extension GL_EXT_texture_array : enable
 uniform sampler2DArray shadowMapArray;
 uniform sampler2DArray discontinuityMapArray;
-uniform sampler2D vertexMap;
+#include "GBuffer/GBufferDecode.glsl"
 uniform sampler2D visibilityMap;
 uniform mat4 lightMVPs[4];
 uniform int shadowMapIndices[4];
@@ -14,7 +14,7 @@ varying vec2 f_texcoord;
 void main()
 {	
 
-	vec4 vertex = texture2D(vertexMap, f_texcoord);
+	vec4 vertex = fetchVertex(f_texcoord);
 	if(vertex.x == 0.0) discard; //Discard background scene
 	
 	vec4 shadowCoord[4];
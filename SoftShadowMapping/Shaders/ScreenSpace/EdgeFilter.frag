@@ -1,6 +1,6 @@
 uniform sampler2D image;
 uniform sampler2D shadowMap;
-uniform sampler2D vertexMap;
+#include "GBuffer/GBufferDecode.glsl"
 uniform mat4 MV;
 uniform mat4 MVP;
 uniform mat4 lightMVP;
@@ -73,7 +73,7 @@ float linearize(float depth) {
 void main()
 {	
 
-	vec4 vertex = texture2D(vertexMap, f_texcoord);	
+	vec4 vertex = fetchVertex(f_texcoord);	
 	if(vertex.x == 0.0) discard;
 	
 	vec2 step, center;
@@ -0,0 +1,52 @@
+//Window sums and guide shared by the guided filter passes. The summed-area tables hold inclusive sums, so the sum over the
+//texels [lower, upper] reads the four corners around it, and the row and column before the image read as zero.
+//Expects ScreenSpace/GuidedFilterFixedPoint.glsl to be included first, and f_texcoord, MV, windowWidth and windowHeight 
+//to be declared by the including shader
+uniform float guideOffset;
+const float farPlane = 1000.0;
+
+uvec4 fetchSAT(usampler2D table, ivec2 texel)
+{
+
+	if(texel.x < 0 || texel.y < 0) return uvec4(0u);
+	return texelFetch2D(table, texel, 0);
+
+}
+
+uvec4 computeFirstWindowSum(usampler2D table, ivec2 lower, ivec2 upper)
+{
+
+	uvec4 sum = subtractFirstTable(fetchSAT(table, upper), fetchSAT(table, ivec2(lower.x - 1, upper.y)));
+	sum = subtractFirstTable(sum, fetchSAT(table, ivec2(upper.x, lower.y - 1)));
+	return addFirstTable(sum, fetchSAT(table, lower - 1));
+
+}
+
+uvec4 computeSecondWindowSum(usampler2D table, ivec2 lower, ivec2 upper)
+{
+
+	uvec4 sum = subtractSecondTable(fetchSAT(table, upper), fetchSAT(table, ivec2(lower.x - 1, upper.y)));
+	sum = subtractSecondTable(sum, fetchSAT(table, ivec2(upper.x, lower.y - 1)));
+	return addSecondTable(sum, fetchSAT(table, lower - 1));
+
+}
+
+//The penumbra width is in texture coordinates along both axes, as in the separable bilateral filter
+void computeFilterWindow(float penumbraWidth, out ivec2 lower, out ivec2 upper)
+{
+
+	vec2 size = vec2(windowWidth, windowHeight);
+	vec2 center = floor(f_texcoord * size);
+	vec2 radius = floor(penumbraWidth * size + 0.5);
+	lower = ivec2(max(center - radius, vec2(0.0)));
+	upper = ivec2(min(center + radius, size - 1.0));
+
+}
+
+//Camera depth over the far plane, shifted by the depth of the point the camera looks at to keep the guide close to zero
+float computeGuide(vec4 vertex)
+{
+
+	return -(MV * vertex).z / farPlane - guideOffset;
+
+}
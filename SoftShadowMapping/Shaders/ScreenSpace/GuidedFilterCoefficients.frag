@@ -0,0 +1,47 @@
+#include "ScreenSpace/GuidedFilterFixedPoint.glsl"
+#include "GBuffer/GBufferDecode.glsl"
+uniform sampler2D hardShadowMap;
+uniform usampler2D momentsSAT;
+uniform usampler2D crossMomentSAT;
+uniform mat4 MV;
+uniform float guidedFilterEpsilon;
+uniform int windowWidth;
+uniform int windowHeight;
+varying vec2 f_texcoord;
+varying out uvec4 firstTable;
+varying out uvec4 secondTable;
+#include "ScreenSpace/GuidedFilter.glsl"
+
+//Linear model p = a * I + b of the shadow in the window of each receiver. Where the depth varies little against epsilon, 
+//a goes to zero and the window is averaged. Across a depth discontinuity the model follows the guide, so the surfaces 
+//on each side keep their own shadow. Writes (a, b) and the count of 1 for the averaging of the models that cover each pixel
+void main()
+{	
+
+	vec4 center = texture2D(hardShadowMap, f_texcoord.xy);
+	
+	if(center.r > 0.0) {
+
+		ivec2 lower, upper;
+		computeFilterWindow(center.g, lower, upper);
+		uvec4 moments = computeFirstWindowSum(momentsSAT, lower, upper);
+		uvec4 crossMoments = computeSecondWindowSum(crossMomentSAT, lower, upper);
+
+		//the window always holds the receiver at its centre
+		float count = max(float(crossMoments.z), 1.0);
+		float meanGuide = fromFixedPoint(moments.xy) / count;
+		float meanShadow = fromShadowFixedPoint(crossMoments.w) / count;
+		float variance = max(fromFixedPoint(moments.zw) / count - meanGuide * meanGuide, 0.0);
+		float covariance = fromFixedPoint(crossMoments.xy) / count - meanGuide * meanShadow;
+		float a = covariance / (variance + guidedFilterEpsilon);
+		firstTable = uvec4(toFixedPoint(a), toFixedPoint(meanShadow - a * meanGuide));
+		secondTable = uvec4(0u, 0u, 1u, 0u);
+
+	} else {
+
+		firstTable = uvec4(0u);
+		secondTable = uvec4(0u);
+
+	}
+
+}
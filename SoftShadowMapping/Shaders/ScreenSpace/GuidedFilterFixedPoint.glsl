@@ -0,0 +1,93 @@
+#extension GL_EXT_gpu_shader4 : enable
+//Fixed-point values of the guided filter tables. The guide, its square, the cross moment and the coefficients are 64-bit two's 
+//complement values with 24 fractional bits, split in a low and a high word. The shadow is a 32-bit value with 10 fractional bits, 
+//which holds the sums of windows of up to 2^21 texels, next to the receiver count. Their sums wrap around like those of 
+//Moments/IntegerSAT.glsl, so a window sum does not cancel against the sums of the whole image it is read from.
+//Must be included first, the extension directive has to come before any declaration
+const float fixedPointScale = 16777216.0;
+const float shadowFixedPointScale = 1024.0;
+
+uvec2 toFixedPoint(float value)
+{
+
+	float scaled = floor(value * fixedPointScale + 0.5);
+	
+	//values that fit the low word are converted exactly, the larger ones keep the precision of the float
+	if(abs(scaled) < 2147483648.0) {
+		int low = int(scaled);
+		return uvec2(uint(low), (low < 0) ? 0xFFFFFFFFu : 0u);
+	}
+
+	float high = floor(scaled / 4294967296.0);
+	return uvec2(uint(scaled - high * 4294967296.0), uint(int(high)));
+
+}
+
+float fromFixedPoint(uvec2 value)
+{
+
+	//sums that fit the low word are read from it alone, which keeps those close to zero exact
+	int low = int(value.x);
+	int high = int(value.y);
+	if(high == ((low < 0) ? -1 : 0)) return float(low) / fixedPointScale;
+	return (float(high) * 4294967296.0 + float(value.x)) / fixedPointScale;
+
+}
+
+uvec2 addFixedPoint(uvec2 a, uvec2 b)
+{
+
+	uint low = a.x + b.x;
+	return uvec2(low, a.y + b.y + ((low < a.x) ? 1u : 0u));
+
+}
+
+uvec2 subtractFixedPoint(uvec2 a, uvec2 b)
+{
+
+	return uvec2(a.x - b.x, a.y - b.y - ((a.x < b.x) ? 1u : 0u));
+
+}
+
+uint toShadowFixedPoint(float value)
+{
+
+	return uint(int(floor(value * shadowFixedPointScale + 0.5)));
+
+}
+
+float fromShadowFixedPoint(uint value)
+{
+
+	return float(int(value)) / shadowFixedPointScale;
+
+}
+
+//Adds two texels of the tables: the first holds two 64-bit values, the second a 64-bit value and two 32-bit ones
+uvec4 addFirstTable(uvec4 a, uvec4 b)
+{
+
+	return uvec4(addFixedPoint(a.xy, b.xy), addFixedPoint(a.zw, b.zw));
+
+}
+
+uvec4 addSecondTable(uvec4 a, uvec4 b)
+{
+
+	return uvec4(addFixedPoint(a.xy, b.xy), a.zw + b.zw);
+
+}
+
+uvec4 subtractFirstTable(uvec4 a, uvec4 b)
+{
+
+	return uvec4(subtractFixedPoint(a.xy, b.xy), subtractFixedPoint(a.zw, b.zw));
+
+}
+
+uvec4 subtractSecondTable(uvec4 a, uvec4 b)
+{
+
+	return uvec4(subtractFixedPoint(a.xy, b.xy), a.zw - b.zw);
+
+}
@@ -0,0 +1,34 @@
+#include "ScreenSpace/GuidedFilterFixedPoint.glsl"
+#include "GBuffer/GBufferDecode.glsl"
+uniform sampler2D hardShadowMap;
+uniform mat4 MV;
+uniform int windowWidth;
+uniform int windowHeight;
+varying vec2 f_texcoord;
+varying out uvec4 firstTable;
+varying out uvec4 secondTable;
+#include "ScreenSpace/GuidedFilter.glsl"
+
+//Per-pixel terms of the statistics of the guided filter, which regresses the shadow p on the guide I: (I, I * I) in the 
+//first target and (I * p, 1, p) in the second, in fixed point. Pixels without a receiver have zero weight, like the texels 
+//the bilateral filter skips. The shadow is centred around zero for the same reason as the guide
+void main()
+{	
+
+	float shadow = texture2D(hardShadowMap, f_texcoord.xy).r;
+	
+	if(shadow > 0.0) {
+
+		float guide = computeGuide(fetchVertex(f_texcoord.xy));
+		float value = shadow - 0.5;
+		firstTable = uvec4(toFixedPoint(guide), toFixedPoint(guide * guide));
+		secondTable = uvec4(toFixedPoint(guide * value), 1u, toShadowFixedPoint(value));
+
+	} else {
+
+		firstTable = uvec4(0u);
+		secondTable = uvec4(0u);
+
+	}
+
+}
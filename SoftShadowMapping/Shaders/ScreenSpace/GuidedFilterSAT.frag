@@ -0,0 +1,24 @@
+#include "ScreenSpace/GuidedFilterFixedPoint.glsl"
+uniform usampler2D image;
+uniform usampler2D secondImage;
+uniform int iteration;
+uniform int horizontal;
+varying out uvec4 firstTable;
+varying out uvec4 secondTable;
+
+//One step of the recursive doubling of IntegerSATHorizontalPass and IntegerSATVerticalPass, over both fixed-point targets 
+//of the guided filter. Texels before the first row or column add nothing instead of repeating the edge of the image
+void main()
+{	
+
+	ivec2 texel = ivec2(gl_FragCoord.xy);
+	ivec2 previous = texel - ((horizontal == 1) ? ivec2(1 << iteration, 0) : ivec2(0, 1 << iteration));
+	firstTable = texelFetch2D(image, texel, 0);
+	secondTable = texelFetch2D(secondImage, texel, 0);
+	
+	if(previous.x >= 0 && previous.y >= 0) {
+		firstTable = addFirstTable(firstTable, texelFetch2D(image, previous, 0));
+		secondTable = addSecondTable(secondTable, texelFetch2D(secondImage, previous, 0));
+	}
+	
+}
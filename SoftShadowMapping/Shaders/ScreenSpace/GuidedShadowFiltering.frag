@@ -0,0 +1,45 @@
+#include "ScreenSpace/GuidedFilterFixedPoint.glsl"
+#include "GBuffer/GBufferDecode.glsl"
+uniform sampler2D hardShadowMap;
+uniform usampler2D coefficientsSAT;
+uniform usampler2D countSAT;
+uniform mat4 MV;
+uniform float shadowIntensity;
+uniform int kernelSize;
+uniform int windowWidth;
+uniform int windowHeight;
+varying vec2 f_texcoord;
+#include "ScreenSpace/GuidedFilter.glsl"
+
+//Guided filter (He et al. 2010) in place of both passes of the bilateral filter of ScreenSpaceSoftShadow. The models of 
+//all the windows that cover the pixel are averaged and applied to its guide. Every window is read from a summed-area 
+//table, so the cost does not depend on the kernel size. Pixels out of the filtering range take the bilateral filter values
+void main()
+{	
+
+	vec4 center = texture2D(hardShadowMap, f_texcoord.xy);
+	
+	if(center.r > 0.0) {
+
+		float shadow = 1.0;
+		float stepSize = 2.0 * center.g/float(kernelSize);
+		
+		if(stepSize > 0.0 && stepSize < 1.0) {
+			ivec2 lower, upper;
+			computeFilterWindow(center.g, lower, upper);
+			uvec4 coefficients = computeFirstWindowSum(coefficientsSAT, lower, upper);
+			float count = max(float(computeSecondWindowSum(countSAT, lower, upper).z), 1.0);
+			float guide = computeGuide(fetchVertex(f_texcoord.xy));
+			shadow = (fromFixedPoint(coefficients.xy) * guide + fromFixedPoint(coefficients.zw)) / count + 0.5;
+			shadow = clamp(shadow, shadowIntensity, 1.0);
+		}
+
+		gl_FragColor = vec4(shadow, shadow, shadow, 1.0);
+
+	} else {
+
+		gl_FragColor = vec4(shadowIntensity, shadowIntensity, shadowIntensity, 1.0);
+	
+	}
+
+}
@@ -0,0 +1,34 @@
+uniform sampler2D image;
+uniform int width;
+uniform int height;
+uniform int stepSize;
+varying vec2 f_texcoord;
+
+//One pass of the jump flooding: each texel keeps the nearest of the seeds stored by itself and by the 8 texels 
+//stepSize away. The neighbours are visited in the same order as in DistanceTransform::computeJFA
+void main()
+{	
+
+	vec2 size = vec2(width, height);
+	vec2 texel = floor(gl_FragCoord.xy);
+	vec2 nearestSeed = vec2(-1.0);
+	float nearestDistance = 1.0e30;
+
+	for(int y = -1; y <= 1; y++) {
+		for(int x = -1; x <= 1; x++) {
+			vec2 neighbour = texel + vec2(x, y) * float(stepSize);
+			if(any(lessThan(neighbour, vec2(0.0))) || any(greaterThanEqual(neighbour, size))) continue;
+			vec2 seed = texture2D(image, (neighbour + 0.5)/size).xy;
+			if(seed.x < 0.0) continue;
+			vec2 difference = seed - texel;
+			float distance = dot(difference, difference);
+			if(distance < nearestDistance) {
+				nearestDistance = distance;
+				nearestSeed = seed;
+			}
+		}
+	}
+
+	gl_FragColor = vec4(nearestSeed, 0.0, 0.0);
+	
+}
@@ -0,0 +1,41 @@
+uniform sampler2D image;
+uniform sampler2D seedMap;
+uniform sampler2D positionMap;
+uniform float shadowIntensity;
+uniform int width;
+uniform int height;
+uniform int zNear;
+uniform int zFar;
+varying vec2 f_texcoord;
+
+float linearize(float depth) {
+
+	float n = float(zNear);
+	float f = float(zFar);
+	depth = (2.0 * n) / (f + n - depth * (f - n));
+	return depth;
+
+}
+
+//Same shading as pba2DEDTKernel, with the nearest site found by the jump flooding
+void main()
+{	
+
+	vec4 currentFragment = texture2D(image, f_texcoord);
+	vec2 seed = texture2D(seedMap, f_texcoord).xy;
+	float visibility = currentFragment.r;
+
+	if(seed.x >= 0.0) {
+		vec2 seedCoord = (seed + 0.5)/vec2(width, height);
+		vec4 seedFragment = texture2D(image, seedCoord);
+		float distance = length(texture2D(positionMap, f_texcoord).xyz - texture2D(positionMap, seedCoord).xyz);
+		float penumbraSize = seedFragment.a * 750.0;
+		if(seedFragment.b == 1.0 && abs(linearize(seedFragment.g) - linearize(currentFragment.g)) <= 0.0025 && distance <= penumbraSize/2.0) {
+			if(currentFragment.r == shadowIntensity) visibility = mix(0.5 - distance/penumbraSize, 1.0, shadowIntensity);
+			else visibility = mix(0.5 + distance/penumbraSize, 1.0, shadowIntensity);
+		}
+	}
+
+	gl_FragColor = vec4(visibility, currentFragment.g, 0.0, 0.0);
+	
+}
@@ -0,0 +1,13 @@
+uniform sampler2D image;
+varying vec2 f_texcoord;
+
+//Seeds of the jump flooding. The sites are marked as in initializeInput of the PBA and store their own texel, 
+//the other texels store -1
+void main()
+{	
+
+	vec4 currentFragment = texture2D(image, f_texcoord);
+	if(currentFragment.a != 0.0) gl_FragColor = vec4(floor(gl_FragCoord.xy), 0.0, 0.0);
+	else gl_FragColor = vec4(-1.0, -1.0, 0.0, 0.0);
+	
+}
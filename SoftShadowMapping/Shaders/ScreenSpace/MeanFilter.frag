@@ -1,5 +1,5 @@
 uniform sampler2D image;
-uniform sampler2D vertexMap;
+#include "GBuffer/GBufferDecode.glsl"
 uniform mat4 MV;
 uniform float shadowIntensity;
 uniform float fov;
@@ -59,7 +59,7 @@ vec4 blur(vec2 step, vec2 center, vec2 dir, vec4 vertex)
 void main()
 {	
 
-	vec4 vertex = texture2D(vertexMap, f_texcoord);	
+	vec4 vertex = fetchVertex(f_texcoord);	
 	if(vertex.x == 0.0) discard;
 
 	vec2 step, center, dir;
@@ -1,6 +1,6 @@
 uniform sampler2D hardShadowMap;
 uniform sampler2D shadowMap;
-uniform sampler2D vertexMap;
+#include "GBuffer/GBufferDecode.glsl"
 uniform mat4 lightMVP;
 uniform float shadowIntensity;
 uniform float sigmaColor;
@@ -61,7 +61,7 @@ vec2 computeAverageBlockerDepthBasedOnSSSM() {
 	vec2 blockerSearch = vec2(lightSourceRadius)/vec2(shadowMapWidth, shadowMapHeight);
 	vec2 stepSize = 2.0 * blockerSearch/float(blockerSearchSize);
 	vec2 shadow = vec2(0.0);
-	vec4 vertex = texture2D(vertexMap, f_texcoord);
+	vec4 vertex = fetchVertex(f_texcoord);
 	vec4 shadowCoord = lightMVP * vertex;
 	vec4 normalizedShadowCoord = shadowCoord / shadowCoord.w;
 		
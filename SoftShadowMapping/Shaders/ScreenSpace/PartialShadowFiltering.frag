@@ -1,5 +1,4 @@
-uniform sampler2D vertexMap;
-uniform sampler2D normalMap;
+#include "GBuffer/GBufferDecode.glsl"
 uniform sampler2D shadowMap;
 uniform sampler2D hardShadowMap;
 uniform sampler2D hierarchicalShadowMap;
@@ -24,6 +23,7 @@ uniform int SSPCSS;
 uniform int SSABSS;
 uniform int SSSM;
 uniform int SSRBSSM;
+uniform int guidedFilter;
 varying vec2 f_texcoord;
 
 float computeVisibilityFromHSM(vec4 normalizedShadowCoord) 
@@ -204,7 +204,7 @@ float bilateralShadowFiltering(float penumbraWidth) {
 
 			space = w * w;
 			color = (value - shadow) * (value - shadow);
-			if(SSABSS == 1 || SSRBSSM == 1) sigma = normalize(normalMatrix * texture2D(normalMap, f_texcoord.xy).xyz).z * 1000.0;
+			if(SSABSS == 1 || SSRBSSM == 1) sigma = normalize(normalMatrix * fetchNormal(f_texcoord.xy).xyz).z * 1000.0;
 			weight = exp(-(space * invSigmaSpace + color * invSigmaColor)/sigma);
 			illuminationCount += weight * shadow;
 			count += weight;
@@ -294,7 +294,7 @@ void main()
 	
 	if(shadow.r > 0.0) {
 	
-		vec4 vertex = texture2D(vertexMap, f_texcoord);
+		vec4 vertex = fetchVertex(f_texcoord);
 		vec4 shadowCoord = lightMVP * vertex;
 		vec4 normalizedShadowCoord = shadowCoord / shadowCoord.w;
 		
@@ -304,7 +304,10 @@ void main()
 		else if(SSSM == 1) averageDepth = computeAverageBlockerDepthBasedOnSSSM(normalizedShadowCoord);
 		
 		float penumbraWidth = computePenumbraWidth(averageDepth, normalizedShadowCoord.z, vertex);
-		if(SSPCSS == 1 || SSABSS == 1) {
+		//the guided filter passes filter both axes at once from the hard shadow and the penumbra width
+		if(guidedFilter == 1) {
+			gl_FragColor = vec4(shadow.r, penumbraWidth, 0.0, 1.0);
+		} else if(SSPCSS == 1 || SSABSS == 1) {
 			shadow.r = bilateralShadowFiltering(penumbraWidth);
 			gl_FragColor = vec4(shadow.r, penumbraWidth, 0.0, 1.0);
 		} else if(SSSM == 1) {
@@ -324,7 +327,7 @@ void main()
 				penumbraWidth = computePenumbraWidth(averageDepth, normalizedShadowCoord.z, vertex);
 				//shadow.rg = meanShadowFiltering(penumbraWidth);
 				//gl_FragColor = vec4(shadow.rg, penumbraWidth, 1.0);
-				shadow.r = bilateralShadowFiltering(penumbraWidth);
+				if(guidedFilter == 0) shadow.r = bilateralShadowFiltering(penumbraWidth);
 				gl_FragColor = vec4(shadow.r, penumbraWidth, 0.0, 1.0);
 			}
 
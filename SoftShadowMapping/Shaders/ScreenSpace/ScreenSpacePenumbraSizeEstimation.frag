@@ -1,5 +1,4 @@
-uniform sampler2D vertexMap;
-uniform sampler2D normalMap;
+#include "GBuffer/GBufferDecode.glsl"
 uniform sampler2D hardShadowMap;
 uniform sampler2D hierarchicalShadowMap;
 uniform mat4 MVP;
@@ -10,7 +9,7 @@ varying vec2 f_texcoord;
 void main()
 {	
 
-	vec4 vertex = texture2D(vertexMap, f_texcoord);	
+	vec4 vertex = fetchVertex(f_texcoord);	
 	if(vertex.x == 0.0) discard; //Discard background scene
 
 	vec4 shadow = texture2D(hardShadowMap, f_texcoord.xy);	float visibility = 0.0;
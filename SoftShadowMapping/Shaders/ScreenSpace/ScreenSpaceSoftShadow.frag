@@ -1,5 +1,4 @@
-uniform sampler2D vertexMap;
-uniform sampler2D normalMap;
+#include "GBuffer/GBufferDecode.glsl"
 uniform sampler2D hardShadowMap;
 uniform mat4 lightMVP;
 uniform mat4 MV;
@@ -8,15 +7,25 @@ uniform float shadowIntensity;
 uniform float sigmaColor;
 uniform float sigmaSpace;
 uniform float filterThreshold;
-uniform int kernelSize;
-uniform int blockerSearchSize;
 uniform int lightSourceRadius;
 uniform int windowWidth;
 uniform int windowHeight;
+//Fixed by the application in a SOFT_SHADOW_PERMUTATION, see PlausibleSoftShadow.frag
+#ifdef SOFT_SHADOW_PERMUTATION
+const int kernelSize = PERMUTATION_KERNEL_SIZE;
+const int blockerSearchSize = PERMUTATION_BLOCKER_SEARCH_SIZE;
+const int SSPCSS = PERMUTATION_SSPCSS;
+const int SSABSS = PERMUTATION_SSABSS;
+const int SSSM = PERMUTATION_SSSM;
+const int SSRBSSM = PERMUTATION_SSRBSSM;
+#else
+uniform int kernelSize;
+uniform int blockerSearchSize;
 uniform int SSPCSS;
 uniform int SSABSS;
 uniform int SSSM;
 uniform int SSRBSSM;
+#endif
 varying vec2 f_texcoord;
 
 float bilateralShadowFiltering() {
@@ -47,7 +56,7 @@ float bilateralShadowFiltering() {
 
 			space = h * h;
 			color = (value - shadow) * (value - shadow);
-			if(SSABSS == 1 || SSRBSSM == 1) sigma = normalize(normalMatrix * texture2D(normalMap, f_texcoord.xy).xyz).z * 1000.0;
+			if(SSABSS == 1 || SSRBSSM == 1) sigma = normalize(normalMatrix * fetchNormal(f_texcoord.xy).xyz).z * 1000.0;
 			weight = exp(-(space * invSigmaSpace + color * invSigmaColor)/sigma);
 			illuminationCount += weight * shadow;
 			count += weight;
@@ -114,7 +123,7 @@ float gaussianShadowFiltering()
 	float stepSize = 2.0 * penumbraWidth/float(kernelSize);
 	vec2 illuminationCount = compressedValues.ba;
 	float invSigmaSpace = 0.5f / (sigmaSpace * sigmaSpace);
-	float distance = -(MV * texture2D(vertexMap, f_texcoord.xy)).z;
+	float distance = -(MV * fetchVertex(f_texcoord.xy)).z;
 	
 	if(stepSize <= 0.0 || stepSize >= 1.0)
 		return 1.0;
@@ -122,7 +131,7 @@ float gaussianShadowFiltering()
 	for(float h = -penumbraWidth; h <= penumbraWidth; h += stepSize) {
 		
 		shadow = texture2D(hardShadowMap, vec2(f_texcoord.xy + vec2(0.0, h)));
-		float currentDistance = -(MV * texture2D(vertexMap, f_texcoord.xy + vec2(0.0, h))).z;
+		float currentDistance = -(MV * fetchVertex(f_texcoord.xy + vec2(0.0, h))).z;
 		
 		if(abs(distance - currentDistance) < filterThreshold) {
 			
@@ -1,7 +1,6 @@
 #extension GL_EXT_texture_array : enable
 uniform sampler2DArray shadowMapArray;
-uniform sampler2D vertexMap;
-uniform sampler2D normalMap;
+#include "GBuffer/GBufferDecode.glsl"
 uniform mat4 lightMVP;
 uniform mat4 MV;
 uniform mat3 normalMatrix;
@@ -14,8 +13,14 @@ uniform int windowHeight;
 uniform int shadowMapWidth;
 uniform int shadowMapHeight;
 uniform int monteCarlo;
+//Fixed by the application in a SOFT_SHADOW_PERMUTATION, see PlausibleSoftShadow.frag
+#ifdef SOFT_SHADOW_PERMUTATION
+const int adaptiveSampling = PERMUTATION_ADAPTIVE_SAMPLING;
+const int adaptiveSamplingLowerAccuracy = PERMUTATION_LOWER_ACCURACY;
+#else
 uniform int adaptiveSampling;
 uniform int adaptiveSamplingLowerAccuracy;
+#endif
 varying vec2 f_texcoord;
 
 float computePreEvaluationBasedOnNormalOrientation(vec4 vertex, vec4 normal)
@@ -52,10 +57,10 @@ float myPow(float value, int exponent) {
 void main()
 {	
 
-	vec4 vertex = texture2D(vertexMap, f_texcoord);
+	vec4 vertex = fetchVertex(f_texcoord);
 	if(vertex.x == 0.0) discard; //Discard background scene
 
-	vec4 normal = texture2D(normalMap, f_texcoord);
+	vec4 normal = fetchNormal(f_texcoord);
 	//float shadow = computePreEvaluationBasedOnNormalOrientation(vertex, normal);
 	float shadow = 1.0;
 	if(shadow == 1.0) {
@@ -0,0 +1,35 @@
+//Cascaded PCSS. With cascadedShadowMaps the shadow map is a 2x2 atlas whose quadrants cover consecutive ranges of camera
+//depth, each one with its own cropped light projection. Expects MV, lightMVP, shadowMapWidth and shadowMapHeight to be 
+//declared by the including shader
+uniform mat4 cascadeMVP[4];
+uniform vec3 cascadeSplits;
+uniform float cascadeScale[4]; //texel density of each cascade over the whole light frustum
+uniform int cascadedShadowMaps;
+//the cascade of the receiver, set by computeShadowCoord
+float cascadeFrustumScale = 1.0;
+vec4 cascadeQuadrant = vec4(0.0, 0.0, 1.0, 1.0);
+
+vec4 computeShadowCoord(vec4 vertex)
+{
+
+	if(cascadedShadowMaps == 0) return lightMVP * vertex;
+
+	float depth = -(MV * vertex).z;
+	int cascade = int(dot(vec3(greaterThan(vec3(depth), cascadeSplits)), vec3(1.0)));
+	vec2 origin = 0.5 * vec2(float(cascade - 2 * (cascade / 2)), float(cascade / 2));
+	cascadeFrustumScale = cascadeScale[cascade];
+	cascadeQuadrant = vec4(origin, origin + 0.5);
+	return cascadeMVP[cascade] * vertex;
+
+}
+
+//The blocker search and the filter taps stay in the quadrant of the cascade, as the texture edge clamps them without cascades
+vec2 clampToCascade(vec2 coord)
+{
+
+	if(cascadedShadowMaps == 0) return coord;
+
+	vec2 halfTexel = 0.5 / vec2(float(shadowMapWidth), float(shadowMapHeight));
+	return clamp(coord, cascadeQuadrant.xy + halfTexel, cascadeQuadrant.zw - halfTexel);
+
+}
@@ -0,0 +1,69 @@
+#include "GBuffer/GBufferDecode.glsl"
+uniform sampler2D lowResolutionVisibilityMap;
+uniform vec2 lowResolutionSize;
+uniform int reevaluateEdges;
+varying vec2 f_texcoord;
+
+//Joint-bilateral upsampling of the visibility evaluated at a reduced resolution. Each low resolution sample 
+//was shaded at the centre of its footprint, so its geometry is read from the full resolution G-buffer there.
+//The bilinear weights of the four nearest samples are scaled by their plane distance and normal similarity. Pixels 
+//where a sample on other geometry disagrees with the others are edges: they are discarded for the full 
+//resolution re-evaluation when the technique supports it, or take the most similar sample otherwise. 
+//Resolved pixels write depth 0, so the re-evaluation pass only runs on the edges
+void main()
+{	
+
+	vec4 vertex = fetchVertex(f_texcoord);
+	if(vertex.x == 0.0) discard; //Discard background scene
+
+	vec3 normal = normalize(fetchNormal(f_texcoord).xyz);
+	vec2 position = f_texcoord * lowResolutionSize - 0.5;
+	vec2 base = floor(position);
+	vec2 fraction = position - base;
+
+	float visibility = 0.0;
+	float weightSum = 0.0;
+	float minVisibility = 1.0;
+	float maxVisibility = 0.0;
+	float bestSimilarity = -1.0;
+	float bestVisibility = 0.0;
+	bool rejected = false;
+
+	for(int y = 0; y <= 1; y++) {
+		for(int x = 0; x <= 1; x++) {
+			
+			vec2 coord = clamp((base + vec2(x, y) + 0.5)/lowResolutionSize, 0.5/lowResolutionSize, 1.0 - 0.5/lowResolutionSize);
+			float bilinear = ((x == 0) ? 1.0 - fraction.x : fraction.x) * ((y == 0) ? 1.0 - fraction.y : fraction.y);
+			float sampleVisibility = texture2DLod(lowResolutionVisibilityMap, coord, 0.0).r;
+			vec4 sampleVertex = fetchVertex(coord);
+			
+			float similarity = 0.0;
+			if(sampleVertex.x != 0.0) {
+				//distance to the tangent plane relative to the sample spacing does not depend on the scene scale
+				vec3 offset = sampleVertex.xyz - vertex.xyz;
+				vec3 sampleNormal = normalize(fetchNormal(coord).xyz);
+				float planeDistance = abs(dot(normal, offset)) / (length(offset) + 0.0001);
+				similarity = exp(-planeDistance * 10.0) * pow(max(dot(normal, sampleNormal), 0.0), 8.0);
+			}
+
+			if(similarity < 0.5) rejected = true;
+			minVisibility = min(minVisibility, sampleVisibility);
+			maxVisibility = max(maxVisibility, sampleVisibility);
+			if(similarity > bestSimilarity) {
+				bestSimilarity = similarity;
+				bestVisibility = sampleVisibility;
+			}
+			visibility += bilinear * similarity * sampleVisibility;
+			weightSum += bilinear * similarity;
+				
+		}
+	}
+
+	bool edge = (rejected && maxVisibility - minVisibility > 0.02) || weightSum < 0.0001;
+	if(edge && reevaluateEdges == 1) discard;
+
+	float shadow = (weightSum < 0.0001) ? bestVisibility : visibility/weightSum;
+	gl_FragColor = vec4(shadow, shadow, shadow, 1.0);
+	gl_FragDepth = 0.0;
+	
+}
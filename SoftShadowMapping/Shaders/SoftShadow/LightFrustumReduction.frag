@@ -0,0 +1,32 @@
+#include "GBuffer/GBufferDecode.glsl"
+uniform mat4 lightMV;
+uniform vec2 gBufferSize;
+varying vec2 f_texcoord;
+
+//Reduces each 16x16 tile of the G-buffer to the light space bounds of its receivers: the largest horizontal and 
+//vertical tangents from the light axis. Alpha marks the tiles with receivers in front of the light
+void main()
+{	
+
+	vec2 tileOrigin = floor(f_texcoord * gBufferSize / 16.0) * 16.0;
+	vec4 bounds = vec4(0.0);
+
+	for(int y = 0; y < 16; y++) {
+		for(int x = 0; x < 16; x++) {
+
+			vec4 vertex = fetchVertex((tileOrigin + vec2(x, y) + 0.5)/gBufferSize);
+			if(vertex.x == 0.0) continue; //Background scene
+
+			vec4 lightSpaceVertex = lightMV * vertex;
+			float depth = -lightSpaceVertex.z;
+			if(depth <= 0.0) continue;
+
+			bounds.xy = max(bounds.xy, abs(lightSpaceVertex.xy)/depth);
+			bounds.w = 1.0;
+
+		}
+	}
+
+	gl_FragColor = bounds;
+	
+}
@@ -0,0 +1,80 @@
+#include "GBuffer/GBufferDecode.glsl"
+uniform sampler2D hierarchicalShadowMap;
+uniform mat4 MV;
+uniform mat4 lightMVP;
+uniform mat3 normalMatrix;
+uniform vec3 lightPosition;
+uniform float shadowIntensity;
+uniform float HSMAlpha;
+uniform float HSMBeta;
+uniform int shadowMapWidth;
+uniform int shadowMapHeight;
+uniform int lightSourceRadius;
+uniform float lightFrustumScale;
+varying vec2 f_texcoord;
+
+float computePreEvaluationBasedOnNormalOrientation(vec4 vertex, vec4 normal)
+{
+
+	vertex = MV * vertex;
+	normal.xyz = normalize(normalMatrix * normal.xyz);
+
+	vec3 L = normalize(lightPosition.xyz - vertex.xyz);   
+	
+	if(!bool(normal.w))
+		normal.xyz *= -1;
+
+	if(max(dot(normal.xyz,L), 0.0) == 0) 
+		return shadowIntensity;
+	else
+		return 1.0;
+
+}
+
+void main()
+{	
+
+	vec4 vertex = fetchVertex(f_texcoord);
+	if(vertex.x == 0.0) discard; //Discard background scene
+
+	vec4 normal = fetchNormal(f_texcoord);
+	vec4 shadowCoord = lightMVP * vertex;
+	vec4 normalizedShadowCoord = shadowCoord / shadowCoord.w;
+	float shadow = computePreEvaluationBasedOnNormalOrientation(vertex, normal);
+	
+	if(shadowCoord.w > 0.0 && shadow == 1.0) {
+
+		//Same blocker search region as the filtering shaders
+		float blockerSearchWidth;
+		if(shadowMapWidth <= 1024.0) blockerSearchWidth = lightFrustumScale * float(lightSourceRadius)/float(shadowMapWidth);
+		else blockerSearchWidth = lightFrustumScale * float(lightSourceRadius)/float(1024.0);
+
+		//A texel of this level is at least as wide as the region, so the texels under its corners cover all of it
+		vec2 shadowMapSize = vec2(float(shadowMapWidth), float(shadowMapHeight));
+		float mipLevel = ceil(log2(max(2.0 * blockerSearchWidth * shadowMapSize.x, 1.0)));
+		mipLevel = min(mipLevel, log2(shadowMapSize.x) - 1.0);
+		vec2 levelSize = shadowMapSize / exp2(mipLevel);
+		vec2 minCorner = (floor((normalizedShadowCoord.xy - blockerSearchWidth) * levelSize) + 0.5) / levelSize;
+		vec2 maxCorner = (floor((normalizedShadowCoord.xy + blockerSearchWidth) * levelSize) + 0.5) / levelSize;
+
+		vec2 minMax[4];
+		minMax[0] = texture2DLod(hierarchicalShadowMap, vec2(minCorner.x, minCorner.y), mipLevel).xy;
+		minMax[1] = texture2DLod(hierarchicalShadowMap, vec2(maxCorner.x, minCorner.y), mipLevel).xy;
+		minMax[2] = texture2DLod(hierarchicalShadowMap, vec2(minCorner.x, maxCorner.y), mipLevel).xy;
+		minMax[3] = texture2DLod(hierarchicalShadowMap, vec2(maxCorner.x, maxCorner.y), mipLevel).xy;
+
+		//The HSM offsets tuned for VSSM are removed, so the bounds stay conservative
+		float minDepth = min(min(minMax[0].x, minMax[1].x), min(minMax[2].x, minMax[3].x)) - HSMAlpha;
+		float maxDepth = max(max(minMax[0].y, minMax[1].y), max(minMax[2].y, minMax[3].y)) - HSMBeta;
+
+		if(normalizedShadowCoord.z <= minDepth) shadow = 1.0;
+		else if(normalizedShadowCoord.z > maxDepth) shadow = shadowIntensity;
+		else discard; //Penumbra, left to the filtering shader
+	
+	}
+
+	//Classified pixels sit in front of the full-screen quad of the filtering pass, which the depth test then rejects
+	gl_FragColor = vec4(shadow, 0.0, 0.0, 1.0);
+	gl_FragDepth = 0.0;
+	
+}
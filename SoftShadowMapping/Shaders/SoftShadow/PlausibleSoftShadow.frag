@@ -1,7 +1,8 @@
+#include "Moments/IntegerSAT.glsl"
 uniform sampler2D shadowMap;
-uniform sampler2D vertexMap;
-uniform sampler2D normalMap;
+#include "GBuffer/GBufferDecode.glsl"
 uniform sampler2D SATShadowMap;
+uniform usampler2D integerSATShadowMap;
 uniform sampler2D hierarchicalShadowMap;
 uniform mat4 momentInverseRotationMatrix;
 uniform mat4 MV;
@@ -11,6 +12,8 @@ uniform vec4 momentTranslationVector;
 uniform vec3 lightPosition;
 uniform float shadowIntensity;
 uniform float accFactor;
+uniform float momentBias;
+uniform int integerSAT; //SAVSM and VSSM
 uniform int zNear;
 uniform int zFar;
 uniform int windowWidth;
@@ -19,15 +22,30 @@ uniform int shadowMapWidth;
 uniform int shadowMapHeight;
 uniform int useTextureForColoring;
 uniform int useMeshColor;
+uniform int lightSourceRadius;
+uniform float lightFrustumScale; //Near plane extent of the default light frustum over the fitted one
+#include "SoftShadow/Cascades.glsl"
+//A permutation compiled with SOFT_SHADOW_PERMUTATION fixes the technique and the kernel sizes, so the
+//compiler removes the unused techniques and unrolls the kernel loops. Otherwise they are uniforms
+#ifdef SOFT_SHADOW_PERMUTATION
+const int blockerSearchSize = PERMUTATION_BLOCKER_SEARCH_SIZE;
+const int kernelSize = PERMUTATION_KERNEL_SIZE;
+const int PCSS = PERMUTATION_PCSS;
+const int SAVSM = PERMUTATION_SAVSM;
+const int VSSM = PERMUTATION_VSSM;
+const int ESSM = PERMUTATION_ESSM;
+const int MSSM = PERMUTATION_MSSM;
+const int SAT = PERMUTATION_SAT;
+#else
 uniform int blockerSearchSize;
 uniform int kernelSize;
-uniform int lightSourceRadius;
 uniform int PCSS;
 uniform int SAVSM;
 uniform int VSSM;
 uniform int ESSM;
 uniform int MSSM;
 uniform int SAT;
+#endif
 varying vec2 f_texcoord;
 
 float computePreEvaluationBasedOnNormalOrientation(vec4 vertex, vec4 normal)
@@ -75,6 +93,29 @@ vec2 recombinePrecision(vec4 value)
 	return value.xy;
 } 
 
+uvec2 fetchIntegerSAT(ivec2 texel)
+{
+
+	//texels outside of the table read as zero, like the clamp-to-border float table
+	if(any(lessThan(texel, ivec2(0))) || any(greaterThanEqual(texel, ivec2(shadowMapWidth, shadowMapHeight))))
+		return uvec2(0);
+	return texelFetch2D(integerSATShadowMap, texel, 0).xy;
+
+}
+
+//Sum of the moments between two corners of the integer summed-area table. Integer textures are not filtered, so the corners 
+//snap to the texels that contain them
+vec2 computeBoxSumFromIntegerSAT(vec2 lower, vec2 upper)
+{
+
+	vec2 size = vec2(shadowMapWidth, shadowMapHeight);
+	ivec2 A = ivec2(floor(lower * size));
+	ivec2 D = ivec2(floor(upper * size));
+	uvec2 sum = fetchIntegerSAT(D) + fetchIntegerSAT(A) - fetchIntegerSAT(ivec2(D.x, A.y)) - fetchIntegerSAT(ivec2(A.x, D.y));
+	return fromFixedPoint(sum);
+
+}
+
 float chebyshevUpperBound(vec2 moments, float distanceToLight)
 {
 	
@@ -94,7 +135,7 @@ vec3 computeMomentDepthsFromMSM(vec4 moments, vec3 normalizedShadowCoord)
 {
 
 	vec3 z, c, d;
-	float bias = 0.00003;
+	float bias = momentBias;
 	vec4 b = momentInverseRotationMatrix * (moments - momentTranslationVector);
 	b = (1.0 - bias) * b + bias * vec4(0.5, 0.5, 0.5, 0.5);
 	
@@ -135,7 +176,7 @@ vec3 computeWeightsFromMSM(vec4 moments, vec3 z)
 {
 
 	vec3 w;
-	float bias = 0.00003;
+	float bias = momentBias;
 	vec4 b = momentInverseRotationMatrix * (moments - momentTranslationVector);
 	b = (1.0 - bias) * b + bias * vec4(0.5, 0.5, 0.5, 0.5);
 	
@@ -149,7 +190,7 @@ vec3 computeWeightsFromMSM(vec4 moments, vec3 z)
 float computeShadowIntensityFromMSM(vec4 moments, vec3 z)
 {
 
-	float bias = 0.00003;
+	float bias = momentBias;
 	vec4 b = momentInverseRotationMatrix * (moments - momentTranslationVector);
 	b = (1.0 - bias) * b + bias * vec4(0.5, 0.5, 0.5, 0.5);
 	
@@ -169,15 +210,16 @@ float computeAverageBlockerDepthBasedOnPCF(vec4 normalizedShadowCoord)
 	float averageDepth = 0.0;
 	int numberOfBlockers = 0;
 	float blockerSearchWidth;
-	if(shadowMapWidth <= 1024.0) blockerSearchWidth = float(lightSourceRadius)/float(shadowMapWidth);
-	else blockerSearchWidth = float(lightSourceRadius)/float(1024.0);
+	if(shadowMapWidth <= 1024.0) blockerSearchWidth = lightFrustumScale * float(lightSourceRadius)/float(shadowMapWidth);
+	else blockerSearchWidth = lightFrustumScale * float(lightSourceRadius)/float(1024.0);
+	blockerSearchWidth *= cascadeFrustumScale;
 	float stepSize = 2.0 * blockerSearchWidth/float(blockerSearchSize);
 	float filterWidth = (blockerSearchSize - 1.0) * 0.5;
 	
 	for(int h = -filterWidth; h <= filterWidth; h++) {
 		for(int w = -filterWidth; w <= filterWidth; w++) {
 			
-			float distanceFromLight = texture2D(shadowMap, vec2(normalizedShadowCoord.xy + vec2(w, h) * blockerSearchWidth/filterWidth)).z;
+			float distanceFromLight = texture2D(shadowMap, clampToCascade(normalizedShadowCoord.xy + vec2(w, h) * blockerSearchWidth/filterWidth)).z;
 			if(normalizedShadowCoord.z > distanceFromLight) {
 				averageDepth += distanceFromLight;
 				numberOfBlockers++;
@@ -197,8 +239,8 @@ float computeAverageBlockerDepthBasedOnVSM(vec4 normalizedShadowCoord)
 {
 
 	float blockerSearchWidth;
-	if(shadowMapWidth <= 1024.0) blockerSearchWidth = float(lightSourceRadius)/float(shadowMapWidth);
-	else blockerSearchWidth = float(lightSourceRadius)/float(1024.0);
+	if(shadowMapWidth <= 1024.0) blockerSearchWidth = lightFrustumScale * float(lightSourceRadius)/float(shadowMapWidth);
+	else blockerSearchWidth = lightFrustumScale * float(lightSourceRadius)/float(1024.0);
 	float stepSize = 2.0 * blockerSearchWidth/float(blockerSearchSize);
 	float filterWidth = (blockerSearchSize - 1.0) * 0.5;
 	float zunocc = linearize(normalizedShadowCoord.z);
@@ -217,11 +259,15 @@ float computeAverageBlockerDepthBasedOnVSM(vec4 normalizedShadowCoord)
 		float ymax = normalizedShadowCoord.y + (div) * stepSize;
 		float ymin = normalizedShadowCoord.y - (div + 1.0) * stepSize;
 	
-		vec4 A = texture2D(SATShadowMap, vec2(xmin, ymin));
-		vec4 B = texture2D(SATShadowMap, vec2(xmax, ymin));
-		vec4 C = texture2D(SATShadowMap, vec2(xmin, ymax));
-		vec4 D = texture2D(SATShadowMap, vec2(xmax, ymax));
-		moments = recombinePrecision((D + A - B - C)/float(SATFilterSize * SATFilterSize)).xy;
+		if(integerSAT == 1) {
+			moments = computeBoxSumFromIntegerSAT(vec2(xmin, ymin), vec2(xmax, ymax))/float(SATFilterSize * SATFilterSize);
+		} else {
+			vec4 A = texture2D(SATShadowMap, vec2(xmin, ymin));
+			vec4 B = texture2D(SATShadowMap, vec2(xmax, ymin));
+			vec4 C = texture2D(SATShadowMap, vec2(xmin, ymax));
+			vec4 D = texture2D(SATShadowMap, vec2(xmax, ymax));
+			moments = recombinePrecision((D + A - B - C)/float(SATFilterSize * SATFilterSize)).xy;
+		}
 
 	} else {
  
@@ -247,8 +293,8 @@ float computeAverageBlockerDepthBasedOnESM(vec4 normalizedShadowCoord)
 {
 	
 	float blockerSearchWidth;
-	if(shadowMapWidth <= 1024.0) blockerSearchWidth = float(lightSourceRadius)/float(shadowMapWidth);
-	else blockerSearchWidth = float(lightSourceRadius)/float(1024.0);
+	if(shadowMapWidth <= 1024.0) blockerSearchWidth = lightFrustumScale * float(lightSourceRadius)/float(shadowMapWidth);
+	else blockerSearchWidth = lightFrustumScale * float(lightSourceRadius)/float(1024.0);
 
 	float stepSize = 2.0 * blockerSearchWidth/float(blockerSearchSize);
 	float filterWidth = (blockerSearchSize - 1.0) * 0.5;
@@ -305,7 +351,7 @@ float computeAverageBlockerDepthBasedOnMSM(vec4 normalizedShadowCoord)
 
 	float bias = 0.01;
 	float averageDepth = 0.0;
-	float blockerSearchWidth = float(lightSourceRadius)/float(shadowMapWidth);
+	float blockerSearchWidth = lightFrustumScale * float(lightSourceRadius)/float(shadowMapWidth);
 	float stepSize = 2.0 * blockerSearchWidth/float(blockerSearchSize);
 	float filterWidth = (blockerSearchSize - 1.0) * 0.5;
 	vec4 moments = vec4(0.0);
@@ -369,7 +415,7 @@ float computePenumbraWidth(float averageDepth, float distanceToLight)
 		return 0.0;
 
 	float penumbraWidth = ((distanceToLight - averageDepth)/averageDepth) * float(lightSourceRadius);
-	return (float(zNear) * penumbraWidth)/distanceToLight;
+	return cascadeFrustumScale * lightFrustumScale * (float(zNear) * penumbraWidth)/distanceToLight;
 	//float penumbraWidth = ((distanceToLight - averageDepth)/averageDepth);
 }
 
@@ -386,7 +432,7 @@ float PCF(float penumbraWidth, vec4 normalizedShadowCoord)
 	for(int h = -filterWidth; h <= filterWidth; h++) {
 		for(int w = -filterWidth; w <= filterWidth; w++) {
 			
-			float distanceFromLight = texture2D(shadowMap, normalizedShadowCoord.xy + vec2(w, h) * penumbraWidth/filterWidth).z;
+			float distanceFromLight = texture2D(shadowMap, clampToCascade(normalizedShadowCoord.xy + vec2(w, h) * penumbraWidth/filterWidth)).z;
 			if(normalizedShadowCoord.z <= distanceFromLight) illuminationCount++;
 			else illuminationCount += shadowIntensity;
 				
@@ -418,11 +464,15 @@ float VSM(float penumbraWidth, vec4 normalizedShadowCoord)
 		float ymax = normalizedShadowCoord.y + (div) * stepSize;
 		float ymin = normalizedShadowCoord.y - (div + 1.0) * stepSize;
 	
-		vec4 A = texture2D(SATShadowMap, vec2(xmin, ymin));
-		vec4 B = texture2D(SATShadowMap, vec2(xmax, ymin));
-		vec4 C = texture2D(SATShadowMap, vec2(xmin, ymax));
-		vec4 D = texture2D(SATShadowMap, vec2(xmax, ymax));
-		moments = recombinePrecision((D + A - B - C)/float(SATFilterSize * SATFilterSize)).xy;
+		if(integerSAT == 1) {
+			moments = computeBoxSumFromIntegerSAT(vec2(xmin, ymin), vec2(xmax, ymax))/float(SATFilterSize * SATFilterSize);
+		} else {
+			vec4 A = texture2D(SATShadowMap, vec2(xmin, ymin));
+			vec4 B = texture2D(SATShadowMap, vec2(xmax, ymin));
+			vec4 C = texture2D(SATShadowMap, vec2(xmin, ymax));
+			vec4 D = texture2D(SATShadowMap, vec2(xmax, ymax));
+			moments = recombinePrecision((D + A - B - C)/float(SATFilterSize * SATFilterSize)).xy;
+		}
 
 	} else {
 
@@ -537,14 +587,8 @@ float computeVisibilityFromHSM(vec4 normalizedShadowCoord)
 
 	float mipLevel = float(shadowMapWidth)/1024.0 + 0.5;
 	if(shadowMapWidth > 1024) mipLevel = 1.75;
-	/*
-	float zmin = texture2DLod(hierarchicalShadowMap, normalizedShadowCoord.xy, 8).x;
-	float wk = (float(lightSourceRadius)/float(shadowMapWidth)) * (1/zmin - 1/normalizedShadowCoord.z);
-	float mipLevel = floor(log2(wk));
-	float zmin2 = texture2DLod(hierarchicalShadowMap, normalizedShadowCoord.xy, mipLevel).x;
-	float wk2 = (float(lightSourceRadius)/float(shadowMapWidth)) * (1/zmin2 - 1/normalizedShadowCoord.z);
-	float mipLevel2 = abs(floor(log2(wk2))) + 1.75;
-	*/
+	//a fitted frustum covers lightFrustumScale times more texels with the same light footprint
+	mipLevel += log2(lightFrustumScale);
 	vec2 minMax = texture2DLod(hierarchicalShadowMap, normalizedShadowCoord.xy, mipLevel).xy;
 	
 	if(normalizedShadowCoord.z <= minMax.x) return 1.0;
@@ -605,11 +649,11 @@ float momentSoftShadowMapping(vec4 normalizedShadowCoord)
 void main()
 {	
 
-	vec4 vertex = texture2D(vertexMap, f_texcoord);
+	vec4 vertex = fetchVertex(f_texcoord);
 	if(vertex.x == 0.0) discard; //Discard background scene
 
-	vec4 normal = texture2D(normalMap, f_texcoord);
-	vec4 shadowCoord = lightMVP * vertex;
+	vec4 normal = fetchNormal(f_texcoord);
+	vec4 shadowCoord = computeShadowCoord(vertex);
 	vec4 normalizedShadowCoord = shadowCoord / shadowCoord.w;
 	float shadow = computePreEvaluationBasedOnNormalOrientation(vertex, normal);
 	
@@ -0,0 +1,74 @@
+#extension GL_EXT_texture_array : enable
+uniform sampler2DArray shadowMapArray;
+#include "GBuffer/GBufferDecode.glsl"
+uniform sampler2D historyMap;
+uniform mat4 lightMVP;
+uniform mat4 cameraMVP;
+uniform mat4 previousCameraMVP;
+uniform vec4 lightMVPTrans[289];
+uniform float shadowIntensity;
+uniform int numberOfSamples;
+uniform int totalNumberOfSamples;
+uniform int resetHistory;
+varying vec2 f_texcoord;
+
+void main()
+{	
+
+	vec4 vertex = fetchVertex(f_texcoord);
+	
+	//Background pixels are stored as converged so they do not hold back the convergence metric
+	if(vertex.x == 0.0) {
+		gl_FragData[0] = vec4(1.0, float(totalNumberOfSamples), 0.0, 1.0);
+		gl_FragData[1] = vec4(1.0, 0.0, 0.0, 1.0);
+		return;
+	}
+
+	vec4 shadowCoord;
+	vec4 commonShadowCoord;
+	float distanceFromLight;
+	float accShadow = 0.0;
+
+	commonShadowCoord.x = lightMVP[0][0] * vertex.x + lightMVP[1][0] * vertex.y + lightMVP[2][0] * vertex.z;
+	commonShadowCoord.y = lightMVP[0][1] * vertex.x + lightMVP[1][1] * vertex.y + lightMVP[2][1] * vertex.z;
+	commonShadowCoord.z = lightMVP[0][2] * vertex.x + lightMVP[1][2] * vertex.y + lightMVP[2][2] * vertex.z;
+	commonShadowCoord.w = lightMVP[0][3] * vertex.x + lightMVP[1][3] * vertex.y + lightMVP[2][3] * vertex.z;
+
+	//Only the subset of light samples rendered in this frame is stored in the shadow map array
+	for(int index = 0; index < numberOfSamples; index++) {
+				
+		shadowCoord = commonShadowCoord + lightMVPTrans[index];
+		shadowCoord /= shadowCoord.w;
+		distanceFromLight = texture2DArray(shadowMapArray, vec3(shadowCoord.xy, index)).z;		
+		accShadow += (shadowCoord.z <= distanceFromLight) ? 1.0 : shadowIntensity; 
+
+	}
+
+	//Visibility from the area light does not depend on the viewpoint, so the history is fetched at the previous screen position of the same surface point
+	vec4 currentPosition = cameraMVP * vec4(vertex.xyz, 1.0);
+	vec4 previousPosition = previousCameraMVP * vec4(vertex.xyz, 1.0);
+	vec2 previousTexcoord = (previousPosition.xy / previousPosition.w) * 0.5 + 0.5;
+	float mean = 0.0;
+	float count = 0.0;
+
+	if(resetHistory == 0 && previousPosition.w > 0.0 && all(greaterThanEqual(previousTexcoord, vec2(0.0))) && all(lessThanEqual(previousTexcoord, vec2(1.0)))) {
+		
+		//r: mean visibility, g: number of accumulated samples, b: view depth used to reject disoccluded pixels
+		vec4 history = texture2D(historyMap, previousTexcoord);
+		if(abs(history.b - previousPosition.w) <= 0.01 * previousPosition.w) {
+			mean = history.r;
+			count = history.g;
+		}
+
+	}
+
+	//Once every light sample has been seen the pixel is converged and the history is kept as is
+	if(count < float(totalNumberOfSamples)) {
+		mean = (mean * count + accShadow) / (count + float(numberOfSamples));
+		count = min(count + float(numberOfSamples), float(totalNumberOfSamples));
+	}
+
+	gl_FragData[0] = vec4(mean, count, currentPosition.w, 1.0);
+	gl_FragData[1] = vec4(mean, 0.0, 0.0, 1.0);
+	
+}
\ No newline at end of file
@@ -1,6 +1,5 @@
 uniform sampler2D shadowMap;
-uniform sampler2D vertexMap;
-uniform sampler2D normalMap;
+#include "GBuffer/GBufferDecode.glsl"
 uniform sampler2D hierarchicalShadowMap;
 uniform mat4 MV;
 uniform mat4 lightMVP;
@@ -17,6 +16,7 @@ uniform int maxSearch;
 uniform int blockerSearchSize;
 uniform int kernelSize;
 uniform int lightSourceRadius;
+uniform float lightFrustumScale;
 uniform int useTextureForColoring;
 uniform int useMeshColor;
 varying vec2 f_texcoord;
@@ -1152,8 +1152,8 @@ float computeAverageBlockerDepthBasedOnPCF(vec4 normalizedShadowCoord)
 	float averageDepth = 0.0;
 	int numberOfBlockers = 0;
 	float blockerSearchWidth;
-	if(shadowMapWidth <= 1024.0) blockerSearchWidth = float(lightSourceRadius)/float(shadowMapWidth);
-	else blockerSearchWidth = float(lightSourceRadius)/float(1024.0);
+	if(shadowMapWidth <= 1024.0) blockerSearchWidth = lightFrustumScale * float(lightSourceRadius)/float(shadowMapWidth);
+	else blockerSearchWidth = lightFrustumScale * float(lightSourceRadius)/float(1024.0);
 	float filterWidth = (blockerSearchSize - 1.0) * 0.5;
 	
 	for(int h = -filterWidth; h <= filterWidth; h++) {
@@ -1182,7 +1182,7 @@ float computePenumbraWidth(float averageDepth, float distanceToLight)
 		return 0.0;
 
 	float penumbraWidth = ((distanceToLight - averageDepth)/averageDepth) * float(lightSourceRadius);
-	return (float(zNear) * penumbraWidth)/distanceToLight;
+	return lightFrustumScale * (float(zNear) * penumbraWidth)/distanceToLight;
 	
 }
 
@@ -1362,10 +1362,10 @@ vec4 revectorizationBasedShadowMappingSmoothing(vec4 normalizedShadowCoord)
 void main()
 {	
 
-	vec4 vertex = texture2D(vertexMap, f_texcoord);
+	vec4 vertex = fetchVertex(f_texcoord);
 	if(vertex.x == 0.0) discard; //Discard background scene
 
-	vec4 normal = texture2D(normalMap, f_texcoord);
+	vec4 normal = fetchNormal(f_texcoord);
 	vec4 shadowCoord = lightMVP * vertex;
 	vec4 normalizedShadowCoord = shadowCoord / shadowCoord.w;
 	float shadow = computePreEvaluationBasedOnNormalOrientation(vertex, normal);
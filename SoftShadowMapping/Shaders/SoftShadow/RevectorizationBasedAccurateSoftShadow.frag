@@ -2,8 +2,7 @@
 uniform sampler2DArray shadowMapArray;
 uniform sampler2DArray discontinuityMapArray;
 uniform sampler2D visibilityMap;
-uniform sampler2D vertexMap;
-uniform sampler2D normalMap;
+#include "GBuffer/GBufferDecode.glsl"
 uniform mat4 lightMVP;
 uniform mat4 MV;
 uniform mat3 normalMatrix;
@@ -1252,10 +1251,10 @@ float linearize(float depth) {
 void main()
 {	
 
-	vec4 vertex = texture2D(vertexMap, f_texcoord);
+	vec4 vertex = fetchVertex(f_texcoord);
 	if(vertex.x == 0.0) discard; //Discard background scene
 	
-	vec4 normal = texture2D(normalMap, f_texcoord);
+	vec4 normal = fetchNormal(f_texcoord);
 	float shadow = computePreEvaluationBasedOnNormalOrientation(vertex, normal);
 	
 	if(shadow == 1.0)
@@ -0,0 +1,43 @@
+#extension GL_EXT_texture_array : enable
+uniform sampler2DArray shadowMapArray;
+#include "GBuffer/GBufferDecode.glsl"
+uniform mat4 lightMVP;
+uniform vec4 lightMVPTrans[289];
+uniform float shadowIntensity;
+uniform int sampleStride;
+varying vec2 f_texcoord;
+
+void main()
+{	
+
+	vec4 vertex = fetchVertex(f_texcoord);
+	if(vertex.x == 0.0) discard; //Discard background scene
+
+	vec4 shadowCoord;
+	vec4 commonShadowCoord;
+	float distanceFromLight;
+	float accShadow = 0.0;
+	float count = 0.0;
+
+	commonShadowCoord.x = lightMVP[0][0] * vertex.x + lightMVP[1][0] * vertex.y + lightMVP[2][0] * vertex.z;
+	commonShadowCoord.y = lightMVP[0][1] * vertex.x + lightMVP[1][1] * vertex.y + lightMVP[2][1] * vertex.z;
+	commonShadowCoord.z = lightMVP[0][2] * vertex.x + lightMVP[1][2] * vertex.y + lightMVP[2][2] * vertex.z;
+	commonShadowCoord.w = lightMVP[0][3] * vertex.x + lightMVP[1][3] * vertex.y + lightMVP[2][3] * vertex.z;
+
+	//Every tile drawn in this pass stopped at the same quadtree level, so the loop bounds are uniform
+	for(int y = 0; y <= 16; y += sampleStride) {
+		for(int x = 0; x <= 16; x += sampleStride) {
+
+			int index = y * 17 + x;
+			shadowCoord = commonShadowCoord + lightMVPTrans[index];
+			shadowCoord /= shadowCoord.w;
+			distanceFromLight = texture2DArray(shadowMapArray, vec3(shadowCoord.xy, index)).z;
+			accShadow += (shadowCoord.z <= distanceFromLight) ? 1.0 : shadowIntensity;
+			count++;
+
+		}
+	}
+
+	gl_FragColor = vec4(accShadow / count, 0.0, 0.0, 1.0);
+	
+}
@@ -0,0 +1,39 @@
+#ifndef DISTANCE_TRANSFORM_H
+#define DISTANCE_TRANSFORM_H
+
+#include <malloc.h>
+#include <math.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+
+//same conventions as the PBA textures: each pixel holds a pair of shorts with the coordinates of a site, or MARKER
+#define EDT_MARKER -32768
+#define EDT_TILE_SIZE 16
+#define MAX_JUMP_FLOODING_PASSES 32
+
+//CPU versions of the Voronoi diagrams computed by pba2D, to check and time the GPU ones. The full diagram is the
+//separable exact EDT (nearest site of each column, then the lower envelope of the column parabolas along each row).
+//The bounded one follows pba2DBoundedVoronoiDiagram tile by tile and the jump flooding follows Shaders/ScreenSpace/JumpFlooding
+class DistanceTransform
+{
+
+public:
+	DistanceTransform();
+	~DistanceTransform();
+
+	void computeEDT(short *sites, short *nearestSites, int width, int height);
+	void computeBoundedEDT(short *sites, short *nearestSites, int width, int height, int radius);
+	int compareBoundedEDT(short *nearestSites, short *boundedNearestSites, int width, int height, int radius);
+	void computeJFA(short *sites, short *nearestSites, int width, int height, int extraPasses);
+	int compareEDT(short *nearestSites, short *approximateNearestSites, int width, int height, float *meanError, float *maxError);
+	int getJumpFloodingSteps(int width, int height, int extraPasses, int *steps);
+
+	int getActiveTiles() { return activeTiles; }
+
+private:
+	int activeTiles;
+
+};
+
+#endif
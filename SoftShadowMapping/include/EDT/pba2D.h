@@ -52,6 +52,9 @@ DAMAGE.
 extern "C" void pba2DInitialization(int textureWidth, int textureHeight); 
 extern "C" void pba2DDeinitialization(); 
 extern "C" void pba2DVoronoiDiagram(int phase1Band, int phase2Band, int phase3Band, float shadowIntensity);
+// Sparse variant: only pixels within radius (<= MAX_BOUNDED_EDT_RADIUS) of a site get their nearest site
+extern "C" void pba2DBoundedVoronoiDiagram(int radius, float shadowIntensity);
+extern "C" int pba2DCountActiveTiles();
 extern "C" void pbaCudaBindTexture(cudaGraphicsResource_t *resource);
 extern "C" void pbaCudaUnbindTexture(cudaGraphicsResource_t *resource);
 
@@ -60,4 +63,6 @@ extern "C" void pbaCudaUnbindTexture(cudaGraphicsResource_t *resource);
 // Input texture should have x = MARKER for all pixels other than sites
 #define MARKER      -32768
 
+#define MAX_BOUNDED_EDT_RADIUS 64
+
 #endif
@@ -595,6 +595,12 @@ __global__ void pba2DEDTKernel(short2 *nearestSite, float *EDTImage, int cols, f
 	int pixel = blockIdx.x * blockDim.x + threadIdx.x;
 	short2 site = nearestSite[pixel];
 	float4 imagePixel = tex2D(pbaImage, pixel % cols, pixel / cols);
+	//no site within the bounded radius, the pixel is farther than any penumbra reaches
+	if(site.x == MARKER) {
+		EDTImage[pixel * 4 + 0] = imagePixel.x;
+		EDTImage[pixel * 4 + 1] = imagePixel.y;
+		return;
+	}
 	float4 nearestSiteImagePixel = tex2D(pbaImage, site.x, site.y);
 	float4 p1 = tex2D(pbaGlobalPosition, pixel % cols, pixel / cols);
 	float4 p2 = tex2D(pbaGlobalPosition, site.x, site.y);
@@ -606,4 +612,82 @@ __global__ void pba2DEDTKernel(short2 *nearestSite, float *EDTImage, int cols, f
 	else EDTImage[pixel * 4 + 0] = plerp<float>(0.5 + distance/penumbraSize, 1.0, shadowIntensity);
 	EDTImage[pixel * 4 + 1] = imagePixel.y;
 	
-}
\ No newline at end of file
+}
+// Sparse bounded-radius variant. Only the distances up to the widest penumbra are used by pba2DEDTKernel, so
+// the 16x16 tiles farther than the radius from any site skip the Voronoi diagram and keep MARKER. The last row and
+// column of tiles are partial when the size is not a multiple of 16, their threads outside the image do nothing
+__global__ void kernelMarkSiteTiles(short2 *sites, unsigned char *siteTiles, int cols, int rows)
+{
+	int x = blockIdx.x * TILE_DIM + threadIdx.x;
+	int y = blockIdx.y * TILE_DIM + threadIdx.y;
+	int hasSite = (x < cols && y < rows && sites[TOID(x, y, cols)].x != MARKER);
+	hasSite = __syncthreads_or(hasSite);
+	if(threadIdx.x == 0 && threadIdx.y == 0) siteTiles[blockIdx.y * gridDim.x + blockIdx.x] = hasSite;
+}
+
+__global__ void kernelDilateSiteTiles(unsigned char *siteTiles, unsigned char *activeTiles, int tilesX, int tilesY, int haloTiles)
+{
+	int tx = blockIdx.x * blockDim.x + threadIdx.x;
+	int ty = blockIdx.y * blockDim.y + threadIdx.y;
+	if(tx >= tilesX || ty >= tilesY) return;
+
+	unsigned char active = 0;
+	for(int y = max(ty - haloTiles, 0); y <= min(ty + haloTiles, tilesY - 1); y++)
+		for(int x = max(tx - haloTiles, 0); x <= min(tx + haloTiles, tilesX - 1); x++)
+			active |= siteTiles[y * tilesX + x];
+	activeTiles[ty * tilesX + tx] = active;
+}
+
+// One block per tile. The columns of the tile plus the halo are swept once down and once up to find the nearest site
+// of each column within the radius, then every pixel takes the closest of those candidates. Any site within the
+// radius lies in that window, so the result is exact for the pixels whose nearest site is within the radius
+__global__ void kernelBoundedColor(short2 *sites, short2 *output, unsigned char *activeTiles, int cols, int rows, int radius)
+{
+	__shared__ short columnSite[TILE_DIM][TILE_DIM + 2 * MAX_BOUNDED_EDT_RADIUS];
+
+	int x0 = blockIdx.x * TILE_DIM;
+	int y0 = blockIdx.y * TILE_DIM;
+	int y1 = min(y0 + TILE_DIM, rows);
+	int px = x0 + threadIdx.x;
+	int py = y0 + threadIdx.y;
+	bool inside = (px < cols && py < rows);
+
+	if(!activeTiles[blockIdx.y * gridDim.x + blockIdx.x]) {
+		if(inside) output[TOID(px, py, cols)] = make_short2(MARKER, MARKER);
+		return;
+	}
+
+	int windowWidth = TILE_DIM + 2 * radius;
+	for(int column = threadIdx.y * TILE_DIM + threadIdx.x; column < windowWidth; column += TILE_DIM * TILE_DIM) {
+		int x = x0 - radius + column;
+		int last = MARKER;
+		for(int y = max(y0 - radius, 0); y < y1; y++) {
+			if(x >= 0 && x < cols && sites[TOID(x, y, cols)].x != MARKER) last = y;
+			if(y >= y0) columnSite[y - y0][column] = (last != MARKER && y - last <= radius) ? last : MARKER;
+		}
+		last = MARKER;
+		for(int y = min(y1 - 1 + radius, rows - 1); y >= y0; y--) {
+			if(x >= 0 && x < cols && sites[TOID(x, y, cols)].x != MARKER) last = y;
+			if(y < y1 && last != MARKER && last - y <= radius) {
+				int above = columnSite[y - y0][column];
+				if(above == MARKER || last - y < y - above) columnSite[y - y0][column] = last;
+			}
+		}
+	}
+	__syncthreads();
+	if(!inside) return;
+
+	int bestDistance = radius * radius + 1;
+	short2 bestSite = make_short2(MARKER, MARKER);
+	for(int column = threadIdx.x; column <= threadIdx.x + 2 * radius; column++) {
+		int sy = columnSite[threadIdx.y][column];
+		if(sy == MARKER) continue;
+		int sx = x0 - radius + column;
+		int distance = (sx - px) * (sx - px) + (sy - py) * (sy - py);
+		if(distance < bestDistance) {
+			bestDistance = distance;
+			bestSite = make_short2(sx, sy);
+		}
+	}
+	output[TOID(px, py, cols)] = bestSite;
+}
@@ -4,6 +4,10 @@
 #include <malloc.h>
 #include <math.h>
 #include <stdio.h>
+#include <emmintrin.h>
+
+//steps per unit of the fixed-point moments, the same as fixedPointScale in Moments/IntegerSAT.glsl
+#define FIXED_POINT_SAT_SCALE 65536.0f
 
 class Filter
 {
@@ -14,6 +18,9 @@ public:
 	
 	void buildGaussianKernel(int order);
 	void buildBilateralKernel(int order);
+	void guidedFilter(float *input, float *guide, float *radius, float *output, int width, int height, float epsilon);
+	void computeFixedPointSAT(float *image, unsigned int *table, int width, int height);
+	void computeFixedPointBoxSum(unsigned int *table, int width, int *lower, int *upper, float *sum);
 
 	int getOrder() { return order; }
 	float* getKernel() { return kernel; }
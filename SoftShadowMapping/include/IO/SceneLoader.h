@@ -5,12 +5,13 @@
 #include <sstream>
 #include <iostream>
 #include "Scene\Mesh.h"
+#include "IO\TextureLoader.h"
 
 class SceneLoader
 {
 
 public:
-	SceneLoader(char *filename, Mesh *mesh);
+	SceneLoader(char *filename, Mesh *mesh, bool compressTextures = false);
 	void load();
 	float* getCameraPosition() { return cameraPosition; }
 	float* getCameraAt() { return cameraAt; }
@@ -19,7 +20,9 @@ public:
 	float getDepthThreshold() { return depthThreshold; }
 	float getHSMAlpha() { return HSMAlpha; }
 	float getHSMBeta() { return HSMBeta; }
+	int getNumberOfCachedTextures() { return numberOfCachedTextures; }
 private:
+	void prefetchTextures(TextureLoader *textureLoader);
 	Mesh *mesh;
 	std::fstream file;
 	float cameraPosition[3];
@@ -29,6 +32,8 @@ private:
 	float depthThreshold;
 	float HSMAlpha;
 	float HSMBeta;
+	bool compressTextures;
+	int numberOfCachedTextures;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,30 @@
+#ifndef TEXTURELOADER_H
+#define TEXTURELOADER_H
+
+#include <string>
+#include <vector>
+#include <opencv2\opencv.hpp>
+#include "Image.h"
+
+class TextureLoader
+{
+
+public:
+	TextureLoader(bool useCompression = false, bool useCache = true);
+	~TextureLoader();
+	void request(char *filename);
+	void decode();
+	Image* getImage(char *filename);
+	int getNumberOfCacheHits() { return cacheHits; }
+	int getNumberOfTextures() { return (int)images.size(); }
+	void loadImage(int index);
+private:
+	std::vector<std::string> filenames;
+	std::vector<Image*> images;
+	std::vector<int> fromCache;
+	bool useCompression;
+	bool useCache;
+	int cacheHits;
+};
+
+#endif
@@ -0,0 +1,109 @@
+#ifndef RBSSMREFERENCE_H
+#define RBSSMREFERENCE_H
+
+#include <malloc.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <omp.h>
+#include <GL/glew.h>
+#include "Viewers/ShadowParams.h"
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_inverse.hpp"
+
+#define MAX_BATCH_TAPS (1 << 20)
+
+//Kernel taps of one batch of rows, kernel size squared per pixel. Only the taps on a discontinuity keep their coordinates,
+//the others hold their shadow test in value from the start
+typedef struct RBSSMBatch
+{
+	glm::vec4 *lightCoord;
+	glm::vec4 *discontinuity;
+	glm::vec4 *discontinuitySpace; //left, right, down and up lengths of orientateDS
+	glm::vec2 *subCoord;
+	float *value; //illumination of the tap
+	unsigned char *onEdge;
+	glm::vec4 *pixelShadowCoord;
+	float *pixelPenumbraWidth;
+	float *pixelShadow; //pre-evaluated shadow, 0 for the background
+	unsigned char *pixelFiltered;
+} RBSSMBatch;
+
+//CPU evaluation of Shaders/SoftShadow/RBSSM.frag. It reads the G-buffer vertex and normal maps and the depth map and writes the
+//red channel of the soft shadow map. Each batch of rows runs in three stages, timed apart: the blocker search and the penumbra
+//width of every pixel, the discontinuity search of every kernel tap (computeDiscontinuity and the edge walks of orientateDS)
+//and the smoothing of the taps on a discontinuity (normalizeDS and smoothONDS). The shader code is transliterated as is, so
+//both paths take the same branches for the same depth map
+class RBSSMReference
+{
+
+public:
+	RBSSMReference();
+
+	void computeSoftShadows(ShadowParams shadowParams, float *shadows);
+
+	void setGBuffer(float *vertexMap, float *normalMap, int width, int height);
+	void setShadowMap(float *shadowMap, int width, int height);
+	void setCamera(glm::mat4 MV, glm::mat3 normalMatrix, glm::vec3 lightPosition, float zNear, float zFar);
+
+	double getBlockerSearchTime() { return blockerSearchTime; }
+	double getDiscontinuitySearchTime() { return discontinuitySearchTime; }
+	double getSmoothingTime() { return smoothingTime; }
+	int getNumberOfPixels() { return numberOfPixels; }
+	int getNumberOfTaps() { return numberOfTaps; }
+	int getNumberOfSearches() { return numberOfSearches; }
+
+private:
+	void allocateBatch(RBSSMBatch *batch, int numberOfPixels, int numberOfTaps);
+	void freeBatch(RBSSMBatch *batch);
+	int searchBlockers(RBSSMBatch *batch, int firstRow, int numberOfRows);
+	int searchDiscontinuities(RBSSMBatch *batch, int numberOfPixels);
+	void smoothDiscontinuities(RBSSMBatch *batch, int firstRow, int numberOfRows, float *shadows);
+	float fetchDepth(float s, float t);
+	float computePreEvaluationBasedOnNormalOrientation(glm::vec4 vertex, glm::vec4 normal);
+	float compressPositiveDiscontinuity(float normalizedDiscontinuity);
+	float decompressPositiveDiscontinuity(float normalizedDiscontinuity);
+	glm::vec4 getDisc(glm::vec4 normalizedLightCoord, float distanceFromLight);
+	bool getDisc(glm::vec4 normalizedLightCoord, glm::vec2 dir, float discType);
+	bool getDisc(glm::vec4 normalizedLightCoord, glm::vec2 dir, glm::vec4 discType);
+	float computeDiscontinuityLength(glm::vec4 inputDiscontinuity, glm::vec4 lightCoord, glm::vec2 dir, int maxSearch);
+	float normalizeDiscontinuitySpace(glm::vec2 dir, int maxSearch, float subCoord);
+	glm::vec4 orientateDS(glm::vec4 lightCoord, glm::vec4 discontinuity);
+	glm::vec4 normalizeDS(glm::vec2 subCoord, glm::vec4 dir);
+	float smoothONDS(glm::vec4 lightCoord, glm::vec4 normalizedDiscontinuity, glm::vec4 discontinuity, glm::vec2 subCoord);
+	glm::vec4 computeDiscontinuity(glm::vec4 normalizedLightCoord, float distanceFromLight);
+	float computeAverageBlockerDepthBasedOnPCF(glm::vec4 normalizedShadowCoord);
+	float computePenumbraWidth(float averageDepth, float distanceToLight);
+
+	float *vertexMap;
+	float *normalMap;
+	float *shadowMap;
+	int width;
+	int height;
+	int shadowMapWidth;
+	int shadowMapHeight;
+	glm::mat4 MV;
+	glm::mat3 normalMatrix;
+	glm::vec3 lightPosition;
+	glm::mat4 lightMVP; //biased as in configureShadow
+	glm::vec2 shadowMapStep;
+	float depthThreshold;
+	float shadowIntensity;
+	float lightFrustumScale;
+	int maxSearch;
+	int blockerSearchSize;
+	int kernelSize;
+	int lightSourceRadius;
+	int zNear;
+	int zFar;
+	int tapsPerPixel;
+	double blockerSearchTime;
+	double discontinuitySearchTime;
+	double smoothingTime;
+	int numberOfPixels;
+	int numberOfTaps;
+	int numberOfSearches;
+
+};
+
+#endif
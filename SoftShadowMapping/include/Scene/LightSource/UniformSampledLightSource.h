@@ -4,20 +4,37 @@
 #include "glm/glm.hpp"
 #include "Scene/LightSource/LightSource.h"
 
+enum LightSamplingPattern {
+	REGULAR_GRID_SAMPLING = 0,
+	STRATIFIED_SAMPLING = 1,
+	HALTON_SAMPLING = 2,
+	SOBOL_SAMPLING = 3,
+	BLUE_NOISE_SAMPLING = 4
+};
+
 class UniformSampledLightSource : public LightSource
 {
 public:
 	
-	UniformSampledLightSource(LightSource *lightSource, int numberOfPointLights);
+	UniformSampledLightSource(LightSource *lightSource, int numberOfPointLights, int samplingPattern = REGULAR_GRID_SAMPLING);
+	~UniformSampledLightSource();
 	
 	int getNumberOfPointLights() { return numberOfPointLights; }
+	int getSamplingPattern() { return samplingPattern; }
 	glm::vec3 getEye(int sampleIndex);
 	glm::vec3 getAt(int sampleIndex);
 	
 private:
 
+	void computeRegularGridSampling();
+	void computeStratifiedSampling();
+	void computeHaltonSampling();
+	void computeSobolSampling();
+	void computeBlueNoiseSampling();
 	glm::vec3 computeUniformSampling(glm::vec3 sample, int sampleIndex);
 	int numberOfPointLights;
+	int samplingPattern;
+	glm::vec2 *sampleOffsets;
 };
 
-#endif
\ No newline at end of file
+#endif
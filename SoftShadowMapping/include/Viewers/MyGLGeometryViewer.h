@@ -18,6 +18,7 @@ class MyGLGeometryViewer
 public:
 	MyGLGeometryViewer();
 	void configureAmbient(int windowWidth, int windowHeight);
+	void configureCascades(ShadowParams shadowParams);
 	void configureGBuffer(ShadowParams shadowParams);
 	void configureLight();	
 	void configureLinearization();
@@ -30,8 +31,10 @@ public:
 	glm::mat4 getViewMatrix() { return view; }
 	glm::mat4 getModelMatrix() { return model; }
 	glm::mat4 getPSRMatrix() { return psr; }
+	float getFov() { return fov; }
 	void loadVBOs(GLuint *VBOs, Mesh *scene);
 	void setEye(glm::vec3 eye) { this->eye = eye; }
+	void setFov(float fov) { this->fov = fov; }
 	void setLook(glm::vec3 look) { this->look = look; }
 	void setShaderProg(GLuint shaderProg) { this->shaderProg = shaderProg; }
 	void setUp(glm::vec3 up) { this->up = up; }
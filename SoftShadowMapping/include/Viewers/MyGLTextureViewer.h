@@ -6,6 +6,8 @@
 #include <GL/glew.h>
 #include <GL/glut.h>
 #include <stdio.h>
+#include <string.h>
+#include "Image.h"
 
 class MyGLTextureViewer
 {
@@ -15,14 +17,23 @@ public:
 	void createRGBATextureArray(GLuint *texVBO, int index, int imageWidth, int imageHeight, int size);
 	void loadDepthComponentTexture(float *data, GLuint *texVBO, int index, int imageWidth, int imageHeight);
 	void loadRGBTexture(const unsigned char *data, GLuint *texVBO, int index, int imageWidth, int imageHeight);
+	void loadRGBTexture(Image *image, GLuint *texVBO, int index);
 	void loadRGBTexture(float *data, GLuint *texVBO, int index, int imageWidth, int imageHeight, GLint param = GL_LINEAR_MIPMAP_LINEAR);
 	void loadRGBATexture(float *data, GLuint *texVBO, int index, int imageWidth, int imageHeight, GLint param = GL_LINEAR_MIPMAP_LINEAR);
 	void loadRGBATexture(int *data, GLuint *texVBO, int index, int imageWidth, int imageHeight, GLint param = GL_LINEAR_MIPMAP_LINEAR);
+	void loadRGBATexture(unsigned int *data, GLuint *texVBO, int index, int imageWidth, int imageHeight);
+	void loadRTexture(float *data, GLuint *texVBO, int index, int imageWidth, int imageHeight, GLint internalFormat, GLint param = GL_NEAREST);
+	void loadRGTexture(unsigned short *data, GLuint *texVBO, int index, int imageWidth, int imageHeight, GLint param = GL_NEAREST);
+	void loadRGTexture(unsigned int *data, GLuint *texVBO, int index, int imageWidth, int imageHeight);
+	void loadRGTexture(float *data, GLuint *texVBO, int index, int imageWidth, int imageHeight, GLint param = GL_NEAREST);
+	void loadRGBATexture(unsigned char *data, GLuint *texVBO, int index, int imageWidth, int imageHeight, GLint param = GL_NEAREST);
+	void loadRGBATexture(unsigned short *data, GLuint *texVBO, int index, int imageWidth, int imageHeight, GLint param = GL_LINEAR_MIPMAP_LINEAR);
 	void loadFrameBufferTexture(int x, int y, int width, int height, unsigned char *frameBuffer);
 	void loadQuad();
 	void configureSeparableFilter(int order, float *kernel, bool horizontal, bool vertical, float sigmaSpace = 0, float sigmaColor = 0);
 	void configureSeparableFilter(int order, bool horizontal, bool vertical, float shadowIntensity);
 	void drawTextureQuad();
+	void drawTextureQuads(float *texcoords, int numberOfQuads);
 	void drawTextureOnShader(GLuint texture, int imageWidth, int imageHeight);
 	void drawTexturesForBilateralFiltering(GLuint lightDepthTexture, GLuint eyeDepthTexture, GLuint shadowTexture, int imageWidth, int imageHeight);
 	void drawShadow(GLuint *texVBO, int sceneColorIndex, int shadowIndex, int windowWidth, int windowHeight, GLuint shaderProg);
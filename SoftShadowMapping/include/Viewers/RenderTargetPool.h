@@ -0,0 +1,51 @@
+#ifndef RENDERTARGETPOOL_H
+#define RENDERTARGETPOOL_H
+
+#include <vector>
+#include <GL/glew.h>
+#include "Viewers\MyGLTextureViewer.h"
+
+#define MAX_RENDER_TARGET_SLOTS 64
+
+typedef struct RenderTargetDescription
+{
+	GLenum internalFormat;
+	int width;
+	int height;
+	GLint filter;
+	bool transient;
+} RenderTargetDescription;
+
+typedef struct RenderTarget
+{
+	GLuint texture;
+	RenderTargetDescription description;
+	int users;
+} RenderTarget;
+
+class RenderTargetPool
+{
+
+public:
+	RenderTargetPool();
+	void declare(int slot, GLenum internalFormat, int width, int height, GLint filter, bool transient);
+	GLuint acquire(int slot);
+	void release(int slot);
+	void trim();
+	void clear();
+	long long getAllocatedBytes();
+	long long getDeclaredBytes();
+	long long getSavedBytes() { return getDeclaredBytes() - getAllocatedBytes(); }
+	void setTextureViewer(MyGLTextureViewer *textureViewer) { this->textureViewer = textureViewer; }
+private:
+	bool isEqual(RenderTargetDescription *a, RenderTargetDescription *b);
+	long long computeSize(RenderTargetDescription *description);
+	GLuint createTexture(RenderTargetDescription *description);
+	std::vector<RenderTarget> targets;
+	RenderTargetDescription slots[MAX_RENDER_TARGET_SLOTS];
+	bool declared[MAX_RENDER_TARGET_SLOTS];
+	int slotTarget[MAX_RENDER_TARGET_SLOTS];
+	MyGLTextureViewer *textureViewer;
+};
+
+#endif
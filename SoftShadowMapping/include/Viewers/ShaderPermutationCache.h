@@ -0,0 +1,29 @@
+#ifndef SHADERPERMUTATIONCACHE_H
+#define SHADERPERMUTATIONCACHE_H
+
+#include <string>
+#include <vector>
+#include <GL/glew.h>
+
+typedef struct ShaderPermutation
+{
+	std::string shaderName;
+	std::string defines;
+	GLuint program;
+} ShaderPermutation;
+
+class ShaderPermutationCache
+{
+
+public:
+	ShaderPermutationCache();
+	GLuint getProgram(char *shaderName, const char *defines);
+	void clear();
+	void printStatistics();
+	static void printProgram(const char *shaderName, const char *defines, GLuint program);
+	int getNumberOfPermutations() { return (int)permutations.size(); }
+private:
+	std::vector<ShaderPermutation> permutations;
+};
+
+#endif
@@ -3,11 +3,18 @@
 
 #include "glm/glm.hpp"
 
+#define NUMBER_OF_CASCADES 4
+
 typedef struct ShadowParams
 {
 	glm::mat4 lightMVP;
 	glm::mat4 lightMVPs[1024];
 	glm::mat4 quadTreeLightMVPs[4];
+	glm::mat4 cameraMVP; //progressiveMonteCarlo
+	glm::mat4 previousCameraMVP; //progressiveMonteCarlo
+	glm::mat4 inverseGBufferMVP; //packedGBuffer
+	glm::mat4 cascadeMVP[NUMBER_OF_CASCADES]; //cropped light transforms, one per atlas quadrant (PCSS)
+	glm::vec3 cascadeSplits; //camera depths between consecutive cascades
 	glm::vec4 lightTrans[1024];
 	int localQuadTreeHash[4];
 	int shadowMapWidth;
@@ -19,18 +26,28 @@ typedef struct ShadowParams
 	int lightSourceRadius;
 	int maxSearch; //RBSSM
 	int numberOfSamples; //monteCarlo
+	int totalNumberOfSamples; //progressiveMonteCarlo
 	int currentShadowMapSample;
 	int quadTreeLevel;
+	int sampleStride; //tiledAdaptiveSampling
 	float shadowIntensity;
 	float blockerThreshold; //SSSM
 	float filterThreshold; //SSSM
 	float depthThreshold; //RBSSM
 	float HSMAlpha;
 	float HSMBeta;
+	float lightFrustumScale; //fitted light frustum
+	float cascadeScale[NUMBER_OF_CASCADES]; //texel density of each cascade over the whole light frustum
 	float accFactor[1024]; //adaptiveSampling
 	bool renderFromCamera;
 	bool renderFromGBuffer;
 	bool monteCarlo;
+	bool progressiveMonteCarlo;
+	bool streamingMonteCarlo;
+	bool tiledAdaptiveSampling;
+	bool penumbraClassification;
+	bool cascadedShadowMaps; //PCSS
+	bool resetHistory; //progressiveMonteCarlo
 	bool adaptiveSampling;
 	bool adaptiveSamplingLowerAccuracy;
 	bool revectorizationBasedAdaptiveSampling;
@@ -50,6 +67,8 @@ typedef struct ShadowParams
 	bool SSRBSSM;
 	bool SSEDTSSM;
 	bool SAT; 
+	bool compactMoments; //MSSM moments stored as 16-bit UNORM
+	bool integerSAT; //fixed-point SAT for SAVSM and VSSM
 	bool useHardShadowMap;
 	bool useSoftShadowMap;
 	bool usePartialAverageBlockerDepthMap;
@@ -58,6 +77,7 @@ typedef struct ShadowParams
 	GLuint shadowMapArray;
 	GLuint discontinuityMapArray;
 	GLuint SATShadowMap;
+	GLuint integerSATShadowMap;
 	GLuint hierarchicalShadowMap;
 	GLuint hardShadowMap;
 	GLuint softShadowMap;
@@ -66,6 +86,7 @@ typedef struct ShadowParams
 	GLuint normalMap;
 	GLuint colorMap;
 	GLuint visibilityMap;
+	GLuint historyMap;
 } ShadowParams;
 
 #endif
\ No newline at end of file
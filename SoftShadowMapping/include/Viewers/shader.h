@@ -21,6 +21,7 @@
 typedef enum {
     EVertexShader,
     EFragmentShader,
+    EComputeShader,
 } EShaderType;
 
 
@@ -38,7 +39,7 @@ extern GLuint FragmentShaderObject;
 
 extern GLuint 	shaderVS; 
 extern GLuint 	shaderFS; 
-extern GLuint 	shaderProg[30];   // handles to objects
+extern GLuint 	shaderProg[47];   // handles to objects
 extern GLint  	linked;
 
 
@@ -87,6 +88,14 @@ static int shaderSize(char *fileName, EShaderType shaderType) ;
 // ***********************************************************************
 static int readShader(char *fileName, EShaderType shaderType, char *shaderText, int size) ;
 
+// ***********************************************************************
+//
+// Replaces every #include "<file>" line of the shader source with the
+// contents of Shaders/<file>.
+//
+// ***********************************************************************
+static GLchar *resolveIncludes(GLchar *source);
+
 // ***********************************************************************
 // ***********************************************************************
 
@@ -115,6 +124,31 @@ void getGlVersion( int *major, int *minor );
 // ** 
 // ***********************************************************************
 
+// ***********************************************************************
+// ** Preprocessor lines (e.g. "#define NAME\n") prepended to the shaders
+// ** compiled by the following calls to initShader. The string is not copied.
+// ***********************************************************************
+
+void setShaderDefines(const char *defines);
+
+// ***********************************************************************
+// ** 
+// ***********************************************************************
+
 void initShader(char* shaderName, int id );
 
+// ***********************************************************************
+// ** Compiles shaderName with the preprocessor lines in defines added after
+// ** the global ones. Returns the linked program, or 0 if it failed to build.
+// ***********************************************************************
+
+GLuint compileShaderPermutation(char *shaderName, const char *defines);
+
+// ***********************************************************************
+// ** Compiles the compute shader shaderName.comp into shaderProg[id]. The
+// ** GLSL 4.30 #version line is added by the loader, ahead of the defines.
+// ***********************************************************************
+
+void initComputeShader(char* shaderName, int id );
+
 
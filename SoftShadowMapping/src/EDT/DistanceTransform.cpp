@@ -0,0 +1,285 @@
+#include "EDT\DistanceTransform.h"
+
+DistanceTransform::DistanceTransform() {
+
+	activeTiles = 0;
+
+}
+
+DistanceTransform::~DistanceTransform() {
+
+}
+
+static int squaredDistance(int x0, int y0, int x1, int y1) {
+
+	return (x1 - x0) * (x1 - x0) + (y1 - y0) * (y1 - y0);
+
+}
+
+void DistanceTransform::computeEDT(short *sites, short *nearestSites, int width, int height) 
+{
+
+	//nearest site row of each pixel along its own column, EDT_MARKER when the column has no site
+	int *columnSite = (int*)malloc(width * height * sizeof(int));
+
+	#pragma omp parallel for
+	for(int x = 0; x < width; x++) {
+		int last = EDT_MARKER;
+		for(int y = 0; y < height; y++) {
+			if(sites[(y * width + x) * 2] != EDT_MARKER) last = y;
+			columnSite[y * width + x] = last;
+		}
+		last = EDT_MARKER;
+		for(int y = height - 1; y >= 0; y--) {
+			if(sites[(y * width + x) * 2] != EDT_MARKER) last = y;
+			int above = columnSite[y * width + x];
+			if(last != EDT_MARKER && (above == EDT_MARKER || last - y < y - above)) columnSite[y * width + x] = last;
+		}
+	}
+
+	//each column with a site is a parabola (x - column)^2 + (y - columnSite)^2 over the row. The lower envelope of
+	//the parabolas gives the nearest site of every pixel of the row
+	#pragma omp parallel for
+	for(int y = 0; y < height; y++) {
+		int *parabolas = (int*)malloc(width * sizeof(int));
+		double *boundaries = (double*)malloc((width + 1) * sizeof(double));
+		int *row = columnSite + y * width;
+		int k = -1;
+		for(int x = 0; x < width; x++) {
+			if(row[x] == EDT_MARKER) continue;
+			double fx = (double)(row[x] - y) * (row[x] - y) + (double)x * x;
+			double boundary = 0.0;
+			while(k >= 0) {
+				int p = parabolas[k];
+				double fp = (double)(row[p] - y) * (row[p] - y) + (double)p * p;
+				boundary = (fx - fp) / (2.0 * (x - p));
+				if(boundary > boundaries[k]) break;
+				k--;
+			}
+			k++;
+			parabolas[k] = x;
+			boundaries[k] = (k == 0) ? -1.0e30 : boundary;
+			boundaries[k + 1] = 1.0e30;
+		}
+
+		int parabola = 0;
+		for(int x = 0; x < width; x++) {
+			short *nearestSite = nearestSites + (y * width + x) * 2;
+			if(k < 0) {
+				nearestSite[0] = nearestSite[1] = EDT_MARKER;
+				continue;
+			}
+			while(boundaries[parabola + 1] < x) parabola++;
+			nearestSite[0] = parabolas[parabola];
+			nearestSite[1] = row[parabolas[parabola]];
+		}
+		free(parabolas);
+		free(boundaries);
+	}
+
+	free(columnSite);
+
+}
+
+void DistanceTransform::computeBoundedEDT(short *sites, short *nearestSites, int width, int height, int radius) 
+{
+
+	//the last row and column of tiles are partial when the size is not a multiple of the tile size
+	int tilesX = (width + EDT_TILE_SIZE - 1) / EDT_TILE_SIZE;
+	int tilesY = (height + EDT_TILE_SIZE - 1) / EDT_TILE_SIZE;
+	int haloTiles = (radius + EDT_TILE_SIZE - 1) / EDT_TILE_SIZE;
+	unsigned char *siteTiles = (unsigned char*)calloc(tilesX * tilesY, 1);
+
+	for(int y = 0; y < height; y++)
+		for(int x = 0; x < width; x++)
+			if(sites[(y * width + x) * 2] != EDT_MARKER) siteTiles[(y / EDT_TILE_SIZE) * tilesX + x / EDT_TILE_SIZE] = 1;
+
+	int windowWidth = EDT_TILE_SIZE + 2 * radius;
+	int numberOfActiveTiles = 0;
+
+	#pragma omp parallel for reduction(+:numberOfActiveTiles)
+	for(int tile = 0; tile < tilesX * tilesY; tile++) {
+
+		int tx = tile % tilesX, ty = tile / tilesX;
+		int x0 = tx * EDT_TILE_SIZE, y0 = ty * EDT_TILE_SIZE;
+		int x1 = (x0 + EDT_TILE_SIZE < width) ? x0 + EDT_TILE_SIZE : width;
+		int y1 = (y0 + EDT_TILE_SIZE < height) ? y0 + EDT_TILE_SIZE : height;
+
+		bool active = false;
+		for(int y = ty - haloTiles; y <= ty + haloTiles && !active; y++)
+			for(int x = tx - haloTiles; x <= tx + haloTiles && !active; x++)
+				if(x >= 0 && y >= 0 && x < tilesX && y < tilesY && siteTiles[y * tilesX + x]) active = true;
+
+		if(!active) {
+			for(int y = y0; y < y1; y++)
+				for(int x = x0; x < x1; x++)
+					nearestSites[(y * width + x) * 2] = nearestSites[(y * width + x) * 2 + 1] = EDT_MARKER;
+			continue;
+		}
+		numberOfActiveTiles++;
+
+		//the same two sweeps as kernelBoundedColor over the columns of the tile and its halo
+		int *columnSite = (int*)malloc(EDT_TILE_SIZE * windowWidth * sizeof(int));
+		for(int column = 0; column < windowWidth; column++) {
+			int x = x0 - radius + column;
+			bool inside = (x >= 0 && x < width);
+			int last = EDT_MARKER;
+			for(int y = (y0 - radius > 0) ? y0 - radius : 0; y < y1; y++) {
+				if(inside && sites[(y * width + x) * 2] != EDT_MARKER) last = y;
+				if(y >= y0) columnSite[(y - y0) * windowWidth + column] = (last != EDT_MARKER && y - last <= radius) ? last : EDT_MARKER;
+			}
+			last = EDT_MARKER;
+			for(int y = (y1 - 1 + radius < height - 1) ? y1 - 1 + radius : height - 1; y >= y0; y--) {
+				if(inside && sites[(y * width + x) * 2] != EDT_MARKER) last = y;
+				if(y < y1 && last != EDT_MARKER && last - y <= radius) {
+					int above = columnSite[(y - y0) * windowWidth + column];
+					if(above == EDT_MARKER || last - y < y - above) columnSite[(y - y0) * windowWidth + column] = last;
+				}
+			}
+		}
+
+		for(int y = 0; y < y1 - y0; y++) {
+			for(int x = 0; x < x1 - x0; x++) {
+				int px = x0 + x, py = y0 + y;
+				int bestDistance = radius * radius + 1;
+				short bestSite[2] = {EDT_MARKER, EDT_MARKER};
+				for(int column = x; column <= x + 2 * radius; column++) {
+					int sy = columnSite[y * windowWidth + column];
+					if(sy == EDT_MARKER) continue;
+					int sx = x0 - radius + column;
+					int distance = squaredDistance(px, py, sx, sy);
+					if(distance < bestDistance) {
+						bestDistance = distance;
+						bestSite[0] = sx;
+						bestSite[1] = sy;
+					}
+				}
+				nearestSites[(py * width + px) * 2] = bestSite[0];
+				nearestSites[(py * width + px) * 2 + 1] = bestSite[1];
+			}
+		}
+		free(columnSite);
+
+	}
+
+	activeTiles = numberOfActiveTiles;
+	free(siteTiles);
+
+}
+
+//Number of pixels where the bounded diagram is not exact: within the radius it must find a site as near as the full
+//diagram's (ties may pick another site), beyond it no site at all
+int DistanceTransform::compareBoundedEDT(short *nearestSites, short *boundedNearestSites, int width, int height, int radius) 
+{
+
+	int mismatches = 0;
+	for(int y = 0; y < height; y++) {
+		for(int x = 0; x < width; x++) {
+			short *site = nearestSites + (y * width + x) * 2;
+			short *boundedSite = boundedNearestSites + (y * width + x) * 2;
+			bool withinRadius = (site[0] != EDT_MARKER && squaredDistance(x, y, site[0], site[1]) <= radius * radius);
+			if(withinRadius) {
+				if(boundedSite[0] == EDT_MARKER || squaredDistance(x, y, boundedSite[0], boundedSite[1]) != squaredDistance(x, y, site[0], site[1]))
+					mismatches++;
+			} else if(boundedSite[0] != EDT_MARKER)
+				mismatches++;
+		}
+	}
+	return mismatches;
+
+}
+
+//Step sizes of the jump flooding passes: half the power of two that covers the image down to 1, then the steps of the 
+//error-correction passes (JFA+1 adds a pass of step 1, JFA+2 adds passes of step 2 and 1)
+int DistanceTransform::getJumpFloodingSteps(int width, int height, int extraPasses, int *steps) 
+{
+
+	int largestSide = (width > height) ? width : height;
+	int step = 1;
+	while(step < largestSide) step *= 2;
+
+	int numberOfSteps = 0;
+	for(step /= 2; step >= 1; step /= 2)
+		steps[numberOfSteps++] = step;
+	if(extraPasses >= 2) steps[numberOfSteps++] = 2;
+	if(extraPasses >= 1) steps[numberOfSteps++] = 1;
+	return numberOfSteps;
+
+}
+
+void DistanceTransform::computeJFA(short *sites, short *nearestSites, int width, int height, int extraPasses) 
+{
+
+	int steps[MAX_JUMP_FLOODING_PASSES];
+	int numberOfSteps = getJumpFloodingSteps(width, height, extraPasses, steps);
+	short *seeds = (short*)malloc(width * height * 2 * sizeof(short));
+	short *nextSeeds = (short*)malloc(width * height * 2 * sizeof(short));
+	memcpy(seeds, sites, width * height * 2 * sizeof(short));
+
+	for(int pass = 0; pass < numberOfSteps; pass++) {
+
+		int step = steps[pass];
+		#pragma omp parallel for
+		for(int y = 0; y < height; y++) {
+			for(int x = 0; x < width; x++) {
+				int nearestDistance = INT_MAX;
+				short nearestSeed[2] = {EDT_MARKER, EDT_MARKER};
+				for(int dy = -1; dy <= 1; dy++) {
+					for(int dx = -1; dx <= 1; dx++) {
+						int nx = x + dx * step, ny = y + dy * step;
+						if(nx < 0 || ny < 0 || nx >= width || ny >= height) continue;
+						short *seed = seeds + (ny * width + nx) * 2;
+						if(seed[0] == EDT_MARKER) continue;
+						int distance = squaredDistance(x, y, seed[0], seed[1]);
+						if(distance < nearestDistance) {
+							nearestDistance = distance;
+							nearestSeed[0] = seed[0];
+							nearestSeed[1] = seed[1];
+						}
+					}
+				}
+				nextSeeds[(y * width + x) * 2] = nearestSeed[0];
+				nextSeeds[(y * width + x) * 2 + 1] = nearestSeed[1];
+			}
+		}
+		short *temp = seeds;
+		seeds = nextSeeds;
+		nextSeeds = temp;
+
+	}
+
+	memcpy(nearestSites, seeds, width * height * 2 * sizeof(short));
+	free(seeds);
+	free(nextSeeds);
+
+}
+
+//Number of pixels whose approximate site is farther than the exact nearest one, with the mean (over all the pixels) and
+//the largest excess distance in pixels. Pixels the approximation left without a site only add to the count
+int DistanceTransform::compareEDT(short *nearestSites, short *approximateNearestSites, int width, int height, float *meanError, float *maxError) 
+{
+
+	int mismatches = 0;
+	double errorSum = 0.0;
+	*maxError = 0.0f;
+	for(int y = 0; y < height; y++) {
+		for(int x = 0; x < width; x++) {
+			short *site = nearestSites + (y * width + x) * 2;
+			short *approximateSite = approximateNearestSites + (y * width + x) * 2;
+			if(site[0] == EDT_MARKER) continue;
+			if(approximateSite[0] == EDT_MARKER) {
+				mismatches++;
+				continue;
+			}
+			float error = sqrtf((float)squaredDistance(x, y, approximateSite[0], approximateSite[1])) - sqrtf((float)squaredDistance(x, y, site[0], site[1]));
+			if(error > 0.0f) {
+				mismatches++;
+				errorSum += error;
+				if(error > *maxError) *maxError = error;
+			}
+		}
+	}
+	*meanError = (float)(errorSum / (width * height));
+	return mismatches;
+
+}
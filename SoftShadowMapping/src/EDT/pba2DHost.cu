@@ -67,6 +67,8 @@ texture<float4, cudaTextureType2D, cudaReadModeElementType> pbaImage;
 texture<float4, cudaTextureType2D, cudaReadModeElementType> pbaGlobalPosition;
 cudaArray* arrayDevice[2];
 float* GPUNormalizedEDTImage;
+unsigned char *pbaSiteTiles;    // 16x16 tiles that hold a site
+unsigned char *pbaActiveTiles;  // 16x16 tiles within the bounded radius of a site
 
 /********* Kernels ********/
 #include "EDT\pba2DKernel.h"
@@ -90,6 +92,8 @@ void pba2DInitialization(int textureWidth, int textureHeight)
     cudaMalloc((void **) &pbaTextures[1], pbaMemSize); 
 	cudaMalloc((void **) &pbaTransposed, pbaMemSize);
 	cudaMalloc(&GPUNormalizedEDTImage, pbaTexWidth * pbaTexHeight * 4 * sizeof(float));
+	cudaMalloc((void **) &pbaSiteTiles, ((pbaTexWidth + TILE_DIM - 1) / TILE_DIM) * ((pbaTexHeight + TILE_DIM - 1) / TILE_DIM));
+	cudaMalloc((void **) &pbaActiveTiles, ((pbaTexWidth + TILE_DIM - 1) / TILE_DIM) * ((pbaTexHeight + TILE_DIM - 1) / TILE_DIM));
 	
 }
 
@@ -104,6 +108,8 @@ void pba2DDeinitialization()
     cudaFree(pbaTextures[1]); 
 	cudaFree(pbaTransposed);
 	cudaFree(GPUNormalizedEDTImage);
+	cudaFree(pbaSiteTiles);
+	cudaFree(pbaActiveTiles);
     free(pbaTextures); 
 }
 
@@ -271,6 +277,45 @@ void pba2DVoronoiDiagram(int floodBand, int maurerBand, int colorBand, float sha
 
 }
 
+// Bounded 2D Voronoi diagram. Tiles with sites are dilated by the tiles the radius reaches, and only those
+// tiles search for their nearest site; the others get MARKER. The tiles on the right and bottom edges may be partial
+void pba2DBoundedCompute(int radius)
+{
+	int tilesX = (pbaTexWidth + TILE_DIM - 1) / TILE_DIM;
+	int tilesY = (pbaTexHeight + TILE_DIM - 1) / TILE_DIM;
+	int haloTiles = (radius + TILE_DIM - 1) / TILE_DIM;
+	dim3 block = dim3(TILE_DIM, TILE_DIM);
+	dim3 grid = dim3(tilesX, tilesY);
+
+	kernelMarkSiteTiles<<< grid, block>>>(pbaTextures[0], pbaSiteTiles, pbaTexWidth, pbaTexHeight);
+	kernelDilateSiteTiles<<< dim3((tilesX + BLOCKX - 1) / BLOCKX, (tilesY + BLOCKY - 1) / BLOCKY), dim3(BLOCKX, BLOCKY)>>>(pbaSiteTiles, pbaActiveTiles, tilesX, tilesY, haloTiles);
+	kernelBoundedColor<<< grid, block>>>(pbaTextures[0], pbaTextures[1], pbaActiveTiles, pbaTexWidth, pbaTexHeight, radius);
+}
+
+void pba2DBoundedVoronoiDiagram(int radius, float shadowIntensity)
+{
+
+	pba2DInitializeInput(0.0);
+	pba2DBoundedCompute(min(max(radius, 1), MAX_BOUNDED_EDT_RADIUS));
+	pba2DEDT(shadowIntensity);
+
+}
+
+// Number of tiles the last bounded diagram processed
+int pba2DCountActiveTiles()
+{
+
+	int numberOfTiles = ((pbaTexWidth + TILE_DIM - 1) / TILE_DIM) * ((pbaTexHeight + TILE_DIM - 1) / TILE_DIM);
+	unsigned char *activeTiles = (unsigned char*) malloc(numberOfTiles);
+	cudaMemcpy(activeTiles, pbaActiveTiles, numberOfTiles, cudaMemcpyDeviceToHost);
+	int count = 0;
+	for(int tile = 0; tile < numberOfTiles; tile++)
+		count += activeTiles[tile];
+	free(activeTiles);
+	return count;
+
+}
+
 void pbaCudaBindTexture(cudaGraphicsResource_t *resource) {
 
 	cudaGraphicsMapResources(2, resource);
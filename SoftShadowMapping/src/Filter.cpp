@@ -56,4 +56,191 @@ void Filter::buildBilateralKernel(int order) {
 		kernel[kernelCenter - i] = kernel[kernelCenter + i] = 0.39894f * exp((-0.5f * i * i)/(sigmaSpace * sigmaSpace)) / sigmaSpace;
 	}
 
-}
\ No newline at end of file
+}
+
+//inclusive summed-area table of vectorsPerTexel SSE2 vectors per texel. The rows are summed in parallel, then the columns 
+//in strips that keep each thread on its own cache lines
+static void computeSAT(__m128d *table, int width, int height, int vectorsPerTexel) 
+{
+
+	#pragma omp parallel for
+	for(int y = 0; y < height; y++) {
+		__m128d *row = table + y * width * vectorsPerTexel;
+		for(int x = 1; x < width; x++)
+			for(int v = 0; v < vectorsPerTexel; v++)
+				row[x * vectorsPerTexel + v] = _mm_add_pd(row[x * vectorsPerTexel + v], row[(x - 1) * vectorsPerTexel + v]);
+	}
+
+	#pragma omp parallel for
+	for(int strip = 0; strip < width; strip += 64) {
+		int stripEnd = (strip + 64 < width) ? strip + 64 : width;
+		for(int y = 1; y < height; y++) {
+			__m128d *row = table + y * width * vectorsPerTexel;
+			__m128d *previousRow = row - width * vectorsPerTexel;
+			for(int v = strip * vectorsPerTexel; v < stripEnd * vectorsPerTexel; v++)
+				row[v] = _mm_add_pd(row[v], previousRow[v]);
+		}
+	}
+
+}
+
+static __m128d fetchSAT(__m128d *table, int width, int vectorsPerTexel, int x, int y, int v) 
+{
+
+	if(x < 0 || y < 0) return _mm_setzero_pd();
+	return table[(y * width + x) * vectorsPerTexel + v];
+
+}
+
+static __m128d computeWindowSum(__m128d *table, int width, int vectorsPerTexel, int *lower, int *upper, int v) 
+{
+
+	__m128d sum = _mm_sub_pd(fetchSAT(table, width, vectorsPerTexel, upper[0], upper[1], v), fetchSAT(table, width, vectorsPerTexel, lower[0] - 1, upper[1], v));
+	sum = _mm_sub_pd(sum, fetchSAT(table, width, vectorsPerTexel, upper[0], lower[1] - 1, v));
+	return _mm_add_pd(sum, fetchSAT(table, width, vectorsPerTexel, lower[0] - 1, lower[1] - 1, v));
+
+}
+
+static void computeFilterWindow(float *radius, int width, int height, int x, int y, int *lower, int *upper) 
+{
+
+	int radiusX = (int)floorf(radius[0] + 0.5f);
+	int radiusY = (int)floorf(radius[1] + 0.5f);
+	lower[0] = (x - radiusX > 0) ? x - radiusX : 0;
+	lower[1] = (y - radiusY > 0) ? y - radiusY : 0;
+	upper[0] = (x + radiusX < width - 1) ? x + radiusX : width - 1;
+	upper[1] = (y + radiusY < height - 1) ? y + radiusY : height - 1;
+
+}
+
+//Guided filter (He et al. 2010) of the input regressed on the guide, over a window of radius[2 * pixel] x radius[2 * pixel + 1]
+//texels around each pixel. Pixels with input <= 0 are neither filtered nor used by their neighbours, as in the screen-space
+//shaders. Reference for GuidedShadowFiltering.frag: the sums are kept in double precision, two SSE2 lanes at a time, so the
+//tables do not lose the variance of the guide, and the rows are spread over the OpenMP threads
+void Filter::guidedFilter(float *input, float *guide, float *radius, float *output, int width, int height, float epsilon) 
+{
+
+	int size = width * height;
+	//(w, w * I), (w * p, w * I * I), (w * I * p, 0)
+	__m128d *statistics = (__m128d*)_mm_malloc(size * 3 * sizeof(__m128d), 16);
+	//(w, w * a), (w * b, 0)
+	__m128d *coefficients = (__m128d*)_mm_malloc(size * 2 * sizeof(__m128d), 16);
+
+	#pragma omp parallel for
+	for(int pixel = 0; pixel < size; pixel++) {
+		double weight = (input[pixel] > 0.0f) ? 1.0 : 0.0;
+		double value = weight * input[pixel];
+		double guideValue = weight * guide[pixel];
+		statistics[pixel * 3] = _mm_set_pd(guideValue, weight);
+		statistics[pixel * 3 + 1] = _mm_set_pd(guideValue * guide[pixel], value);
+		statistics[pixel * 3 + 2] = _mm_set_pd(0.0, guideValue * input[pixel]);
+	}
+	computeSAT(statistics, width, height, 3);
+
+	#pragma omp parallel for
+	for(int y = 0; y < height; y++) {
+		for(int x = 0; x < width; x++) {
+
+			int pixel = y * width + x;
+			if(input[pixel] <= 0.0f) {
+				coefficients[pixel * 2] = coefficients[pixel * 2 + 1] = _mm_setzero_pd();
+				continue;
+			}
+
+			int lower[2], upper[2];
+			double sums[6];
+			computeFilterWindow(radius + pixel * 2, width, height, x, y, lower, upper);
+			for(int v = 0; v < 3; v++)
+				_mm_storeu_pd(sums + v * 2, computeWindowSum(statistics, width, 3, lower, upper, v));
+
+			double meanGuide = sums[1] / sums[0];
+			double meanValue = sums[2] / sums[0];
+			double variance = sums[3] / sums[0] - meanGuide * meanGuide;
+			double covariance = sums[4] / sums[0] - meanGuide * meanValue;
+			double a = covariance / (((variance > 0.0) ? variance : 0.0) + epsilon);
+			coefficients[pixel * 2] = _mm_set_pd(a, 1.0);
+			coefficients[pixel * 2 + 1] = _mm_set_pd(0.0, meanValue - a * meanGuide);
+
+		}
+	}
+	computeSAT(coefficients, width, height, 2);
+
+	#pragma omp parallel for
+	for(int y = 0; y < height; y++) {
+		for(int x = 0; x < width; x++) {
+
+			int pixel = y * width + x;
+			if(input[pixel] <= 0.0f) {
+				output[pixel] = input[pixel];
+				continue;
+			}
+
+			int lower[2], upper[2];
+			double sums[4];
+			computeFilterWindow(radius + pixel * 2, width, height, x, y, lower, upper);
+			_mm_storeu_pd(sums, computeWindowSum(coefficients, width, 2, lower, upper, 0));
+			_mm_storeu_pd(sums + 2, computeWindowSum(coefficients, width, 2, lower, upper, 1));
+			output[pixel] = (float)((sums[1] * guide[pixel] + sums[2]) / sums[0]);
+
+		}
+	}
+
+	_mm_free(statistics);
+	_mm_free(coefficients);
+
+}
+
+//Fixed-point summed-area table of the first two channels of an RGBA image, as built by IntegerSATHorizontalPass and 
+//IntegerSATVerticalPass: two's complement values with FIXED_POINT_SAT_SCALE steps per unit. The unsigned sums wrap around
+//like the GPU ones, so both tables match texel for texel whatever their size
+void Filter::computeFixedPointSAT(float *image, unsigned int *table, int width, int height) 
+{
+
+	#pragma omp parallel for
+	for(int y = 0; y < height; y++) {
+		unsigned int sum[2] = {0, 0};
+		for(int x = 0; x < width; x++) {
+			for(int channel = 0; channel < 2; channel++) {
+				sum[channel] += (unsigned int)(int)floorf(image[(y * width + x) * 4 + channel] * FIXED_POINT_SAT_SCALE + 0.5f);
+				table[(y * width + x) * 2 + channel] = sum[channel];
+			}
+		}
+	}
+
+	//the columns are added four values at a time, _mm_add_epi32 wraps around as well
+	#pragma omp parallel for
+	for(int strip = 0; strip < width * 2; strip += 64) {
+		int stripEnd = (strip + 64 < width * 2) ? strip + 64 : width * 2;
+		for(int y = 1; y < height; y++) {
+			unsigned int *row = table + y * width * 2;
+			unsigned int *previousRow = row - width * 2;
+			int v = strip;
+			for(; v + 4 <= stripEnd; v += 4)
+				_mm_storeu_si128((__m128i*)(row + v), _mm_add_epi32(_mm_loadu_si128((__m128i*)(row + v)), _mm_loadu_si128((__m128i*)(previousRow + v))));
+			for(; v < stripEnd; v++)
+				row[v] += previousRow[v];
+		}
+	}
+
+}
+
+static unsigned int fetchFixedPointSAT(unsigned int *table, int width, int x, int y, int channel) 
+{
+
+	if(x < 0 || y < 0) return 0;
+	return table[(y * width + x) * 2 + channel];
+
+}
+
+//Sum of the two channels over the texels from lower to upper, inclusive. The wrapped difference of the corners is exact while 
+//the sum fits 31 bits
+void Filter::computeFixedPointBoxSum(unsigned int *table, int width, int *lower, int *upper, float *sum) 
+{
+
+	for(int channel = 0; channel < 2; channel++) {
+		unsigned int boxSum = fetchFixedPointSAT(table, width, upper[0], upper[1], channel) - fetchFixedPointSAT(table, width, lower[0] - 1, upper[1], channel) - 
+			fetchFixedPointSAT(table, width, upper[0], lower[1] - 1, channel) + fetchFixedPointSAT(table, width, lower[0] - 1, lower[1] - 1, channel);
+		sum[channel] = (float)(int)boxSum / FIXED_POINT_SAT_SCALE;
+	}
+
+}
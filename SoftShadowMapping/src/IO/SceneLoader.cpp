@@ -1,18 +1,50 @@
 #include "IO\SceneLoader.h"
 
-SceneLoader::SceneLoader(char *filename, Mesh *mesh) 
+SceneLoader::SceneLoader(char *filename, Mesh *mesh, bool compressTextures) 
 {
 
 	this->file = std::fstream(filename);
 	this->mesh = mesh;
+	this->compressTextures = compressTextures;
+	this->numberOfCachedTextures = 0;
 	this->HSMAlpha = 0;
 	this->HSMBeta = 0;
 
 }
 
+void SceneLoader::prefetchTextures(TextureLoader *textureLoader)
+{
+
+	std::string line, key, value;
+
+	while(!file.eof()) 
+	{
+
+		std::getline(file, line);
+		std::istringstream split(line);
+		if(!(split >> key)) continue;
+
+		if(key[0] == 'm') {
+			split >> value;
+			textureLoader->request((char*)value.c_str());
+		}
+
+	}
+
+	textureLoader->decode();
+	file.clear();
+	file.seekg(0, std::ios::beg);
+
+}
+
 void SceneLoader::load()
 {
 
+	//all the textures of the scene are decoded concurrently before the meshes are assembled
+	TextureLoader *textureLoader = new TextureLoader(compressTextures);
+	prefetchTextures(textureLoader);
+	numberOfCachedTextures = textureLoader->getNumberOfCacheHits();
+
 	std::string line, key, value;
 	Mesh *temp;
 	float scale[3];
@@ -36,7 +68,7 @@ void SceneLoader::load()
 		} else if(key[0] == 'm') {
 			split >> value;
 			numberOfTextures++;
-			temp->loadTexture((char*)value.c_str(), numberOfTextures);
+			temp->loadTexture(textureLoader->getImage((char*)value.c_str()), numberOfTextures);
 		} else if(key[0] == 's') {
 			for(int axis = 0; axis < 3; axis++) {
 				split >> value;
@@ -98,4 +130,6 @@ void SceneLoader::load()
 
 	}
 
+	delete textureLoader;
+
 }
\ No newline at end of file
@@ -0,0 +1,1420 @@
+#include "Reference\RBSSMReference.h"
+
+//global of RBSSM.frag: the depth getDisc leaves for the next step of an exiting discontinuity walk
+static float newDepth;
+#pragma omp threadprivate(newDepth)
+
+RBSSMReference::RBSSMReference() {
+
+	vertexMap = normalMap = shadowMap = 0;
+	width = height = shadowMapWidth = shadowMapHeight = 0;
+	depthThreshold = shadowIntensity = lightFrustumScale = 0.0f;
+	maxSearch = blockerSearchSize = kernelSize = lightSourceRadius = 0;
+	zNear = zFar = 0;
+	tapsPerPixel = 0;
+	blockerSearchTime = discontinuitySearchTime = smoothingTime = 0.0;
+	numberOfPixels = numberOfTaps = numberOfSearches = 0;
+
+}
+
+void RBSSMReference::setGBuffer(float *vertexMap, float *normalMap, int width, int height) {
+
+	this->vertexMap = vertexMap;
+	this->normalMap = normalMap;
+	this->width = width;
+	this->height = height;
+
+}
+
+void RBSSMReference::setShadowMap(float *shadowMap, int width, int height) {
+
+	this->shadowMap = shadowMap;
+	this->shadowMapWidth = width;
+	this->shadowMapHeight = height;
+
+}
+
+void RBSSMReference::setCamera(glm::mat4 MV, glm::mat3 normalMatrix, glm::vec3 lightPosition, float zNear, float zFar) {
+
+	this->MV = MV;
+	this->normalMatrix = normalMatrix;
+	this->lightPosition = lightPosition;
+	//the shader receives the planes as integers
+	this->zNear = (int)zNear;
+	this->zFar = (int)zFar;
+
+}
+
+void RBSSMReference::allocateBatch(RBSSMBatch *batch, int numberOfPixels, int numberOfTaps) {
+
+	batch->lightCoord = (glm::vec4*)malloc(numberOfTaps * sizeof(glm::vec4));
+	batch->discontinuity = (glm::vec4*)malloc(numberOfTaps * sizeof(glm::vec4));
+	batch->discontinuitySpace = (glm::vec4*)malloc(numberOfTaps * sizeof(glm::vec4));
+	batch->subCoord = (glm::vec2*)malloc(numberOfTaps * sizeof(glm::vec2));
+	batch->value = (float*)malloc(numberOfTaps * sizeof(float));
+	batch->onEdge = (unsigned char*)malloc(numberOfTaps * sizeof(unsigned char));
+	batch->pixelShadowCoord = (glm::vec4*)malloc(numberOfPixels * sizeof(glm::vec4));
+	batch->pixelPenumbraWidth = (float*)malloc(numberOfPixels * sizeof(float));
+	batch->pixelShadow = (float*)malloc(numberOfPixels * sizeof(float));
+	batch->pixelFiltered = (unsigned char*)malloc(numberOfPixels * sizeof(unsigned char));
+
+}
+
+void RBSSMReference::freeBatch(RBSSMBatch *batch) {
+
+	free(batch->lightCoord);
+	free(batch->discontinuity);
+	free(batch->discontinuitySpace);
+	free(batch->subCoord);
+	free(batch->value);
+	free(batch->onEdge);
+	free(batch->pixelShadowCoord);
+	free(batch->pixelPenumbraWidth);
+	free(batch->pixelShadow);
+	free(batch->pixelFiltered);
+
+}
+
+float RBSSMReference::fetchDepth(float s, float t) {
+
+	//GL_NEAREST with a zero border, the depth map of RBSSM.frag
+	int x = (int)floorf(s * shadowMapWidth);
+	int y = (int)floorf(t * shadowMapHeight);
+	if(x < 0 || y < 0 || x >= shadowMapWidth || y >= shadowMapHeight)
+		return 0.0f;
+	return shadowMap[y * shadowMapWidth + x];
+
+}
+
+float RBSSMReference::computePreEvaluationBasedOnNormalOrientation(glm::vec4 vertex, glm::vec4 normal) {
+
+	vertex = MV * vertex;
+	glm::vec3 N = glm::normalize(normalMatrix * glm::vec3(normal));
+	glm::vec3 L = glm::normalize(lightPosition - glm::vec3(vertex));
+
+	if(normal.w == 0.0f)
+		N *= -1.0f;
+
+	if(glm::max(glm::dot(N, L), 0.0f) == 0.0f) 
+		return shadowIntensity;
+	else
+		return 1.0f;
+
+}
+
+float RBSSMReference::compressPositiveDiscontinuity(float normalizedDiscontinuity) {
+
+	return -2.0f - ((0.5f - normalizedDiscontinuity) * 2.0f);
+
+}
+
+float RBSSMReference::decompressPositiveDiscontinuity(float normalizedDiscontinuity) {
+
+	return (0.5f - ((normalizedDiscontinuity + 2.0f) * -1.0f)/2.0f);
+
+}
+
+glm::vec4 RBSSMReference::getDisc(glm::vec4 normalizedLightCoord, float distanceFromLight) 
+{
+
+	glm::vec4 dir = glm::vec4(0.0f, 0.0f, 0.0f, 0.0f);
+	
+	normalizedLightCoord.x -= shadowMapStep.x;
+	distanceFromLight = fetchDepth(normalizedLightCoord.x, normalizedLightCoord.y);
+	dir.x = (normalizedLightCoord.z <= distanceFromLight) ? 1.0f : 0.0f; 
+	
+	normalizedLightCoord.x += 2.0f * shadowMapStep.x;
+	distanceFromLight = fetchDepth(normalizedLightCoord.x, normalizedLightCoord.y);
+	dir.y = (normalizedLightCoord.z <= distanceFromLight) ? 1.0f : 0.0f; 
+	
+	normalizedLightCoord.x -= shadowMapStep.x;
+	normalizedLightCoord.y += shadowMapStep.y;
+	distanceFromLight = fetchDepth(normalizedLightCoord.x, normalizedLightCoord.y);
+	dir.z = (normalizedLightCoord.z <= distanceFromLight) ? 1.0f : 0.0f; 
+	
+	normalizedLightCoord.y -= 2.0f * shadowMapStep.y;
+	distanceFromLight = fetchDepth(normalizedLightCoord.x, normalizedLightCoord.y);
+	dir.w = (normalizedLightCoord.z <= distanceFromLight) ? 1.0f : 0.0f; 
+	
+	return dir;
+
+}
+
+bool RBSSMReference::getDisc(glm::vec4 normalizedLightCoord, glm::vec2 dir, float discType)
+{
+
+	float distanceFromLight;
+			
+	if(dir.x == 0.0f) {
+		
+		normalizedLightCoord.x -= shadowMapStep.x;
+		distanceFromLight = fetchDepth(normalizedLightCoord.x, normalizedLightCoord.y);
+		float left = (normalizedLightCoord.z <= distanceFromLight) ? 1.0f : 0.0f; 
+		if(fabsf(left - discType) == 0.0f) return true;
+
+		normalizedLightCoord.x += 2.0f * shadowMapStep.x;
+		distanceFromLight = fetchDepth(normalizedLightCoord.x, normalizedLightCoord.y);
+		float right = (normalizedLightCoord.z <= distanceFromLight) ? 1.0f : 0.0f; 
+		if(fabsf(right - discType) == 0.0f) return true;
+
+		normalizedLightCoord.x -= shadowMapStep.x;
+
+	}
+
+	if(dir.y == 0.0f) {
+	
+		normalizedLightCoord.y += shadowMapStep.y;
+		distanceFromLight = fetchDepth(normalizedLightCoord.x, normalizedLightCoord.y);
+		float bottom = (normalizedLightCoord.z <= distanceFromLight) ? 1.0f : 0.0f; 
+		if(fabsf(bottom - discType) == 0.0f) return true;
+
+		normalizedLightCoord.y -= 2.0f * shadowMapStep.y;
+		distanceFromLight = fetchDepth(normalizedLightCoord.x, normalizedLightCoord.y);
+		float top = (normalizedLightCoord.z <= distanceFromLight) ? 1.0f : 0.0f; 
+		if(fabsf(top - discType) == 0.0f) return true;
+
+	}
+
+	return false;
+
+	
+}
+
+bool RBSSMReference::getDisc(glm::vec4 normalizedLightCoord, glm::vec2 dir, glm::vec4 discType)
+{
+
+	float distanceFromLight;
+	glm::vec4 relativeCoord = normalizedLightCoord;
+	newDepth = normalizedLightCoord.z;
+
+	if(dir.x == 0.0f) {
+		
+		if(discType.r == 0.5f || discType.r == 0.75f) {
+			
+			relativeCoord.x = normalizedLightCoord.x - shadowMapStep.x;
+			distanceFromLight = fetchDepth(relativeCoord.x, relativeCoord.y);
+			//Solving incorrect shadowing due to numerical accuracy
+			if(discType.b == 1.0f) {
+				if(fabsf(normalizedLightCoord.z - distanceFromLight) < depthThreshold) {
+					normalizedLightCoord.z -= depthThreshold;
+					newDepth = normalizedLightCoord.z;
+				}
+			}
+			float left = (normalizedLightCoord.z <= distanceFromLight) ? 1.0f : 0.0f; 
+			if(fabsf(left - discType.b) == 0.0f) return true;
+			
+		}
+
+		if(discType.r == 0.75f || discType.r == 0.25f) {
+
+			relativeCoord.x = normalizedLightCoord.x + shadowMapStep.x;
+			distanceFromLight = fetchDepth(relativeCoord.x, relativeCoord.y);
+			//Solving incorrect shadowing due to numerical accuracy
+			if(discType.b == 1.0f) {
+				if(fabsf(normalizedLightCoord.z - distanceFromLight) < depthThreshold) {
+					normalizedLightCoord.z -= depthThreshold;
+					newDepth = normalizedLightCoord.z;
+				}
+			}
+			float right = (normalizedLightCoord.z <= distanceFromLight) ? 1.0f : 0.0f; 
+			if(fabsf(right - discType.b) == 0.0f) return true;
+			
+		}
+
+	}
+
+	if(dir.y == 0.0f) {
+	
+		if(discType.g == 0.5f || discType.g == 0.75f) {
+				
+			relativeCoord.y = normalizedLightCoord.y + shadowMapStep.y;
+			distanceFromLight = fetchDepth(relativeCoord.x, relativeCoord.y);
+			//Solving incorrect shadowing due to numerical accuracy
+			if(discType.b == 1.0f) {
+				if(fabsf(normalizedLightCoord.z - distanceFromLight) < depthThreshold) {
+					normalizedLightCoord.z -= depthThreshold;
+					newDepth = normalizedLightCoord.z;
+				}
+			}
+			float bottom = (normalizedLightCoord.z <= distanceFromLight) ? 1.0f : 0.0f; 
+			if(fabsf(bottom - discType.b) == 0.0f) return true;
+		
+		}
+
+		if(discType.g == 0.75f || discType.g == 0.25f) {
+			
+			relativeCoord.y = normalizedLightCoord.y - shadowMapStep.y;
+			distanceFromLight = fetchDepth(relativeCoord.x, relativeCoord.y);
+			//Solving incorrect shadowing due to numerical accuracy
+			if(discType.b == 1.0f) {
+				if(fabsf(normalizedLightCoord.z - distanceFromLight) < depthThreshold) {
+					normalizedLightCoord.z -= depthThreshold;
+					newDepth = normalizedLightCoord.z;
+				}
+			}
+			float top = (normalizedLightCoord.z <= distanceFromLight) ? 1.0f : 0.0f; 
+			if(fabsf(top - discType.b) == 0.0f) return true;
+			
+		}
+
+	}
+
+	return false;
+
+	
+}
+
+/*
+if(fabsf(sample - disc.b) == 0.0f)
+is equivalent to 
+if((disc.b == 1.0f && !isSampleUmbra) || (disc.b == 0.0f && isSampleUmbra))
+*/
+
+float RBSSMReference::computeDiscontinuityLength(glm::vec4 inputDiscontinuity, glm::vec4 lightCoord, glm::vec2 dir, int maxSearch)
+{
+
+	glm::vec4 centeredLightCoord = lightCoord;
+	
+	float foundEdgeEnd = 0.0f;
+	bool hasDisc = false;
+	
+	if(dir.x == 0.0f && inputDiscontinuity.r == 0.0f && inputDiscontinuity.g != 0.0f) return -1.0f;
+	if(dir.y == 0.0f && inputDiscontinuity.r != 0.0f && inputDiscontinuity.g == 0.0f) return -1.0f;
+	if(((0.5f - inputDiscontinuity.r) * 8.0f - 1) == dir.x) return 1.0f;
+	if(((inputDiscontinuity.g - 0.5f) * 8.0f + 1) == dir.y) return 1.0f;
+	
+	float dist = 1.0f;
+
+	glm::vec2 shadowMapDiscontinuityStep = dir * shadowMapStep;
+	centeredLightCoord.x += shadowMapDiscontinuityStep.x;
+	centeredLightCoord.y += shadowMapDiscontinuityStep.y;
+	
+	for(int it = 0; it < maxSearch; it++) {
+		
+		float distanceFromLight = fetchDepth(centeredLightCoord.x, centeredLightCoord.y);
+
+		//To solve incorrect shadowing due to depth accuracy, we use a depth threshold/bias
+		if(inputDiscontinuity.b == 0.0f)
+			if(fabsf(centeredLightCoord.z - distanceFromLight) < depthThreshold)
+				centeredLightCoord.z -= depthThreshold;
+
+		float center = (centeredLightCoord.z <= distanceFromLight) ? 1.0f : 0.0f; 
+		
+		if(fabsf(center - inputDiscontinuity.b) == 0.0f) {
+
+			//We disable exiting discontinuities if the neighbour entering discontinuity is in all the directions
+			//We disable entering discontinuities if the neighbour exiting discontinuity is in all the directions
+			hasDisc = getDisc(centeredLightCoord, glm::vec2(0.0f, 0.0f), inputDiscontinuity.b);
+			
+			if(!hasDisc) foundEdgeEnd = 0.0f;
+			else foundEdgeEnd = 1.0f;
+			
+			break;
+		
+		} else {
+
+		    hasDisc = getDisc(centeredLightCoord, dir, inputDiscontinuity);
+			if(!hasDisc) break;
+		
+		}
+
+		dist++;
+		centeredLightCoord.x += shadowMapDiscontinuityStep.x;
+		centeredLightCoord.y += shadowMapDiscontinuityStep.y;
+		
+		//For exiting discontinuity, we deal with incorrect shadowing in a different way.
+		//The limited accuracy of the shadow map affects only the shadow test for regions which are illuminated by the light source.
+		//Therefore, we use the depth threshold only during discontinuity evaluation (getDisc) and update the current depth later on.
+		if(inputDiscontinuity.b == 1.0f) 
+			centeredLightCoord.z = newDepth;
+	
+	}
+	
+	return glm::mix(-dist, dist, foundEdgeEnd);
+
+}
+
+float RBSSMReference::normalizeDiscontinuitySpace(glm::vec2 dir, int maxSearch, float subCoord) {
+
+	//If negative discontinuity in both sides, do not fill
+	if(dir.x < 0.0f && dir.y < 0.0f)
+		return -1.0f;
+	
+	float edgeLength = glm::min(fabsf(dir.x) + fabsf(dir.y) - 1.0f, float(maxSearch));
+	float normalizedDiscontinuity = 1.0f - glm::max(dir.x, dir.y)/edgeLength;
+	
+	//If positive discontinuity in both sides, we must handle the sub-coord addition in a different way
+	//If subCoord < 0.5f return x; else return y;
+	if(dir.x == dir.y)
+		normalizedDiscontinuity += glm::mix(subCoord/edgeLength, (1.0f - subCoord)/edgeLength, glm::step(0.5f, subCoord));
+	//If left or down, add (1.0f - subCoord) 
+	else if(dir.x == glm::max(dir.x, dir.y))
+		normalizedDiscontinuity += (1.0f - subCoord)/edgeLength;
+	else
+		normalizedDiscontinuity += subCoord/edgeLength;
+
+	//If positive discontinuity in both sides
+	if(dir.x > 0.0f && dir.y > 0.0f)
+		return compressPositiveDiscontinuity(normalizedDiscontinuity);
+	else
+		return normalizedDiscontinuity;
+
+}
+
+glm::vec4 RBSSMReference::orientateDS(glm::vec4 lightCoord, glm::vec4 discontinuity)
+{
+	
+	float left = computeDiscontinuityLength(discontinuity, lightCoord, glm::vec2(-1, 0), maxSearch);
+	float right = computeDiscontinuityLength(discontinuity, lightCoord, glm::vec2(1, 0), maxSearch);
+	float down = computeDiscontinuityLength(discontinuity, lightCoord, glm::vec2(0, -1), maxSearch);
+	float up = computeDiscontinuityLength(discontinuity, lightCoord, glm::vec2(0, 1), maxSearch);
+	return glm::vec4(left, right, down, up);
+
+}
+
+glm::vec4 RBSSMReference::normalizeDS(glm::vec2 subCoord, glm::vec4 dir)
+{
+
+	glm::vec4 normalizedDiscontinuityCoord = glm::vec4(0.0f);
+	normalizedDiscontinuityCoord.x = normalizeDiscontinuitySpace(glm::vec2(dir.x, dir.y), maxSearch, subCoord.x);
+	normalizedDiscontinuityCoord.y = normalizeDiscontinuitySpace(glm::vec2(dir.z, dir.w), maxSearch, subCoord.y);
+	return normalizedDiscontinuityCoord;
+
+}
+
+/* 
+type glm::mix(x, y, glm::step(a, b)):
+	if(b < a)
+		return x;
+	else
+		return y;
+*/
+
+float RBSSMReference::smoothONDS(glm::vec4 lightCoord, glm::vec4 normalizedDiscontinuity, glm::vec4 discontinuity, glm::vec2 subCoord)
+{
+
+	if(discontinuity.b == 0.0f) {
+
+		//If positive entering discontinuity on both directions and the discontinuity is in both sides of an axis
+		if(normalizedDiscontinuity.x <= -2.0f && normalizedDiscontinuity.y <= -2.0f && (discontinuity.r == 0.75f || discontinuity.g == 0.75f)) {
+
+			//These booleans indicate where there is umbra	
+			bool left = true;
+			bool right = true;
+			bool bottom = true;
+			bool top = true;
+
+			if(discontinuity.r == 0.75f) {
+		
+				//Determine the discontinuity
+				if(discontinuity.g == 0.0f) {
+
+					lightCoord.y += shadowMapStep.y;
+					top = getDisc(lightCoord, glm::vec2(0.0f, 1.0f), discontinuity.b);
+					
+					lightCoord.y -= 2.0f * shadowMapStep.y;
+					bottom = getDisc(lightCoord, glm::vec2(0.0f, 1.0f), discontinuity.b);
+				
+					//If the dual discontinuity (i.e. left-right) persists in the next neighbours (i.e. top-bottom), fill all the ONDS
+					lightCoord.y += shadowMapStep.y;
+					if(top && bottom) return 0.0f;
+				
+					//According to the y-axis discontinuity, determine x-axis discontinuity
+					lightCoord.y += glm::mix(-shadowMapStep.y, shadowMapStep.y, glm::step(1.0f, float(top)));
+					left = getDisc(lightCoord, glm::vec2(0.0f, 1.0f), glm::vec4(0.5f, 0.0f, 0.0f, 0.0f));
+				
+					right = !left;
+				
+				} else {
+				
+					if(discontinuity.g == 0.5f) 
+						top = false;
+					else if(discontinuity.g == 0.25f)
+						bottom = false;
+				
+					lightCoord.y += ((0.5f - discontinuity.g) * 8.0f - 1) * shadowMapStep.y;
+		
+					left = getDisc(lightCoord, glm::vec2(0.0f, 1.0f), glm::vec4(0.5f, 0.0f, 0.0f, discontinuity.b));
+					right = getDisc(lightCoord, glm::vec2(0.0f, 1.0f), glm::vec4(0.25f, 0.0f, 0.0f, discontinuity.b));
+				
+					//If the dual discontinuity (i.e. left-right) persists in the next neighbour, check the exiting neighbours
+					if(left && right) {
+					
+						if(normalizedDiscontinuity.y <= -2.0f) 
+							normalizedDiscontinuity.y = decompressPositiveDiscontinuity(normalizedDiscontinuity.y) + 0.5f;
+					
+						float a = glm::clamp(subCoord.x - (normalizedDiscontinuity.y - 1.0f), 0.0f, 1.0f);
+						float b = glm::clamp((1.0f - subCoord.x) - (normalizedDiscontinuity.y - 1.0f), 0.0f, 1.0f);
+						float c = glm::mix(1.0f - subCoord.y, subCoord.y, glm::step(discontinuity.g, 1.0f));
+						return glm::min(glm::min(a, b), c);
+
+					}
+			
+				}
+			
+			}
+
+			if(discontinuity.g == 0.75f) {
+
+				if(discontinuity.r == 0.0f) {
+
+					lightCoord.x -= shadowMapStep.x;
+					left = getDisc(lightCoord, glm::vec2(1.0f, 0.0f), discontinuity.b);
+					
+					lightCoord.x += 2.0f * shadowMapStep.x;
+					right = getDisc(lightCoord, glm::vec2(1.0f, 0.0f), discontinuity.b);
+				
+					//If the dual discontinuity (i.e. top-bottom) persists in the next neighbours (i.e. left-right), fill all the ONDS
+					lightCoord.x -= shadowMapStep.x;
+					if(left && right) return 0.0f;
+
+					//According to the x-axis discontinuity, determine y-axis discontinuity
+					lightCoord.x += glm::mix(shadowMapStep.x, -shadowMapStep.x, glm::step(1.0f, float(left)));
+				
+					bottom = getDisc(lightCoord, glm::vec2(0.0f, 0.25f), glm::vec4(0.5f, 0.0f, 0.0f, discontinuity.b));
+					top = !bottom;
+
+				} else {
+		
+					if(discontinuity.r == 0.5f)
+						right = false;
+					else if(discontinuity.r == 0.25f)
+						left = false;
+				
+					lightCoord.x -= ((0.5f - discontinuity.r) * 8.0f - 1) * shadowMapStep.x;
+		
+					bottom = getDisc(lightCoord, glm::vec2(1.0f, 0.0f), glm::vec4(0.0f, 0.5f, 0.0f, discontinuity.b));
+					top = getDisc(lightCoord, glm::vec2(1.0f, 0.0f), glm::vec4(0.0f, 0.25f, 0.0f, discontinuity.b));
+
+					//If the dual discontinuity (i.e. top-bottom) persists in the next neighbour, clip all the ONDS
+					if(bottom && top) {
+
+						if(normalizedDiscontinuity.x <= -2.0f) 
+							normalizedDiscontinuity.x = decompressPositiveDiscontinuity(normalizedDiscontinuity.x) + 0.5f;
+					
+						float a = glm::clamp(subCoord.y - (normalizedDiscontinuity.x - 1.0f), 0.0f, 1.0f);
+						float b = glm::clamp((1.0f - subCoord.y) - (normalizedDiscontinuity.x - 1.0f), 0.0f, 1.0f);
+						float c = glm::mix(1.0f - subCoord.x, subCoord.x, glm::step(discontinuity.r, 1.0f));
+						return glm::min(glm::min(a, b), c);
+					
+					}
+
+				}
+
+			}
+
+			if(!left && !bottom)
+				return glm::clamp((1.0f - subCoord.x) - (1.0f - subCoord.y), 0.0f, 1.0f);
+			else if(!right && !bottom) 
+				return glm::clamp(subCoord.x - (1.0f - subCoord.y), 0.0f, 1.0f);
+			else if(!left && !top)
+				return glm::clamp((1.0f - subCoord.y) - subCoord.x, 0.0f, 1.0f);
+			else if(!right && !top)
+				return glm::clamp((1.0f - subCoord.y) - (1.0f - subCoord.x), 0.0f, 1.0f);
+
+		}
+
+		if(discontinuity.r == 0.75f || discontinuity.g == 0.75f) {
+
+			//If entering left and right discontinuity
+			if(discontinuity.r == 0.75f && discontinuity.g != 0.0f) {
+		
+				//These booleans indicate where there is umbra
+				bool left = true;
+				bool right = true;
+
+				//While umbra in all directions
+				//while(left && right) {
+		
+					lightCoord.y += ((discontinuity.g - 0.75f) * 4.0f) * shadowMapStep.y;
+					left = getDisc(lightCoord, glm::vec2(0.0f, 1.0f), glm::vec4(0.5f, 0.0f, 0.0f, discontinuity.b));
+					right = getDisc(lightCoord, glm::vec2(0.0f, 1.0f), glm::vec4(0.25f, 0.0f, 0.0f, discontinuity.b));
+					//if(lightCoord.z > fetchDepth(lightCoord.x, lightCoord.y)) break; 
+					
+				//}
+
+				//If there is no umbra in the left or right..
+				if(!left && !right)
+					return glm::clamp(1.0f - normalizedDiscontinuity.y, 0.0f, 1.0f);
+		
+				float sub = glm::mix(1.0f - subCoord.y, subCoord.y, glm::step(1.0f, discontinuity.g));
+				float a = glm::mix(sub, glm::clamp((1.0f - subCoord.x) - (normalizedDiscontinuity.y - 1.0f), 0.0f, 1.0f), glm::step(1.0f, float(right)));
+				float b = glm::mix(sub, glm::clamp(subCoord.x - (normalizedDiscontinuity.y - 1.0f), 0.0f, 1.0f), glm::step(1.0f, float(left)));
+			
+				return glm::min(a, b);
+
+			}
+
+			//If entering left and right discontinuity only
+			if(discontinuity.r == 0.75f && discontinuity.g == 0.0f) {
+		
+				//These booleans indicate where there is umbra
+				bool topLeft = true;
+				bool topRight = true;
+				bool bottomLeft = true;
+				bool bottomRight = true;
+
+				//These booleans help us to find the discontinuity end
+				bool topCenter = false;
+				bool bottomCenter = false;
+		
+				glm::vec4 topLightCoord = lightCoord;
+				glm::vec4 bottomLightCoord = lightCoord;
+
+				//While umbra in all directions
+				//while(topLeft && topRight && bottomLeft && bottomRight && (!topCenter || !bottomCenter)) {
+	
+					if(!topCenter) {
+				
+						topLightCoord.y += shadowMapStep.y;
+						float center = (topLightCoord.z <= fetchDepth(topLightCoord.x, topLightCoord.y)) ? 1.0f : 0.0f; 
+						topCenter = !bool(center);
+					
+						topLeft = getDisc(topLightCoord, glm::vec2(0.0f, 1.0f), glm::vec4(0.5f, 0.0f, 0.0f, discontinuity.b));
+						topRight = getDisc(topLightCoord, glm::vec2(0.0f, 1.0f), glm::vec4(0.25f, 0.0f, 0.0f, discontinuity.b));
+				
+					}
+
+					if(!bottomCenter) {
+			
+						bottomLightCoord.y -= shadowMapStep.y;
+						float center = (bottomLightCoord.z <= fetchDepth(bottomLightCoord.x, bottomLightCoord.y)) ? 1.0f : 0.0f; 
+						bottomCenter = !bool(center);
+				
+						bottomLeft = getDisc(bottomLightCoord, glm::vec2(0.0f, 1.0f), glm::vec4(0.5f, 0.0f, 0.0f, discontinuity.b));
+						bottomRight = getDisc(bottomLightCoord, glm::vec2(0.0f, 1.0f), glm::vec4(0.25f, 0.0f, 0.0f, discontinuity.b));
+				
+					}
+
+				//}
+
+				if(topCenter) {
+
+					topLeft = true;
+					topRight = true;
+
+				}
+
+				if(bottomCenter) {
+
+					bottomLeft = true;
+					bottomRight = true;
+
+				}
+
+				if(normalizedDiscontinuity.y <= -2.0f) {
+
+					normalizedDiscontinuity.y = decompressPositiveDiscontinuity(normalizedDiscontinuity.y) + 0.5f;
+					float a = glm::clamp(subCoord.x - (normalizedDiscontinuity.y - 1.0f), 0.0f, 1.0f);
+					float b = glm::clamp((1.0f - subCoord.x) - (normalizedDiscontinuity.y - 1.0f), 0.0f, 1.0f);
+			
+					if(!bottomRight || !topRight)  return a;
+					else if(!bottomLeft || !topLeft) return b;
+					else return glm::min(a, b);
+			
+				}
+
+				//If, for top or bottom directions, there is no umbra in the left or right..
+				if((!bottomRight && !bottomLeft) || (!topRight && !topLeft))
+					return glm::clamp(1.0f - normalizedDiscontinuity.y, 0.0f, 1.0f);
+				//If there is no umbra only on the right
+				else if(!bottomRight || !topRight)	
+					return glm::clamp(subCoord.x - (normalizedDiscontinuity.y - 1.0f), 0.0f, 1.0f);
+				//If there is no umbra only on the left
+				else
+					return glm::clamp((1.0f - subCoord.x) - (normalizedDiscontinuity.y - 1.0f), 0.0f, 1.0f);
+
+			}
+
+			//If entering top and bottom discontinuity
+			if(discontinuity.r != 0.0f && discontinuity.g == 0.75f) {
+
+				//These booleans indicate where there is umbra
+				bool bottom = true;
+				bool top = true;
+
+				//While umbra in all directions
+				//while(bottom && top) {	
+		
+					lightCoord.x -= ((0.5f - discontinuity.r) * 8.0f - 1) * shadowMapStep.x;
+					bottom = getDisc(lightCoord, glm::vec2(1.0f, 0.0f), glm::vec4(0.0f, 0.5f, 0.0f, discontinuity.b));
+					top = getDisc(lightCoord, glm::vec2(1.0f, 0.0f), glm::vec4(0.0f, 0.25f, 0.0f, discontinuity.b));
+					//if(lightCoord.z > fetchDepth(lightCoord.x, lightCoord.y)) break; 
+					
+				//}
+		
+		
+				//If there is no umbra in the bottom or top..
+				if(!bottom && !top)
+					return glm::clamp(1.0f - normalizedDiscontinuity.x, 0.0f, 1.0f);
+
+				float sub = glm::mix(subCoord.x, 1.0f - subCoord.x, glm::step(discontinuity.r, 0.25f));
+				float a = glm::mix(sub, glm::clamp(subCoord.y - (normalizedDiscontinuity.x - 1.0f), 0.0f, 1.0f), glm::step(1.0f, float(top)));
+				float b = glm::mix(sub, glm::clamp((1.0f - subCoord.y) - (normalizedDiscontinuity.x - 1.0f), 0.0f, 1.0f), glm::step(1.0f, float(bottom)));
+
+				return glm::min(a, b);
+
+			}
+
+			//If entering top and bottom discontinuity only
+			if(discontinuity.r == 0.0f && discontinuity.g == 0.75f) {
+
+				//These booleans indicate where there is umbra
+				bool topLeft = true;
+				bool topRight = true;
+				bool bottomLeft = true;
+				bool bottomRight = true;
+
+				//These booleans help us to find the discontinuity end
+				bool leftCenter = false;
+				bool rightCenter = false;
+				float center;
+
+				glm::vec4 leftLightCoord = lightCoord;
+				glm::vec4 rightLightCoord = lightCoord;
+
+				//While umbra in all directions
+				//while(topLeft && topRight && bottomLeft && bottomRight && (!rightCenter || !leftCenter)) {
+
+					if(!rightCenter) {
+				
+						rightLightCoord.x += shadowMapStep.x;
+						center = (rightLightCoord.z <= fetchDepth(rightLightCoord.x, rightLightCoord.y)) ? 1.0f : 0.0f; 
+						rightCenter = !bool(center);
+			
+						bottomRight = getDisc(rightLightCoord, glm::vec2(1.0f, 0.0f), glm::vec4(0.0f, 0.5f, 0.0f, discontinuity.b));
+						topRight = getDisc(rightLightCoord, glm::vec2(1.0f, 0.0f), glm::vec4(0.0f, 0.25f, 0.0f, discontinuity.b));
+
+					}
+		
+					if(!leftCenter) {
+				
+						leftLightCoord.x -= shadowMapStep.x;
+						center = (leftLightCoord.z <= fetchDepth(leftLightCoord.x, leftLightCoord.y)) ? 1.0f : 0.0f; 
+						leftCenter = !bool(center);
+			
+						bottomLeft = getDisc(leftLightCoord, glm::vec2(1.0f, 0.0f), glm::vec4(0.0f, 0.5f, 0.0f, discontinuity.b));
+						topLeft = getDisc(leftLightCoord, glm::vec2(1.0f, 0.0f), glm::vec4(0.0f, 0.25f, 0.0f, discontinuity.b));
+				
+					}
+
+				//}
+
+				if(rightCenter) {
+			
+					bottomRight = true;
+					topRight = true;
+
+				} 
+
+				if(leftCenter) {
+
+					topLeft = true;
+					bottomLeft = true;
+
+				}
+
+				if(normalizedDiscontinuity.x <= -2.0f) {
+
+					normalizedDiscontinuity.x = decompressPositiveDiscontinuity(normalizedDiscontinuity.x) + 0.5f;
+					float a = glm::clamp(subCoord.y - (normalizedDiscontinuity.x - 1.0f), 0.0f, 1.0f);
+					float b = glm::clamp((1.0f - subCoord.y) - (normalizedDiscontinuity.x - 1.0f), 0.0f, 1.0f);
+			
+					if(!bottomRight || !bottomLeft)  return a;
+					else if(!topRight || !topLeft) return b;
+					else return glm::min(a, b);
+			
+				}
+
+				//If, for left or right directions, there is no umbra in the top or bottom..
+				if((!bottomRight && !topRight) || (!bottomLeft && !topLeft))
+					return glm::clamp(1.0f - normalizedDiscontinuity.x, 0.0f, 1.0f);
+				//If there is no umbra only on the bottom
+				else if(!bottomRight || !bottomLeft)	
+					return glm::clamp(subCoord.y - (normalizedDiscontinuity.x - 1.0f), 0.0f, 1.0f);
+				//If there is no umbra only on the top
+				else
+					return glm::clamp((1.0f - subCoord.y) - (normalizedDiscontinuity.x - 1.0f), 0.0f, 1.0f);
+
+			}
+
+		}
+
+		//If discontinuity in both axes (corner)
+		if(discontinuity.r > 0.0f && discontinuity.g > 0.0f) {
+			
+			//Compute dominant axis - Evaluate if there is discontinuity in the closest neighbours
+			lightCoord.x -= ((0.5f - discontinuity.r) * 8.0f - 1) * shadowMapStep.x;
+			bool horizontal = getDisc(lightCoord, glm::vec2(1.0f, 0.0f), 0.0f);
+		
+			lightCoord.x += ((0.5f - discontinuity.r) * 8.0f - 1) * shadowMapStep.x;
+			lightCoord.y += ((0.5f - discontinuity.g) * 8.0f - 1) * shadowMapStep.y;
+			bool vertical = getDisc(lightCoord, glm::vec2(0.0f, 1.0f), 0.0f);
+
+			//If dominant axis is x-axis - Disable discontinuity in y-axis
+			if(horizontal && !vertical) {
+		
+				discontinuity.r = 0.0f;
+		
+			//If dominant axis is y-axis - Disable discontinuity is x-axis
+			} else if(!horizontal && vertical) {
+
+				discontinuity.g = 0.0f;
+		
+			//If there is no dominant axis
+			} else if(!horizontal && !vertical) {
+
+				//If bottom discontinuity
+				if(discontinuity.g == 0.5f) return glm::clamp((1.0f - normalizedDiscontinuity.x) - (subCoord.y - 1.0f), 0.0f, 1.0f);
+				//If top discontinuity
+				else if(discontinuity.g == 0.25f) return glm::clamp((1.0f - normalizedDiscontinuity.x) + subCoord.y, 0.0f, 1.0f);
+
+			} else {
+
+				float a, b;
+
+				//If left and bottom discontinuities
+				if(discontinuity.r == 0.5f && discontinuity.g == 0.5f) {
+			
+					a = glm::mix(1.0f - subCoord.y, glm::clamp(1.0f - (normalizedDiscontinuity.x - (1.0f - subCoord.y)), 0.0f, 1.0f), glm::step(-2.0f, normalizedDiscontinuity.x));
+					b = glm::mix(subCoord.x, glm::clamp(1.0f - (normalizedDiscontinuity.y - subCoord.x), 0.0f, 1.0f), glm::step(-2.0f, normalizedDiscontinuity.y));
+					return glm::min(a, b);
+
+				//If left and top discontinuities
+				} else if(discontinuity.r == 0.5f && discontinuity.g == 0.25f) {
+
+					a = glm::mix(subCoord.y, glm::clamp(1.0f - (normalizedDiscontinuity.x - subCoord.y), 0.0f, 1.0f), glm::step(-2.0f, normalizedDiscontinuity.x));
+					b = glm::mix(subCoord.x, glm::clamp(1.0f - (normalizedDiscontinuity.y - subCoord.x), 0.0f, 1.0f), glm::step(-2.0f, normalizedDiscontinuity.y));
+					return glm::min(a, b);
+
+				//If right and bottom discontinuities
+				} else if(discontinuity.r == 0.25f && discontinuity.g == 0.5f) {
+
+					a = glm::mix(1.0f - subCoord.y, glm::clamp(1.0f - (normalizedDiscontinuity.x - (1.0f - subCoord.y)), 0.0f, 1.0f), glm::step(-2.0f, normalizedDiscontinuity.x));
+					b = glm::mix(1.0f - subCoord.x, glm::clamp(1.0f - (normalizedDiscontinuity.y - (1.0f - subCoord.x)), 0.0f, 1.0f), glm::step(-2.0f, normalizedDiscontinuity.y));
+					return glm::min(a, b);
+
+				//If right and top discontinuities
+				} else if(discontinuity.r == 0.25f && discontinuity.g == 0.25f) {
+			
+					a = glm::mix(subCoord.y, glm::clamp(1.0f - (normalizedDiscontinuity.x - subCoord.y), 0.0f, 1.0f), glm::step(-2.0f, normalizedDiscontinuity.x));
+					b = glm::mix(1.0f - subCoord.x, glm::clamp(1.0f - (normalizedDiscontinuity.y - (1.0f - subCoord.x)), 0.0f, 1.0f), glm::step(-2.0f, normalizedDiscontinuity.y));
+					return glm::min(a, b);
+
+				}
+
+			}
+
+		}
+
+		//If positive discontinuity only in x-axis
+		if(normalizedDiscontinuity.x <= -2.0f) return glm::mix(1.0f - subCoord.y, subCoord.y, glm::step(discontinuity.g, 0.25f));
+
+		//If positive discontinuity only in y-axis
+		if(normalizedDiscontinuity.y <= -2.0f) return glm::mix(subCoord.x, 1.0f - subCoord.x, glm::step(discontinuity.r, 0.25f));
+		
+		//If discontinuity only in y-axis
+		if(discontinuity.g > 0.0f) {
+	
+			//If bottom discontinuity
+			if(discontinuity.g == 0.5f) return glm::clamp((1.0f - subCoord.y) - (normalizedDiscontinuity.x - 1.0f), 0.0f, 1.0f);
+			//If top discontinuity
+			else return glm::clamp(subCoord.y - (normalizedDiscontinuity.x - 1.0f), 0.0f, 1.0f);
+		
+		}
+
+		//If discontinuity only in x-axis
+		if(discontinuity.r > 0.0f) {
+		
+			//If left discontinuity
+			if(discontinuity.r == 0.5f) return glm::clamp(subCoord.x - (normalizedDiscontinuity.y - 1.0f), 0.0f, 1.0f);
+			//If right discontinuity
+			else return glm::clamp((1.0f - subCoord.x) - (normalizedDiscontinuity.y - 1.0f), 0.0f, 1.0f);
+
+		}
+
+	//For exiting discontinuity
+	} else {
+
+		if(discontinuity.r == 0.75f || discontinuity.g == 0.75f) {
+
+			//If exiting left and right discontinuity only
+			if(discontinuity.r == 0.75f && discontinuity.g == 0.0f) {
+		
+				glm::vec4 referenceCoord = lightCoord;
+				referenceCoord.x = lightCoord.x - shadowMapStep.x;
+				bool left = getDisc(referenceCoord, glm::vec2(0.0f, 1.0f), glm::vec4(0.5f, 0.0f, 0.0f, discontinuity.b));
+				referenceCoord.x = lightCoord.x + shadowMapStep.x;
+				bool right = getDisc(referenceCoord, glm::vec2(0.0f, 1.0f), glm::vec4(0.25f, 0.0f, 0.0f, discontinuity.b));
+		
+				//If there is umbra on left and right
+				if(left && right) {
+
+					return glm::clamp(normalizedDiscontinuity.y, 0.0f, 1.0f);
+		
+				} else if (left || right) {
+
+					if(!left) return glm::mix(1.0f - subCoord.x, glm::clamp(normalizedDiscontinuity.y - subCoord.x, 0.0f, 1.0f), glm::step(-2.0f, normalizedDiscontinuity.y));
+					else return glm::mix(subCoord.x, glm::clamp(normalizedDiscontinuity.y - (1.0f - subCoord.x), 0.0f, 1.0f), glm::step(-2.0f, normalizedDiscontinuity.y));
+
+				} else {
+
+					int count = 0;
+					int mult;
+			
+					//while(!left && !right) {
+
+						mult = (count / 2) + 1;
+
+						if(glm::mod(float(count), 2.0f) == 0.0f) referenceCoord.y = lightCoord.y + float(mult) * shadowMapStep.y;
+						else referenceCoord.y = lightCoord.y - float(mult) * shadowMapStep.y;
+
+						referenceCoord.x = lightCoord.x - shadowMapStep.x;
+						left = getDisc(referenceCoord, glm::vec2(1.0f, 0.0f), 0.0f);
+				
+						referenceCoord.x = lightCoord.x + shadowMapStep.x;
+						right = getDisc(referenceCoord, glm::vec2(1.0f, 0.0f), 0.0f);
+				
+						//Break if the sample is out of the shadow
+						//if(lightCoord.z <= fetchDepth(lightCoord.x, lightCoord.y)) break; 
+
+						count++;
+
+					//}
+			
+					if(left && right) {
+
+						return glm::clamp(normalizedDiscontinuity.y, 0.0f, 1.0f);
+			
+					} else {
+			
+						if(!left) return glm::mix(1.0f - subCoord.x, glm::clamp(normalizedDiscontinuity.y - subCoord.x, 0.0f, 1.0f), glm::step(-2.0f, normalizedDiscontinuity.y));
+						else return glm::mix(subCoord.x, glm::clamp(normalizedDiscontinuity.y - (1.0f - subCoord.x), 0.0f, 1.0f), glm::step(-2.0f, normalizedDiscontinuity.y));
+
+					}
+
+				}
+
+			}
+
+			//If exiting left and right discontinuity
+			if(discontinuity.r == 0.75f && discontinuity.g != 0.0f) {
+		
+				//Scan exiting discontinuity in the opposite y-axis direction
+				lightCoord.y += ((0.5f - discontinuity.g) * 8.0f - 1) * shadowMapStep.y;
+		
+				bool left = getDisc(lightCoord, glm::vec2(0.0f, 1.0f), glm::vec4(0.5f, 0.0f, 0.0f, discontinuity.b));
+				bool right = getDisc(lightCoord, glm::vec2(0.0f, 1.0f), glm::vec4(0.25f, 0.0f, 0.0f, discontinuity.b));
+		
+				float a = 0.0f, b = 0.0f;
+		
+				//If there is umbra on left or right
+				if(left && right) {
+
+					return glm::clamp(normalizedDiscontinuity.y, 0.0f, 1.0f);
+		
+				} else if (left || right) {
+			
+					if(left) a = glm::mix(subCoord.y, 1.0f - subCoord.y, glm::step(discontinuity.g, 0.25f));
+					else a = glm::mix(1.0f - subCoord.x, glm::clamp(normalizedDiscontinuity.y - subCoord.x, 0.0f, 1.0f), glm::step(-2.0f, normalizedDiscontinuity.y));
+
+					if(right) b = glm::mix(subCoord.y, 1.0f - subCoord.y, glm::step(discontinuity.g, 0.25f));
+					else b = glm::mix(subCoord.x, glm::clamp(normalizedDiscontinuity.y - (1.0f - subCoord.x), 0.0f, 1.0f), glm::step(-2.0f, normalizedDiscontinuity.y));
+			
+					return glm::max(a, b);
+
+				} else {
+
+					if(discontinuity.g == 0.75f) 
+						return 0.0f;
+			
+					glm::vec4 referenceCoord;
+			
+					//while(!left && !right) {
+
+						referenceCoord = lightCoord;
+				
+						referenceCoord.x = lightCoord.x - shadowMapStep.x;
+						left = getDisc(referenceCoord, glm::vec2(1.0f, 0.0f), 0.0f);
+
+						referenceCoord.x = lightCoord.x + shadowMapStep.x;
+						right = getDisc(referenceCoord, glm::vec2(1.0f, 0.0f), 0.0f);
+
+						//Break if the sample is out of the shadow
+						//if(lightCoord.z <= fetchDepth(lightCoord.x, lightCoord.y)) break; 
+				
+						lightCoord.y += ((0.5f - discontinuity.g) * 8.0f - 1) * shadowMapStep.y;
+		
+					//}
+			
+					if(left && right) {
+
+						return glm::clamp(normalizedDiscontinuity.y, 0.0f, 1.0f);
+			
+					} else {
+			
+						a = glm::mix(1.0f - subCoord.x, subCoord.x, glm::step(1.0f, float(left)));
+						b = glm::mix(subCoord.y, 1.0f - subCoord.y, glm::step(discontinuity.g, 0.25f));
+						return glm::max(a, b);
+			
+					}
+
+				}
+
+			}
+
+			//If exiting top and bottom discontinuity only
+			if(discontinuity.r == 0.0f && discontinuity.g == 0.75f) {
+		
+				glm::vec4 referenceCoord = lightCoord;
+				referenceCoord.y = lightCoord.y - shadowMapStep.y;
+				bool top = getDisc(referenceCoord, glm::vec2(0.0f, 1.0f), 0.0f);
+				referenceCoord.y = lightCoord.y + shadowMapStep.y;
+				bool bottom = getDisc(referenceCoord, glm::vec2(0.0f, 1.0f), 0.0f);
+		
+				//If there is umbra on bottom and top
+				if(bottom && top) {
+
+					return glm::clamp(normalizedDiscontinuity.x, 0.0f, 1.0f);
+		
+				} else if (bottom || top) {
+			
+					if(!top) return glm::mix(1.0f - subCoord.y, glm::clamp(normalizedDiscontinuity.x - subCoord.y, 0.0f, 1.0f), glm::step(-2.0f, normalizedDiscontinuity.x));
+					else return glm::mix(subCoord.y, glm::clamp(normalizedDiscontinuity.x - (1.0f - subCoord.y), 0.0f, 1.0f), glm::step(-2.0f, normalizedDiscontinuity.x));
+			
+				} else {
+			
+					int count = 0;
+					int mult;
+			
+					//while(!top && !bottom) {
+
+						mult = (count / 2) + 1;
+
+						if(glm::mod(float(count), 2.0f) == 0.0f) referenceCoord.x = lightCoord.x + float(mult) * shadowMapStep.x;
+						else referenceCoord.x = lightCoord.x - float(mult) * shadowMapStep.x;
+
+						referenceCoord.y = lightCoord.y - shadowMapStep.y;
+						top = getDisc(referenceCoord, glm::vec2(0.0f, 1.0f), 0.0f);
+				
+						referenceCoord.y = lightCoord.y + shadowMapStep.y;
+						bottom = getDisc(referenceCoord, glm::vec2(0.0f, 1.0f), 0.0f);
+				
+						//Break if the sample is out of the shadow
+						//if(lightCoord.z <= fetchDepth(lightCoord.x, lightCoord.y)) break; 
+				
+						count++;
+
+					//}
+			
+					if(top && bottom) {
+
+						return glm::clamp(normalizedDiscontinuity.x, 0.0f, 1.0f);
+			
+					} else {
+			
+						if(!top) return glm::mix(1.0f - subCoord.y, glm::clamp(normalizedDiscontinuity.x - subCoord.y, 0.0f, 1.0f), glm::step(-2.0f, normalizedDiscontinuity.x));
+						else return glm::mix(subCoord.y, glm::clamp(normalizedDiscontinuity.x - (1.0f - subCoord.y), 0.0f, 1.0f), glm::step(-2.0f, normalizedDiscontinuity.x));
+			
+					}
+
+				}
+		
+			}
+
+			//If exiting top and bottom discontinuity
+			if(discontinuity.r != 0.0f && discontinuity.g == 0.75f) {
+			
+				//Scan exiting discontinuity in the opposite x-axis direction
+				lightCoord.x -= ((0.5f - discontinuity.r) * 8.0f - 1) * shadowMapStep.x;
+		
+				bool bottom = getDisc(lightCoord, glm::vec2(1.0f, 0.0f), glm::vec4(0.0f, 0.5f, 0.0f, discontinuity.b));
+				bool top = getDisc(lightCoord, glm::vec2(1.0f, 0.0f), glm::vec4(0.0f, 0.25f, 0.0f, discontinuity.b));
+		
+				float a = 0.0f, b = 0.0f;
+		
+				//If there is umbra on bottom and top
+				if(bottom && top) {
+
+					return glm::clamp(normalizedDiscontinuity.x, 0.0f, 1.0f);
+		
+				} else if (bottom || top) {
+			
+					if(top)	a = glm::mix(1.0f - subCoord.x, subCoord.x, glm::step(discontinuity.r, 0.25f));
+					else a = glm::mix(1.0f - subCoord.y, glm::clamp(normalizedDiscontinuity.x - subCoord.y, 0.0f, 1.0f), glm::step(-2.0f, normalizedDiscontinuity.x));
+
+					if(bottom) b = glm::mix(1.0f - subCoord.x, subCoord.x, glm::step(discontinuity.r, 0.25f));
+					else b = glm::mix(subCoord.y, glm::clamp(normalizedDiscontinuity.x - (1.0f - subCoord.y), 0.0f, 1.0f), glm::step(-2.0f, normalizedDiscontinuity.x));
+			
+					return glm::max(a, b);
+
+				} else {
+			
+					glm::vec4 referenceCoord;
+
+					if(discontinuity.r == 0.75f) 
+						return 0.0f;
+			
+					//while(!top && !bottom) {
+
+						referenceCoord = lightCoord;
+				
+						referenceCoord.y = lightCoord.y - shadowMapStep.y;
+						top = getDisc(referenceCoord, glm::vec2(0.0f, 1.0f), 0.0f);
+				
+						referenceCoord.y = lightCoord.y + shadowMapStep.y;
+						bottom = getDisc(referenceCoord, glm::vec2(0.0f, 1.0f), 0.0f);
+				
+						//Break if the sample is out of the shadow
+						//if(lightCoord.z <= fetchDepth(lightCoord.x, lightCoord.y)) break; 
+				
+						lightCoord.x -= ((0.5f - discontinuity.r) * 8.0f - 1) * shadowMapStep.x;
+		
+					//}
+			
+					if(top && bottom) {
+
+						return glm::clamp(normalizedDiscontinuity.x, 0.0f, 1.0f);
+			
+					} else {
+			
+						a = glm::mix(1.0f - subCoord.y, subCoord.y, glm::step(1.0f, float(top)));
+						b = glm::mix(1.0f - subCoord.x, subCoord.x, glm::step(discontinuity.r, 0.25f));
+						return glm::max(a, b);
+			
+					}
+
+				}
+		
+			}
+
+		}
+
+		//If discontinuity in both axes (corner)
+		if(discontinuity.r > 0.0f && discontinuity.g > 0.0f) {
+			
+			//Compute dominant axis - Evaluate if there is discontinuity in the closest neighbours
+			lightCoord.x += ((0.5f - discontinuity.r) * 8.0f - 1) * shadowMapStep.x;
+			bool horizontal = getDisc(lightCoord, glm::vec2(1.0f, 0.0f), discontinuity.b);
+		
+			lightCoord.x += ((0.5f - discontinuity.r) * 8.0f - 1) * shadowMapStep.x;
+			lightCoord.y += ((0.5f - discontinuity.g) * 8.0f - 1) * shadowMapStep.y;
+			bool vertical = getDisc(lightCoord, glm::vec2(0.0f, 1.0f), discontinuity.b);
+
+			//If dominant axis is x-axis - Disable discontinuity in y-axis
+			if(horizontal && !vertical) {
+		
+				discontinuity.r = 0.0f;
+		
+			//If dominant axis is y-axis - Disable discontinuity is x-axis
+			} else if(!horizontal && vertical) {
+
+				discontinuity.g = 0.0f;
+		
+			//If there is no dominant axis
+			} else if(!horizontal && !vertical) {
+
+				//If bottom discontinuity
+				if(discontinuity.g == 0.5f) return glm::clamp(subCoord.y - (1.0f - normalizedDiscontinuity.x), 0.0f, 1.0f);
+				//If top discontinuity
+				else if(discontinuity.g == 0.25f) return glm::clamp((1.0f - subCoord.y) - (1.0f - normalizedDiscontinuity.x), 0.0f, 1.0f);
+
+			//If there are two dominant axis
+			} else {
+			
+				float a, b;
+				//If left and bottom discontinuities
+				if(discontinuity.r == 0.5f && discontinuity.g == 0.5f) {
+			
+					a = glm::mix(subCoord.y, glm::clamp(normalizedDiscontinuity.x - (1.0f - subCoord.y), 0.0f, 1.0f), glm::step(-2.0f, normalizedDiscontinuity.x));
+					b = glm::mix(1.0f - subCoord.x, glm::clamp(normalizedDiscontinuity.y - subCoord.x, 0.0f, 1.0f), glm::step(-2.0f, normalizedDiscontinuity.y));
+					return glm::max(a, b);
+
+				//If left and top discontinuities
+				} else if(discontinuity.r == 0.5f && discontinuity.g == 0.25f) {
+
+					a = glm::mix(1.0f - subCoord.y, glm::clamp(normalizedDiscontinuity.x - subCoord.y, 0.0f, 1.0f), glm::step(-2.0f, normalizedDiscontinuity.x));
+					b = glm::mix(1.0f - subCoord.x, glm::clamp(normalizedDiscontinuity.y - subCoord.x, 0.0f, 1.0f), glm::step(-2.0f, normalizedDiscontinuity.y));
+					return glm::max(a, b);
+
+				//If right and bottom discontinuities
+				} else if(discontinuity.r == 0.25f && discontinuity.g == 0.5f) {
+
+					a = glm::mix(subCoord.y, glm::clamp(normalizedDiscontinuity.x - (1.0f - subCoord.y), 0.0f, 1.0f), glm::step(-2.0f, normalizedDiscontinuity.x));
+					b = glm::mix(subCoord.x, glm::clamp(normalizedDiscontinuity.y - (1.0f - subCoord.x), 0.0f, 1.0f), glm::step(-2.0f, normalizedDiscontinuity.y));
+					return glm::max(a, b);
+
+				//If right and top discontinuities
+				} else if(discontinuity.r == 0.25f && discontinuity.g == 0.25f) {
+			
+					a = glm::mix(1.0f - subCoord.y, glm::clamp(normalizedDiscontinuity.x - subCoord.y, 0.0f, 1.0f), glm::step(-2.0f, normalizedDiscontinuity.x));
+					b = glm::mix(subCoord.x, glm::clamp(normalizedDiscontinuity.y - (1.0f - subCoord.x), 0.0f, 1.0f), glm::step(-2.0f, normalizedDiscontinuity.y));
+					return glm::max(a, b);
+
+				}
+
+			}	
+
+		}
+
+		//If positive discontinuity only in x-axis
+		if(normalizedDiscontinuity.x <= -2.0f) return glm::mix(subCoord.y, 1.0f - subCoord.y, glm::step(discontinuity.g, 0.25f));
+
+		//If positive discontinuity only in y-axis
+		if(normalizedDiscontinuity.y <= -2.0f) return glm::mix(1.0f - subCoord.x, subCoord.x, glm::step(discontinuity.r, 0.25f));
+		
+		//If discontinuity only in y-axis
+		if(discontinuity.g > 0.0f) {
+	
+			//If bottom discontinuity
+			if(discontinuity.g == 0.5f) return glm::clamp(normalizedDiscontinuity.x - (1.0f - subCoord.y), 0.0f, 1.0f);
+			//If top discontinuity
+			else return glm::clamp(normalizedDiscontinuity.x - subCoord.y, 0.0f, 1.0f);
+
+		}
+
+		//If discontinuity only in x-axis
+		if(discontinuity.r > 0.0f) {
+		
+			//If left discontinuity
+			if(discontinuity.r == 0.5f) return glm::clamp(normalizedDiscontinuity.y - subCoord.x, 0.0f, 1.0f);
+			//If right discontinuity
+			else return glm::clamp(normalizedDiscontinuity.y - (1.0f - subCoord.x), 0.0f, 1.0f);
+
+		}
+
+	}
+	
+	return 1.0f - discontinuity.b;
+
+}
+
+glm::vec4 RBSSMReference::computeDiscontinuity(glm::vec4 normalizedLightCoord, float distanceFromLight) 
+{
+
+	float center = (normalizedLightCoord.z <= distanceFromLight) ? 1.0f : 0.0f;	
+	float discType = 1.0f - center;
+	glm::vec4 dir = getDisc(normalizedLightCoord, distanceFromLight);
+	glm::vec4 disc = glm::abs(dir - center);
+	glm::vec2 color = (2.0f * glm::vec2(disc.x, disc.z) + glm::vec2(disc.y, disc.w))/4.0f;
+	return glm::vec4(color.x, color.y, discType, 1.0f);		
+		
+}
+
+float RBSSMReference::computeAverageBlockerDepthBasedOnPCF(glm::vec4 normalizedShadowCoord) 
+{
+
+	float averageDepth = 0.0f;
+	int numberOfBlockers = 0;
+	float blockerSearchWidth;
+	if(shadowMapWidth <= 1024.0f) blockerSearchWidth = lightFrustumScale * float(lightSourceRadius)/float(shadowMapWidth);
+	else blockerSearchWidth = lightFrustumScale * float(lightSourceRadius)/float(1024.0f);
+	float filterWidth = (blockerSearchSize - 1.0f) * 0.5f;
+	
+	for(int h = (int)-filterWidth; h <= filterWidth; h++) {
+		for(int w = (int)-filterWidth; w <= filterWidth; w++) {
+		
+			float distanceFromLight = fetchDepth(normalizedShadowCoord.x + w * blockerSearchWidth/filterWidth, normalizedShadowCoord.y + h * blockerSearchWidth/filterWidth);
+			if(normalizedShadowCoord.z > distanceFromLight) {
+				averageDepth += distanceFromLight;
+				numberOfBlockers++;
+			} 
+				
+		}
+	}
+
+	if(numberOfBlockers == 0)
+		return 1.0f;
+	else
+		return averageDepth / float(numberOfBlockers);
+	
+}
+
+float RBSSMReference::computePenumbraWidth(float averageDepth, float distanceToLight)
+{
+
+	if(averageDepth < 0.99f)
+		return 0.0f;
+
+	float penumbraWidth = ((distanceToLight - averageDepth)/averageDepth) * float(lightSourceRadius);
+	return lightFrustumScale * (float(zNear) * penumbraWidth)/distanceToLight;
+	
+}
+
+int RBSSMReference::searchBlockers(RBSSMBatch *batch, int firstRow, int numberOfRows) {
+
+	//main and revectorizationBasedShadowMappingSmoothing up to the kernel: background pixels stay 0, back faces and pixels
+	//without a penumbra keep the pre-evaluated shadow
+	int filteredPixels = 0;
+
+	#pragma omp parallel for schedule(dynamic) reduction(+:filteredPixels)
+	for(int y = 0; y < numberOfRows; y++) {
+		for(int x = 0; x < width; x++) {
+
+			int pixel = y * width + x;
+			int index = (firstRow + y) * width + x;
+			batch->pixelFiltered[pixel] = 0;
+			batch->pixelShadow[pixel] = 0.0f;
+
+			glm::vec4 vertex = glm::vec4(vertexMap[index * 4], vertexMap[index * 4 + 1], vertexMap[index * 4 + 2], vertexMap[index * 4 + 3]);
+			if(vertex.x == 0.0f) continue;
+
+			glm::vec4 normal = glm::vec4(normalMap[index * 4], normalMap[index * 4 + 1], normalMap[index * 4 + 2], normalMap[index * 4 + 3]);
+			glm::vec4 shadowCoord = lightMVP * vertex;
+			glm::vec4 normalizedShadowCoord = shadowCoord / shadowCoord.w;
+			float shadow = computePreEvaluationBasedOnNormalOrientation(vertex, normal);
+			batch->pixelShadow[pixel] = shadow;
+			if(!(shadowCoord.w > 0.0f && shadow == 1.0f)) continue;
+
+			float averageDepth = computeAverageBlockerDepthBasedOnPCF(normalizedShadowCoord);
+			float penumbraWidth = computePenumbraWidth(averageDepth, normalizedShadowCoord.z);
+			float stepSize = 2.0f * penumbraWidth/float(kernelSize);
+			if(stepSize <= 0.0f || stepSize >= 1.0f) continue;
+
+			batch->pixelShadowCoord[pixel] = normalizedShadowCoord;
+			batch->pixelPenumbraWidth[pixel] = penumbraWidth;
+			batch->pixelFiltered[pixel] = 1;
+			filteredPixels++;
+
+		}
+	}
+
+	return filteredPixels;
+
+}
+
+int RBSSMReference::searchDiscontinuities(RBSSMBatch *batch, int numberOfPixels) {
+
+	//the RBSSM loop up to orientateDS. The taps off a discontinuity are finished here, the others keep what smoothONDS needs
+	float filterWidth = (kernelSize - 1.0f) * 0.5f;
+	int searches = 0;
+
+	#pragma omp parallel for schedule(dynamic, 64) reduction(+:searches)
+	for(int pixel = 0; pixel < numberOfPixels; pixel++) {
+
+		if(!batch->pixelFiltered[pixel]) continue;
+
+		glm::vec4 normalizedShadowCoord = batch->pixelShadowCoord[pixel];
+		float penumbraWidth = batch->pixelPenumbraWidth[pixel];
+		int tap = pixel * tapsPerPixel;
+
+		for(int h = (int)-filterWidth; h <= filterWidth; h++) {
+			for(int w = (int)-filterWidth; w <= filterWidth; w++, tap++) {
+
+				glm::vec4 normalizedLightCoord = glm::vec4(normalizedShadowCoord.x + w * penumbraWidth/filterWidth, 
+					normalizedShadowCoord.y + h * penumbraWidth/filterWidth, normalizedShadowCoord.z, normalizedShadowCoord.w);
+				glm::vec2 subCoord = glm::fract(glm::vec2(normalizedLightCoord.x * float(shadowMapWidth), normalizedLightCoord.y * float(shadowMapHeight)));
+				float distanceFromLight = fetchDepth(normalizedLightCoord.x, normalizedLightCoord.y);
+				glm::vec4 discontinuity = computeDiscontinuity(normalizedLightCoord, distanceFromLight);
+
+				if(discontinuity.r > 0.0f || discontinuity.g > 0.0f) {
+
+					batch->lightCoord[tap] = normalizedLightCoord;
+					batch->discontinuity[tap] = discontinuity;
+					batch->subCoord[tap] = subCoord;
+					batch->discontinuitySpace[tap] = orientateDS(normalizedLightCoord, discontinuity);
+					batch->onEdge[tap] = 1;
+					searches++;
+
+				} else {
+
+					batch->value[tap] = (normalizedLightCoord.z <= distanceFromLight) ? 1.0f : shadowIntensity;
+					batch->onEdge[tap] = 0;
+
+				}
+
+			}
+		}
+
+	}
+
+	return searches;
+
+}
+
+void RBSSMReference::smoothDiscontinuities(RBSSMBatch *batch, int firstRow, int numberOfRows, float *shadows) {
+
+	//the RBSSM loop from normalizeDS on. The taps are summed in kernel order, as the shader does
+	#pragma omp parallel for schedule(dynamic, 64)
+	for(int pixel = 0; pixel < numberOfRows * width; pixel++) {
+
+		if(!batch->pixelFiltered[pixel]) {
+			shadows[firstRow * width + pixel] = batch->pixelShadow[pixel];
+			continue;
+		}
+
+		float illuminationCount = 0.0f;
+		for(int tap = pixel * tapsPerPixel; tap < (pixel + 1) * tapsPerPixel; tap++) {
+
+			if(batch->onEdge[tap]) {
+				glm::vec4 normalizedDiscontinuity = normalizeDS(batch->subCoord[tap], batch->discontinuitySpace[tap]);
+				float fill = smoothONDS(batch->lightCoord[tap], normalizedDiscontinuity, batch->discontinuity[tap], batch->subCoord[tap]);
+				batch->value[tap] = glm::mix(fill, 1.0f, shadowIntensity);
+			}
+			illuminationCount += batch->value[tap];
+
+		}
+		shadows[firstRow * width + pixel] = illuminationCount/float(kernelSize * kernelSize);
+
+	}
+
+}
+
+void RBSSMReference::computeSoftShadows(ShadowParams shadowParams, float *shadows) {
+
+	glm::mat4 bias;
+	bias[0][0] = 0.5;	bias[0][1] = 0;		bias[0][2] = 0;		bias[0][3] = 0.0;
+	bias[1][0] = 0;		bias[1][1] = 0.5;	bias[1][2] = 0;		bias[1][3] = 0.0;
+	bias[2][0] = 0;		bias[2][1] = 0;		bias[2][2] = 0.5;	bias[2][3] = 0.0;
+	bias[3][0] = 0.5;	bias[3][1] = 0.5;	bias[3][2] = 0.5;	bias[3][3] = 1.0;
+
+	//the uniforms configureShadow sets for RBSSM.frag, which is not a screen-space shader
+	lightMVP = bias * shadowParams.lightMVP;
+	shadowMapStep = glm::vec2((float)(1.0/shadowParams.shadowMapWidth), (float)(1.0/shadowParams.shadowMapHeight));
+	depthThreshold = shadowParams.depthThreshold;
+	shadowIntensity = shadowParams.shadowIntensity;
+	lightFrustumScale = shadowParams.lightFrustumScale;
+	maxSearch = shadowParams.maxSearch;
+	blockerSearchSize = shadowParams.blockerSearchSize;
+	kernelSize = shadowParams.kernelSize;
+	lightSourceRadius = shadowParams.lightSourceRadius;
+
+	float filterWidth = (kernelSize - 1.0f) * 0.5f;
+	int tapsPerRow = 0;
+	for(int w = (int)-filterWidth; w <= filterWidth; w++) tapsPerRow++;
+	tapsPerPixel = tapsPerRow * tapsPerRow;
+
+	int rowsPerBatch = MAX_BATCH_TAPS / (width * tapsPerPixel);
+	if(rowsPerBatch < 1) rowsPerBatch = 1;
+	if(rowsPerBatch > height) rowsPerBatch = height;
+	RBSSMBatch batch;
+	allocateBatch(&batch, rowsPerBatch * width, rowsPerBatch * width * tapsPerPixel);
+
+	blockerSearchTime = discontinuitySearchTime = smoothingTime = 0.0;
+	numberOfPixels = numberOfTaps = numberOfSearches = 0;
+
+	for(int firstRow = 0; firstRow < height; firstRow += rowsPerBatch) {
+
+		int numberOfRows = (height - firstRow < rowsPerBatch) ? height - firstRow : rowsPerBatch;
+
+		double time = omp_get_wtime();
+		int filteredPixels = searchBlockers(&batch, firstRow, numberOfRows);
+		blockerSearchTime += omp_get_wtime() - time;
+
+		time = omp_get_wtime();
+		int searches = searchDiscontinuities(&batch, numberOfRows * width);
+		discontinuitySearchTime += omp_get_wtime() - time;
+
+		time = omp_get_wtime();
+		smoothDiscontinuities(&batch, firstRow, numberOfRows, shadows);
+		smoothingTime += omp_get_wtime() - time;
+
+		numberOfPixels += filteredPixels;
+		numberOfTaps += filteredPixels * tapsPerPixel;
+		numberOfSearches += searches;
+
+	}
+
+	freeBatch(&batch);
+
+}
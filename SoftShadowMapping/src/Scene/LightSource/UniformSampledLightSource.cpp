@@ -1,12 +1,92 @@
 #include "Scene\LightSource\UniformSampledLightSource.h"
 
-UniformSampledLightSource::UniformSampledLightSource(LightSource *lightSource, int numberOfPointLights) {
+//fixed seed, so the same pattern and number of samples always give the same sample set
+static unsigned int nextRandom(unsigned int *state) {
+
+	*state = *state * 1664525u + 1013904223u;
+	return *state;
+
+}
+
+static float randomFloat(unsigned int *state) {
+
+	return (nextRandom(state) >> 8) * (1.0f / 16777216.0f);
+
+}
+
+static float radicalInverse(unsigned int index, unsigned int base) {
+
+	float inverseBase = 1.0f / base;
+	float factor = inverseBase;
+	float result = 0.0f;
+
+	while(index > 0) {
+		result += (index % base) * factor;
+		index /= base;
+		factor *= inverseBase;
+	}
+
+	return result;
+
+}
+
+static unsigned int reverseBits(unsigned int x) {
+
+	x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+	x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+	x = ((x >> 4) & 0x0F0F0F0Fu) | ((x & 0x0F0F0F0Fu) << 4);
+	x = ((x >> 8) & 0x00FF00FFu) | ((x & 0x00FF00FFu) << 8);
+	return (x >> 16) | (x << 16);
+
+}
+
+//Owen scrambling with the hash-based permutation of Laine and Karras, applied to the bit-reversed value
+static unsigned int nestedUniformScramble(unsigned int x, unsigned int seed) {
+
+	x = reverseBits(x);
+	x += seed;
+	x ^= x * 0x6c50b47cu;
+	x ^= x * 0xb82f1e52u;
+	x ^= x * 0xc7afe638u;
+	x ^= x * 0x8d22f6e6u;
+	return reverseBits(x);
+
+}
+
+UniformSampledLightSource::UniformSampledLightSource(LightSource *lightSource, int numberOfPointLights, int samplingPattern) {
 	
 	LightSource::setEye(lightSource->getEye());
 	LightSource::setAt(lightSource->getAt());
 	LightSource::setUp(lightSource->getUp());
 	LightSource::setSize(lightSource->getSize());
 	this->numberOfPointLights = numberOfPointLights;
+	this->samplingPattern = samplingPattern;
+
+	//the offsets only depend on the pattern and on the number of samples, so moving the light does not recompute them
+	sampleOffsets = new glm::vec2[numberOfPointLights];
+	switch(samplingPattern) {
+	case STRATIFIED_SAMPLING:
+		computeStratifiedSampling();
+		break;
+	case HALTON_SAMPLING:
+		computeHaltonSampling();
+		break;
+	case SOBOL_SAMPLING:
+		computeSobolSampling();
+		break;
+	case BLUE_NOISE_SAMPLING:
+		computeBlueNoiseSampling();
+		break;
+	default:
+		computeRegularGridSampling();
+		break;
+	}
+
+}
+
+UniformSampledLightSource::~UniformSampledLightSource() {
+
+	delete [] sampleOffsets;
 
 }
 
@@ -26,13 +106,146 @@ glm::vec3 UniformSampledLightSource::getAt(int sampleIndex) {
 
 glm::vec3 UniformSampledLightSource::computeUniformSampling(glm::vec3 sample, int sampleIndex) {
 	
-	float halfSize = (float)LightSource::getSize()/2.0; //step
-	float factor = sqrtf(numberOfPointLights); //17
-	float sampleSize = (factor - 1)/2.0; //8
+	float halfSize = (float)LightSource::getSize()/2.0;
 
-	sample[0] += (((sampleIndex % (int)factor) - sampleSize)/sampleSize) * halfSize;  
-	sample[1] += (((int)(sampleIndex / factor) - sampleSize)/sampleSize) * halfSize;
+	sample[0] += sampleOffsets[sampleIndex].x * halfSize;  
+	sample[1] += sampleOffsets[sampleIndex].y * halfSize;
 	
 	return sample;
 
-}
\ No newline at end of file
+}
+
+void UniformSampledLightSource::computeRegularGridSampling() {
+
+	//samples on the edges of the area light. Counts that are not perfect squares leave the last row incomplete
+	int factor = (int)ceilf(sqrtf((float)numberOfPointLights));
+	float sampleSize = (factor - 1)/2.0;
+
+	for(int sample = 0; sample < numberOfPointLights; sample++) {
+		if(factor == 1) {
+			sampleOffsets[sample] = glm::vec2(0.0);
+		} else {
+			sampleOffsets[sample].x = ((sample % factor) - sampleSize)/sampleSize;
+			sampleOffsets[sample].y = ((sample / factor) - sampleSize)/sampleSize;
+		}
+	}
+
+}
+
+void UniformSampledLightSource::computeStratifiedSampling() {
+
+	//one jittered sample per stratum. The rows are as tall as the share of samples they hold, so every stratum covers 
+	//1/N of the area light for any N
+	int columns = (int)ceilf(sqrtf((float)numberOfPointLights));
+	unsigned int state = 1;
+	int sample = 0;
+
+	while(sample < numberOfPointLights) {
+
+		int rowSamples = (numberOfPointLights - sample < columns) ? numberOfPointLights - sample : columns;
+		float rowStart = (float)sample / numberOfPointLights;
+		float rowHeight = (float)rowSamples / numberOfPointLights;
+
+		for(int column = 0; column < rowSamples; column++, sample++) {
+			sampleOffsets[sample].x = (column + randomFloat(&state)) / rowSamples * 2.0 - 1.0;
+			sampleOffsets[sample].y = (rowStart + randomFloat(&state) * rowHeight) * 2.0 - 1.0;
+		}
+
+	}
+
+}
+
+void UniformSampledLightSource::computeHaltonSampling() {
+
+	//the first point of the sequence is skipped, as it sits on the corner of the area light
+	for(int sample = 0; sample < numberOfPointLights; sample++) {
+		sampleOffsets[sample].x = radicalInverse(sample + 1, 2) * 2.0 - 1.0;
+		sampleOffsets[sample].y = radicalInverse(sample + 1, 3) * 2.0 - 1.0;
+	}
+
+}
+
+void UniformSampledLightSource::computeSobolSampling() {
+
+	for(int sample = 0; sample < numberOfPointLights; sample++) {
+
+		//first dimension is the van der Corput sequence, the second one uses the direction numbers of x + 1
+		unsigned int index = nestedUniformScramble(sample, 0x8ca21d37u);
+		unsigned int x = reverseBits(index);
+		unsigned int y = 0;
+		for(unsigned int v = 1u << 31; index != 0; index >>= 1, v ^= v >> 1)
+			if(index & 1) y ^= v;
+
+		x = nestedUniformScramble(x, 0x5f3759dfu);
+		y = nestedUniformScramble(y, 0x2545f491u);
+		sampleOffsets[sample].x = (x >> 8) * (2.0f / 16777216.0f) - 1.0f;
+		sampleOffsets[sample].y = (y >> 8) * (2.0f / 16777216.0f) - 1.0f;
+
+	}
+
+}
+
+void UniformSampledLightSource::computeBlueNoiseSampling() {
+
+	//Mitchell's best-candidate algorithm: every new sample is the candidate farthest from the samples placed so far. The
+	//placed samples are binned in a uniform grid of about one sample per cell, and the rings of cells around a candidate are
+	//searched until no closer sample can be found or the candidate cannot beat the best one, which gives the same set as the
+	//exhaustive search in close to linear time
+	const int candidatesPerSample = 16;
+	unsigned int state = 1;
+	int gridSize = (int)ceilf(sqrtf((float)numberOfPointLights));
+	float cellSize = 2.0f / gridSize;
+	int *cellHead = new int[gridSize * gridSize];
+	int *nextInCell = new int[numberOfPointLights];
+	for(int cell = 0; cell < gridSize * gridSize; cell++)
+		cellHead[cell] = -1;
+
+	for(int sample = 0; sample < numberOfPointLights; sample++) {
+
+		float bestDistance = -1.0f;
+		for(int candidate = 0; candidate < candidatesPerSample; candidate++) {
+
+			glm::vec2 offset(randomFloat(&state) * 2.0 - 1.0, randomFloat(&state) * 2.0 - 1.0);
+			int cellX = glm::min((int)((offset.x + 1.0f) / cellSize), gridSize - 1);
+			int cellY = glm::min((int)((offset.y + 1.0f) / cellSize), gridSize - 1);
+			float minDistance = 8.0f;
+
+			//the cells of ring r are at least (r - 1) cells away from the candidate
+			for(int ring = 0; ring < gridSize && minDistance > bestDistance; ring++) {
+
+				float ringDistance = (ring - 1) * cellSize;
+				if(ring > 1 && ringDistance * ringDistance >= minDistance) break;
+
+				for(int y = cellY - ring; y <= cellY + ring; y++) {
+					if(y < 0 || y >= gridSize) continue;
+					for(int x = cellX - ring; x <= cellX + ring; x++) {
+						if(x < 0 || x >= gridSize) continue;
+						if(abs(x - cellX) != ring && abs(y - cellY) != ring) continue;
+						for(int previous = cellHead[y * gridSize + x]; previous >= 0; previous = nextInCell[previous]) {
+							glm::vec2 difference = offset - sampleOffsets[previous];
+							float distance = difference.x * difference.x + difference.y * difference.y;
+							if(distance < minDistance) minDistance = distance;
+						}
+					}
+				}
+
+			}
+
+			if(minDistance > bestDistance) {
+				bestDistance = minDistance;
+				sampleOffsets[sample] = offset;
+			}
+
+		}
+
+		int cellX = glm::min((int)((sampleOffsets[sample].x + 1.0f) / cellSize), gridSize - 1);
+		int cellY = glm::min((int)((sampleOffsets[sample].y + 1.0f) / cellSize), gridSize - 1);
+		nextInCell[sample] = cellHead[cellY * gridSize + cellX];
+		cellHead[cellY * gridSize + cellX] = sample;
+
+	}
+
+	delete [] cellHead;
+	delete [] nextInCell;
+
+}
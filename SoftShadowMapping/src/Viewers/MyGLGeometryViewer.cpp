@@ -25,6 +25,34 @@ void MyGLGeometryViewer::configureAmbient(int windowWidth, int windowHeight)
 	
 }
 
+void MyGLGeometryViewer::configureCascades(ShadowParams shadowParams)
+{
+
+	GLuint cascadedShadowMapsID = glGetUniformLocation(shaderProg, "cascadedShadowMaps");
+	glUniform1i(cascadedShadowMapsID, shadowParams.cascadedShadowMaps);
+
+	if(shadowParams.cascadedShadowMaps) {
+		
+		//each cascade is stored in a quadrant of the shadow map, so the bias also scales and offsets into the atlas
+		glm::mat4 cascadeMVP[NUMBER_OF_CASCADES];
+		for(int cascade = 0; cascade < NUMBER_OF_CASCADES; cascade++) {
+			glm::mat4 atlas;
+			atlas[0][0] = 0.25;	atlas[1][1] = 0.25;	atlas[2][2] = 0.5;
+			atlas[3][0] = 0.25 + 0.5 * (cascade % 2);	atlas[3][1] = 0.25 + 0.5 * (cascade / 2);	atlas[3][2] = 0.5;
+			cascadeMVP[cascade] = atlas * shadowParams.cascadeMVP[cascade];
+		}
+
+		GLuint cascadeMVPID = glGetUniformLocation(shaderProg, "cascadeMVP");
+		glUniformMatrix4fv(cascadeMVPID, NUMBER_OF_CASCADES, GL_FALSE, &cascadeMVP[0][0][0]);
+		GLuint cascadeSplitsID = glGetUniformLocation(shaderProg, "cascadeSplits");
+		glUniform3f(cascadeSplitsID, shadowParams.cascadeSplits[0], shadowParams.cascadeSplits[1], shadowParams.cascadeSplits[2]);
+		GLuint cascadeScaleID = glGetUniformLocation(shaderProg, "cascadeScale");
+		glUniform1fv(cascadeScaleID, NUMBER_OF_CASCADES, shadowParams.cascadeScale);
+
+	}
+
+}
+
 void MyGLGeometryViewer::configureGBuffer(ShadowParams shadowParams) {
 
 	GLuint vertexMap = glGetUniformLocation(shaderProg, "vertexMap");
@@ -33,6 +61,8 @@ void MyGLGeometryViewer::configureGBuffer(ShadowParams shadowParams) {
 	glUniform1i(normalMap, 9);
 	GLuint colorMap = glGetUniformLocation(shaderProg, "colorMap");
 	glUniform1i(colorMap, 10);
+	GLuint inverseGBufferMVPID = glGetUniformLocation(shaderProg, "inverseGBufferMVP");
+	glUniformMatrix4fv(inverseGBufferMVPID, 1, GL_FALSE, &shadowParams.inverseGBufferMVP[0][0]);
 
 	glActiveTexture(GL_TEXTURE8);
 	glBindTexture(GL_TEXTURE_2D, shadowParams.vertexMap);
@@ -124,6 +154,9 @@ void MyGLGeometryViewer::configureMoments(ShadowParams shadowParams)
 		glUniformMatrix4fv(mQuantizationID, 1, GL_FALSE, &mQuantization[0][0]);
 		GLuint mQuantizationInverseID = glGetUniformLocation(shaderProg, "momentInverseRotationMatrix");
 		glUniformMatrix4fv(mQuantizationInverseID, 1, GL_FALSE, &mQuantizationInverse[0][0]);
+		//16-bit moments need the larger bias of Peters et al. to hide their rounding error
+		GLuint momentBiasID = glGetUniformLocation(shaderProg, "momentBias");
+		glUniform1f(momentBiasID, (shadowParams.compactMoments) ? 0.00006 : 0.00003);
 	}
 
 }
@@ -213,6 +246,9 @@ void MyGLGeometryViewer::configureShadow(ShadowParams shadowParams)
 	glUniform1i(kernelSizeID, shadowParams.kernelSize);
 	GLuint lightSourceRadiusID = glGetUniformLocation(shaderProg, "lightSourceRadius");
 	glUniform1i(lightSourceRadiusID, shadowParams.lightSourceRadius);
+	GLuint lightFrustumScaleID = glGetUniformLocation(shaderProg, "lightFrustumScale");
+	glUniform1f(lightFrustumScaleID, shadowParams.lightFrustumScale);
+	configureCascades(shadowParams);
 	if(shadowParams.SSSM) {
 		GLuint blockerThresholdID = glGetUniformLocation(shaderProg, "blockerThreshold");
 		glUniform1f(blockerThresholdID, shadowParams.blockerThreshold);
@@ -257,6 +293,11 @@ void MyGLGeometryViewer::configureShadow(ShadowParams shadowParams)
 	configureMoments(shadowParams);
 	GLuint shadowMap = glGetUniformLocation(shaderProg, "shadowMap");
 	glUniform1i(shadowMap, 0);
+	//samplers of different types cannot share a unit, so the integer table keeps its own even when it is not read
+	GLuint integerSATShadowMap = glGetUniformLocation(shaderProg, "integerSATShadowMap");
+	glUniform1i(integerSATShadowMap, 15);
+	GLuint integerSATID = glGetUniformLocation(shaderProg, "integerSAT");
+	glUniform1i(integerSATID, shadowParams.SAT && shadowParams.integerSAT && (shadowParams.SAVSM || shadowParams.VSSM));
 
 	if(shadowParams.renderFromGBuffer) {
 
@@ -266,6 +307,8 @@ void MyGLGeometryViewer::configureShadow(ShadowParams shadowParams)
 		glUniform1i(normalMap, 9);
 		GLuint colorMap = glGetUniformLocation(shaderProg, "colorMap");
 		glUniform1i(colorMap, 10);
+		GLuint inverseGBufferMVPID = glGetUniformLocation(shaderProg, "inverseGBufferMVP");
+		glUniformMatrix4fv(inverseGBufferMVPID, 1, GL_FALSE, &shadowParams.inverseGBufferMVP[0][0]);
 
 		if(shadowParams.useSoftShadowMap) {
 		
@@ -286,7 +329,7 @@ void MyGLGeometryViewer::configureShadow(ShadowParams shadowParams)
 
 	}
 	
-	if(shadowParams.useHierarchicalShadowMap) {
+	if(shadowParams.useHierarchicalShadowMap || shadowParams.penumbraClassification) {
 		
 		GLuint hierarchicalShadowMap = glGetUniformLocation(shaderProg, "hierarchicalShadowMap");
 		glUniform1i(hierarchicalShadowMap, 11);
@@ -298,6 +341,35 @@ void MyGLGeometryViewer::configureShadow(ShadowParams shadowParams)
 
 	} 
 	
+	if(shadowParams.progressiveMonteCarlo) {
+
+		GLuint historyMap = glGetUniformLocation(shaderProg, "historyMap");
+		glUniform1i(historyMap, 14);
+		GLuint cameraMVPID = glGetUniformLocation(shaderProg, "cameraMVP");
+		glUniformMatrix4fv(cameraMVPID, 1, GL_FALSE, &shadowParams.cameraMVP[0][0]);
+		GLuint previousCameraMVPID = glGetUniformLocation(shaderProg, "previousCameraMVP");
+		glUniformMatrix4fv(previousCameraMVPID, 1, GL_FALSE, &shadowParams.previousCameraMVP[0][0]);
+		GLuint totalNumberOfSamplesID = glGetUniformLocation(shaderProg, "totalNumberOfSamples");
+		glUniform1i(totalNumberOfSamplesID, shadowParams.totalNumberOfSamples);
+		GLuint resetHistoryID = glGetUniformLocation(shaderProg, "resetHistory");
+		glUniform1i(resetHistoryID, shadowParams.resetHistory);
+
+	}
+
+	if(shadowParams.tiledAdaptiveSampling) {
+
+		GLuint sampleStrideID = glGetUniformLocation(shaderProg, "sampleStride");
+		glUniform1i(sampleStrideID, shadowParams.sampleStride);
+
+	}
+
+	if(shadowParams.streamingMonteCarlo) {
+
+		GLuint totalNumberOfSamplesID = glGetUniformLocation(shaderProg, "totalNumberOfSamples");
+		glUniform1i(totalNumberOfSamplesID, shadowParams.totalNumberOfSamples);
+
+	}
+
 	if(shadowParams.revectorizationBasedQuadTreeEvaluation) {
 
 		GLuint discontinuityMapArray = glGetUniformLocation(shaderProg, "discontinuityMapArray");
@@ -337,12 +409,14 @@ void MyGLGeometryViewer::configureShadow(ShadowParams shadowParams)
 
 			glActiveTexture(GL_TEXTURE1);
 			glBindTexture(GL_TEXTURE_2D, shadowParams.SATShadowMap);
+			glActiveTexture(GL_TEXTURE15);
+			glBindTexture(GL_TEXTURE_2D, shadowParams.integerSATShadowMap);
 		
 		} 
 
 	}
 	
-	if(shadowParams.useHierarchicalShadowMap) {
+	if(shadowParams.useHierarchicalShadowMap || shadowParams.penumbraClassification) {
 		
 		glActiveTexture(GL_TEXTURE11);
 		glBindTexture(GL_TEXTURE_2D, shadowParams.hierarchicalShadowMap);
@@ -354,6 +428,13 @@ void MyGLGeometryViewer::configureShadow(ShadowParams shadowParams)
 
 	} 
 	
+	if(shadowParams.progressiveMonteCarlo) {
+
+		glActiveTexture(GL_TEXTURE14);
+		glBindTexture(GL_TEXTURE_2D, shadowParams.historyMap);
+
+	}
+
 	if(shadowParams.revectorizationBasedAdaptiveSampling) {
 
 		glActiveTexture(GL_TEXTURE12);
@@ -387,7 +468,7 @@ void MyGLGeometryViewer::configureShadow(ShadowParams shadowParams)
 
 	} 
 	
-	if(shadowParams.useHierarchicalShadowMap) {
+	if(shadowParams.useHierarchicalShadowMap || shadowParams.penumbraClassification) {
 			
 		glActiveTexture(GL_TEXTURE11);
 		glDisable(GL_TEXTURE_2D);
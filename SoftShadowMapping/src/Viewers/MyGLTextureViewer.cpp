@@ -66,6 +66,45 @@ void MyGLTextureViewer::loadRGBTexture(const unsigned char *data, GLuint *texVBO
 	
 }
 
+void MyGLTextureViewer::loadRGBTexture(Image *image, GLuint *texVBO, int index)
+{
+
+	if(image->getMipmaps() == NULL) {
+		loadRGBTexture(image->getData(), texVBO, index, image->getWidth(), image->getHeight());
+		return;
+	}
+
+	//the whole mip chain is staged in a single pixel unpack buffer, so the driver can copy it asynchronously
+	GLuint pixelBuffer;
+	glGenBuffers(1, &pixelBuffer);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer);
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, image->getMipmapsSize(), NULL, GL_STREAM_DRAW);
+	void *pixels = glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
+	memcpy(pixels, image->getMipmaps(), image->getMipmapsSize());
+	glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+	glBindTexture(GL_TEXTURE_2D, texVBO[index]);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, image->getNumberOfLevels() - 1);
+	glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+
+	for(int level = 0; level < image->getNumberOfLevels(); level++) {
+		GLvoid *offset = (GLvoid*)(image->getLevel(level) - image->getMipmaps());
+		if(image->isCompressed())
+			glCompressedTexImage2D(GL_TEXTURE_2D, level, GL_COMPRESSED_RGB_S3TC_DXT1_EXT, image->getLevelWidth(level), image->getLevelHeight(level), 0, image->getLevelSize(level), offset);
+		else
+			glTexImage2D(GL_TEXTURE_2D, level, GL_RGB8, image->getLevelWidth(level), image->getLevelHeight(level), 0, GL_RGB, GL_UNSIGNED_BYTE, offset);
+	}
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	glDeleteBuffers(1, &pixelBuffer);
+
+}
+
 void MyGLTextureViewer::loadRGBTexture(float *data, GLuint *texVBO, int index, int imageWidth, int imageHeight, GLint params)
 {
 
@@ -114,6 +153,99 @@ void MyGLTextureViewer::loadRGBATexture(int *data, GLuint *texVBO, int index, in
 	
 }
 
+void MyGLTextureViewer::loadRGBATexture(unsigned int *data, GLuint *texVBO, int index, int imageWidth, int imageHeight)
+{
+
+	//integer textures cannot be filtered
+	glBindTexture(GL_TEXTURE_2D, texVBO[index]);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32UI, imageWidth, imageHeight, 0, GL_RGBA_INTEGER, GL_UNSIGNED_INT, data);
+	
+}
+
+void MyGLTextureViewer::loadRTexture(float *data, GLuint *texVBO, int index, int imageWidth, int imageHeight, GLint internalFormat, GLint param)
+{
+
+	glBindTexture(GL_TEXTURE_2D, texVBO[index]);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, param);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, param);
+	glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+	glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, imageWidth, imageHeight, 0, GL_RED, GL_FLOAT, data);
+	
+}
+
+void MyGLTextureViewer::loadRGTexture(unsigned short *data, GLuint *texVBO, int index, int imageWidth, int imageHeight, GLint param)
+{
+
+	glBindTexture(GL_TEXTURE_2D, texVBO[index]);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, param);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, param);
+	glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16, imageWidth, imageHeight, 0, GL_RG, GL_UNSIGNED_SHORT, data);
+	
+}
+
+void MyGLTextureViewer::loadRGTexture(unsigned int *data, GLuint *texVBO, int index, int imageWidth, int imageHeight)
+{
+
+	//integer textures cannot be filtered
+	glBindTexture(GL_TEXTURE_2D, texVBO[index]);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32UI, imageWidth, imageHeight, 0, GL_RG_INTEGER, GL_UNSIGNED_INT, data);
+	
+}
+
+void MyGLTextureViewer::loadRGTexture(float *data, GLuint *texVBO, int index, int imageWidth, int imageHeight, GLint param)
+{
+
+	glBindTexture(GL_TEXTURE_2D, texVBO[index]);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, param);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, param);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32F, imageWidth, imageHeight, 0, GL_RG, GL_FLOAT, data);
+	
+}
+
+void MyGLTextureViewer::loadRGBATexture(unsigned char *data, GLuint *texVBO, int index, int imageWidth, int imageHeight, GLint param)
+{
+
+	glBindTexture(GL_TEXTURE_2D, texVBO[index]);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, param);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, param);
+	glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, imageWidth, imageHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+	
+}
+
+void MyGLTextureViewer::loadRGBATexture(unsigned short *data, GLuint *texVBO, int index, int imageWidth, int imageHeight, GLint param)
+{
+
+	glBindTexture(GL_TEXTURE_2D, texVBO[index]);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, param);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, param);
+	glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_TRUE);
+	
+	glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16, imageWidth, imageHeight, 0, GL_RGBA, GL_UNSIGNED_SHORT, data);
+	glGenerateMipmap(GL_TEXTURE_2D);
+	
+}
+
 void MyGLTextureViewer::loadFrameBufferTexture(int x, int y, int width, int height, unsigned char *frameBuffer) {
 
 	glReadPixels(x, y, width, height, GL_RGB, GL_UNSIGNED_BYTE, frameBuffer);
@@ -211,6 +343,21 @@ void MyGLTextureViewer::drawTextureQuad()
  
 }
 
+//draws a list of screen regions with the full-screen quad shaders, two triangles per region
+void MyGLTextureViewer::drawTextureQuads(float *texcoords, int numberOfQuads) 
+{
+
+	GLuint attribute_texcoord = glGetAttribLocation(shaderProg, "texcoord");
+    glEnableVertexAttribArray(attribute_texcoord);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glVertexAttribPointer(attribute_texcoord, 2, GL_FLOAT, GL_FALSE, 0, texcoords);
+	
+	glDrawArrays(GL_TRIANGLES, 0, numberOfQuads * 6);
+
+	glDisableVertexAttribArray(attribute_texcoord);
+ 
+}
+
 void MyGLTextureViewer::drawTextureOnShader(GLuint texture, int imageWidth, int imageHeight)
 {
 
@@ -0,0 +1,180 @@
+#include "Viewers\RenderTargetPool.h"
+
+RenderTargetPool::RenderTargetPool()
+{
+
+	textureViewer = NULL;
+	for(int slot = 0; slot < MAX_RENDER_TARGET_SLOTS; slot++) {
+		declared[slot] = false;
+		slotTarget[slot] = -1;
+	}
+
+}
+
+void RenderTargetPool::declare(int slot, GLenum internalFormat, int width, int height, GLint filter, bool transient)
+{
+
+	slots[slot].internalFormat = internalFormat;
+	slots[slot].width = width;
+	slots[slot].height = height;
+	slots[slot].filter = filter;
+	slots[slot].transient = transient;
+	declared[slot] = true;
+
+	//a slot holding a target of another size or format gives it back, the next acquire picks a matching one
+	if(slotTarget[slot] >= 0 && !isEqual(&targets[slotTarget[slot]].description, &slots[slot]))
+		release(slot);
+
+}
+
+bool RenderTargetPool::isEqual(RenderTargetDescription *a, RenderTargetDescription *b)
+{
+
+	return a->internalFormat == b->internalFormat && a->width == b->width && a->height == b->height && a->filter == b->filter && 
+		a->transient == b->transient;
+
+}
+
+long long RenderTargetPool::computeSize(RenderTargetDescription *description)
+{
+
+	long long size = (long long)description->width * description->height;
+	
+	//color targets are loaded with a full mip chain, which adds a third of the base level
+	if(description->internalFormat == GL_RGBA32F)
+		return (size * 16 * 4) / 3;
+	else if(description->internalFormat == GL_RGBA16)
+		return (size * 8 * 4) / 3;
+	else if(description->internalFormat == GL_R16F)
+		return size * 2;
+	else if(description->internalFormat == GL_RG32UI || description->internalFormat == GL_RG32F)
+		return size * 8;
+	else if(description->internalFormat == GL_RGBA32UI)
+		return size * 16;
+	else //GL_R32F, GL_RG16, GL_RGBA8 and the 32-bit depth formats
+		return size * 4;
+
+}
+
+GLuint RenderTargetPool::createTexture(RenderTargetDescription *description)
+{
+
+	GLuint texture;
+	glGenTextures(1, &texture);
+	if(description->internalFormat == GL_RGBA32F)
+		textureViewer->loadRGBATexture((float*)NULL, &texture, 0, description->width, description->height, description->filter);
+	else if(description->internalFormat == GL_R16F || description->internalFormat == GL_R32F)
+		textureViewer->loadRTexture((float*)NULL, &texture, 0, description->width, description->height, description->internalFormat, description->filter);
+	else if(description->internalFormat == GL_RGBA16)
+		textureViewer->loadRGBATexture((unsigned short*)NULL, &texture, 0, description->width, description->height, description->filter);
+	else if(description->internalFormat == GL_RG32UI)
+		textureViewer->loadRGTexture((unsigned int*)NULL, &texture, 0, description->width, description->height);
+	else if(description->internalFormat == GL_RGBA32UI)
+		textureViewer->loadRGBATexture((unsigned int*)NULL, &texture, 0, description->width, description->height);
+	else if(description->internalFormat == GL_RG32F)
+		textureViewer->loadRGTexture((float*)NULL, &texture, 0, description->width, description->height, description->filter);
+	else if(description->internalFormat == GL_RG16)
+		textureViewer->loadRGTexture((unsigned short*)NULL, &texture, 0, description->width, description->height, description->filter);
+	else if(description->internalFormat == GL_RGBA8)
+		textureViewer->loadRGBATexture((unsigned char*)NULL, &texture, 0, description->width, description->height, description->filter);
+	else
+		textureViewer->loadDepthComponentTexture(NULL, &texture, 0, description->width, description->height);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	return texture;
+
+}
+
+GLuint RenderTargetPool::acquire(int slot)
+{
+
+	if(!declared[slot])
+		return 0;
+	if(slotTarget[slot] >= 0)
+		return targets[slotTarget[slot]].texture;
+
+	//transient targets are shared by every slot with the same description, persistent ones only reuse a target nobody holds
+	for(int target = 0; target < (int)targets.size(); target++) {
+		if(isEqual(&targets[target].description, &slots[slot]) && (slots[slot].transient || targets[target].users == 0)) {
+			targets[target].users++;
+			slotTarget[slot] = target;
+			return targets[target].texture;
+		}
+	}
+
+	RenderTarget renderTarget;
+	renderTarget.description = slots[slot];
+	renderTarget.texture = createTexture(&slots[slot]);
+	renderTarget.users = 1;
+	targets.push_back(renderTarget);
+	slotTarget[slot] = (int)targets.size() - 1;
+	return renderTarget.texture;
+
+}
+
+void RenderTargetPool::release(int slot)
+{
+
+	if(slotTarget[slot] < 0)
+		return;
+	targets[slotTarget[slot]].users--;
+	slotTarget[slot] = -1;
+
+}
+
+void RenderTargetPool::trim()
+{
+
+	std::vector<int> remap(targets.size());
+	int numberOfTargets = 0;
+
+	for(int target = 0; target < (int)targets.size(); target++) {
+		if(targets[target].users > 0) {
+			remap[target] = numberOfTargets;
+			targets[numberOfTargets++] = targets[target];
+		} else {
+			glDeleteTextures(1, &targets[target].texture);
+			remap[target] = -1;
+		}
+	}
+	targets.resize(numberOfTargets);
+
+	for(int slot = 0; slot < MAX_RENDER_TARGET_SLOTS; slot++)
+		if(slotTarget[slot] >= 0)
+			slotTarget[slot] = remap[slotTarget[slot]];
+
+}
+
+void RenderTargetPool::clear()
+{
+
+	for(int target = 0; target < (int)targets.size(); target++)
+		glDeleteTextures(1, &targets[target].texture);
+	targets.clear();
+	for(int slot = 0; slot < MAX_RENDER_TARGET_SLOTS; slot++) {
+		declared[slot] = false;
+		slotTarget[slot] = -1;
+	}
+
+}
+
+long long RenderTargetPool::getAllocatedBytes()
+{
+
+	long long bytes = 0;
+	for(int target = 0; target < (int)targets.size(); target++)
+		bytes += computeSize(&targets[target].description);
+	return bytes;
+
+}
+
+long long RenderTargetPool::getDeclaredBytes()
+{
+
+	//the memory a dedicated texture per slot would take, as when every target was created up front
+	long long bytes = 0;
+	for(int slot = 0; slot < MAX_RENDER_TARGET_SLOTS; slot++)
+		if(declared[slot])
+			bytes += computeSize(&slots[slot]);
+	return bytes;
+
+}
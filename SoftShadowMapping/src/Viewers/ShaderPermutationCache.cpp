@@ -0,0 +1,61 @@
+#include "Viewers\ShaderPermutationCache.h"
+#include "Viewers\shader.h"
+
+ShaderPermutationCache::ShaderPermutationCache()
+{
+
+}
+
+GLuint ShaderPermutationCache::getProgram(char *shaderName, const char *defines)
+{
+
+	for(int p = 0; p < (int)permutations.size(); p++)
+		if(permutations[p].shaderName == shaderName && permutations[p].defines == defines)
+			return permutations[p].program;
+
+	//a permutation that fails to build is kept with program 0, so it is not compiled again every frame
+	ShaderPermutation permutation;
+	permutation.shaderName = shaderName;
+	permutation.defines = defines;
+	permutation.program = compileShaderPermutation(shaderName, defines);
+	permutations.push_back(permutation);
+	return permutation.program;
+
+}
+
+void ShaderPermutationCache::clear()
+{
+
+	for(int p = 0; p < (int)permutations.size(); p++)
+		if(permutations[p].program)
+			glDeleteProgram(permutations[p].program);
+	permutations.clear();
+
+}
+
+void ShaderPermutationCache::printProgram(const char *shaderName, const char *defines, GLuint program)
+{
+
+	//GLSL gives no instruction counts, the program binary size and the active uniforms are the closest portable measures
+	GLint binaryLength = 0;
+	GLint activeUniforms = 0;
+	if(program) {
+		if(GLEW_ARB_get_program_binary)
+			glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+		glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &activeUniforms);
+	}
+
+	std::string line = defines;
+	for(int c = 0; c < (int)line.size(); c++)
+		if(line[c] == '\n') line[c] = ' ';
+	printf("%s [%s]: %d bytes, %d active uniforms\n", shaderName, line.c_str(), binaryLength, activeUniforms);
+
+}
+
+void ShaderPermutationCache::printStatistics()
+{
+
+	for(int p = 0; p < (int)permutations.size(); p++)
+		printProgram(permutations[p].shaderName.c_str(), permutations[p].defines.c_str(), permutations[p].program);
+
+}
@@ -1,5 +1,10 @@
 #include "Viewers\shader.h"
 
+//
+// Preprocessor lines prepended to every shader compiled by initShader
+//
+static const GLchar *shaderDefines = "";
+
 // ***********************************************************************
 // ***********************************************************************
 //
@@ -91,6 +96,7 @@ static void printProgramInfoLog(GLuint program) {
 //
 // <fileName>.vert
 // <fileName>.frag
+// <fileName>.comp
 //
 // ***********************************************************************
 
@@ -109,6 +115,9 @@ static int shaderSize(char *fileName, EShaderType shaderType) {
         case EFragmentShader:
             strcat(name, ".frag");
             break;
+        case EComputeShader:
+            strcat(name, ".comp");
+            break;
         default:
             printf("ERROR: unknown shader file type\n");
             exit(1);
@@ -160,6 +169,9 @@ static int readShader(char *fileName, EShaderType shaderType, char *shaderText,
         case EFragmentShader:
             strcat(name, ".frag");
             break;
+        case EComputeShader:
+            strcat(name, ".comp");
+            break;
         default:
             printf("ERROR: unknown shader file type\n");
             exit(1);
@@ -187,6 +199,63 @@ static int readShader(char *fileName, EShaderType shaderType, char *shaderText,
     return count;
 }
 
+// ***********************************************************************
+//
+// Replaces every #include "<file>" line of the shader source with the
+// contents of Shaders/<file>, so common GLSL functions are kept in a
+// single file. Included files may include other files. The source
+// buffer is released and the expanded buffer is returned.
+//
+// ***********************************************************************
+static GLchar *resolveIncludes(GLchar *source) {
+
+    FILE *fh;
+    char name[256];
+    char *directive, *begin, *end, *lineEnd;
+    GLchar *expanded;
+    int includeSize, prefixSize, count;
+
+    directive = strstr(source, "#include");
+    if (directive == NULL)
+        return source;
+
+    begin = strchr(directive, '"');
+    end = (begin != NULL) ? strchr(begin + 1, '"') : NULL;
+    if (end == NULL)
+    {
+        printf("ERROR: malformed #include directive\n");
+        exit(1);
+    }
+
+    strcpy(name, "Shaders/");
+    strncat(name, begin + 1, end - begin - 1);
+
+    fh = fopen(name, "r");
+    if (!fh)
+    {
+        printf("Cannot read the include file %s\n", name);
+        exit(0);
+    }
+    fseek(fh, 0, SEEK_END);
+    includeSize = (int) ftell(fh);
+    fseek(fh, 0, SEEK_SET);
+
+    lineEnd = strchr(end, '\n');
+    if (lineEnd == NULL)
+        lineEnd = end + strlen(end);
+    prefixSize = (int) (directive - source);
+
+    expanded = (GLchar *) malloc(prefixSize + includeSize + strlen(lineEnd) + 2);
+    memcpy(expanded, source, prefixSize);
+    count = (int) fread(expanded + prefixSize, 1, includeSize, fh);
+    fclose(fh);
+    expanded[prefixSize + count] = '\n';
+    strcpy(expanded + prefixSize + count + 1, lineEnd);
+
+    free(source);
+    return resolveIncludes(expanded);
+}
+
 // ***********************************************************************
 // ***********************************************************************
 
@@ -223,15 +292,24 @@ int readShaderSource(char *fileName, GLchar **vertexShader, GLchar **fragmentSha
         return 0;
     }
 
+    *vertexShader = resolveIncludes(*vertexShader);
+    *fragmentShader = resolveIncludes(*fragmentShader);
+
     return 1;
 }
 
 // ***********************************************************************
+//
+// Compiles the two shaders with the global defines followed by the
+// permutation defines and links them. Returns the program object, or 0
+// if an error occurred.
+//
 // ***********************************************************************
-int installShaders(	const GLchar *shVertex,
-					const GLchar *shFragment,
-					const int id) {
+static GLuint linkShaders(	const GLchar *shVertex,
+							const GLchar *shFragment,
+							const GLchar *permutationDefines) {
 
+    GLuint program;
     GLint  vertCompiled;
     GLint  fragCompiled;    // status values
 
@@ -242,8 +320,10 @@ int installShaders(	const GLchar *shVertex,
 
     // Load source code strings into shaders
 
-    glShaderSource(shaderVS, 1, &shVertex, NULL);
-    glShaderSource(shaderFS, 1, &shFragment, NULL);
+    const GLchar *vertexSources[3] = {shaderDefines, permutationDefines, shVertex};
+    const GLchar *fragmentSources[3] = {shaderDefines, permutationDefines, shFragment};
+    glShaderSource(shaderVS, 3, vertexSources, NULL);
+    glShaderSource(shaderFS, 3, fragmentSources, NULL);
 
     // Compile the vertex shader, and print out
     // the compiler log file.
@@ -266,20 +346,33 @@ int installShaders(	const GLchar *shVertex,
 
     // Create a program object and attach the two compiled shaders
 
-    shaderProg[id] = glCreateProgram();
-    glAttachShader(shaderProg[id], shaderVS);
-    glAttachShader(shaderProg[id], shaderFS);
+    program = glCreateProgram();
+    glAttachShader(program, shaderVS);
+    glAttachShader(program, shaderFS);
 
     // Link the program object and print out the info log
 
-    glLinkProgram(shaderProg[id]);
+    glLinkProgram(program);
     printOpenGLError();  // Check for OpenGL errors
-    glGetProgramiv(shaderProg[id], GL_LINK_STATUS, &linked);
-    printProgramInfoLog(shaderProg[id]);
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    printProgramInfoLog(program);
 
     if (!linked)
         return 0;
 
+    return program;
+}
+
+// ***********************************************************************
+// ***********************************************************************
+int installShaders(	const GLchar *shVertex,
+					const GLchar *shFragment,
+					const int id) {
+
+    shaderProg[id] = linkShaders(shVertex, shFragment, "");
+    if (!shaderProg[id])
+        return 0;
+
     // Install program object as part of current state
 
     glUseProgram(shaderProg[id]);
@@ -327,6 +420,15 @@ void getGlVersion( int *major, int *minor ) {
 /// ** 
 /// ***********************************************************************
 
+void setShaderDefines(const char *defines) {
+
+    shaderDefines = defines;
+}
+
+/// ***********************************************************************
+/// ** 
+/// ***********************************************************************
+
 void initShader(char* shaderName, int id ) {
 	
 int success = 0;
@@ -354,3 +456,80 @@ GLchar 	*VertexShaderSource,
     	exit(0);
     	}   	
 }
+
+/// ***********************************************************************
+/// ** 
+/// ***********************************************************************
+
+GLuint compileShaderPermutation(char *shaderName, const char *defines) {
+
+GLuint program;
+GLchar 	*VertexShaderSource, 
+		*FragmentShaderSource;
+
+    if (!readShaderSource(shaderName, &VertexShaderSource, &FragmentShaderSource))
+        return 0;
+
+    program = linkShaders(VertexShaderSource, FragmentShaderSource, defines);
+    free(VertexShaderSource);
+    free(FragmentShaderSource);
+
+    if (!program)
+    	printf("Fail to load the permutation of %s:\n%s\n", shaderName, defines);
+    return program;
+}
+
+/// ***********************************************************************
+/// ** 
+/// ***********************************************************************
+
+void initComputeShader(char* shaderName, int id ) {
+
+int size;
+GLint computeCompiled;
+GLchar *ComputeShaderSource;
+GLuint shaderCS;
+
+    size = shaderSize(shaderName, EComputeShader);
+    if (size == -1)
+    {
+        printf("Cannot determine size of the shader %s\n", shaderName);
+        exit(0);
+    }
+
+    ComputeShaderSource = (GLchar *) malloc(size);
+    if (!readShader(shaderName, EComputeShader, ComputeShaderSource, size))
+    {
+        printf("Cannot read the file %s.comp\n", shaderName);
+        exit(0);
+    }
+    ComputeShaderSource = resolveIncludes(ComputeShaderSource);
+
+    // The #version line must come first, so it is not part of the file
+
+    const GLchar *computeSources[3] = {"#version 430 compatibility\n", shaderDefines, ComputeShaderSource};
+    shaderCS = glCreateShader(GL_COMPUTE_SHADER);
+    glShaderSource(shaderCS, 3, computeSources, NULL);
+    glCompileShader(shaderCS);
+    printOpenGLError();  // Check for OpenGL errors
+    glGetShaderiv(shaderCS, GL_COMPILE_STATUS, &computeCompiled);
+    printShaderInfoLog(shaderCS);
+    free(ComputeShaderSource);
+
+    if (!computeCompiled) {
+    	printf("Fail to load Shaders!!\n");
+    	exit(0);
+    	}
+
+    shaderProg[id] = glCreateProgram();
+    glAttachShader(shaderProg[id], shaderCS);
+    glLinkProgram(shaderProg[id]);
+    printOpenGLError();  // Check for OpenGL errors
+    glGetProgramiv(shaderProg[id], GL_LINK_STATUS, &linked);
+    printProgramInfoLog(shaderProg[id]);
+
+    if (!linked) {
+    	printf("Fail to load Shaders!!\n");
+    	exit(0);
+    	}
+}
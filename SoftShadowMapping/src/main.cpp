@@ -26,6 +26,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
+#include <string.h>
 #include <GL/glew.h>
 #include <GL/glut.h>
 #include <time.h>
@@ -36,12 +37,17 @@
 #include "Viewers\MyGLGeometryViewer.h"
 #include "Viewers\shader.h"
 #include "Viewers\ShadowParams.h"
+#include "Viewers\ShadowMapCache.h"
+#include "Viewers\RenderTargetPool.h"
+#include "Viewers\ShaderPermutationCache.h"
 #include "IO\SceneLoader.h"
 #include "Scene\Mesh.h"
 #include "Scene\LightSource\LightSource.h"
 #include "Scene\LightSource\UniformSampledLightSource.h"
 #include "Scene\LightSource\QuadTreeLightSource.h"
 #include "EDT\pba2D.h"
+#include "EDT\DistanceTransform.h"
+#include "Reference\RBSSMReference.h"
 #include "Image.h"
 #include "Filter.h"
 
@@ -72,7 +78,28 @@ enum
 	VISIBILITY_MAP_COLOR = 22,
 	CUDA_MAP_DEPTH = 23,
 	CUDA_MAP_COLOR = 24,
-	CUDA_POSITION_MAP_COLOR = 25
+	CUDA_POSITION_MAP_COLOR = 25,
+	HISTORY_MAP_DEPTH = 26,
+	HISTORY_MAP_COLOR = 27,
+	TEMP_HISTORY_MAP_COLOR = 28,
+	VISIBILITY_ACCUMULATION_MAP_COLOR = 29,
+	TILE_CLASSIFICATION_MAP_COLOR = 30,
+	FULL_GBUFFER_MAP_DEPTH = 31,
+	FULL_VERTEX_MAP_COLOR = 32,
+	FULL_NORMAL_MAP_COLOR = 33,
+	FULL_TEXTURE_MAP_COLOR = 34,
+	UPSAMPLED_SOFT_SHADOW_MAP_DEPTH = 35,
+	UPSAMPLED_SOFT_SHADOW_MAP_COLOR = 36,
+	LIGHT_FRUSTUM_MAP_COLOR = 37,
+	GUIDED_FILTER_MAP_COLOR = 38,
+	GUIDED_FILTER_MOMENTS_MAP_COLOR = 39,
+	TEMP_GUIDED_FILTER_MAP_COLOR = 40,
+	TEMP_GUIDED_FILTER_MOMENTS_MAP_COLOR = 41,
+	INTEGER_SAT_SHADOW_MAP_COLOR = 42,
+	TEMP_INTEGER_SAT_SHADOW_MAP_COLOR = 43,
+	JUMP_FLOODING_MAP_COLOR = 44,
+	TEMP_JUMP_FLOODING_MAP_COLOR = 45,
+	JUMP_FLOODING_EDT_MAP_COLOR = 46
 };
 
 enum
@@ -104,7 +131,26 @@ enum
 	PLAUSIBLE_SOFT_SHADOW_SHADER = 24,
 	RBSSM_SHADER = 25,
 	ACCURATE_SOFT_SHADOW_SHADER = 26,
-	REVECTORIZATION_BASED_ACCURATE_SOFT_SHADOW_SHADER = 27
+	REVECTORIZATION_BASED_ACCURATE_SOFT_SHADOW_SHADER = 27,
+	PROGRESSIVE_SOFT_SHADOW_SHADER = 28,
+	STREAMING_SOFT_SHADOW_SHADER = 29,
+	TILE_CLASSIFICATION_SHADER = 30,
+	TILED_SOFT_SHADOW_SHADER = 31,
+	PENUMBRA_CLASSIFICATION_SHADER = 32,
+	COMPUTE_PCSS_SHADER = 33,
+	JOINT_BILATERAL_UPSAMPLING_SHADER = 34,
+	LIGHT_FRUSTUM_REDUCTION_SHADER = 35,
+	GUIDED_FILTER_MOMENTS_SHADER = 36,
+	GUIDED_FILTER_SAT_SHADER = 37,
+	GUIDED_FILTER_COEFFICIENTS_SHADER = 38,
+	GUIDED_SHADOW_FILTERING_SHADER = 39,
+	INTEGER_SAT_HORIZONTAL_PASS_SHADER = 40,
+	INTEGER_SAT_VERTICAL_PASS_SHADER = 41,
+	JUMP_FLOODING_INITIALIZATION_SHADER = 42,
+	JUMP_FLOODING_SHADER = 43,
+	JUMP_FLOODING_EDT_SHADER = 44,
+	CASCADE_DEPTH_REDUCTION_SHADER = 45,
+	CASCADE_BOUNDS_REDUCTION_SHADER = 46
 };
 
 enum
@@ -119,16 +165,42 @@ enum
 	PARTIAL_BLOCKER_SEARCH_MAP_FRAMEBUFFER = 7,
 	QUAD_TREE_REPROJECTION_FRAMEBUFFER = 8,
 	VISIBILITY_FRAMEBUFFER = 9,
-	CUDA_FRAMEBUFFER = 10
+	CUDA_FRAMEBUFFER = 10,
+	HISTORY_FRAMEBUFFER = 11,
+	VISIBILITY_ACCUMULATION_FRAMEBUFFER = 12,
+	TILE_CLASSIFICATION_FRAMEBUFFER = 13,
+	FULL_GBUFFER_FRAMEBUFFER = 14,
+	UPSAMPLED_SOFT_SHADOW_FRAMEBUFFER = 15,
+	LIGHT_FRUSTUM_FRAMEBUFFER = 16,
+	GUIDED_FILTER_FRAMEBUFFER = 17,
+	TEMP_GUIDED_FILTER_FRAMEBUFFER = 18,
+	INTEGER_SAT_FRAMEBUFFER = 19,
+	TEMP_INTEGER_SAT_FRAMEBUFFER = 20,
+	JUMP_FLOODING_FRAMEBUFFER = 21,
+	TEMP_JUMP_FLOODING_FRAMEBUFFER = 22,
+	JUMP_FLOODING_EDT_FRAMEBUFFER = 23
+};
+
+//distance transforms the EDT techniques can use. JFA+1 and JFA+2 add error-correction passes to the jump flooding
+enum
+{
+	PBA_DISTANCE_TRANSFORM = 0,
+	JFA_DISTANCE_TRANSFORM = 1,
+	JFA_1_DISTANCE_TRANSFORM = 2,
+	JFA_2_DISTANCE_TRANSFORM = 3
 };
 
 bool temp = false;
 //Window size
 int windowWidth = 1280;
 int windowHeight = 720;
+int displayWidth = 1280;
+int displayHeight = 720;
 
 int shadowMapWidth = 512 * 2;
 int shadowMapHeight = 512 * 2;
+int fullShadowMapWidth = 512 * 2;
+int fullShadowMapHeight = 512 * 2;
 
 //  The number of frames
 int frameCount = 0;
@@ -139,17 +211,21 @@ char fileName[1000];
 MyGLTextureViewer myGLTextureViewer;
 MyGLGeometryViewer myGLGeometryViewer;
 ShadowParams shadowParams;
+ShadowMapCache shadowMapCache;
 
 Mesh *scene;
 SceneLoader *sceneLoader;
 LightSource *lightSource;
 UniformSampledLightSource *uniformSampledLightSource;
+UniformSampledLightSource *streamingLightSource;
+UniformSampledLightSource *tiledLightSource;
 QuadTreeLightSource *quadTreeLightSource;
 Filter *bilateralFilter;
+DistanceTransform *distanceTransform;
 
 GLuint textureArray[3];
-GLuint textures[30];
-GLuint frameBuffer[20];
+GLuint textures[48];
+GLuint frameBuffer[24];
 GLuint sceneVBO[5];
 GLuint sceneTextures[4];
 GLuint queryObject[1];
@@ -162,7 +238,7 @@ glm::mat4 lightMVP;
 GLuint ProgramObject = 0;
 GLuint VertexShaderObject = 0;
 GLuint FragmentShaderObject = 0;
-GLuint shaderVS, shaderFS, shaderProg[30];   // handles to objects
+GLuint shaderVS, shaderFS, shaderProg[47];   // handles to objects
 GLint  linked;
 
 float translationVector[3] = {0.0, 0.0, 0.0};
@@ -190,6 +266,82 @@ int quadTreeHash[17][17];
 int maxLevel = 4;
 int quadTreeShadowMapSamples = 0;
 int frameBufferIndices[4];
+bool compressTextures = false;
+bool packedGBuffer = false;
+int geometryVersion = 0;
+bool changeSamplesPerFrameOn = false;
+int samplesPerFrame = 16;
+int progressiveSampleOffset = 0;
+int progressiveSampleOrder[1024];
+int historyIndex = 0;
+int accumulatedFrames = 0;
+ShadowMapCache historyCache;
+glm::mat4 previousCameraMVP;
+bool changeStreamingBatchSizeOn = false;
+bool changeStreamingSamplesOn = false;
+bool streamingBenchmark = false;
+int streamingBatchSize = 16;
+int streamingNumberOfSamples = 1024;
+int lightSamplingPattern = REGULAR_GRID_SAMPLING;
+bool lightSamplingBenchmark = false;
+int *tileLevels = NULL;
+int *activeTiles = NULL;
+float *tileFlags = NULL;
+float *tileQuads = NULL;
+int numberOfTileQuads = 0;
+int tilesPerLevel[5];
+int tiledShadowMapSamples = 0;
+bool penumbraMaskActive = false;
+GLuint classifiedPixels = 0;
+GLuint filteredPixels = 0;
+ShaderPermutationCache shaderPermutationCache;
+bool useShaderPermutations = false;
+bool shaderPermutationBenchmark = false;
+float uberShaderFrameTime = 0.0;
+bool computePCSS = false;
+bool computePCSSValidation = false;
+int visibilityDownsampling = 1;
+bool visibilityDownsamplingBenchmark = false;
+bool fullResolutionPass = false;
+int fullWindowWidth = 1280, fullWindowHeight = 720;
+GLuint upsamplingEdgePixels = 0;
+bool fitLightFrustum = false;
+bool lightFrustumActive = false;
+bool lightFrustumBenchmark = false;
+float lightFrustumFov = 45.0;
+//Cascaded PCSS. The cascades are the quadrants of the shadow map, fitted to the receivers of the G-buffer
+bool cascadedSoftShadows = false;
+float cascadeSplitLambda = 0.5;
+int cascadeBorder = 16;
+glm::mat4 cascadeCrop[NUMBER_OF_CASCADES];
+bool guidedFilter = false;
+bool edgeAwareFilterBenchmark = false;
+float guidedFilterEpsilon = 0.00001;
+bool momentStorageBenchmark = false;
+bool integerSATBenchmark = false;
+bool RBSSMComparison = false;
+bool boundedEDT = false;
+int boundedEDTRadius = 32;
+bool boundedEDTBenchmark = false;
+int distanceTransformMethod[2] = {PBA_DISTANCE_TRANSFORM, PBA_DISTANCE_TRANSFORM}; //EDTSSM and SSEDTSSM
+const char *distanceTransformMethodNames[4] = {"PBA", "JFA", "JFA+1", "JFA+2"};
+int jumpFloodingSeeds = JUMP_FLOODING_MAP_COLOR;
+bool distanceTransformBenchmark = false;
+float sceneBounds[6];
+int sceneBoundsVersion = -1;
+int allocatedShadowMapLayers = 0;
+RenderTargetPool renderTargetPool;
+bool renderTargetsDirty = true;
+int allocatedRenderTargetUsage = -1;
+int allocatedWindowWidth = 0, allocatedWindowHeight = 0;
+int allocatedShadowMapWidth = 0, allocatedShadowMapHeight = 0;
+GLuint CUDATextures[2] = {0, 0};
+bool dynamicResolution = false;
+float resolutionScale = 1.0;
+float frameTimeBudget = 33.3f;
+float accumulatedFrameTime = 0.0;
+int accumulatedFrameCount = 0;
+int lastFrameTime = 0;
 
 cudaGraphicsResource_t CUDAGraphicsResource[2];
 
@@ -202,6 +354,24 @@ double cpu_time(void)
 
 }
 
+float computeConvergence()
+{
+
+	//the top level of the history mip chain holds the screen average of the accumulated sample counts
+	int size = (windowWidth > windowHeight) ? windowWidth : windowHeight;
+	int topLevel = 0;
+	while((size >> (topLevel + 1)) > 0) topLevel++;
+
+	float average[4];
+	glBindTexture(GL_TEXTURE_2D, textures[HISTORY_MAP_COLOR + historyIndex]);
+	glGenerateMipmap(GL_TEXTURE_2D);
+	glGetTexImage(GL_TEXTURE_2D, topLevel, GL_RGBA, GL_FLOAT, average);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	return average[1] / uniformSampledLightSource->getNumberOfPointLights();
+
+}
+
 void calculateFPS()
 {
 
@@ -217,6 +387,63 @@ void calculateFPS()
         frameCount = 0;
 	
 		printf("FPS: %f\n", fps);
+		if(shadowMapCache.isEnabled()) {
+			printf("Shadow map cache: %d hits, %d misses\n", shadowMapCache.getHits(), shadowMapCache.getMisses());
+			shadowMapCache.resetCounters();
+		}
+		if(shadowParams.adaptiveSampling)
+			printf("Adaptive sampling: %d shadow maps, %d samples per pixel\n", quadTreeShadowMapSamples, quadTreeShadowMapSamples);
+		if(shadowParams.tiledAdaptiveSampling) {
+			int numberOfTiles = (windowWidth / 16) * (windowHeight / 16);
+			float samplesPerPixel = 0.0;
+			for(int level = 0; level <= maxLevel; level++)
+				samplesPerPixel += tilesPerLevel[level] * powf(powf(2, level) + 1, 2) / numberOfTiles;
+			printf("Tiled adaptive sampling: %d shadow maps, %f samples per pixel, tiles per level %d %d %d %d %d\n", tiledShadowMapSamples, samplesPerPixel, 
+				tilesPerLevel[0], tilesPerLevel[1], tilesPerLevel[2], tilesPerLevel[3], tilesPerLevel[4]);
+		}
+		if(fitLightFrustum && shadowParams.lightFrustumScale != 1.0)
+			printf("Fitted light frustum: %f degrees, %f times the default texel density\n", lightFrustumFov, 
+				shadowParams.lightFrustumScale * shadowParams.lightFrustumScale);
+		if(visibilityDownsampling > 1)
+			printf("Visibility at 1/%d resolution: %f%% of the pixels re-evaluated at full resolution\n", visibilityDownsampling, 
+				100.0f * upsamplingEdgePixels / (fullWindowWidth * fullWindowHeight));
+		if(shadowParams.penumbraClassification && classifiedPixels + filteredPixels > 0)
+			printf("Penumbra classification: %f%% of the pixels skipped the filtering\n", 
+				100.0f * classifiedPixels / (classifiedPixels + filteredPixels));
+		//the benchmark measures one interval with the uber-shaders and the next one with the permutations
+		if(shaderPermutationBenchmark) {
+			if(!useShaderPermutations) {
+				uberShaderFrameTime = 1000.0f / fps;
+				useShaderPermutations = true;
+			} else {
+				printf("Shader permutations: %f ms with the uber-shaders, %f ms with the permutations, %fx speedup\n", uberShaderFrameTime, 
+					1000.0f / fps, uberShaderFrameTime * fps / 1000.0f);
+				ShaderPermutationCache::printProgram("Shaders/SoftShadow/PlausibleSoftShadow", "", shaderProg[PLAUSIBLE_SOFT_SHADOW_SHADER]);
+				ShaderPermutationCache::printProgram("Shaders/ScreenSpace/ScreenSpaceSoftShadow", "", shaderProg[SCREEN_SPACE_SOFT_SHADOW_SHADER]);
+				ShaderPermutationCache::printProgram("Shaders/SoftShadow/AccurateSoftShadow", "", shaderProg[ACCURATE_SOFT_SHADOW_SHADER]);
+				shaderPermutationCache.printStatistics();
+				shaderPermutationBenchmark = false;
+			}
+		}
+		if(shadowParams.progressiveMonteCarlo)
+			printf("Progressive Monte-Carlo: %d samples per frame, %d frames accumulated, %f%% converged\n", samplesPerFrame, accumulatedFrames, 
+				computeConvergence() * 100.0f);
+		if(shadowParams.streamingMonteCarlo) {
+			float ringSize = (float)shadowMapWidth * shadowMapHeight * 4 * streamingBatchSize / 1048576.0f;
+			float accumulationSize = (float)windowWidth * windowHeight * ((streamingBatchSize * 8 >= streamingNumberOfSamples) ? 2 : 4) / 1048576.0f;
+			printf("Streaming Monte-Carlo: %d samples in batches of %d, %.1f MB layer ring + %.1f MB accumulation (%.1f MB with all layers resident), %f ms\n", 
+				streamingNumberOfSamples, streamingBatchSize, ringSize, accumulationSize, 
+				(float)shadowMapWidth * shadowMapHeight * 4 * streamingNumberOfSamples / 1048576.0f, 1000.0f / fps);
+			//the benchmark reports a full interval for every batch size before it moves on to the next one
+			if(streamingBenchmark) {
+				if(streamingBatchSize < 64) {
+					streamingBatchSize *= 2;
+					renderTargetsDirty = true;
+				} else {
+					streamingBenchmark = false;
+				}
+			}
+		}
 	}
 
 }
@@ -224,8 +451,10 @@ void calculateFPS()
 void reshape(int w, int h)
 {
 	
-	windowWidth = w;
-	windowHeight = h;
+	//the internal targets follow the window on the next frame, scaled by the dynamic resolution
+	displayWidth = w;
+	displayHeight = h;
+	renderTargetsDirty = true;
 
 }
 
@@ -262,19 +491,71 @@ void updateLight()
 		sceneLoader->getLightPosition()[2] + lightTranslationVector[2]));
 	quadTreeLightSource->setEye(glm::vec3(sceneLoader->getLightPosition()[0] + lightTranslationVector[0], sceneLoader->getLightPosition()[1] + lightTranslationVector[1], 
 		sceneLoader->getLightPosition()[2] + lightTranslationVector[2]));
+	streamingLightSource->setEye(glm::vec3(sceneLoader->getLightPosition()[0] + lightTranslationVector[0], sceneLoader->getLightPosition()[1] + lightTranslationVector[1], 
+		sceneLoader->getLightPosition()[2] + lightTranslationVector[2]));
 
 	if(animationOn) {
 		lightSource->setEye(glm::mat3(glm::rotate((float)animation/10, glm::vec3(0, 1, 0))) * lightSource->getEye());
 		uniformSampledLightSource->setEye(glm::mat3(glm::rotate((float)animation/10, glm::vec3(0, 1, 0))) * ((LightSource*)uniformSampledLightSource)->getEye());
 		quadTreeLightSource->setEye(glm::mat3(glm::rotate((float)animation/10, glm::vec3(0, 1, 0))) * ((LightSource*)quadTreeLightSource)->getEye());
+		streamingLightSource->setEye(glm::mat3(glm::rotate((float)animation/10, glm::vec3(0, 1, 0))) * ((LightSource*)streamingLightSource)->getEye());
 	}
 
 }
 
-void displaySceneFromLightPOV()
+void buildShadowMapKey(ShadowMapCache *cache, int renderPath)
 {
 
-	glViewport(0, 0, shadowMapWidth, shadowMapHeight);
+	//the light-space maps only depend on the light pose, the scene transformation and the light-side technique parameters
+	updateLight();
+	cache->beginKey(lightSource->getEye(), lightSource->getAt(), lightSource->getUp(), geometryVersion);
+	cache->addParameter(renderPath);
+	cache->addParameter(shadowParams.monteCarlo);
+	cache->addParameter(shadowParams.SAVSM);
+	cache->addParameter(shadowParams.VSSM);
+	cache->addParameter(shadowParams.ESSM);
+	cache->addParameter(shadowParams.MSSM);
+	cache->addParameter(shadowParams.SAT);
+	cache->addParameter(shadowParams.useHierarchicalShadowMap);
+	cache->addParameter(shadowParams.penumbraClassification);
+	cache->addParameter(shadowParams.HSMAlpha);
+	cache->addParameter(shadowParams.HSMBeta);
+	cache->addParameter(lightSource->getSize());
+	cache->addParameter(uniformSampledLightSource->getNumberOfPointLights());
+	cache->addParameter(uniformSampledLightSource->getSamplingPattern());
+	cache->addParameter(shadowMapWidth);
+	cache->addParameter(shadowMapHeight);
+	cache->addParameter((lightFrustumActive) ? lightFrustumFov : 0.0f);
+	cache->addParameter(shadowParams.cascadedShadowMaps);
+	if(shadowParams.cascadedShadowMaps) {
+		for(int cascade = 0; cascade < NUMBER_OF_CASCADES; cascade++) {
+			cache->addParameter(cascadeCrop[cascade][0][0]);
+			cache->addParameter(cascadeCrop[cascade][3][0]);
+			cache->addParameter(cascadeCrop[cascade][3][1]);
+		}
+	}
+	for(int axis = 0; axis < 3; axis++) {
+		cache->addParameter(translationVector[axis]);
+		cache->addParameter(rotationAngles[axis]);
+	}
+
+}
+
+bool isShadowMapCached(int renderPath)
+{
+
+	buildShadowMapKey(&shadowMapCache, renderPath);
+	return shadowMapCache.lookup();
+
+}
+
+void displaySceneFromLightPOV(int cascade = -1)
+{
+
+	if(cascade < 0)
+		glViewport(0, 0, shadowMapWidth, shadowMapHeight);
+	else
+		glViewport((cascade % 2) * shadowMapWidth/2, (cascade / 2) * shadowMapHeight/2, shadowMapWidth/2, shadowMapHeight/2);
 	
 	if(!shadowParams.monteCarlo && !shadowParams.adaptiveSampling) updateLight();
 
@@ -298,7 +579,11 @@ void displaySceneFromLightPOV()
 	myGLGeometryViewer.setEye(lightSource->getEye());
 	myGLGeometryViewer.setLook(lightSource->getAt());
 	myGLGeometryViewer.setUp(lightSource->getUp());
+	//the fitted frustum only narrows the light projection, the camera keeps its field of view
+	float cameraFov = myGLGeometryViewer.getFov();
+	if(lightFrustumActive) myGLGeometryViewer.setFov(lightFrustumFov);
 	myGLGeometryViewer.configureAmbient(shadowMapWidth, shadowMapHeight);
+	myGLGeometryViewer.setFov(cameraFov);
 	myGLGeometryViewer.setIsCameraViewpoint(false);
 
 	glm::mat4 projection = myGLGeometryViewer.getProjectionMatrix();
@@ -311,6 +596,8 @@ void displaySceneFromLightPOV()
 	model *= glm::rotate(rotationAngles[2], glm::vec3(0, 0, 1));
 
 	lightMVP = projection * view * model;
+	if(cascade >= 0)
+		myGLGeometryViewer.setProjectionMatrix(cascadeCrop[cascade] * projection);
 	
 	displayScene();
 	glUseProgram(0);
@@ -320,7 +607,11 @@ void displaySceneFromLightPOV()
 void displaySceneFromCameraPOV(GLuint shader)
 {
 
-	glViewport(0, 0, windowWidth, windowHeight);
+	//the full resolution G-buffer keeps the projection of the reduced one, so both see the same scene
+	if(fullResolutionPass)
+		glViewport(0, 0, fullWindowWidth, fullWindowHeight);
+	else
+		glViewport(0, 0, windowWidth, windowHeight);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 	
 	updateLight();
@@ -334,10 +625,11 @@ void displaySceneFromCameraPOV(GLuint shader)
 			shadowParams.SATShadowMap = textures[SAT_SHADOW_MAP_COLOR];
 		else
 			shadowParams.SATShadowMap = textures[SHADOW_MAP_COLOR];
+		shadowParams.integerSATShadowMap = textures[INTEGER_SAT_SHADOW_MAP_COLOR];
 	} else {
 		shadowParams.softShadowMap = textures[SOFT_SHADOW_MAP_COLOR];
 	}
-	if(shadowParams.useHierarchicalShadowMap) 
+	if(shadowParams.useHierarchicalShadowMap || shadowParams.penumbraClassification) 
 		shadowParams.hierarchicalShadowMap = textures[HIERARCHICAL_SHADOW_MAP_COLOR];
 
 	shadowParams.lightMVP = lightMVP;
@@ -355,12 +647,22 @@ void displaySceneFromCameraPOV(GLuint shader)
 
 }
 
-void displaySceneFromGBuffer(GLuint shader)
+void displaySceneFromGBuffer(GLuint shader, bool dispatchCompute = false)
 {
 
-	glViewport(0, 0, windowWidth, windowHeight);
+	//the final shading goes to the window, the other passes stay at the internal resolution
+	if(shadowParams.useSoftShadowMap)
+		glViewport(0, 0, displayWidth, displayHeight);
+	else if(fullResolutionPass)
+		glViewport(0, 0, fullWindowWidth, fullWindowHeight);
+	else
+		glViewport(0, 0, windowWidth, windowHeight);
 	
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	//each batch of the streaming path adds its visibility to what the previous batches left in the target, 
+	//each tile level of the tiled path fills its own tiles of it and the filtering pass keeps the classified pixels
+	if((!(shadowParams.streamingMonteCarlo || shadowParams.tiledAdaptiveSampling || penumbraMaskActive) || shadowParams.useSoftShadowMap) && 
+		!dispatchCompute)
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 	
 	if(!shadowParams.adaptiveSampling || (shadowParams.adaptiveSampling && adaptiveSamplingFinalRendering)) {
 		updateLight();
@@ -372,20 +674,28 @@ void displaySceneFromGBuffer(GLuint shader)
 	myGLTextureViewer.setShaderProg(shader);
 
 	shadowParams.shadowMap = textures[SHADOW_MAP_DEPTH];
-	shadowParams.softShadowMap = textures[SOFT_SHADOW_MAP_COLOR];
-	shadowParams.vertexMap = textures[VERTEX_MAP_COLOR];
-	shadowParams.normalMap = textures[NORMAL_MAP_COLOR];
-	shadowParams.colorMap = textures[TEXTURE_MAP_COLOR];
+	if(fullResolutionPass) {
+		shadowParams.softShadowMap = textures[UPSAMPLED_SOFT_SHADOW_MAP_COLOR];
+		shadowParams.vertexMap = (packedGBuffer) ? textures[FULL_GBUFFER_MAP_DEPTH] : textures[FULL_VERTEX_MAP_COLOR];
+		shadowParams.normalMap = textures[FULL_NORMAL_MAP_COLOR];
+		shadowParams.colorMap = textures[FULL_TEXTURE_MAP_COLOR];
+	} else {
+		shadowParams.softShadowMap = (shadowParams.streamingMonteCarlo) ? textures[VISIBILITY_ACCUMULATION_MAP_COLOR] : textures[SOFT_SHADOW_MAP_COLOR];
+		shadowParams.vertexMap = (packedGBuffer) ? textures[GBUFFER_MAP_DEPTH] : textures[VERTEX_MAP_COLOR];
+		shadowParams.normalMap = textures[NORMAL_MAP_COLOR];
+		shadowParams.colorMap = textures[TEXTURE_MAP_COLOR];
+	}
 	shadowParams.lightMVP = lightMVP;
 	if(shadowParams.useHardShadowMap)
 		shadowParams.hardShadowMap = textures[HARD_SHADOW_MAP_COLOR];
 	if(shadowParams.usePartialAverageBlockerDepthMap)
 		shadowParams.hardShadowMap = textures[PARTIAL_BLOCKER_SEARCH_MAP_COLOR];
-	if(shadowParams.useHierarchicalShadowMap) 
+	if(shadowParams.useHierarchicalShadowMap || shadowParams.penumbraClassification) 
 		shadowParams.hierarchicalShadowMap = textures[HIERARCHICAL_SHADOW_MAP_COLOR];
 	if(shadowParams.SAVSM || shadowParams.VSSM || shadowParams.ESSM || shadowParams.MSSM)  {
 		if(shadowParams.SAT) shadowParams.SATShadowMap = textures[SAT_SHADOW_MAP_COLOR];
 		else shadowParams.SATShadowMap = textures[SHADOW_MAP_COLOR];
+		shadowParams.integerSATShadowMap = textures[INTEGER_SAT_SHADOW_MAP_COLOR];
 	}
 	if(shadowParams.SSPCSS || shadowParams.SSABSS || shadowParams.SSSM || shadowParams.SSRBSSM) 
 		myGLTextureViewer.configureSeparableFilter(bilateralFilter->getOrder(), bilateralFilter->getKernel(), false, false, bilateralFilter->getSigmaSpace(), 
@@ -417,7 +727,17 @@ void displaySceneFromGBuffer(GLuint shader)
 	myGLGeometryViewer.setModelMatrix(model);
 	myGLGeometryViewer.configurePhong(lightSource->getEye(), cameraEye);
 
-	myGLTextureViewer.drawTextureQuad();
+	//compute passes write every pixel of the soft shadow map in 16x16 work groups
+	if(dispatchCompute) {
+		glBindImageTexture(0, textures[SOFT_SHADOW_MAP_COLOR], 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
+		glUniform1i(glGetUniformLocation(shader, "softShadowImage"), 0);
+		glDispatchCompute((windowWidth + 15) / 16, (windowHeight + 15) / 16, 1);
+		glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT);
+	} else if(tileQuads != NULL) {
+		myGLTextureViewer.drawTextureQuads(tileQuads, numberOfTileQuads);
+	} else {
+		myGLTextureViewer.drawTextureQuad();
+	}
 	
 	glUseProgram(0);
 
@@ -753,6 +1073,59 @@ void renderHSM()
 
 }
 
+void renderGBuffer()
+{
+
+	glClearColor(0.0f, 0.0f, 0.0f, 1.0);
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[GBUFFER_FRAMEBUFFER]);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	displaySceneFromCameraPOV(shaderProg[GBUFFER_SHADER]);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	//the packed layout reconstructs positions with the same transform the G-buffer was rasterized with
+	shadowParams.inverseGBufferMVP = glm::inverse(myGLGeometryViewer.getProjectionMatrix() * myGLGeometryViewer.getViewMatrix() * 
+		myGLGeometryViewer.getModelMatrix());
+
+}
+
+//Returns the program of a soft shadow shader specialized for the current technique and kernel sizes,
+//compiled on first use. The uber-shader in shaderProg is used when permutations are off or fail to build
+GLuint getSoftShadowProgram(int shader)
+{
+
+	char defines[512];
+	char *shaderName;
+	GLuint program = 0;
+
+	if(!useShaderPermutations)
+		return shaderProg[shader];
+
+	if(shader == PLAUSIBLE_SOFT_SHADOW_SHADER) {
+		shaderName = "Shaders/SoftShadow/PlausibleSoftShadow";
+		sprintf(defines, "#define SOFT_SHADOW_PERMUTATION\n#define PERMUTATION_BLOCKER_SEARCH_SIZE %d\n#define PERMUTATION_KERNEL_SIZE %d\n"
+			"#define PERMUTATION_PCSS %d\n#define PERMUTATION_SAVSM %d\n#define PERMUTATION_VSSM %d\n#define PERMUTATION_ESSM %d\n"
+			"#define PERMUTATION_MSSM %d\n#define PERMUTATION_SAT %d\n", shadowParams.blockerSearchSize, shadowParams.kernelSize, 
+			shadowParams.PCSS, shadowParams.SAVSM, shadowParams.VSSM, shadowParams.ESSM, shadowParams.MSSM, shadowParams.SAT);
+	} else if(shader == SCREEN_SPACE_SOFT_SHADOW_SHADER) {
+		//configureShadow uploads the blocker search size minus one for the screen-space techniques
+		shaderName = "Shaders/ScreenSpace/ScreenSpaceSoftShadow";
+		sprintf(defines, "#define SOFT_SHADOW_PERMUTATION\n#define PERMUTATION_BLOCKER_SEARCH_SIZE %d\n#define PERMUTATION_KERNEL_SIZE %d\n"
+			"#define PERMUTATION_SSPCSS %d\n#define PERMUTATION_SSABSS %d\n#define PERMUTATION_SSSM %d\n#define PERMUTATION_SSRBSSM %d\n", 
+			shadowParams.blockerSearchSize - 1, shadowParams.kernelSize, shadowParams.SSPCSS, shadowParams.SSABSS, shadowParams.SSSM, 
+			shadowParams.SSRBSSM);
+	} else if(shader == ACCURATE_SOFT_SHADOW_SHADER) {
+		shaderName = "Shaders/SoftShadow/AccurateSoftShadow";
+		sprintf(defines, "#define SOFT_SHADOW_PERMUTATION\n#define PERMUTATION_ADAPTIVE_SAMPLING %d\n#define PERMUTATION_LOWER_ACCURACY %d\n", 
+			shadowParams.adaptiveSampling, shadowParams.adaptiveSamplingLowerAccuracy);
+	} else {
+		return shaderProg[shader];
+	}
+
+	program = shaderPermutationCache.getProgram(shaderName, defines);
+	return (program) ? program : shaderProg[shader];
+
+}
+
 void renderMonteCarlo()
 {
 
@@ -769,26 +1142,92 @@ void renderMonteCarlo()
 	lightSource->setEye(((LightSource*)uniformSampledLightSource)->getEye());
 	lightSource->setAt(((LightSource*)uniformSampledLightSource)->getAt());
 
-	int pointLightSample = 0;
+	//the shadow map array and the light matrices survive between frames while the light and the scene do not move
+	if(!isShadowMapCached(0)) {
+
+		int pointLightSample = 0;
 	
-	while(pointLightSample < uniformSampledLightSource->getNumberOfPointLights()) {
+		while(pointLightSample < uniformSampledLightSource->getNumberOfPointLights()) {
 
-		lightSource->setEye(uniformSampledLightSource->getEye(pointLightSample));
-		lightSource->setAt(uniformSampledLightSource->getAt(pointLightSample));
+			lightSource->setEye(uniformSampledLightSource->getEye(pointLightSample));
+			lightSource->setAt(uniformSampledLightSource->getAt(pointLightSample));
 	
+			glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[TEMP_SHADOW_FRAMEBUFFER]);
+			glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, textureArray[0], 0, pointLightSample);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[TEMP_SHADOW_MAP_COLOR], 0);
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+			glClearColor(1.0f, 1.0f, 1.0f, 1.0);
+			glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[TEMP_SHADOW_FRAMEBUFFER]);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			displaySceneFromLightPOV();
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		
+			shadowParams.lightMVPs[pointLightSample] = lightMVP;
+			pointLightSample++;
+
+		}
+
 		glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[TEMP_SHADOW_FRAMEBUFFER]);
-		glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, textureArray[0], 0, pointLightSample);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, textures[TEMP_SHADOW_MAP_DEPTH], 0);
 		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[TEMP_SHADOW_MAP_COLOR], 0);
 		glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-		glClearColor(1.0f, 1.0f, 1.0f, 1.0);
+	}
+
+	lightSource->setEye(((LightSource*)uniformSampledLightSource)->getEye());
+	lightSource->setAt(((LightSource*)uniformSampledLightSource)->getAt());
+
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[SOFT_SHADOW_FRAMEBUFFER]);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	glClearColor(0.0f, 0.0f, 0.0f, 1.0);
+	displaySceneFromGBuffer(getSoftShadowProgram(ACCURATE_SOFT_SHADOW_SHADER));
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	
+	glFinish();
+	
+}
+
+void renderProgressiveMonteCarlo()
+{
+
+	int numberOfPointLights = uniformSampledLightSource->getNumberOfPointLights();
+	int numberOfSamples = (samplesPerFrame < numberOfPointLights) ? samplesPerFrame : numberOfPointLights;
+
+	//the accumulated visibility is only valid while the light, the scene and the shadow intensity stay the same
+	buildShadowMapKey(&historyCache, 3);
+	historyCache.addParameter(shadowParams.shadowIntensity);
+	shadowParams.resetHistory = !historyCache.lookup();
+	if(shadowParams.resetHistory) {
+		progressiveSampleOffset = 0;
+		accumulatedFrames = 0;
+	}
+
+	//the subset of samples is rendered into the layers used by the Monte-Carlo path
+	shadowMapCache.invalidate();
+
+	renderGBuffer();
+
+	shadowParams.cameraMVP = myGLGeometryViewer.getProjectionMatrix() * myGLGeometryViewer.getViewMatrix() * myGLGeometryViewer.getModelMatrix();
+	shadowParams.previousCameraMVP = (shadowParams.resetHistory) ? shadowParams.cameraMVP : previousCameraMVP;
+
+	updateLight();
+
+	for(int sample = 0; sample < numberOfSamples; sample++) {
+
+		int pointLightSample = progressiveSampleOrder[(progressiveSampleOffset + sample) % numberOfPointLights];
+		lightSource->setEye(uniformSampledLightSource->getEye(pointLightSample));
+		lightSource->setAt(uniformSampledLightSource->getAt(pointLightSample));
+
 		glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[TEMP_SHADOW_FRAMEBUFFER]);
+		glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, textureArray[0], 0, sample);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[TEMP_SHADOW_MAP_COLOR], 0);
+		glClearColor(1.0f, 1.0f, 1.0f, 1.0);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 		displaySceneFromLightPOV();
 		glBindFramebuffer(GL_FRAMEBUFFER, 0);
-		
-		shadowParams.lightMVPs[pointLightSample] = lightMVP;
-		pointLightSample++;
+
+		shadowParams.lightMVPs[sample] = lightMVP;
 
 	}
 
@@ -797,17 +1236,109 @@ void renderMonteCarlo()
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[TEMP_SHADOW_MAP_COLOR], 0);
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
+	progressiveSampleOffset = (progressiveSampleOffset + numberOfSamples) % numberOfPointLights;
+
 	lightSource->setEye(((LightSource*)uniformSampledLightSource)->getEye());
 	lightSource->setAt(((LightSource*)uniformSampledLightSource)->getAt());
 
-	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[SOFT_SHADOW_FRAMEBUFFER]);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	//the new history and the soft shadow map are written together, reading the history of the previous frame
+	shadowParams.numberOfSamples = numberOfSamples;
+	shadowParams.totalNumberOfSamples = numberOfPointLights;
+	shadowParams.historyMap = textures[HISTORY_MAP_COLOR + historyIndex];
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[HISTORY_FRAMEBUFFER]);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[HISTORY_MAP_COLOR + 1 - historyIndex], 0);
 	glClearColor(0.0f, 0.0f, 0.0f, 1.0);
-	displaySceneFromGBuffer(shaderProg[ACCURATE_SOFT_SHADOW_SHADER]);
+	displaySceneFromGBuffer(shaderProg[PROGRESSIVE_SOFT_SHADOW_SHADER]);
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-	
-	glFinish();
-	
+
+	historyIndex = 1 - historyIndex;
+	previousCameraMVP = shadowParams.cameraMVP;
+	accumulatedFrames++;
+
+}
+
+void renderStreamingMonteCarlo()
+{
+
+	int numberOfPointLights = streamingLightSource->getNumberOfPointLights();
+
+	//the batches reuse the layers of the Monte-Carlo path
+	shadowMapCache.invalidate();
+
+	renderGBuffer();
+
+	glClearColor(0.0f, 0.0f, 0.0f, 1.0);
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[VISIBILITY_ACCUMULATION_FRAMEBUFFER]);
+	glClear(GL_COLOR_BUFFER_BIT);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	shadowParams.totalNumberOfSamples = numberOfPointLights;
+
+	for(int firstSample = 0; firstSample < numberOfPointLights; firstSample += streamingBatchSize) {
+
+		int numberOfSamples = (numberOfPointLights - firstSample < streamingBatchSize) ? numberOfPointLights - firstSample : streamingBatchSize;
+
+		updateLight();
+
+		for(int sample = 0; sample < numberOfSamples; sample++) {
+
+			lightSource->setEye(streamingLightSource->getEye(firstSample + sample));
+			lightSource->setAt(streamingLightSource->getAt(firstSample + sample));
+
+			glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[TEMP_SHADOW_FRAMEBUFFER]);
+			glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, textureArray[0], 0, sample);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[TEMP_SHADOW_MAP_COLOR], 0);
+			glClearColor(1.0f, 1.0f, 1.0f, 1.0);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			displaySceneFromLightPOV();
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+			shadowParams.lightMVPs[sample] = lightMVP;
+
+		}
+
+		glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[TEMP_SHADOW_FRAMEBUFFER]);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, textures[TEMP_SHADOW_MAP_DEPTH], 0);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[TEMP_SHADOW_MAP_COLOR], 0);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		lightSource->setEye(((LightSource*)streamingLightSource)->getEye());
+		lightSource->setAt(((LightSource*)streamingLightSource)->getAt());
+
+		//the visibility of the batch is added to the accumulation buffer before its layers are overwritten by the next one
+		shadowParams.numberOfSamples = numberOfSamples;
+		glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[VISIBILITY_ACCUMULATION_FRAMEBUFFER]);
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_ONE, GL_ONE);
+		displaySceneFromGBuffer(shaderProg[STREAMING_SOFT_SHADOW_SHADER]);
+		glDisable(GL_BLEND);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	}
+
+}
+
+void changeStreamingSamples(int numberOfSamples)
+{
+
+	//the sample set is rebuilt around the unsampled area light, whatever sample the light source was last moved to
+	streamingNumberOfSamples = numberOfSamples;
+	delete streamingLightSource;
+	streamingLightSource = new UniformSampledLightSource(uniformSampledLightSource, streamingNumberOfSamples, lightSamplingPattern);
+	renderTargetsDirty = true;
+
+}
+
+void changeLightSampling(int samplingPattern)
+{
+
+	//the shadow map cache and the progressive history key on the pattern, so they are rebuilt on the next frame
+	lightSamplingPattern = samplingPattern;
+	UniformSampledLightSource *previousLightSource = uniformSampledLightSource;
+	uniformSampledLightSource = new UniformSampledLightSource(previousLightSource, previousLightSource->getNumberOfPointLights(), lightSamplingPattern);
+	delete previousLightSource;
+	changeStreamingSamples(streamingNumberOfSamples);
+
 }
 
 void renderAdaptiveLightSourceSampling()
@@ -821,6 +1352,8 @@ void renderAdaptiveLightSourceSampling()
 	myGLTextureViewer.drawTextureOnShader(textures[SHADOW_MAP_COLOR], windowWidth, windowHeight);
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 	
+	//the quadtree reuses the layers of the shadow map array, so the cached Monte-Carlo maps are lost
+	shadowMapCache.invalidate();
 	updateLight();
 	if(!(shadowParams.revectorizationBasedAdaptiveSampling && temporalCoherency && !firstFrame)) {
 		quadTreeLightSource->buildFirstLevel();
@@ -832,11 +1365,7 @@ void renderAdaptiveLightSourceSampling()
 	lightSource->setEye(((LightSource*)quadTreeLightSource)->getEye());
 	lightSource->setAt(((LightSource*)quadTreeLightSource)->getAt());
 	
-	glClearColor(0.0f, 0.0f, 0.0f, 1.0);
-	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[GBUFFER_FRAMEBUFFER]);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	displaySceneFromCameraPOV(shaderProg[GBUFFER_SHADER]);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	renderGBuffer();
 	
 	for(int x = 0; x < 17; x++) for(int y = 0; y < 17; y++) { quadTreeShadowMapIndices[x][y] = false; quadTreeHash[x][y] = -1; }
 	
@@ -870,7 +1399,7 @@ void renderAdaptiveLightSourceSampling()
 		displaySceneFromGBuffer(shaderProg[REVECTORIZATION_BASED_ACCURATE_SOFT_SHADOW_SHADER]);
 		shadowParams.revectorizationBasedQuadTreeEvaluation = false;
 	} else {
-		displaySceneFromGBuffer(shaderProg[ACCURATE_SOFT_SHADOW_SHADER]);
+		displaySceneFromGBuffer(getSoftShadowProgram(ACCURATE_SOFT_SHADOW_SHADER));
 	}
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 	adaptiveSamplingFinalRendering = false;
@@ -891,243 +1420,2264 @@ void renderAdaptiveLightSourceSampling()
 	
 }
 
-void computeEDT() 
+void buildTileQuads(float *quads, int *tiles, int numberOfTiles)
 {
 
-	pbaCudaBindTexture(CUDAGraphicsResource);
-	pba2DVoronoiDiagram(16, 16, 16, shadowParams.shadowIntensity);
-	pbaCudaUnbindTexture(CUDAGraphicsResource);
-	
-	myGLTextureViewer.setShaderProg(shaderProg[MEAN_FILTER_SHADER]);
-	myGLGeometryViewer.setShaderProg(shaderProg[MEAN_FILTER_SHADER]);
-	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[HARD_SHADOW_FRAMEBUFFER]);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	glViewport(0, 0, windowWidth, windowHeight);
-	myGLTextureViewer.configureSeparableFilter(shadowParams.kernelSize, true, false, shadowParams.shadowIntensity);
-	myGLGeometryViewer.configurePhong(lightSource->getEye(), cameraEye);
-	myGLGeometryViewer.configureGBuffer(shadowParams);
-	myGLGeometryViewer.configureLinearization();
-	myGLTextureViewer.drawTextureOnShader(textures[CUDA_MAP_COLOR], windowWidth, windowHeight);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-		
-	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[SOFT_SHADOW_FRAMEBUFFER]);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	glViewport(0, 0, windowWidth, windowHeight);
-	myGLTextureViewer.configureSeparableFilter(shadowParams.kernelSize, false, true, shadowParams.shadowIntensity);
-	myGLGeometryViewer.configurePhong(lightSource->getEye(), cameraEye);
-	myGLGeometryViewer.configureGBuffer(shadowParams);
-	myGLGeometryViewer.configureLinearization();
-	myGLTextureViewer.drawTextureOnShader(textures[HARD_SHADOW_MAP_COLOR], windowWidth, windowHeight);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	int tilesPerRow = windowWidth / 16;
+	float tileWidth = 32.0 / windowWidth;
+	float tileHeight = 32.0 / windowHeight;
+
+	for(int tile = 0; tile < numberOfTiles; tile++, quads += 12) {
+		float x0 = (tiles[tile] % tilesPerRow) * tileWidth - 1.0;
+		float y0 = (tiles[tile] / tilesPerRow) * tileHeight - 1.0;
+		float x1 = x0 + tileWidth;
+		float y1 = y0 + tileHeight;
+		quads[0] = x1; quads[1] = y1; quads[2] = x1; quads[3] = y0; quads[4] = x0; quads[5] = y0;
+		quads[6] = x0; quads[7] = y1; quads[8] = x1; quads[9] = y1; quads[10] = x0; quads[11] = y0;
+	}
 
 }
 
-void renderSoftShadows() 
+void renderTiledLightSamples(int level, bool *renderedSamples)
 {
 
-	glClearColor(0.0f, 0.0f, 0.0f, 1.0);
-	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[GBUFFER_FRAMEBUFFER]);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	displaySceneFromCameraPOV(shaderProg[GBUFFER_SHADER]);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-	
-	glClearColor(0.0f, 0.0f, 0.0f, 0.0);
-	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[SHADOW_FRAMEBUFFER]);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	displaySceneFromLightPOV();
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-	
-	glBindTexture(GL_TEXTURE_2D, textures[SHADOW_MAP_COLOR]);
-	glGenerateMipmap(GL_TEXTURE_2D);
+	int sampleStride = 16/powf(2, level);
 
-	if(shadowParams.SAT) {
-	
-		int m = std::logf(shadowMapWidth)/std::logf(2);
-		for(int iteration = 0; iteration < m; iteration++) {
+	for(int y = 0; y <= 16; y += sampleStride) {
+		for(int x = 0; x <= 16; x += sampleStride) {
+
+			//the samples of a level include the ones of the coarser levels
+			int sample = y * 17 + x;
+			if(renderedSamples[sample]) continue;
+			renderedSamples[sample] = true;
+
+			lightSource->setEye(tiledLightSource->getEye(sample));
+			lightSource->setAt(tiledLightSource->getAt(sample));
 
 			glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[TEMP_SHADOW_FRAMEBUFFER]);
+			glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, textureArray[0], 0, sample);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[TEMP_SHADOW_MAP_COLOR], 0);
+			glClearColor(1.0f, 1.0f, 1.0f, 1.0);
 			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-			glViewport(0, 0, shadowMapWidth, shadowMapHeight);
-			myGLTextureViewer.setShaderProg(shaderProg[SAT_HORIZONTAL_PASS_SHADER]);
-			glUseProgram(shaderProg[SAT_HORIZONTAL_PASS_SHADER]);
-			glUniform1i(glGetUniformLocation(shaderProg[SAT_HORIZONTAL_PASS_SHADER], "iteration"), iteration);
-			if(iteration == 0)
-				myGLTextureViewer.drawTextureOnShader(textures[SHADOW_MAP_COLOR], shadowMapWidth, shadowMapHeight);
-			else
-				myGLTextureViewer.drawTextureOnShader(textures[SAT_SHADOW_MAP_COLOR], shadowMapWidth, shadowMapHeight);
+			displaySceneFromLightPOV();
 			glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-			glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[SAT_SHADOW_FRAMEBUFFER]);
-			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-			glViewport(0, 0, shadowMapWidth, shadowMapHeight);
-			myGLTextureViewer.setShaderProg(shaderProg[SAT_VERTICAL_PASS_SHADER]);
-			glUseProgram(shaderProg[SAT_VERTICAL_PASS_SHADER]);
-			glUniform1i(glGetUniformLocation(shaderProg[SAT_VERTICAL_PASS_SHADER], "iteration"), iteration);
-			myGLTextureViewer.drawTextureOnShader(textures[TEMP_SHADOW_MAP_COLOR], shadowMapWidth, shadowMapHeight);
-			glBindFramebuffer(GL_FRAMEBUFFER, 0);
-			
+			shadowParams.lightMVPs[sample] = lightMVP;
+			tiledShadowMapSamples++;
+
 		}
-		
 	}
 
-	if(shadowParams.useHierarchicalShadowMap) renderHSM();
-	
-	glDisable(GL_CULL_FACE);
-	glDisable(GL_POLYGON_OFFSET_FILL);
-	
-	if(shadowParams.EDTSSM) {
-	
-		/*
-		glClearColor(0.0f, 0.0f, 0.0f, 1.0);
-		glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[CUDA_FRAMEBUFFER]);
-		displaySceneFromGBuffer(shaderProg[SMSR_SHADER]);
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
-		*/
+	lightSource->setEye(((LightSource*)tiledLightSource)->getEye());
+	lightSource->setAt(((LightSource*)tiledLightSource)->getAt());
 
-		glClearColor(0.0f, 0.0f, 0.0f, 1.0);
-		glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[SOFT_SHADOW_FRAMEBUFFER]);
-		displaySceneFromGBuffer(shaderProg[SMSR_SHADER]);
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
-		
-		myGLTextureViewer.setShaderProg(shaderProg[EDGE_FILTER_SHADER]);
-		myGLGeometryViewer.setShaderProg(shaderProg[EDGE_FILTER_SHADER]);
-		glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[CUDA_FRAMEBUFFER]);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-		glViewport(0, 0, windowWidth, windowHeight);
-		myGLTextureViewer.configureSeparableFilter(1, false, false, shadowParams.shadowIntensity);
-		myGLGeometryViewer.configurePhong(lightSource->getEye(), cameraEye);
-		myGLGeometryViewer.configureGBuffer(shadowParams);
-		myGLGeometryViewer.configureShadow(shadowParams);
-		myGLGeometryViewer.configureLinearization();
-		myGLTextureViewer.drawTextureOnShader(textures[SOFT_SHADOW_MAP_COLOR], windowWidth, windowHeight);
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
 
-		computeEDT();
+void renderTiledAdaptiveSampling()
+{
 
-	} else {
-	
-		glClearColor(0.0f, 0.0f, 0.0f, 1.0);
-		glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[SOFT_SHADOW_FRAMEBUFFER]);
-		glBeginQuery(GL_SAMPLES_PASSED, queryObject[0]);
-		if(shadowParams.RBSSM) displaySceneFromGBuffer(shaderProg[RBSSM_SHADER]);
-		else displaySceneFromGBuffer(shaderProg[PLAUSIBLE_SOFT_SHADOW_SHADER]);
-		glEndQuery(GL_SAMPLES_PASSED);
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
-		GLuint output;
-		glGetQueryObjectuiv(queryObject[0], GL_QUERY_RESULT, &output);
-		//std::cout << output << std::endl;
+	int numberOfTiles = (windowWidth / 16) * (windowHeight / 16);
+	int numberOfActiveTiles = numberOfTiles;
+	bool renderedSamples[289];
+	float *quads = (float*)malloc(numberOfTiles * 12 * sizeof(float));
 
+	//the tiles reuse the layers of the shadow map array, so the cached Monte-Carlo maps are lost
+	shadowMapCache.invalidate();
+	updateLight();
+	tiledLightSource->setEye(((LightSource*)uniformSampledLightSource)->getEye());
+	tiledLightSource->setAt(((LightSource*)uniformSampledLightSource)->getAt());
+	lightSource->setEye(((LightSource*)tiledLightSource)->getEye());
+	lightSource->setAt(((LightSource*)tiledLightSource)->getAt());
+
+	renderGBuffer();
+
+	for(int sample = 0; sample < 289; sample++) renderedSamples[sample] = false;
+	for(int tile = 0; tile < numberOfTiles; tile++) {
+		tileLevels[tile] = 0;
+		activeTiles[tile] = tile;
+	}
+	tiledShadowMapSamples = 0;
+
+	//every tile starts at the corners of the area light and only the tiles that see a penumbra move to the next level
+	for(int level = 0; level <= maxLevel; level++) {
+
+		//once every tile has converged the samples of the next level would not be read by any of them
+		if(numberOfActiveTiles == 0) break;
+		renderTiledLightSamples(level, renderedSamples);
+		if(level == maxLevel) break;
+
+		shadowParams.sampleStride = 16/powf(2, level);
+		buildTileQuads(quads, activeTiles, numberOfActiveTiles);
+		tileQuads = quads;
+		numberOfTileQuads = numberOfActiveTiles;
+		glClearColor(0.0f, 0.0f, 0.0f, 1.0);
+		glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[TILE_CLASSIFICATION_FRAMEBUFFER]);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		displaySceneFromGBuffer(shaderProg[TILE_CLASSIFICATION_SHADER]);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		tileQuads = NULL;
+
+		//any penumbra pixel leaves a non-zero average in the texel of its tile
+		glBindTexture(GL_TEXTURE_2D, textures[TILE_CLASSIFICATION_MAP_COLOR]);
+		glGenerateMipmap(GL_TEXTURE_2D);
+		glGetTexImage(GL_TEXTURE_2D, 4, GL_RED, GL_FLOAT, tileFlags);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		int numberOfRefinedTiles = 0;
+		for(int tile = 0; tile < numberOfActiveTiles; tile++) {
+			if(tileFlags[activeTiles[tile]] > 0.0) {
+				tileLevels[activeTiles[tile]] = level + 1;
+				activeTiles[numberOfRefinedTiles++] = activeTiles[tile];
+			}
+		}
+		numberOfActiveTiles = numberOfRefinedTiles;
+
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[TEMP_SHADOW_FRAMEBUFFER]);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, textures[TEMP_SHADOW_MAP_DEPTH], 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[TEMP_SHADOW_MAP_COLOR], 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	glClearColor(0.0f, 0.0f, 0.0f, 1.0);
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[SOFT_SHADOW_FRAMEBUFFER]);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	//one compacted tile list per level, so each draw only evaluates the samples its tiles need
+	for(int level = 0; level <= maxLevel; level++) {
+
+		int numberOfLevelTiles = 0;
+		for(int tile = 0; tile < numberOfTiles; tile++)
+			if(tileLevels[tile] == level)
+				activeTiles[numberOfLevelTiles++] = tile;
+		tilesPerLevel[level] = numberOfLevelTiles;
+		if(numberOfLevelTiles == 0) continue;
+
+		shadowParams.sampleStride = 16/powf(2, level);
+		buildTileQuads(quads, activeTiles, numberOfLevelTiles);
+		tileQuads = quads;
+		numberOfTileQuads = numberOfLevelTiles;
+		glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[SOFT_SHADOW_FRAMEBUFFER]);
+		displaySceneFromGBuffer(shaderProg[TILED_SOFT_SHADOW_SHADER]);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		tileQuads = NULL;
+
+	}
+
+	free(quads);
+	glFinish();
+
+}
+
+int getDistanceTransform()
+{
+
+	return distanceTransformMethod[(shadowParams.SSEDTSSM) ? 1 : 0];
+
+}
+
+//Jump flooding in GLSL, so the EDT needs no CUDA mapping. The seeds are ping-ponged between the two maps and
+//jumpFloodingSeeds is left on the one that holds the nearest sites
+void computeJumpFlooding(int extraPasses)
+{
+
+	glViewport(0, 0, windowWidth, windowHeight);
+	myGLTextureViewer.setShaderProg(shaderProg[JUMP_FLOODING_INITIALIZATION_SHADER]);
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[JUMP_FLOODING_FRAMEBUFFER]);
+	myGLTextureViewer.drawTextureOnShader(textures[CUDA_MAP_COLOR], windowWidth, windowHeight);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	jumpFloodingSeeds = JUMP_FLOODING_MAP_COLOR;
+
+	int steps[MAX_JUMP_FLOODING_PASSES];
+	int numberOfSteps = distanceTransform->getJumpFloodingSteps(windowWidth, windowHeight, extraPasses, steps);
+	GLuint shader = shaderProg[JUMP_FLOODING_SHADER];
+	myGLTextureViewer.setShaderProg(shader);
+	for(int pass = 0; pass < numberOfSteps; pass++) {
+
+		bool toTemp = (jumpFloodingSeeds == JUMP_FLOODING_MAP_COLOR);
+		glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[(toTemp) ? TEMP_JUMP_FLOODING_FRAMEBUFFER : JUMP_FLOODING_FRAMEBUFFER]);
+		glUseProgram(shader);
+		glUniform1i(glGetUniformLocation(shader, "stepSize"), steps[pass]);
+		myGLTextureViewer.drawTextureOnShader(textures[jumpFloodingSeeds], windowWidth, windowHeight);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		jumpFloodingSeeds = (toTemp) ? TEMP_JUMP_FLOODING_MAP_COLOR : JUMP_FLOODING_MAP_COLOR;
+
+	}
+
+	shader = shaderProg[JUMP_FLOODING_EDT_SHADER];
+	myGLTextureViewer.setShaderProg(shader);
+	myGLGeometryViewer.setShaderProg(shader);
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[JUMP_FLOODING_EDT_FRAMEBUFFER]);
+	glUseProgram(shader);
+	glUniform1f(glGetUniformLocation(shader, "shadowIntensity"), shadowParams.shadowIntensity);
+	glUniform1i(glGetUniformLocation(shader, "seedMap"), 6);
+	glUniform1i(glGetUniformLocation(shader, "positionMap"), 5);
+	myGLGeometryViewer.configureLinearization();
+	glActiveTexture(GL_TEXTURE6);
+	glBindTexture(GL_TEXTURE_2D, textures[jumpFloodingSeeds]);
+	glActiveTexture(GL_TEXTURE5);
+	glBindTexture(GL_TEXTURE_2D, textures[CUDA_POSITION_MAP_COLOR]);
+	glActiveTexture(GL_TEXTURE0);
+	myGLTextureViewer.drawTextureOnShader(textures[CUDA_MAP_COLOR], windowWidth, windowHeight);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	glActiveTexture(GL_TEXTURE6);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glActiveTexture(GL_TEXTURE5);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glActiveTexture(GL_TEXTURE0);
+
+}
+
+void computeEDT() 
+{
+
+	//PBA writes the EDT image over its input, the jump flooding writes it to its own map
+	GLuint EDTImage = textures[CUDA_MAP_COLOR];
+	if(getDistanceTransform() == PBA_DISTANCE_TRANSFORM) {
+		pbaCudaBindTexture(CUDAGraphicsResource);
+		//the bounded diagram only covers the tiles within boundedEDTRadius pixels of a discontinuity
+		if(boundedEDT) pba2DBoundedVoronoiDiagram(boundedEDTRadius, shadowParams.shadowIntensity);
+		else pba2DVoronoiDiagram(16, 16, 16, shadowParams.shadowIntensity);
+		pbaCudaUnbindTexture(CUDAGraphicsResource);
+	} else {
+		computeJumpFlooding(getDistanceTransform() - JFA_DISTANCE_TRANSFORM);
+		EDTImage = textures[JUMP_FLOODING_EDT_MAP_COLOR];
+	}
+	
+	myGLTextureViewer.setShaderProg(shaderProg[MEAN_FILTER_SHADER]);
+	myGLGeometryViewer.setShaderProg(shaderProg[MEAN_FILTER_SHADER]);
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[HARD_SHADOW_FRAMEBUFFER]);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	glViewport(0, 0, windowWidth, windowHeight);
+	myGLTextureViewer.configureSeparableFilter(shadowParams.kernelSize, true, false, shadowParams.shadowIntensity);
+	myGLGeometryViewer.configurePhong(lightSource->getEye(), cameraEye);
+	myGLGeometryViewer.configureGBuffer(shadowParams);
+	myGLGeometryViewer.configureLinearization();
+	myGLTextureViewer.drawTextureOnShader(EDTImage, windowWidth, windowHeight);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[SOFT_SHADOW_FRAMEBUFFER]);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	glViewport(0, 0, windowWidth, windowHeight);
+	myGLTextureViewer.configureSeparableFilter(shadowParams.kernelSize, false, true, shadowParams.shadowIntensity);
+	myGLGeometryViewer.configurePhong(lightSource->getEye(), cameraEye);
+	myGLGeometryViewer.configureGBuffer(shadowParams);
+	myGLGeometryViewer.configureLinearization();
+	myGLTextureViewer.drawTextureOnShader(textures[HARD_SHADOW_MAP_COLOR], windowWidth, windowHeight);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+}
+
+void computeSceneBounds()
+{
+
+	float *pointCloud = scene->getPointCloud();
+	for(int axis = 0; axis < 3; axis++)
+		sceneBounds[axis] = sceneBounds[axis + 3] = pointCloud[axis];
+
+	for(int point = 3; point < scene->getPointCloudSize(); point += 3) {
+		for(int axis = 0; axis < 3; axis++) {
+			if(pointCloud[point + axis] < sceneBounds[axis]) sceneBounds[axis] = pointCloud[point + axis];
+			if(pointCloud[point + axis] > sceneBounds[axis + 3]) sceneBounds[axis + 3] = pointCloud[point + axis];
+		}
+	}
+	sceneBoundsVersion = geometryVersion;
+
+}
+
+//Narrows the field of view of the light to the receivers the camera sees, bounded by the scene box, so the same 
+//shadow map spends its texels on visible surfaces. The depth range stays fixed, as the blocker search and the 
+//filters are tuned to its non-linear depths. The filter widths are scaled by the density gain instead
+void fitLightFrustumToReceivers()
+{
+
+	updateLight();
+	glm::mat4 model = glm::translate(glm::vec3(translationVector[0], translationVector[1], translationVector[2]));
+	model *= glm::rotate(rotationAngles[0], glm::vec3(1, 0, 0));
+	model *= glm::rotate(rotationAngles[1], glm::vec3(0, 1, 0));
+	model *= glm::rotate(rotationAngles[2], glm::vec3(0, 0, 1));
+	glm::mat4 lightMV = glm::lookAt(lightSource->getEye(), lightSource->getAt(), lightSource->getUp()) * model;
+	float defaultTangent = tanf(glm::radians(myGLGeometryViewer.getFov() * 0.5f));
+
+	//the scene box only bounds the frustum when the light is outside of it
+	if(sceneBoundsVersion != geometryVersion)
+		computeSceneBounds();
+	float sceneTangent = 0.0;
+	for(int corner = 0; corner < 8; corner++) {
+		glm::vec4 vertex = lightMV * glm::vec4(sceneBounds[(corner & 1) ? 3 : 0], sceneBounds[(corner & 2) ? 4 : 1], sceneBounds[(corner & 4) ? 5 : 2], 1.0);
+		if(vertex.z >= 0.0f) {
+			sceneTangent = defaultTangent;
+			break;
+		}
+		sceneTangent = glm::max(sceneTangent, glm::max(fabs(vertex.x), fabs(vertex.y)) / -vertex.z);
+	}
+
+	//each texel of the reduction holds the receiver bounds of a 16x16 G-buffer tile
+	int tilesX = windowWidth / 16;
+	int tilesY = windowHeight / 16;
+	float *tileBounds = (float*)malloc(tilesX * tilesY * 4 * sizeof(float));
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[LIGHT_FRUSTUM_FRAMEBUFFER]);
+	glViewport(0, 0, tilesX, tilesY);
+	glUseProgram(shaderProg[LIGHT_FRUSTUM_REDUCTION_SHADER]);
+	myGLGeometryViewer.setShaderProg(shaderProg[LIGHT_FRUSTUM_REDUCTION_SHADER]);
+	myGLTextureViewer.setShaderProg(shaderProg[LIGHT_FRUSTUM_REDUCTION_SHADER]);
+	shadowParams.vertexMap = (packedGBuffer) ? textures[GBUFFER_MAP_DEPTH] : textures[VERTEX_MAP_COLOR];
+	shadowParams.normalMap = textures[NORMAL_MAP_COLOR];
+	shadowParams.colorMap = textures[TEXTURE_MAP_COLOR];
+	myGLGeometryViewer.configureGBuffer(shadowParams);
+	glActiveTexture(GL_TEXTURE0);
+	glUniformMatrix4fv(glGetUniformLocation(shaderProg[LIGHT_FRUSTUM_REDUCTION_SHADER], "lightMV"), 1, GL_FALSE, &lightMV[0][0]);
+	glUniform2f(glGetUniformLocation(shaderProg[LIGHT_FRUSTUM_REDUCTION_SHADER], "gBufferSize"), (float)windowWidth, (float)windowHeight);
+	myGLTextureViewer.drawTextureQuad();
+	glReadPixels(0, 0, tilesX, tilesY, GL_RGBA, GL_FLOAT, tileBounds);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glUseProgram(0);
+
+	float receiverTangent = -1.0;
+	for(int tile = 0; tile < tilesX * tilesY; tile++)
+		if(tileBounds[tile * 4 + 3] > 0.0f)
+			receiverTangent = glm::max(receiverTangent, glm::max(tileBounds[tile * 4], tileBounds[tile * 4 + 1]));
+	free(tileBounds);
+
+	//the blocker search reaches past the outermost receivers by a constant angle, whatever the frustum
+	float searchMargin = 2.0f * defaultTangent * shadowParams.lightSourceRadius / (float)((shadowMapWidth <= 1024) ? shadowMapWidth : 1024);
+	float fittedTangent = (receiverTangent < 0.0f) ? defaultTangent : receiverTangent + searchMargin;
+	fittedTangent = glm::min(fittedTangent, glm::min(sceneTangent, defaultTangent));
+
+	//half degree steps keep the cached shadow maps valid while the camera barely moves
+	lightFrustumFov = ceilf(glm::degrees(2.0f * atanf(fittedTangent)) * 2.0f) / 2.0f;
+	lightFrustumFov = glm::clamp(lightFrustumFov, 1.0f, myGLGeometryViewer.getFov());
+	shadowParams.lightFrustumScale = defaultTangent / tanf(glm::radians(lightFrustumFov * 0.5f));
+
+}
+
+void drawCascadeReduction(int shader, glm::mat4 cameraMV, glm::mat4 lightViewProjection, int cascade)
+{
+
+	//each texel of the reductions holds the receivers of a 16x16 G-buffer tile
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[LIGHT_FRUSTUM_FRAMEBUFFER]);
+	glViewport(0, 0, windowWidth / 16, windowHeight / 16);
+	glUseProgram(shaderProg[shader]);
+	myGLGeometryViewer.setShaderProg(shaderProg[shader]);
+	myGLTextureViewer.setShaderProg(shaderProg[shader]);
+	shadowParams.vertexMap = (packedGBuffer) ? textures[GBUFFER_MAP_DEPTH] : textures[VERTEX_MAP_COLOR];
+	shadowParams.normalMap = textures[NORMAL_MAP_COLOR];
+	shadowParams.colorMap = textures[TEXTURE_MAP_COLOR];
+	myGLGeometryViewer.configureGBuffer(shadowParams);
+	glActiveTexture(GL_TEXTURE0);
+	glUniformMatrix4fv(glGetUniformLocation(shaderProg[shader], "cameraMV"), 1, GL_FALSE, &cameraMV[0][0]);
+	glUniformMatrix4fv(glGetUniformLocation(shaderProg[shader], "lightMVP"), 1, GL_FALSE, &lightViewProjection[0][0]);
+	glUniform3f(glGetUniformLocation(shaderProg[shader], "cascadeSplits"), shadowParams.cascadeSplits[0], shadowParams.cascadeSplits[1], 
+		shadowParams.cascadeSplits[2]);
+	glUniform1i(glGetUniformLocation(shaderProg[shader], "cascade"), cascade);
+	glUniform2f(glGetUniformLocation(shaderProg[shader], "gBufferSize"), (float)windowWidth, (float)windowHeight);
+	myGLTextureViewer.drawTextureQuad();
+
+}
+
+//Splits the shadow map of PCSS in 2x2 cascades over the depth range of the receivers, each one cropped to the light space 
+//bounds of its receivers. The crops are square, so each cascade scales the blocker search and the penumbra by one density
+void fitSoftShadowCascades()
+{
+
+	updateLight();
+	glm::mat4 model = glm::translate(glm::vec3(translationVector[0], translationVector[1], translationVector[2]));
+	model *= glm::rotate(rotationAngles[0], glm::vec3(1, 0, 0));
+	model *= glm::rotate(rotationAngles[1], glm::vec3(0, 1, 0));
+	model *= glm::rotate(rotationAngles[2], glm::vec3(0, 0, 1));
+	glm::mat4 cameraMV = glm::lookAt(cameraEye, cameraAt, cameraUp) * model;
+	float lightFov = (lightFrustumActive) ? lightFrustumFov : myGLGeometryViewer.getFov();
+	glm::mat4 lightViewProjection = glm::perspective(lightFov, (GLfloat)shadowMapWidth/shadowMapHeight, myGLGeometryViewer.zNear, 
+		myGLGeometryViewer.zFar) * glm::lookAt(lightSource->getEye(), lightSource->getAt(), lightSource->getUp()) * model;
+
+	int tilesX = windowWidth / 16;
+	int tilesY = windowHeight / 16;
+	float *tileBounds = (float*)malloc(tilesX * tilesY * 4 * sizeof(float));
+	drawCascadeReduction(CASCADE_DEPTH_REDUCTION_SHADER, cameraMV, lightViewProjection, -1);
+	glReadPixels(0, 0, tilesX, tilesY, GL_RGBA, GL_FLOAT, tileBounds);
+
+	float minDepth = 1.0e30f, maxDepth = 0.0f;
+	for(int tile = 0; tile < tilesX * tilesY; tile++) {
+		if(tileBounds[tile * 4 + 3] > 0.0f) {
+			minDepth = glm::min(minDepth, tileBounds[tile * 4]);
+			maxDepth = glm::max(maxDepth, tileBounds[tile * 4 + 1]);
+		}
+	}
+
+	//without receivers there is nothing to fit and the single shadow map is kept
+	if(maxDepth <= 0.0f) {
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glUseProgram(0);
+		free(tileBounds);
+		return;
+	}
+
+	//practical split scheme over the depth range of the receivers, instead of the one of the camera frustum
+	minDepth = glm::max(minDepth, myGLGeometryViewer.zNear);
+	maxDepth = glm::max(maxDepth, minDepth);
+	for(int split = 1; split < NUMBER_OF_CASCADES; split++) {
+		float fraction = (float)split / NUMBER_OF_CASCADES;
+		float logarithmicSplit = minDepth * powf(maxDepth / minDepth, fraction);
+		float uniformSplit = minDepth + (maxDepth - minDepth) * fraction;
+		shadowParams.cascadeSplits[split - 1] = cascadeSplitLambda * logarithmicSplit + (1.0f - cascadeSplitLambda) * uniformSplit;
+	}
+
+	//the blocker search reaches past the outermost receivers of a cascade by a constant angle, whatever the crop
+	float searchMargin = 2.0f * shadowParams.lightFrustumScale * shadowParams.lightSourceRadius / (float)((shadowMapWidth <= 1024) ? shadowMapWidth : 1024);
+	int quadrantSize = glm::min(shadowMapWidth, shadowMapHeight) / 2;
+	for(int cascade = 0; cascade < NUMBER_OF_CASCADES; cascade++) {
+
+		drawCascadeReduction(CASCADE_BOUNDS_REDUCTION_SHADER, cameraMV, lightViewProjection, cascade);
+		glReadPixels(0, 0, tilesX, tilesY, GL_RGBA, GL_FLOAT, tileBounds);
+
+		float bounds[4] = {1.0e30f, 1.0e30f, -1.0e30f, -1.0e30f};
+		for(int tile = 0; tile < tilesX * tilesY; tile++) {
+			bounds[0] = glm::min(bounds[0], tileBounds[tile * 4]);
+			bounds[1] = glm::min(bounds[1], tileBounds[tile * 4 + 1]);
+			bounds[2] = glm::max(bounds[2], tileBounds[tile * 4 + 2]);
+			bounds[3] = glm::max(bounds[3], tileBounds[tile * 4 + 3]);
+		}
+
+		//a cascade without receivers keeps the whole light frustum
+		if(bounds[0] > bounds[2] || bounds[1] > bounds[3]) {
+			bounds[0] = -1.0f; bounds[1] = -1.0f; bounds[2] = 1.0f; bounds[3] = 1.0f;
+		}
+		for(int side = 0; side < 4; side++)
+			bounds[side] = glm::clamp(bounds[side] + ((side < 2) ? -searchMargin : searchMargin), -1.0f, 1.0f);
+
+		//the border keeps most of the filter taps inside the quadrant, the shader clamps the other ones to it
+		float extent = glm::max(glm::max(bounds[2] - bounds[0], bounds[3] - bounds[1]), 1.0e-3f) * quadrantSize / (quadrantSize - 2 * cascadeBorder);
+		float centerX = 0.5f * (bounds[0] + bounds[2]);
+		float centerY = 0.5f * (bounds[1] + bounds[3]);
+
+		cascadeCrop[cascade] = glm::mat4(1.0f);
+		cascadeCrop[cascade][0][0] = 2.0f / extent;
+		cascadeCrop[cascade][1][1] = 2.0f / extent;
+		cascadeCrop[cascade][3][0] = -2.0f * centerX / extent;
+		cascadeCrop[cascade][3][1] = -2.0f * centerY / extent;
+		shadowParams.cascadeMVP[cascade] = cascadeCrop[cascade] * lightViewProjection;
+		//the crop magnifies the light frustum by 2/extent and the quadrant halves it
+		shadowParams.cascadeScale[cascade] = 1.0f / extent;
+
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glUseProgram(0);
+	free(tileBounds);
+	shadowParams.cascadedShadowMaps = true;
+
+}
+
+//Summed-area table of the moments in float by recursive doubling: each iteration adds the texels 2^iteration to the left,
+//then the ones 2^iteration above
+void computeShadowMapSAT()
+{
+
+	int m = std::logf(shadowMapWidth)/std::logf(2);
+	for(int iteration = 0; iteration < m; iteration++) {
+
+		glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[TEMP_SHADOW_FRAMEBUFFER]);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		glViewport(0, 0, shadowMapWidth, shadowMapHeight);
+		myGLTextureViewer.setShaderProg(shaderProg[SAT_HORIZONTAL_PASS_SHADER]);
+		glUseProgram(shaderProg[SAT_HORIZONTAL_PASS_SHADER]);
+		glUniform1i(glGetUniformLocation(shaderProg[SAT_HORIZONTAL_PASS_SHADER], "iteration"), iteration);
+		if(iteration == 0)
+			myGLTextureViewer.drawTextureOnShader(textures[SHADOW_MAP_COLOR], shadowMapWidth, shadowMapHeight);
+		else
+			myGLTextureViewer.drawTextureOnShader(textures[SAT_SHADOW_MAP_COLOR], shadowMapWidth, shadowMapHeight);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[SAT_SHADOW_FRAMEBUFFER]);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		glViewport(0, 0, shadowMapWidth, shadowMapHeight);
+		myGLTextureViewer.setShaderProg(shaderProg[SAT_VERTICAL_PASS_SHADER]);
+		glUseProgram(shaderProg[SAT_VERTICAL_PASS_SHADER]);
+		glUniform1i(glGetUniformLocation(shaderProg[SAT_VERTICAL_PASS_SHADER], "iteration"), iteration);
+		myGLTextureViewer.drawTextureOnShader(textures[TEMP_SHADOW_MAP_COLOR], shadowMapWidth, shadowMapHeight);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	
+	}
+
+}
+
+//Fixed-point summed-area table of the SAVSM/VSSM moments, built with the same recursive doubling as the float one. The first 
+//horizontal pass reads the float moments of the shadow map and converts them
+void computeIntegerShadowMapSAT()
+{
+
+	int largestSide = (shadowMapWidth > shadowMapHeight) ? shadowMapWidth : shadowMapHeight;
+	int m = (int)ceilf(logf((float)largestSide)/logf(2.0f));
+	glViewport(0, 0, shadowMapWidth, shadowMapHeight);
+	for(int iteration = 0; iteration < m; iteration++) {
+
+		GLuint shader = shaderProg[INTEGER_SAT_HORIZONTAL_PASS_SHADER];
+		glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[TEMP_INTEGER_SAT_FRAMEBUFFER]);
+		myGLTextureViewer.setShaderProg(shader);
+		glUseProgram(shader);
+		glUniform1i(glGetUniformLocation(shader, "iteration"), iteration);
+		glUniform1i(glGetUniformLocation(shader, "momentMap"), 6);
+		glActiveTexture(GL_TEXTURE6);
+		glBindTexture(GL_TEXTURE_2D, textures[SHADOW_MAP_COLOR]);
+		glActiveTexture(GL_TEXTURE0);
+		myGLTextureViewer.drawTextureOnShader(textures[INTEGER_SAT_SHADOW_MAP_COLOR], shadowMapWidth, shadowMapHeight);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		shader = shaderProg[INTEGER_SAT_VERTICAL_PASS_SHADER];
+		glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[INTEGER_SAT_FRAMEBUFFER]);
+		myGLTextureViewer.setShaderProg(shader);
+		glUseProgram(shader);
+		glUniform1i(glGetUniformLocation(shader, "iteration"), iteration);
+		myGLTextureViewer.drawTextureOnShader(textures[TEMP_INTEGER_SAT_SHADOW_MAP_COLOR], shadowMapWidth, shadowMapHeight);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	}
+
+	glActiveTexture(GL_TEXTURE6);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glActiveTexture(GL_TEXTURE0);
+
+}
+
+//Renders the input of the EDT into the CUDA map: the hard shadows, with the penumbra width at the sites on their edges.
+//The PBA path writes its result over that map, so the sites must be rendered again before each EDT
+void renderEDTSites()
+{
+
+	glClearColor(0.0f, 0.0f, 0.0f, 1.0);
+	if(shadowParams.EDTSSM) {
+
+		glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[SOFT_SHADOW_FRAMEBUFFER]);
+		displaySceneFromGBuffer(shaderProg[SMSR_SHADER]);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		
+		myGLTextureViewer.setShaderProg(shaderProg[EDGE_FILTER_SHADER]);
+		myGLGeometryViewer.setShaderProg(shaderProg[EDGE_FILTER_SHADER]);
+		glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[CUDA_FRAMEBUFFER]);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		glViewport(0, 0, windowWidth, windowHeight);
+		myGLTextureViewer.configureSeparableFilter(1, false, false, shadowParams.shadowIntensity);
+		myGLGeometryViewer.configurePhong(lightSource->getEye(), cameraEye);
+		myGLGeometryViewer.configureGBuffer(shadowParams);
+		myGLGeometryViewer.configureShadow(shadowParams);
+		myGLGeometryViewer.configureLinearization();
+		myGLTextureViewer.drawTextureOnShader(textures[SOFT_SHADOW_MAP_COLOR], windowWidth, windowHeight);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	} else {
+
+		glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[HARD_SHADOW_FRAMEBUFFER]);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		displaySceneFromGBuffer(shaderProg[SMSR_SHADER]);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		shadowParams.useHardShadowMap = true;
+		glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[CUDA_FRAMEBUFFER]);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		displaySceneFromGBuffer(shaderProg[SCREEN_SPACE_PENUMBRA_SIZE_ESTIMATION_SHADER]);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		shadowParams.useHardShadowMap = false;
+
+	}
+
+}
+
+void renderSoftShadows() 
+{
+
+	renderGBuffer();
+
+	lightFrustumActive = fitLightFrustum;
+	if(fitLightFrustum)
+		fitLightFrustumToReceivers();
+	else
+		shadowParams.lightFrustumScale = 1.0;
+	//only the PCF-based PCSS reads the cascades, the other techniques filter moment tables that span the whole shadow map
+	shadowParams.cascadedShadowMaps = false;
+	if(cascadedSoftShadows && shadowParams.PCSS && !shadowParams.RBSSM && !shadowParams.penumbraClassification)
+		fitSoftShadowCascades();
+	
+	if(!isShadowMapCached(1)) {
+
+		glClearColor(0.0f, 0.0f, 0.0f, 0.0);
+		glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[SHADOW_FRAMEBUFFER]);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		if(shadowParams.cascadedShadowMaps) {
+			for(int cascade = 0; cascade < NUMBER_OF_CASCADES; cascade++)
+				displaySceneFromLightPOV(cascade);
+		} else {
+			displaySceneFromLightPOV();
+		}
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	
+		glBindTexture(GL_TEXTURE_2D, textures[SHADOW_MAP_COLOR]);
+		glGenerateMipmap(GL_TEXTURE_2D);
+
+		if(shadowParams.SAT) {
+			if(shadowParams.integerSAT && (shadowParams.SAVSM || shadowParams.VSSM))
+				computeIntegerShadowMapSAT();
+			else
+				computeShadowMapSAT();
+		}
+
+		if(shadowParams.useHierarchicalShadowMap || shadowParams.penumbraClassification) renderHSM();
+
+	}
+	
+	glDisable(GL_CULL_FACE);
+	glDisable(GL_POLYGON_OFFSET_FILL);
+	
+	if(shadowParams.EDTSSM) {
+	
+		renderEDTSites();
+		computeEDT();
+
+	} else {
+	
+		glClearColor(0.0f, 0.0f, 0.0f, 1.0);
+		glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[SOFT_SHADOW_FRAMEBUFFER]);
+		
+		//lit and umbra pixels are resolved from the HSM bounds, so only the penumbra runs the blocker search and the filter
+		if(shadowParams.penumbraClassification) {
+			glUseProgram(shaderProg[PENUMBRA_CLASSIFICATION_SHADER]);
+			glUniform1f(glGetUniformLocation(shaderProg[PENUMBRA_CLASSIFICATION_SHADER], "HSMAlpha"), shadowParams.HSMAlpha);
+			glUniform1f(glGetUniformLocation(shaderProg[PENUMBRA_CLASSIFICATION_SHADER], "HSMBeta"), shadowParams.HSMBeta);
+			glBeginQuery(GL_SAMPLES_PASSED, queryObject[0]);
+			displaySceneFromGBuffer(shaderProg[PENUMBRA_CLASSIFICATION_SHADER]);
+			glEndQuery(GL_SAMPLES_PASSED);
+			glGetQueryObjectuiv(queryObject[0], GL_QUERY_RESULT, &classifiedPixels);
+			penumbraMaskActive = true;
+			glDepthFunc(GL_LESS);
+			glDepthMask(GL_FALSE);
+		}
+
+		//the compute path shades every pixel, so it is not combined with the penumbra mask. Its shared tile covers a single frustum
+		if(computePCSS && shadowParams.PCSS && !shadowParams.RBSSM && !shadowParams.penumbraClassification && !shadowParams.cascadedShadowMaps && 
+			GLEW_VERSION_4_3) {
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+			displaySceneFromGBuffer(shaderProg[COMPUTE_PCSS_SHADER], true);
+		} else {
+			glBeginQuery(GL_SAMPLES_PASSED, queryObject[0]);
+			if(shadowParams.RBSSM) displaySceneFromGBuffer(shaderProg[RBSSM_SHADER]);
+			else displaySceneFromGBuffer(getSoftShadowProgram(PLAUSIBLE_SOFT_SHADOW_SHADER));
+			glEndQuery(GL_SAMPLES_PASSED);
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+			glGetQueryObjectuiv(queryObject[0], GL_QUERY_RESULT, &filteredPixels);
+		}
+		
+		if(penumbraMaskActive) {
+			glDepthMask(GL_TRUE);
+			penumbraMaskActive = false;
+		}
+
+	}
+
+	lightFrustumActive = false;
+	shadowParams.cascadedShadowMaps = false;
+	
+}
+
+//The guided filter passes write both fixed-point targets from integer outputs, which are bound to them before linking again
+void bindGuidedFilterOutputs(GLuint shader)
+{
+
+	glBindFragDataLocation(shader, 0, "firstTable");
+	glBindFragDataLocation(shader, 1, "secondTable");
+	glLinkProgram(shader);
+
+}
+
+//Builds the summed-area tables of both targets of one of the guided filter framebuffers (0 for GUIDED_FILTER_FRAMEBUFFER, 
+//1 for TEMP_GUIDED_FILTER_FRAMEBUFFER), ping-ponging between the two. Returns the framebuffer that holds the tables
+int computeGuidedFilterSAT(int current)
+{
+
+	int horizontalPasses = (int)ceilf(logf((float)windowWidth)/logf(2.0f));
+	int verticalPasses = (int)ceilf(logf((float)windowHeight)/logf(2.0f));
+	GLuint shader = shaderProg[GUIDED_FILTER_SAT_SHADER];
+
+	glViewport(0, 0, windowWidth, windowHeight);
+	myGLTextureViewer.setShaderProg(shader);
+	for(int pass = 0; pass < horizontalPasses + verticalPasses; pass++) {
+
+		glUseProgram(shader);
+		glUniform1i(glGetUniformLocation(shader, "iteration"), (pass < horizontalPasses) ? pass : pass - horizontalPasses);
+		glUniform1i(glGetUniformLocation(shader, "horizontal"), pass < horizontalPasses);
+		glUniform1i(glGetUniformLocation(shader, "secondImage"), 6);
+		glActiveTexture(GL_TEXTURE6);
+		glBindTexture(GL_TEXTURE_2D, textures[GUIDED_FILTER_MOMENTS_MAP_COLOR + 2 * current]);
+		glActiveTexture(GL_TEXTURE0);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[GUIDED_FILTER_FRAMEBUFFER + 1 - current]);
+		myGLTextureViewer.drawTextureOnShader(textures[GUIDED_FILTER_MAP_COLOR + 2 * current], windowWidth, windowHeight);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		current = 1 - current;
+
+	}
+
+	glActiveTexture(GL_TEXTURE6);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glActiveTexture(GL_TEXTURE0);
+	return current;
+
+}
+
+//the model transformations are left out, it only has to bring the guide close to zero
+float computeGuideOffset()
+{
+
+	return glm::length(cameraAt - cameraEye) / 1000.0f;
+
+}
+
+void renderGuidedFilterMoments()
+{
+
+	glUseProgram(shaderProg[GUIDED_FILTER_MOMENTS_SHADER]);
+	glUniform1f(glGetUniformLocation(shaderProg[GUIDED_FILTER_MOMENTS_SHADER], "guideOffset"), computeGuideOffset());
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[GUIDED_FILTER_FRAMEBUFFER]);
+	displaySceneFromGBuffer(shaderProg[GUIDED_FILTER_MOMENTS_SHADER]);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+}
+
+//Edge-aware filtering of the screen-space techniques with a guided filter keyed on the camera depth, in place of the 
+//separable bilateral filter. Every window is read from a summed-area table, so the cost does not grow with the kernel 
+//size. Reads the hard shadow and the penumbra width from the map PartialShadowFiltering wrote and fills the soft shadow map
+void renderGuidedShadowFiltering()
+{
+
+	renderGuidedFilterMoments();
+	int current = computeGuidedFilterSAT(0);
+
+	GLuint shader = shaderProg[GUIDED_FILTER_COEFFICIENTS_SHADER];
+	glUseProgram(shader);
+	glUniform1i(glGetUniformLocation(shader, "momentsSAT"), 15);
+	glUniform1i(glGetUniformLocation(shader, "crossMomentSAT"), 14);
+	glUniform1f(glGetUniformLocation(shader, "guidedFilterEpsilon"), guidedFilterEpsilon);
+	glUniform1f(glGetUniformLocation(shader, "guideOffset"), computeGuideOffset());
+	glActiveTexture(GL_TEXTURE15);
+	glBindTexture(GL_TEXTURE_2D, textures[GUIDED_FILTER_MAP_COLOR + 2 * current]);
+	glActiveTexture(GL_TEXTURE14);
+	glBindTexture(GL_TEXTURE_2D, textures[GUIDED_FILTER_MOMENTS_MAP_COLOR + 2 * current]);
+	glActiveTexture(GL_TEXTURE0);
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[GUIDED_FILTER_FRAMEBUFFER + 1 - current]);
+	displaySceneFromGBuffer(shader);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	current = computeGuidedFilterSAT(1 - current);
+
+	shader = shaderProg[GUIDED_SHADOW_FILTERING_SHADER];
+	glUseProgram(shader);
+	glUniform1i(glGetUniformLocation(shader, "coefficientsSAT"), 15);
+	glUniform1i(glGetUniformLocation(shader, "countSAT"), 14);
+	glUniform1f(glGetUniformLocation(shader, "guideOffset"), computeGuideOffset());
+	glActiveTexture(GL_TEXTURE15);
+	glBindTexture(GL_TEXTURE_2D, textures[GUIDED_FILTER_MAP_COLOR + 2 * current]);
+	glActiveTexture(GL_TEXTURE14);
+	glBindTexture(GL_TEXTURE_2D, textures[GUIDED_FILTER_MOMENTS_MAP_COLOR + 2 * current]);
+	glActiveTexture(GL_TEXTURE0);
+	glClearColor(0.0f, 0.0f, 0.0f, 1.0);
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[SOFT_SHADOW_FRAMEBUFFER]);
+	displaySceneFromGBuffer(shader);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	glActiveTexture(GL_TEXTURE14);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glActiveTexture(GL_TEXTURE15);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glActiveTexture(GL_TEXTURE0);
+
+}
+
+void renderScreenSpaceSoftShadows()
+{
+	
+	myGLTextureViewer.setShaderProg(shaderProg[CLEAR_IMAGE_SHADER]);
+	myGLTextureViewer.drawTextureOnShader(textures[SHADOW_MAP_COLOR], shadowMapWidth, shadowMapHeight);
+	
+	renderGBuffer();
+	
+	if(!isShadowMapCached(2)) {
+
+		glClearColor(0.0f, 0.0f, 0.0f, 1.0);
+		glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[SHADOW_FRAMEBUFFER]);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		displaySceneFromLightPOV();
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		if(shadowParams.useHierarchicalShadowMap) renderHSM();
+
+	}
+	
+	//SSEDTSSM renders its hard shadows along with the EDT sites
+	if(!shadowParams.SSEDTSSM) {
+		glClearColor(0.0f, 0.0f, 0.0f, 1.0);
+		glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[HARD_SHADOW_FRAMEBUFFER]);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		if(shadowParams.SSRBSSM) displaySceneFromGBuffer(shaderProg[RSMSS_SHADER]);
+		else displaySceneFromGBuffer(shaderProg[HARD_SHADOW_SHADER]);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	}
+	
+	if(shadowParams.SSEDTSSM) {
+
+		renderEDTSites();
+		computeEDT();
+
+	} else {
+
+		if(shadowParams.SSPCSS || shadowParams.SSSM) {
+		
+			shadowParams.useHardShadowMap = true;
+			glClearColor(0.0f, 0.0f, 0.0f, 1.0);
+			glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[PARTIAL_BLOCKER_SEARCH_MAP_FRAMEBUFFER]);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			displaySceneFromGBuffer(shaderProg[PARTIAL_BLOCKER_SEARCH_SHADER]);
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+			shadowParams.useHardShadowMap = false;
+	
+		}
+
+		glClearColor(0.0f, 0.0f, 0.0f, 1.0);
+		if(shadowParams.SSPCSS || shadowParams.SSSM) {
+			shadowParams.usePartialAverageBlockerDepthMap = true;
+			glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[HARD_SHADOW_FRAMEBUFFER]);
+		} else {
+			shadowParams.useHardShadowMap = true;
+			glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[PARTIAL_BLOCKER_SEARCH_MAP_FRAMEBUFFER]);
+		}
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		glUseProgram(shaderProg[PARTIAL_SHADOW_FILTERING_SHADER]);
+		glUniform1i(glGetUniformLocation(shaderProg[PARTIAL_SHADOW_FILTERING_SHADER], "guidedFilter"), guidedFilter);
+		displaySceneFromGBuffer(shaderProg[PARTIAL_SHADOW_FILTERING_SHADER]);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		if(shadowParams.SSPCSS || shadowParams.SSSM) shadowParams.usePartialAverageBlockerDepthMap = false;
+		else shadowParams.useHardShadowMap = false;
+	
+		if(shadowParams.SSPCSS || shadowParams.SSSM) shadowParams.useHardShadowMap = true;
+		else shadowParams.usePartialAverageBlockerDepthMap = true;	
+		if(guidedFilter) {
+			renderGuidedShadowFiltering();
+		} else {
+			glClearColor(0.0f, 0.0f, 0.0f, 1.0);
+			glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[SOFT_SHADOW_FRAMEBUFFER]);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			displaySceneFromGBuffer(getSoftShadowProgram(SCREEN_SPACE_SOFT_SHADOW_SHADER));
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		}
+		if(shadowParams.SSPCSS || shadowParams.SSSM) shadowParams.useHardShadowMap = false;
+		else shadowParams.usePartialAverageBlockerDepthMap = false;
+
+	}
+
+	glDisable(GL_CULL_FACE);
+	glDisable(GL_POLYGON_OFFSET_FILL);
+	
+}
+
+void deferredShading()
+{
+	
+	shadowParams.useSoftShadowMap = true;
+	fullResolutionPass = (visibilityDownsampling > 1);
+	glClearColor(0.63f, 0.82f, 0.96f, 1.0);
+	displaySceneFromGBuffer(shaderProg[PHONG_SHADING_SHADER]);
+	shadowParams.useSoftShadowMap = false;
+	fullResolutionPass = false;
+
+}
+
+int getRenderTargetUsage()
+{
+
+	int usage = 0;
+	if(shadowParams.SSPCSS || shadowParams.SSABSS || shadowParams.SSSM || shadowParams.SSRBSSM || shadowParams.SSEDTSSM) usage |= 1;
+	if(shadowParams.adaptiveSampling) usage |= 2;
+	if(shadowParams.EDTSSM || shadowParams.SSEDTSSM) usage |= 4;
+	if(shadowParams.progressiveMonteCarlo) usage |= 8;
+	if(shadowParams.streamingMonteCarlo) usage |= 16;
+	if(shadowParams.tiledAdaptiveSampling) usage |= 32;
+	if(visibilityDownsampling > 1) usage |= 64;
+	if(fitLightFrustum || cascadedSoftShadows) usage |= 128;
+	if(guidedFilter && (usage & 1) && !shadowParams.SSEDTSSM) usage |= 256;
+	if(shadowParams.MSSM && shadowParams.compactMoments) usage |= 512;
+	if(shadowParams.SAT && shadowParams.integerSAT && (shadowParams.SAVSM || shadowParams.VSSM)) usage |= 1024;
+	if((usage & 4) && getDistanceTransform() != PBA_DISTANCE_TRANSFORM) usage |= 2048;
+	return usage;
+
+}
+
+void attachRenderTargets()
+{
+
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[SHADOW_FRAMEBUFFER]);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, textures[SHADOW_MAP_DEPTH], 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[SHADOW_MAP_COLOR], 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[TEMP_SHADOW_FRAMEBUFFER]);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, textures[TEMP_SHADOW_MAP_DEPTH], 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[TEMP_SHADOW_MAP_COLOR], 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[SAT_SHADOW_FRAMEBUFFER]);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, textures[SAT_SHADOW_MAP_DEPTH], 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[SAT_SHADOW_MAP_COLOR], 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[SOFT_SHADOW_FRAMEBUFFER]);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, textures[SOFT_SHADOW_MAP_DEPTH], 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[SOFT_SHADOW_MAP_COLOR], 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[VISIBILITY_ACCUMULATION_FRAMEBUFFER]);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[VISIBILITY_ACCUMULATION_MAP_COLOR], 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[TILE_CLASSIFICATION_FRAMEBUFFER]);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[TILE_CLASSIFICATION_MAP_COLOR], 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[HARD_SHADOW_FRAMEBUFFER]);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, textures[HARD_SHADOW_MAP_DEPTH], 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[HARD_SHADOW_MAP_COLOR], 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[GBUFFER_FRAMEBUFFER]);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, textures[GBUFFER_MAP_DEPTH], 0);
+	GLenum bufs[3];
+	bufs[0] = GL_COLOR_ATTACHMENT0;
+	bufs[1] = GL_COLOR_ATTACHMENT1;
+	bufs[2] = GL_COLOR_ATTACHMENT2;
+	if(packedGBuffer) {
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[NORMAL_MAP_COLOR], 0);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, textures[TEXTURE_MAP_COLOR], 0);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, 0, 0);
+		glDrawBuffers(2,bufs);
+	} else {
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[VERTEX_MAP_COLOR], 0);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, textures[NORMAL_MAP_COLOR], 0);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, textures[TEXTURE_MAP_COLOR], 0);
+		glDrawBuffers(3,bufs);
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[FULL_GBUFFER_FRAMEBUFFER]);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, textures[FULL_GBUFFER_MAP_DEPTH], 0);
+	if(packedGBuffer) {
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[FULL_NORMAL_MAP_COLOR], 0);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, textures[FULL_TEXTURE_MAP_COLOR], 0);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, 0, 0);
+		glDrawBuffers(2,bufs);
+	} else {
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[FULL_VERTEX_MAP_COLOR], 0);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, textures[FULL_NORMAL_MAP_COLOR], 0);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, textures[FULL_TEXTURE_MAP_COLOR], 0);
+		glDrawBuffers(3,bufs);
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[UPSAMPLED_SOFT_SHADOW_FRAMEBUFFER]);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, textures[UPSAMPLED_SOFT_SHADOW_MAP_DEPTH], 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[UPSAMPLED_SOFT_SHADOW_MAP_COLOR], 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[LIGHT_FRUSTUM_FRAMEBUFFER]);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[LIGHT_FRUSTUM_MAP_COLOR], 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[GUIDED_FILTER_FRAMEBUFFER]);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[GUIDED_FILTER_MAP_COLOR], 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, textures[GUIDED_FILTER_MOMENTS_MAP_COLOR], 0);
+	glDrawBuffers(2, bufs);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[TEMP_GUIDED_FILTER_FRAMEBUFFER]);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[TEMP_GUIDED_FILTER_MAP_COLOR], 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, textures[TEMP_GUIDED_FILTER_MOMENTS_MAP_COLOR], 0);
+	glDrawBuffers(2, bufs);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[INTEGER_SAT_FRAMEBUFFER]);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[INTEGER_SAT_SHADOW_MAP_COLOR], 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[TEMP_INTEGER_SAT_FRAMEBUFFER]);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[TEMP_INTEGER_SAT_SHADOW_MAP_COLOR], 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[JUMP_FLOODING_FRAMEBUFFER]);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[JUMP_FLOODING_MAP_COLOR], 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[TEMP_JUMP_FLOODING_FRAMEBUFFER]);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[TEMP_JUMP_FLOODING_MAP_COLOR], 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[JUMP_FLOODING_EDT_FRAMEBUFFER]);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[JUMP_FLOODING_EDT_MAP_COLOR], 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[PARTIAL_BLOCKER_SEARCH_MAP_FRAMEBUFFER]);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, textures[PARTIAL_BLOCKER_SEARCH_MAP_DEPTH], 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[PARTIAL_BLOCKER_SEARCH_MAP_COLOR], 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[QUAD_TREE_REPROJECTION_FRAMEBUFFER]);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, textures[QUAD_TREE_REPROJECTION_DEPTH], 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[QUAD_TREE_REPROJECTION_COLOR], 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, textures[TEMP_VISIBILITY_MAP_COLOR], 0);
+	glDrawBuffers(2,bufs);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[VISIBILITY_FRAMEBUFFER]);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, textures[VISIBILITY_MAP_DEPTH], 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[VISIBILITY_MAP_COLOR], 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[CUDA_FRAMEBUFFER]);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, textures[CUDA_MAP_DEPTH], 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[CUDA_MAP_COLOR], 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, textures[CUDA_POSITION_MAP_COLOR], 0);
+	GLenum CUDABufferTemp[2];
+	CUDABufferTemp[0] = GL_COLOR_ATTACHMENT0;
+	CUDABufferTemp[1] = GL_COLOR_ATTACHMENT1;
+	glDrawBuffers(2, CUDABufferTemp);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[HISTORY_FRAMEBUFFER]);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, textures[HISTORY_MAP_DEPTH], 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[HISTORY_MAP_COLOR], 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, textures[SOFT_SHADOW_MAP_COLOR], 0);
+	glDrawBuffers(2, bufs);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+}
+
+void allocateRenderTargets()
+{
+
+	int usage = getRenderTargetUsage();
+
+	//the internal resolution is kept a multiple of 16, as the EDT kernels work on 16x16 bands. With visibility 
+	//downsampling every technique runs at the reduced size and only the G-buffer is also kept at the full one
+	fullWindowWidth = ((int)(displayWidth * resolutionScale) / 16) * 16;
+	fullWindowHeight = ((int)(displayHeight * resolutionScale) / 16) * 16;
+	windowWidth = ((int)(displayWidth * resolutionScale / visibilityDownsampling) / 16) * 16;
+	windowHeight = ((int)(displayHeight * resolutionScale / visibilityDownsampling) / 16) * 16;
+	if(fullWindowWidth < 16) fullWindowWidth = 16;
+	if(fullWindowHeight < 16) fullWindowHeight = 16;
+	//the SAT and the HSM halve the shadow map level by level, so it is only scaled down by powers of two
+	int shadowMapDivisor = 1;
+	while(shadowMapDivisor * 2 * resolutionScale <= 1.0f) shadowMapDivisor *= 2;
+	shadowMapWidth = fullShadowMapWidth / shadowMapDivisor;
+	shadowMapHeight = fullShadowMapHeight / shadowMapDivisor;
+	if(windowWidth < 16) windowWidth = 16;
+	if(windowHeight < 16) windowHeight = 16;
+	if(shadowMapWidth < 16) shadowMapWidth = 16;
+	if(shadowMapHeight < 16) shadowMapHeight = 16;
+	shadowParams.windowWidth = windowWidth;
+	shadowParams.windowHeight = windowHeight;
+	shadowParams.shadowMapWidth = shadowMapWidth;
+	shadowParams.shadowMapHeight = shadowMapHeight;
+
+	//the quantized MSSM moments lie in [0, 1] and fit a UNORM map of half the size. The SAT built from them stays in float
+	renderTargetPool.declare(SHADOW_MAP_COLOR, (usage & 512) ? GL_RGBA16 : GL_RGBA32F, shadowMapWidth, shadowMapHeight, GL_LINEAR_MIPMAP_LINEAR, false);
+	renderTargetPool.declare(TEMP_SHADOW_MAP_COLOR, GL_RGBA32F, shadowMapWidth, shadowMapHeight, GL_LINEAR_MIPMAP_LINEAR, false);
+	renderTargetPool.declare(SAT_SHADOW_MAP_COLOR, GL_RGBA32F, shadowMapWidth, shadowMapHeight, GL_LINEAR_MIPMAP_LINEAR, false);
+	renderTargetPool.declare(HIERARCHICAL_SHADOW_MAP_COLOR, GL_RGBA32F, shadowMapWidth, shadowMapHeight, GL_LINEAR_MIPMAP_LINEAR, false);
+	renderTargetPool.declare(SOFT_SHADOW_MAP_COLOR, GL_RGBA32F, windowWidth, windowHeight, GL_LINEAR_MIPMAP_LINEAR, false);
+	renderTargetPool.declare(HARD_SHADOW_MAP_COLOR, GL_RGBA32F, windowWidth, windowHeight, GL_NEAREST_MIPMAP_NEAREST, false);
+	//the packed G-buffer keeps 12 bytes per pixel (depth, RG16 normal, RGBA8 albedo and flags) instead of 52
+	renderTargetPool.declare(VERTEX_MAP_COLOR, GL_RGBA32F, windowWidth, windowHeight, GL_NEAREST, false);
+	renderTargetPool.declare(NORMAL_MAP_COLOR, (packedGBuffer) ? GL_RG16 : GL_RGBA32F, windowWidth, windowHeight, GL_NEAREST, false);
+	renderTargetPool.declare(TEXTURE_MAP_COLOR, (packedGBuffer) ? GL_RGBA8 : GL_RGBA32F, windowWidth, windowHeight, GL_NEAREST, false);
+	renderTargetPool.declare(PARTIAL_BLOCKER_SEARCH_MAP_COLOR, GL_RGBA32F, windowWidth, windowHeight, GL_NEAREST, false);
+	renderTargetPool.declare(QUAD_TREE_REPROJECTION_COLOR, GL_RGBA32F, windowWidth, windowHeight, GL_NEAREST, false);
+	renderTargetPool.declare(TEMP_VISIBILITY_MAP_COLOR, GL_RGBA32F, windowWidth, windowHeight, GL_NEAREST, false);
+	renderTargetPool.declare(VISIBILITY_MAP_COLOR, GL_RGBA32F, windowWidth, windowHeight, GL_NEAREST, false);
+	renderTargetPool.declare(CUDA_MAP_COLOR, GL_RGBA32F, windowWidth, windowHeight, GL_NEAREST, false);
+	renderTargetPool.declare(CUDA_POSITION_MAP_COLOR, GL_RGBA32F, windowWidth, windowHeight, GL_NEAREST, false);
+	renderTargetPool.declare(HISTORY_MAP_COLOR, GL_RGBA32F, windowWidth, windowHeight, GL_NEAREST, false);
+	renderTargetPool.declare(TEMP_HISTORY_MAP_COLOR, GL_RGBA32F, windowWidth, windowHeight, GL_NEAREST, false);
+	//half floats keep 11 significant bits, enough for the rounding of up to 8 batches to stay below the 8-bit display step
+	renderTargetPool.declare(VISIBILITY_ACCUMULATION_MAP_COLOR, (streamingBatchSize * 8 >= streamingNumberOfSamples) ? GL_R16F : GL_R32F, 
+		windowWidth, windowHeight, GL_NEAREST, false);
+	//the internal resolution is a multiple of the tile size, so mip level 4 holds one texel per 16x16 tile
+	renderTargetPool.declare(TILE_CLASSIFICATION_MAP_COLOR, GL_R32F, windowWidth, windowHeight, GL_NEAREST, false);
+	renderTargetPool.declare(FULL_VERTEX_MAP_COLOR, GL_RGBA32F, fullWindowWidth, fullWindowHeight, GL_NEAREST, false);
+	renderTargetPool.declare(FULL_NORMAL_MAP_COLOR, (packedGBuffer) ? GL_RG16 : GL_RGBA32F, fullWindowWidth, fullWindowHeight, GL_NEAREST, false);
+	renderTargetPool.declare(FULL_TEXTURE_MAP_COLOR, (packedGBuffer) ? GL_RGBA8 : GL_RGBA32F, fullWindowWidth, fullWindowHeight, GL_NEAREST, false);
+	renderTargetPool.declare(UPSAMPLED_SOFT_SHADOW_MAP_COLOR, GL_RGBA32F, fullWindowWidth, fullWindowHeight, GL_LINEAR, false);
+	renderTargetPool.declare(LIGHT_FRUSTUM_MAP_COLOR, GL_RGBA32F, windowWidth / 16, windowHeight / 16, GL_NEAREST, false);
+	//the summed-area tables of the guided filter hold sums over the whole image, so they need full floats
+	//the guided filter tables are fixed point, see GuidedFilterFixedPoint.glsl
+	renderTargetPool.declare(GUIDED_FILTER_MAP_COLOR, GL_RGBA32UI, windowWidth, windowHeight, GL_NEAREST, false);
+	renderTargetPool.declare(GUIDED_FILTER_MOMENTS_MAP_COLOR, GL_RGBA32UI, windowWidth, windowHeight, GL_NEAREST, false);
+	renderTargetPool.declare(TEMP_GUIDED_FILTER_MAP_COLOR, GL_RGBA32UI, windowWidth, windowHeight, GL_NEAREST, false);
+	renderTargetPool.declare(TEMP_GUIDED_FILTER_MOMENTS_MAP_COLOR, GL_RGBA32UI, windowWidth, windowHeight, GL_NEAREST, false);
+	//the fixed-point tables only hold the two SAVSM/VSSM moments, and have no mip chain
+	renderTargetPool.declare(INTEGER_SAT_SHADOW_MAP_COLOR, GL_RG32UI, shadowMapWidth, shadowMapHeight, GL_NEAREST, false);
+	renderTargetPool.declare(TEMP_INTEGER_SAT_SHADOW_MAP_COLOR, GL_RG32UI, shadowMapWidth, shadowMapHeight, GL_NEAREST, false);
+	//the jump flooding seeds are texel coordinates, exact in a float up to 2^24
+	renderTargetPool.declare(JUMP_FLOODING_MAP_COLOR, GL_RG32F, windowWidth, windowHeight, GL_NEAREST, false);
+	renderTargetPool.declare(TEMP_JUMP_FLOODING_MAP_COLOR, GL_RG32F, windowWidth, windowHeight, GL_NEAREST, false);
+	renderTargetPool.declare(JUMP_FLOODING_EDT_MAP_COLOR, GL_RGBA32F, windowWidth, windowHeight, GL_NEAREST, false);
+
+	//depth attachments that are cleared and only tested within a single pass alias one texture per size
+	renderTargetPool.declare(SHADOW_MAP_DEPTH, GL_DEPTH_COMPONENT32F_NV, shadowMapWidth, shadowMapHeight, GL_NEAREST, false);
+	renderTargetPool.declare(TEMP_SHADOW_MAP_DEPTH, GL_DEPTH_COMPONENT32F_NV, shadowMapWidth, shadowMapHeight, GL_NEAREST, true);
+	renderTargetPool.declare(SAT_SHADOW_MAP_DEPTH, GL_DEPTH_COMPONENT32F_NV, shadowMapWidth, shadowMapHeight, GL_NEAREST, true);
+	renderTargetPool.declare(HIERARCHICAL_SHADOW_MAP_DEPTH, GL_DEPTH_COMPONENT32F_NV, shadowMapWidth, shadowMapHeight, GL_NEAREST, true);
+	renderTargetPool.declare(GBUFFER_MAP_DEPTH, GL_DEPTH_COMPONENT32F_NV, windowWidth, windowHeight, GL_NEAREST, false);
+	renderTargetPool.declare(SOFT_SHADOW_MAP_DEPTH, GL_DEPTH_COMPONENT32F_NV, windowWidth, windowHeight, GL_NEAREST, true);
+	renderTargetPool.declare(HARD_SHADOW_MAP_DEPTH, GL_DEPTH_COMPONENT32F_NV, windowWidth, windowHeight, GL_NEAREST, true);
+	renderTargetPool.declare(PARTIAL_BLOCKER_SEARCH_MAP_DEPTH, GL_DEPTH_COMPONENT32F_NV, windowWidth, windowHeight, GL_NEAREST, true);
+	renderTargetPool.declare(QUAD_TREE_REPROJECTION_DEPTH, GL_DEPTH_COMPONENT32F_NV, windowWidth, windowHeight, GL_NEAREST, true);
+	renderTargetPool.declare(VISIBILITY_MAP_DEPTH, GL_DEPTH_COMPONENT32F_NV, windowWidth, windowHeight, GL_NEAREST, true);
+	renderTargetPool.declare(CUDA_MAP_DEPTH, GL_DEPTH_COMPONENT32F_NV, windowWidth, windowHeight, GL_NEAREST, true);
+	renderTargetPool.declare(HISTORY_MAP_DEPTH, GL_DEPTH_COMPONENT32F_NV, windowWidth, windowHeight, GL_NEAREST, true);
+	renderTargetPool.declare(FULL_GBUFFER_MAP_DEPTH, GL_DEPTH_COMPONENT32F_NV, fullWindowWidth, fullWindowHeight, GL_NEAREST, false);
+	renderTargetPool.declare(UPSAMPLED_SOFT_SHADOW_MAP_DEPTH, GL_DEPTH_COMPONENT32F_NV, fullWindowWidth, fullWindowHeight, GL_NEAREST, true);
+
+	//targets of techniques that are not selected are given back first, so the selected ones can take over their textures
+	bool used[JUMP_FLOODING_EDT_MAP_COLOR + 1];
+	for(int slot = 0; slot <= JUMP_FLOODING_EDT_MAP_COLOR; slot++) used[slot] = true;
+	used[PARTIAL_BLOCKER_SEARCH_MAP_COLOR] = used[PARTIAL_BLOCKER_SEARCH_MAP_DEPTH] = (usage & 1) != 0;
+	used[QUAD_TREE_REPROJECTION_COLOR] = used[QUAD_TREE_REPROJECTION_DEPTH] = (usage & 2) != 0;
+	used[TEMP_VISIBILITY_MAP_COLOR] = used[VISIBILITY_MAP_COLOR] = used[VISIBILITY_MAP_DEPTH] = (usage & 2) != 0;
+	used[CUDA_MAP_COLOR] = used[CUDA_POSITION_MAP_COLOR] = used[CUDA_MAP_DEPTH] = (usage & 4) != 0;
+	used[HISTORY_MAP_COLOR] = used[TEMP_HISTORY_MAP_COLOR] = used[HISTORY_MAP_DEPTH] = (usage & 8) != 0;
+	used[VERTEX_MAP_COLOR] = !packedGBuffer;
+	used[VISIBILITY_ACCUMULATION_MAP_COLOR] = (usage & 16) != 0;
+	used[SOFT_SHADOW_MAP_COLOR] = (usage & 16) == 0;
+	used[TILE_CLASSIFICATION_MAP_COLOR] = (usage & 32) != 0;
+	used[FULL_GBUFFER_MAP_DEPTH] = used[FULL_NORMAL_MAP_COLOR] = used[FULL_TEXTURE_MAP_COLOR] = (usage & 64) != 0;
+	used[FULL_VERTEX_MAP_COLOR] = (usage & 64) != 0 && !packedGBuffer;
+	used[UPSAMPLED_SOFT_SHADOW_MAP_COLOR] = used[UPSAMPLED_SOFT_SHADOW_MAP_DEPTH] = (usage & 64) != 0;
+	used[LIGHT_FRUSTUM_MAP_COLOR] = (usage & 128) != 0;
+	used[GUIDED_FILTER_MAP_COLOR] = used[GUIDED_FILTER_MOMENTS_MAP_COLOR] = (usage & 256) != 0;
+	used[TEMP_GUIDED_FILTER_MAP_COLOR] = used[TEMP_GUIDED_FILTER_MOMENTS_MAP_COLOR] = (usage & 256) != 0;
+	used[INTEGER_SAT_SHADOW_MAP_COLOR] = used[TEMP_INTEGER_SAT_SHADOW_MAP_COLOR] = (usage & 1024) != 0;
+	used[JUMP_FLOODING_MAP_COLOR] = used[TEMP_JUMP_FLOODING_MAP_COLOR] = used[JUMP_FLOODING_EDT_MAP_COLOR] = (usage & 2048) != 0;
+
+	for(int slot = 0; slot <= JUMP_FLOODING_EDT_MAP_COLOR; slot++) {
+		if(!used[slot]) {
+			renderTargetPool.release(slot);
+			textures[slot] = 0;
+		}
+	}
+	for(int slot = 0; slot <= JUMP_FLOODING_EDT_MAP_COLOR; slot++)
+		if(used[slot])
+			textures[slot] = renderTargetPool.acquire(slot);
+
+	//CUDA keeps its own reference to the EDT targets, so it must let go of them before they are deleted or replaced
+	if(CUDATextures[0] != 0 && (CUDATextures[0] != textures[CUDA_MAP_COLOR] || CUDATextures[1] != textures[CUDA_POSITION_MAP_COLOR])) {
+		cudaGraphicsUnregisterResource(CUDAGraphicsResource[0]);
+		cudaGraphicsUnregisterResource(CUDAGraphicsResource[1]);
+		CUDATextures[0] = CUDATextures[1] = 0;
+	}
+	renderTargetPool.trim();
+	//the jump flooding reads the EDT targets in GLSL, they are only registered once PBA is selected
+	if((usage & 4) && !(usage & 2048) && CUDATextures[0] == 0) {
+		cudaGraphicsGLRegisterImage( &CUDAGraphicsResource[0], textures[CUDA_MAP_COLOR], GL_TEXTURE_2D, 0);
+		cudaGraphicsGLRegisterImage( &CUDAGraphicsResource[1], textures[CUDA_POSITION_MAP_COLOR], GL_TEXTURE_2D, 0);
+		CUDATextures[0] = textures[CUDA_MAP_COLOR];
+		CUDATextures[1] = textures[CUDA_POSITION_MAP_COLOR];
 	}
+
+	//texture arrays have immutable storage, so a new size needs a new texture name
+	//the streaming path only keeps the ring of layers of one batch resident
+	int shadowMapLayers = (usage & 16) ? streamingBatchSize : 289;
+	if(shadowMapWidth != allocatedShadowMapWidth || shadowMapHeight != allocatedShadowMapHeight || shadowMapLayers != allocatedShadowMapLayers) {
+		glDeleteTextures(1, &textureArray[0]);
+		glGenTextures(1, &textureArray[0]);
+		myGLTextureViewer.createDepthComponentTextureArray(textureArray, 0, shadowMapWidth, shadowMapHeight, shadowMapLayers);
+	}
+	if(windowWidth != allocatedWindowWidth || windowHeight != allocatedWindowHeight) {
+		glDeleteTextures(1, &textureArray[1]);
+		glGenTextures(1, &textureArray[1]);
+		myGLTextureViewer.createRGBATextureArray(textureArray, 1, windowWidth, windowHeight, 50);
+		if(allocatedWindowWidth > 0)
+			pba2DDeinitialization();
+		pba2DInitialization(windowWidth, windowHeight);
+		int numberOfTiles = (windowWidth / 16) * (windowHeight / 16);
+		tileLevels = (int*)realloc(tileLevels, numberOfTiles * sizeof(int));
+		activeTiles = (int*)realloc(activeTiles, numberOfTiles * sizeof(int));
+		tileFlags = (float*)realloc(tileFlags, numberOfTiles * sizeof(float));
+	}
+	
+	attachRenderTargets();
+
+	//the cached light-space maps and the accumulated history may live in textures that were just replaced
+	shadowMapCache.invalidate();
+	historyCache.invalidate();
+
+	allocatedRenderTargetUsage = usage;
+	allocatedWindowWidth = windowWidth;
+	allocatedWindowHeight = windowHeight;
+	allocatedShadowMapWidth = shadowMapWidth;
+	allocatedShadowMapHeight = shadowMapHeight;
+	allocatedShadowMapLayers = shadowMapLayers;
+	renderTargetsDirty = false;
+
+	printf("Render targets: %dx%d, shadow map %dx%d, %.1f MB allocated, %.1f MB saved by aliasing\n", windowWidth, windowHeight, shadowMapWidth, 
+		shadowMapHeight, renderTargetPool.getAllocatedBytes() / 1048576.0, renderTargetPool.getSavedBytes() / 1048576.0);
+
+}
+
+void updateResolutionScale()
+{
+
+	int time = glutGet(GLUT_ELAPSED_TIME);
+	float frameTime = (float)(time - lastFrameTime);
+	lastFrameTime = time;
 	
+	if(!dynamicResolution)
+		return;
+
+	accumulatedFrameTime += frameTime;
+	accumulatedFrameCount++;
+	if(accumulatedFrameCount < 30)
+		return;
+
+	float averageFrameTime = accumulatedFrameTime / accumulatedFrameCount;
+	accumulatedFrameTime = 0.0;
+	accumulatedFrameCount = 0;
+
+	//the band around the budget keeps the scale from oscillating between two neighbouring levels
+	if(averageFrameTime > frameTimeBudget * 1.1f && resolutionScale > 0.5f) {
+		resolutionScale -= 0.125f;
+		renderTargetsDirty = true;
+	} else if(averageFrameTime < frameTimeBudget * 0.75f && resolutionScale < 1.0f) {
+		resolutionScale += 0.125f;
+		renderTargetsDirty = true;
+	}
+	if(renderTargetsDirty)
+		printf("Dynamic resolution: %f ms per frame, scale %f\n", averageFrameTime, resolutionScale);
+
+}
+
+float computeVisibilityError(float *visibility, float *reference, int size)
+{
+
+	double error = 0.0;
+	int numberOfPixels = 0;
+
+	for(int pixel = 0; pixel < size; pixel++) {
+		if(reference[pixel] > 0.0f || visibility[pixel] > 0.0f) {
+			error += (visibility[pixel] - reference[pixel]) * (visibility[pixel] - reference[pixel]);
+			numberOfPixels++;
+		}
+	}
+
+	return (numberOfPixels > 0) ? (float)sqrt(error / numberOfPixels) : 0.0f;
+
+}
+
+void benchmarkLightSampling()
+{
+
+	const char *patternNames[5] = {"Regular Grid", "Stratified", "Halton", "Sobol", "Blue Noise"};
+	const int referenceNumberOfSamples = 4096;
+	UniformSampledLightSource *previousLightSource = streamingLightSource;
+	int previousNumberOfSamples = streamingNumberOfSamples;
+
+	//the reference count also selects the 32-bit accumulation buffer for the whole run
+	streamingNumberOfSamples = referenceNumberOfSamples;
+	allocateRenderTargets();
+
+	float *reference = (float*)malloc(windowWidth * windowHeight * sizeof(float));
+	float *visibility = (float*)malloc(windowWidth * windowHeight * sizeof(float));
+
+	streamingLightSource = new UniformSampledLightSource(previousLightSource, referenceNumberOfSamples, STRATIFIED_SAMPLING);
+	renderStreamingMonteCarlo();
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[VISIBILITY_ACCUMULATION_FRAMEBUFFER]);
+	glReadPixels(0, 0, windowWidth, windowHeight, GL_RED, GL_FLOAT, reference);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	delete streamingLightSource;
+
+	printf("RMS visibility error against %d stratified samples\n", referenceNumberOfSamples);
+	printf("%-14s", "Samples");
+	for(int numberOfSamples = 4; numberOfSamples <= 1024; numberOfSamples *= 2)
+		printf("%10d", numberOfSamples);
+	printf("\n");
+
+	for(int samplingPattern = REGULAR_GRID_SAMPLING; samplingPattern <= BLUE_NOISE_SAMPLING; samplingPattern++) {
+
+		printf("%-14s", patternNames[samplingPattern]);
+		for(int numberOfSamples = 4; numberOfSamples <= 1024; numberOfSamples *= 2) {
+
+			streamingLightSource = new UniformSampledLightSource(previousLightSource, numberOfSamples, samplingPattern);
+			renderStreamingMonteCarlo();
+			glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[VISIBILITY_ACCUMULATION_FRAMEBUFFER]);
+			glReadPixels(0, 0, windowWidth, windowHeight, GL_RED, GL_FLOAT, visibility);
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+			delete streamingLightSource;
+
+			printf("%10.5f", computeVisibilityError(visibility, reference, windowWidth * windowHeight));
+
+		}
+		printf("\n");
+
+	}
+
+	free(reference);
+	free(visibility);
+	streamingLightSource = previousLightSource;
+	streamingNumberOfSamples = previousNumberOfSamples;
+	renderTargetsDirty = true;
+
+}
+
+void validateComputePCSS()
+{
+
+	if(!shadowParams.PCSS || !GLEW_VERSION_4_3) {
+		printf("Compute PCSS validation needs PCSS and OpenGL 4.3\n");
+		return;
+	}
+
+	bool previousComputePCSS = computePCSS;
+	bool previousPenumbraClassification = shadowParams.penumbraClassification;
+	float *reference = (float*)malloc(windowWidth * windowHeight * sizeof(float));
+	float *visibility = (float*)malloc(windowWidth * windowHeight * sizeof(float));
+
+	shadowParams.penumbraClassification = false;
+	computePCSS = false;
+	renderSoftShadows();
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[SOFT_SHADOW_FRAMEBUFFER]);
+	glReadPixels(0, 0, windowWidth, windowHeight, GL_RED, GL_FLOAT, reference);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	computePCSS = true;
+	renderSoftShadows();
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[SOFT_SHADOW_FRAMEBUFFER]);
+	glReadPixels(0, 0, windowWidth, windowHeight, GL_RED, GL_FLOAT, visibility);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	//a tap that lands on the other side of a texel edge changes the result by one kernel weight, anything larger is a mismatch
+	float tolerance = (1.0f - shadowParams.shadowIntensity) / (shadowParams.kernelSize * shadowParams.kernelSize) + 0.0001f;
+	float maxError = 0.0;
+	int mismatches = 0;
+	for(int pixel = 0; pixel < windowWidth * windowHeight; pixel++) {
+		float error = fabs(visibility[pixel] - reference[pixel]);
+		if(error > maxError) maxError = error;
+		if(error > tolerance) mismatches++;
+	}
+	printf("Compute PCSS: RMS error %f, max error %f, %d pixels above the tolerance %f\n", computeVisibilityError(visibility, reference, windowWidth * windowHeight), maxError,
+		mismatches, tolerance);
+
+	free(reference);
+	free(visibility);
+	computePCSS = previousComputePCSS;
+	shadowParams.penumbraClassification = previousPenumbraClassification;
+
+}
+
+void renderFullResolutionGBuffer()
+{
+
+	fullResolutionPass = true;
+	glClearColor(0.0f, 0.0f, 0.0f, 1.0);
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[FULL_GBUFFER_FRAMEBUFFER]);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	displaySceneFromCameraPOV(shaderProg[GBUFFER_SHADER]);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	fullResolutionPass = false;
+
+}
+
+//Upsamples the visibility of the reduced resolution with the full resolution G-buffer as guide. Edge pixels are 
+//evaluated again at full resolution through the depth mask when the technique is a single pass over the G-buffer
+void upsampleVisibility()
+{
+
+	GLuint lowResolutionVisibilityMap = (shadowParams.streamingMonteCarlo) ? textures[VISIBILITY_ACCUMULATION_MAP_COLOR] : 
+		textures[SOFT_SHADOW_MAP_COLOR];
+	GLuint edgeShader = 0;
+	bool singlePass = !(shadowParams.streamingMonteCarlo || shadowParams.tiledAdaptiveSampling || shadowParams.progressiveMonteCarlo || 
+		shadowParams.adaptiveSampling || shadowParams.SSPCSS || shadowParams.SSABSS || shadowParams.SSSM || shadowParams.SSRBSSM || 
+		shadowParams.SSEDTSSM || shadowParams.EDTSSM);
+	if(singlePass && shadowParams.monteCarlo) edgeShader = getSoftShadowProgram(ACCURATE_SOFT_SHADOW_SHADER);
+	else if(singlePass && shadowParams.RBSSM) edgeShader = shaderProg[RBSSM_SHADER];
+	else if(singlePass && (shadowParams.PCSS || shadowParams.SAVSM || shadowParams.VSSM || shadowParams.ESSM || shadowParams.MSSM))
+		edgeShader = getSoftShadowProgram(PLAUSIBLE_SOFT_SHADOW_SHADER);
+
+	renderFullResolutionGBuffer();
+	fullResolutionPass = true;
+
+	glActiveTexture(GL_TEXTURE15);
+	glBindTexture(GL_TEXTURE_2D, lowResolutionVisibilityMap);
+	glActiveTexture(GL_TEXTURE0);
+	glUseProgram(shaderProg[JOINT_BILATERAL_UPSAMPLING_SHADER]);
+	glUniform1i(glGetUniformLocation(shaderProg[JOINT_BILATERAL_UPSAMPLING_SHADER], "lowResolutionVisibilityMap"), 15);
+	glUniform2f(glGetUniformLocation(shaderProg[JOINT_BILATERAL_UPSAMPLING_SHADER], "lowResolutionSize"), (float)windowWidth, (float)windowHeight);
+	glUniform1i(glGetUniformLocation(shaderProg[JOINT_BILATERAL_UPSAMPLING_SHADER], "reevaluateEdges"), edgeShader != 0);
+
+	glClearColor(0.0f, 0.0f, 0.0f, 1.0);
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[UPSAMPLED_SOFT_SHADOW_FRAMEBUFFER]);
+	displaySceneFromGBuffer(shaderProg[JOINT_BILATERAL_UPSAMPLING_SHADER]);
+
+	upsamplingEdgePixels = 0;
+	if(edgeShader != 0) {
+		penumbraMaskActive = true;
+		glDepthFunc(GL_LESS);
+		glDepthMask(GL_FALSE);
+		glBeginQuery(GL_SAMPLES_PASSED, queryObject[0]);
+		displaySceneFromGBuffer(edgeShader);
+		glEndQuery(GL_SAMPLES_PASSED);
+		glGetQueryObjectuiv(queryObject[0], GL_QUERY_RESULT, &upsamplingEdgePixels);
+		glDepthMask(GL_TRUE);
+		penumbraMaskActive = false;
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	glActiveTexture(GL_TEXTURE15);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glActiveTexture(GL_TEXTURE0);
+	fullResolutionPass = false;
+
+}
+
+void renderVisibility()
+{
+
+	if(shadowParams.streamingMonteCarlo)
+		renderStreamingMonteCarlo();
+	else if(shadowParams.tiledAdaptiveSampling)
+		renderTiledAdaptiveSampling();
+	else if(shadowParams.progressiveMonteCarlo)
+		renderProgressiveMonteCarlo();
+	else if(shadowParams.monteCarlo)
+		renderMonteCarlo();
+	else if(shadowParams.adaptiveSampling)
+		renderAdaptiveLightSourceSampling();
+	else if(shadowParams.SSPCSS || shadowParams.SSABSS || shadowParams.SSSM || shadowParams.SSRBSSM || shadowParams.SSEDTSSM)
+		renderScreenSpaceSoftShadows();
+	else 
+		renderSoftShadows();
+
+	if(visibilityDownsampling > 1)
+		upsampleVisibility();
+
+}
+
+//Frame time of the visibility passes and error of the upsampled visibility against the full resolution one, 
+//for each downsampling factor of the current technique
+void benchmarkVisibilityDownsampling()
+{
+
+	const int numberOfFrames = 16;
+	int previousDownsampling = visibilityDownsampling;
+	float *reference = NULL;
+	float *visibility = NULL;
+
+	printf("%-14s%14s%14s%14s%14s\n", "Downsampling", "Time (ms)", "RMS error", "Max error", "Re-evaluated");
+	for(int downsampling = 1; downsampling <= 4; downsampling *= 2) {
+
+		visibilityDownsampling = downsampling;
+		allocateRenderTargets();
+
+		glFinish();
+		int startTime = glutGet(GLUT_ELAPSED_TIME);
+		for(int frame = 0; frame < numberOfFrames; frame++)
+			renderVisibility();
+		glFinish();
+		float frameTime = (float)(glutGet(GLUT_ELAPSED_TIME) - startTime) / numberOfFrames;
+
+		int size = fullWindowWidth * fullWindowHeight;
+		float *target = (downsampling == 1) ? reference : visibility;
+		if(target == NULL) {
+			target = (float*)malloc(size * sizeof(float));
+			if(downsampling == 1) reference = target;
+			else visibility = target;
+		}
+		if(downsampling > 1)
+			glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[UPSAMPLED_SOFT_SHADOW_FRAMEBUFFER]);
+		else if(shadowParams.streamingMonteCarlo)
+			glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[VISIBILITY_ACCUMULATION_FRAMEBUFFER]);
+		else
+			glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[SOFT_SHADOW_FRAMEBUFFER]);
+		glReadPixels(0, 0, fullWindowWidth, fullWindowHeight, GL_RED, GL_FLOAT, target);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		if(downsampling == 1) {
+			printf("%-14s%14f%14s%14s%14s\n", "1/1", frameTime, "-", "-", "-");
+		} else {
+			float maxError = 0.0;
+			for(int pixel = 0; pixel < size; pixel++)
+				if(fabs(visibility[pixel] - reference[pixel]) > maxError) maxError = fabs(visibility[pixel] - reference[pixel]);
+			char factor[8];
+			sprintf(factor, "1/%d", downsampling);
+			printf("%-14s%14f%14f%14f%13f%%\n", factor, frameTime, computeVisibilityError(visibility, reference, size), maxError, 
+				100.0f * upsamplingEdgePixels / size);
+		}
+
+	}
+
+	free(reference);
+	free(visibility);
+	visibilityDownsampling = previousDownsampling;
+	renderTargetsDirty = true;
+
+}
+
+//Error of the default and the fitted light frustum at decreasing shadow map sizes, against the fitted frustum at
+//twice the configured size. Reports the smallest fitted size that matches the error of the default frustum
+void benchmarkLightFrustum()
+{
+
+	if(shadowParams.streamingMonteCarlo || shadowParams.tiledAdaptiveSampling || shadowParams.progressiveMonteCarlo || shadowParams.monteCarlo || 
+		shadowParams.adaptiveSampling || shadowParams.SSPCSS || shadowParams.SSABSS || shadowParams.SSSM || shadowParams.SSRBSSM || 
+		shadowParams.SSEDTSSM || shadowParams.EDTSSM) {
+		printf("Light frustum fitting is only used by the plausible soft shadow techniques and RBSSM\n");
+		return;
+	}
+
+	int previousShadowMapWidth = fullShadowMapWidth;
+	int previousShadowMapHeight = fullShadowMapHeight;
+	bool previousFitLightFrustum = fitLightFrustum;
+	float *reference = (float*)malloc(windowWidth * windowHeight * sizeof(float));
+	float *visibility = (float*)malloc(windowWidth * windowHeight * sizeof(float));
+
+	fitLightFrustum = true;
+	fullShadowMapWidth = previousShadowMapWidth * 2;
+	fullShadowMapHeight = previousShadowMapHeight * 2;
+	allocateRenderTargets();
+	renderSoftShadows();
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[SOFT_SHADOW_FRAMEBUFFER]);
+	glReadPixels(0, 0, windowWidth, windowHeight, GL_RED, GL_FLOAT, reference);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	printf("%-14s%-10s%14s\n", "Shadow map", "Frustum", "RMS error");
+	float defaultError = 0.0;
+	int smallestWidth = 0, smallestHeight = 0;
+	for(int run = 0; run < 4; run++) {
+
+		//the first run keeps the default frustum at the configured size, the others fit it at 1, 1/2 and 1/4 of it
+		int divisor = (run == 0) ? 1 : 1 << (run - 1);
+		fitLightFrustum = (run > 0);
+		fullShadowMapWidth = previousShadowMapWidth / divisor;
+		fullShadowMapHeight = previousShadowMapHeight / divisor;
+		allocateRenderTargets();
+		renderSoftShadows();
+		glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[SOFT_SHADOW_FRAMEBUFFER]);
+		glReadPixels(0, 0, windowWidth, windowHeight, GL_RED, GL_FLOAT, visibility);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		float error = computeVisibilityError(visibility, reference, windowWidth * windowHeight);
+		if(run == 0) defaultError = error;
+		else if(error <= defaultError) {
+			smallestWidth = shadowMapWidth;
+			smallestHeight = shadowMapHeight;
+		}
+		char size[32];
+		sprintf(size, "%dx%d", shadowMapWidth, shadowMapHeight);
+		printf("%-14s%-10s%14f\n", size, (fitLightFrustum) ? "Fitted" : "Default", error);
+
+	}
+
+	if(smallestWidth > 0)
+		printf("Fitted %dx%d shadow map matches the default %dx%d one\n", smallestWidth, smallestHeight, previousShadowMapWidth, previousShadowMapHeight);
+	else
+		printf("No fitted shadow map size matches the default frustum error\n");
+
+	free(reference);
+	free(visibility);
+	fullShadowMapWidth = previousShadowMapWidth;
+	fullShadowMapHeight = previousShadowMapHeight;
+	fitLightFrustum = previousFitLightFrustum;
+	renderTargetsDirty = true;
+
+}
+
+//Time of the screen-space soft shadows with the separable bilateral filter and the guided filter for growing kernel sizes,
+//then error and time of the GPU guided filter against the CPU reference of Filter::guidedFilter at the current kernel size
+void benchmarkEdgeAwareFiltering()
+{
+
+	if(!(shadowParams.SSPCSS || shadowParams.SSABSS || shadowParams.SSSM || shadowParams.SSRBSSM)) {
+		printf("Edge-aware filtering is only used by SSPCSS, SSABSS, SSSM and SSRBSSM\n");
+		return;
+	}
+
+	const int numberOfFrames = 16;
+	int previousKernelSize = shadowParams.kernelSize;
+	bool previousGuidedFilter = guidedFilter;
+
+	printf("%-14s%16s%16s\n", "Kernel size", "Bilateral (ms)", "Guided (ms)");
+	for(int kernelSize = 7; kernelSize <= 127; kernelSize = kernelSize * 2 + 1) {
+
+		float frameTime[2];
+		shadowParams.kernelSize = kernelSize;
+		for(int filter = 0; filter < 2; filter++) {
+
+			guidedFilter = (filter == 1);
+			allocateRenderTargets();
+			renderScreenSpaceSoftShadows();
+			glFinish();
+			int startTime = glutGet(GLUT_ELAPSED_TIME);
+			for(int frame = 0; frame < numberOfFrames; frame++)
+				renderScreenSpaceSoftShadows();
+			glFinish();
+			frameTime[filter] = (float)(glutGet(GLUT_ELAPSED_TIME) - startTime) / numberOfFrames;
+
+		}
+		printf("%-14d%16f%16f\n", kernelSize, frameTime[0], frameTime[1]);
+
+	}
+
+	shadowParams.kernelSize = previousKernelSize;
+	guidedFilter = true;
+	allocateRenderTargets();
+	renderScreenSpaceSoftShadows();
+
+	int size = windowWidth * windowHeight;
+	float *filterInput = (float*)malloc(size * 4 * sizeof(float));
+	unsigned int *moments = (unsigned int*)malloc(size * 4 * sizeof(unsigned int));
+	float *input = (float*)malloc(size * sizeof(float));
+	float *guide = (float*)malloc(size * sizeof(float));
+	float *radius = (float*)malloc(size * 2 * sizeof(float));
+	float *reference = (float*)malloc(size * sizeof(float));
+	float *visibility = (float*)malloc(size * sizeof(float));
+
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[SOFT_SHADOW_FRAMEBUFFER]);
+	glReadPixels(0, 0, windowWidth, windowHeight, GL_RED, GL_FLOAT, visibility);
+	if(shadowParams.SSPCSS || shadowParams.SSSM)
+		glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[HARD_SHADOW_FRAMEBUFFER]);
+	else
+		glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[PARTIAL_BLOCKER_SEARCH_MAP_FRAMEBUFFER]);
+	glReadPixels(0, 0, windowWidth, windowHeight, GL_RGBA, GL_FLOAT, filterInput);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	//the moments pass is run again to read the guide back, the tables have overwritten it
+	if(shadowParams.SSPCSS || shadowParams.SSSM) shadowParams.useHardShadowMap = true;
+	else shadowParams.usePartialAverageBlockerDepthMap = true;
+	renderGuidedFilterMoments();
+	shadowParams.useHardShadowMap = shadowParams.usePartialAverageBlockerDepthMap = false;
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[GUIDED_FILTER_FRAMEBUFFER]);
+	glReadPixels(0, 0, windowWidth, windowHeight, GL_RGBA_INTEGER, GL_UNSIGNED_INT, moments);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	//the guide is the first 64-bit fixed-point value of the moments, with 24 fractional bits
+	for(int pixel = 0; pixel < size; pixel++) {
+		long long fixedPointGuide = (long long)(((unsigned long long)moments[pixel * 4 + 1] << 32) | moments[pixel * 4]);
+		input[pixel] = filterInput[pixel * 4];
+		guide[pixel] = (float)((double)fixedPointGuide / 16777216.0);
+		radius[pixel * 2] = filterInput[pixel * 4 + 1] * windowWidth;
+		radius[pixel * 2 + 1] = filterInput[pixel * 4 + 1] * windowHeight;
+	}
+
+	int startTime = glutGet(GLUT_ELAPSED_TIME);
+	bilateralFilter->guidedFilter(input, guide, radius, reference, windowWidth, windowHeight, guidedFilterEpsilon);
+	float referenceTime = (float)(glutGet(GLUT_ELAPSED_TIME) - startTime);
+
+	//same ranges as GuidedShadowFiltering.frag
+	float maxError = 0.0;
+	for(int pixel = 0; pixel < size; pixel++) {
+		float stepSize = 2.0f * filterInput[pixel * 4 + 1] / shadowParams.kernelSize;
+		if(input[pixel] <= 0.0f) reference[pixel] = shadowParams.shadowIntensity;
+		else if(stepSize <= 0.0f || stepSize >= 1.0f) reference[pixel] = 1.0f;
+		else reference[pixel] = glm::clamp(reference[pixel], shadowParams.shadowIntensity, 1.0f);
+		if(fabs(visibility[pixel] - reference[pixel]) > maxError) maxError = fabs(visibility[pixel] - reference[pixel]);
+	}
+	printf("CPU guided filter: %f ms, GPU RMS error %f, max error %f\n", referenceTime, computeVisibilityError(visibility, reference, size), maxError);
+
+	free(filterInput);
+	free(moments);
+	free(input);
+	free(guide);
+	free(radius);
+	free(reference);
+	free(visibility);
+	guidedFilter = previousGuidedFilter;
+	renderTargetsDirty = true;
+
+}
+
+//Time of the full and the bounded EDT, with the pass that renders their sites, at 1080p and 4K and the visibility error of
+//the bounded one. The CPU versions are run on the same sites to check that the bounded diagram is exact within the radius
+void benchmarkBoundedEDT()
+{
+
+	if(!(shadowParams.EDTSSM || shadowParams.SSEDTSSM)) {
+		printf("The Euclidean distance transform is only used by EDTSSM and SSEDTSSM\n");
+		return;
+	}
+
+	const int numberOfFrames = 16;
+	const int resolutions[2][2] = {{1920, 1080}, {3840, 2160}};
+	int previousDisplayWidth = displayWidth;
+	int previousDisplayHeight = displayHeight;
+	float previousResolutionScale = resolutionScale;
+	int previousDownsampling = visibilityDownsampling;
+	bool previousBoundedEDT = boundedEDT;
+	int previousDistanceTransform = getDistanceTransform();
+
+	//the bounded diagram is a mode of the PBA
+	distanceTransformMethod[(shadowParams.SSEDTSSM) ? 1 : 0] = PBA_DISTANCE_TRANSFORM;
+	resolutionScale = 1.0;
+	visibilityDownsampling = 1;
+	printf("Radius: %d pixels\n", boundedEDTRadius);
+	printf("%-12s%12s%14s%14s%12s%12s%12s%14s%12s\n", "Resolution", "Full (ms)", "Bounded (ms)", "Active tiles", "RMS error", "Max error", 
+		"CPU full", "CPU bounded", "Mismatches");
+	for(int resolution = 0; resolution < 2; resolution++) {
+
+		displayWidth = resolutions[resolution][0];
+		displayHeight = resolutions[resolution][1];
+		allocateRenderTargets();
+		renderVisibility();
+
+		int size = windowWidth * windowHeight;
+		float *visibility[2];
+		float frameTime[2];
+		for(int bounded = 0; bounded < 2; bounded++) {
+
+			boundedEDT = (bounded == 1);
+			renderEDTSites();
+			computeEDT();
+			glFinish();
+			int startTime = glutGet(GLUT_ELAPSED_TIME);
+			for(int frame = 0; frame < numberOfFrames; frame++) {
+				renderEDTSites();
+				computeEDT();
+			}
+			glFinish();
+			frameTime[bounded] = (float)(glutGet(GLUT_ELAPSED_TIME) - startTime) / numberOfFrames;
+
+			visibility[bounded] = (float*)malloc(size * sizeof(float));
+			glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[HARD_SHADOW_FRAMEBUFFER]);
+			glReadPixels(0, 0, windowWidth, windowHeight, GL_RED, GL_FLOAT, visibility[bounded]);
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		}
+		int activeTiles = pba2DCountActiveTiles();
+
+		float maxError = 0.0;
+		for(int pixel = 0; pixel < size; pixel++)
+			if(fabs(visibility[1][pixel] - visibility[0][pixel]) > maxError) maxError = fabs(visibility[1][pixel] - visibility[0][pixel]);
+
+		//sites are marked as in initializeInput
+		renderEDTSites();
+		float *image = (float*)malloc(size * 4 * sizeof(float));
+		short *sites = (short*)malloc(size * 2 * sizeof(short));
+		short *nearestSites = (short*)malloc(size * 2 * sizeof(short));
+		short *boundedNearestSites = (short*)malloc(size * 2 * sizeof(short));
+		glBindTexture(GL_TEXTURE_2D, textures[CUDA_MAP_COLOR]);
+		glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_FLOAT, image);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		for(int pixel = 0; pixel < size; pixel++) {
+			bool site = (image[pixel * 4 + 3] != 0.0f);
+			sites[pixel * 2] = (site) ? pixel % windowWidth : EDT_MARKER;
+			sites[pixel * 2 + 1] = (site) ? pixel / windowWidth : EDT_MARKER;
+		}
+
+		int startTime = glutGet(GLUT_ELAPSED_TIME);
+		distanceTransform->computeEDT(sites, nearestSites, windowWidth, windowHeight);
+		float fullTime = (float)(glutGet(GLUT_ELAPSED_TIME) - startTime);
+		startTime = glutGet(GLUT_ELAPSED_TIME);
+		distanceTransform->computeBoundedEDT(sites, boundedNearestSites, windowWidth, windowHeight, boundedEDTRadius);
+		float boundedTime = (float)(glutGet(GLUT_ELAPSED_TIME) - startTime);
+		int mismatches = distanceTransform->compareBoundedEDT(nearestSites, boundedNearestSites, windowWidth, windowHeight, boundedEDTRadius);
+
+		char name[16];
+		sprintf(name, "%dx%d", windowWidth, windowHeight);
+		printf("%-12s%12f%14f%8d/%-5d%12f%12f%12f%14f%12d\n", name, frameTime[0], frameTime[1], activeTiles, (windowWidth / 16) * (windowHeight / 16), 
+			computeVisibilityError(visibility[1], visibility[0], size), maxError, fullTime, boundedTime, mismatches);
+		if(distanceTransform->getActiveTiles() != activeTiles)
+			printf("CPU and GPU disagree on the active tiles: %d and %d\n", distanceTransform->getActiveTiles(), activeTiles);
+
+		free(visibility[0]);
+		free(visibility[1]);
+		free(image);
+		free(sites);
+		free(nearestSites);
+		free(boundedNearestSites);
+
+	}
+
+	displayWidth = previousDisplayWidth;
+	displayHeight = previousDisplayHeight;
+	resolutionScale = previousResolutionScale;
+	visibilityDownsampling = previousDownsampling;
+	boundedEDT = previousBoundedEDT;
+	distanceTransformMethod[(shadowParams.SSEDTSSM) ? 1 : 0] = previousDistanceTransform;
+	renderTargetsDirty = true;
+
+}
+
+//Time of each distance transform, with the pass that renders the sites, at several resolutions. The nearest sites of the
+//jump flooding are read back and compared with the exact CPU EDT, and its visibility with the one of PBA
+void benchmarkDistanceTransforms()
+{
+
+	if(!(shadowParams.EDTSSM || shadowParams.SSEDTSSM)) {
+		printf("The Euclidean distance transform is only used by EDTSSM and SSEDTSSM\n");
+		return;
+	}
+
+	const int numberOfFrames = 16;
+	const int resolutions[4][2] = {{1280, 720}, {1920, 1080}, {2560, 1440}, {3840, 2160}};
+	int technique = (shadowParams.SSEDTSSM) ? 1 : 0;
+	int previousDisplayWidth = displayWidth;
+	int previousDisplayHeight = displayHeight;
+	float previousResolutionScale = resolutionScale;
+	int previousDownsampling = visibilityDownsampling;
+	int previousDistanceTransform = distanceTransformMethod[technique];
+
+	resolutionScale = 1.0;
+	visibilityDownsampling = 1;
+	printf("%-12s%8s%12s%12s%12s%12s%12s%12s\n", "Resolution", "Method", "GPU (ms)", "Wrong (%)", "Mean error", "Max error", "RMS error", "CPU (ms)");
+	for(int resolution = 0; resolution < 4; resolution++) {
+
+		displayWidth = resolutions[resolution][0];
+		displayHeight = resolutions[resolution][1];
+		int size = 0;
+		float *reference = NULL;
+		float *visibility = NULL;
+		float *seedImage = NULL;
+		short *sites = NULL;
+		short *nearestSites = NULL;
+		short *approximateNearestSites = NULL;
+		char name[16];
+
+		for(int method = PBA_DISTANCE_TRANSFORM; method <= JFA_2_DISTANCE_TRANSFORM; method++) {
+
+			distanceTransformMethod[technique] = method;
+			allocateRenderTargets();
+			renderVisibility();
+
+			if(method == PBA_DISTANCE_TRANSFORM) {
+				size = windowWidth * windowHeight;
+				reference = (float*)malloc(size * sizeof(float));
+				visibility = (float*)malloc(size * sizeof(float));
+				seedImage = (float*)malloc(size * 4 * sizeof(float));
+				sites = (short*)malloc(size * 2 * sizeof(short));
+				nearestSites = (short*)malloc(size * 2 * sizeof(short));
+				approximateNearestSites = (short*)malloc(size * 2 * sizeof(short));
+				sprintf(name, "%dx%d", windowWidth, windowHeight);
+
+				//sites are marked as in initializeInput
+				renderEDTSites();
+				glBindTexture(GL_TEXTURE_2D, textures[CUDA_MAP_COLOR]);
+				glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_FLOAT, seedImage);
+				glBindTexture(GL_TEXTURE_2D, 0);
+				for(int pixel = 0; pixel < size; pixel++) {
+					bool site = (seedImage[pixel * 4 + 3] != 0.0f);
+					sites[pixel * 2] = (site) ? pixel % windowWidth : EDT_MARKER;
+					sites[pixel * 2 + 1] = (site) ? pixel / windowWidth : EDT_MARKER;
+				}
+			}
+
+			renderEDTSites();
+			computeEDT();
+			glFinish();
+			int startTime = glutGet(GLUT_ELAPSED_TIME);
+			for(int frame = 0; frame < numberOfFrames; frame++) {
+				renderEDTSites();
+				computeEDT();
+			}
+			glFinish();
+			float frameTime = (float)(glutGet(GLUT_ELAPSED_TIME) - startTime) / numberOfFrames;
+
+			glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[HARD_SHADOW_FRAMEBUFFER]);
+			glReadPixels(0, 0, windowWidth, windowHeight, GL_RED, GL_FLOAT, (method == PBA_DISTANCE_TRANSFORM) ? reference : visibility);
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+			if(method == PBA_DISTANCE_TRANSFORM) {
+				startTime = glutGet(GLUT_ELAPSED_TIME);
+				distanceTransform->computeEDT(sites, nearestSites, windowWidth, windowHeight);
+				float CPUTime = (float)(glutGet(GLUT_ELAPSED_TIME) - startTime);
+				printf("%-12s%8s%12f%12s%12s%12s%12s%12f\n", name, distanceTransformMethodNames[method], frameTime, "-", "-", "-", "-", CPUTime);
+				continue;
+			}
+
+			glBindTexture(GL_TEXTURE_2D, textures[jumpFloodingSeeds]);
+			glGetTexImage(GL_TEXTURE_2D, 0, GL_RG, GL_FLOAT, seedImage);
+			glBindTexture(GL_TEXTURE_2D, 0);
+			for(int pixel = 0; pixel < size; pixel++) {
+				bool seed = (seedImage[pixel * 2] >= 0.0f);
+				approximateNearestSites[pixel * 2] = (seed) ? (short)seedImage[pixel * 2] : EDT_MARKER;
+				approximateNearestSites[pixel * 2 + 1] = (seed) ? (short)seedImage[pixel * 2 + 1] : EDT_MARKER;
+			}
+			float meanError, maxError;
+			int mismatches = distanceTransform->compareEDT(nearestSites, approximateNearestSites, windowWidth, windowHeight, &meanError, &maxError);
+
+			int extraPasses = method - JFA_DISTANCE_TRANSFORM;
+			startTime = glutGet(GLUT_ELAPSED_TIME);
+			distanceTransform->computeJFA(sites, approximateNearestSites, windowWidth, windowHeight, extraPasses);
+			float CPUTime = (float)(glutGet(GLUT_ELAPSED_TIME) - startTime);
+			float CPUMeanError, CPUMaxError;
+			int CPUMismatches = distanceTransform->compareEDT(nearestSites, approximateNearestSites, windowWidth, windowHeight, &CPUMeanError, &CPUMaxError);
+
+			printf("%-12s%8s%12f%12f%12f%12f%12f%12f\n", name, distanceTransformMethodNames[method], frameTime, 100.0f * mismatches / size, meanError, maxError, 
+				computeVisibilityError(visibility, reference, size), CPUTime);
+			if(CPUMismatches != mismatches)
+				printf("CPU %s: %d wrong pixels, mean error %f, max error %f\n", distanceTransformMethodNames[method], CPUMismatches, CPUMeanError, CPUMaxError);
+
+		}
+
+		free(reference);
+		free(visibility);
+		free(seedImage);
+		free(sites);
+		free(nearestSites);
+		free(approximateNearestSites);
+
+	}
+
+	displayWidth = previousDisplayWidth;
+	displayHeight = previousDisplayHeight;
+	resolutionScale = previousResolutionScale;
+	visibilityDownsampling = previousDownsampling;
+	distanceTransformMethod[technique] = previousDistanceTransform;
+	renderTargetsDirty = true;
+
+}
+
+//Size, time and visibility error of MSSM with the moments stored in 16-bit UNORM against 32-bit float, with and without the SAT.
+//The moments of both storages are also read back to bound the quantization error
+void benchmarkMomentStorage()
+{
+
+	if(!shadowParams.MSSM) {
+		printf("Compact moment storage is only used by MSSM\n");
+		return;
+	}
+
+	const int numberOfFrames = 16;
+	bool previousCompactMoments = shadowParams.compactMoments;
+	bool previousSAT = shadowParams.SAT;
+	bool previousShadowMapCache = shadowMapCache.isEnabled();
+	int size = windowWidth * windowHeight;
+	int shadowMapSize = shadowMapWidth * shadowMapHeight;
+	float *reference = (float*)malloc(size * sizeof(float));
+	float *visibility = (float*)malloc(size * sizeof(float));
+	float *referenceMoments = (float*)malloc(shadowMapSize * 4 * sizeof(float));
+	float *moments = (float*)malloc(shadowMapSize * 4 * sizeof(float));
+
+	//the moments are rendered every frame, so the timings include writing them
+	shadowMapCache.setEnabled(false);
+	float maxMomentError = 0.0;
+	printf("%-6s%-10s%14s%12s%14s%14s\n", "SAT", "Storage", "Moments (MB)", "Time (ms)", "RMS error", "Max error");
+	for(int sat = 0; sat < 2; sat++) {
+
+		shadowParams.SAT = (sat == 1);
+		for(int storage = 0; storage < 2; storage++) {
+
+			shadowParams.compactMoments = (storage == 1);
+			allocateRenderTargets();
+			renderSoftShadows();
+			glFinish();
+			int startTime = glutGet(GLUT_ELAPSED_TIME);
+			for(int frame = 0; frame < numberOfFrames; frame++)
+				renderSoftShadows();
+			glFinish();
+			float frameTime = (float)(glutGet(GLUT_ELAPSED_TIME) - startTime) / numberOfFrames;
+
+			glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[SOFT_SHADOW_FRAMEBUFFER]);
+			glReadPixels(0, 0, windowWidth, windowHeight, GL_RED, GL_FLOAT, (storage == 0) ? reference : visibility);
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+			glBindTexture(GL_TEXTURE_2D, textures[SHADOW_MAP_COLOR]);
+			glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_FLOAT, (storage == 0) ? referenceMoments : moments);
+			glBindTexture(GL_TEXTURE_2D, 0);
+
+			float error = 0.0, maxError = 0.0;
+			if(storage == 1) {
+				error = computeVisibilityError(visibility, reference, size);
+				for(int pixel = 0; pixel < size; pixel++)
+					if(fabs(visibility[pixel] - reference[pixel]) > maxError) maxError = fabs(visibility[pixel] - reference[pixel]);
+				for(int moment = 0; moment < shadowMapSize * 4; moment++)
+					if(fabs(moments[moment] - referenceMoments[moment]) > maxMomentError) maxMomentError = fabs(moments[moment] - referenceMoments[moment]);
+			}
+			float megabytes = (shadowMapSize * ((storage == 1) ? 8.0f : 16.0f) * 4.0f / 3.0f) / 1048576.0f;
+			printf("%-6s%-10s%14f%12f%14f%14f\n", (sat == 1) ? "On" : "Off", (storage == 1) ? "16-bit" : "32-bit", megabytes, frameTime, error, maxError);
+
+		}
+
+	}
+	printf("Largest moment quantization error: %e (half a 16-bit step is %e)\n", maxMomentError, 0.5 / 65535.0);
+
+	free(reference);
+	free(visibility);
+	free(referenceMoments);
+	free(moments);
+	shadowMapCache.setEnabled(previousShadowMapCache);
+	shadowParams.compactMoments = previousCompactMoments;
+	shadowParams.SAT = previousSAT;
+	renderTargetsDirty = true;
+
 }
 
-void renderScreenSpaceSoftShadows()
+float fetchFloatSAT(float *table, int width, int x, int y, int channel)
 {
-	
-	myGLTextureViewer.setShaderProg(shaderProg[CLEAR_IMAGE_SHADER]);
-	myGLTextureViewer.drawTextureOnShader(textures[SHADOW_MAP_COLOR], shadowMapWidth, shadowMapHeight);
-	
-	glClearColor(0.0f, 0.0f, 0.0f, 1.0);
-	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[GBUFFER_FRAMEBUFFER]);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	displaySceneFromCameraPOV(shaderProg[GBUFFER_SHADER]);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-	
-	glClearColor(0.0f, 0.0f, 0.0f, 1.0);
-	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[SHADOW_FRAMEBUFFER]);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	displaySceneFromLightPOV();
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-	if(shadowParams.useHierarchicalShadowMap) renderHSM();
-	
-	glClearColor(0.0f, 0.0f, 0.0f, 1.0);
-	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[HARD_SHADOW_FRAMEBUFFER]);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	if(shadowParams.SSRBSSM) displaySceneFromGBuffer(shaderProg[RSMSS_SHADER]);
-	else if(shadowParams.SSEDTSSM) displaySceneFromGBuffer(shaderProg[SMSR_SHADER]);
-	else displaySceneFromGBuffer(shaderProg[HARD_SHADOW_SHADER]);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-	
-	if(shadowParams.SSEDTSSM) {
+	if(x < 0 || y < 0) return 0.0f;
+	return table[(y * width + x) * 4 + channel];
 
-		shadowParams.useHardShadowMap = true;
-		glClearColor(0.0f, 0.0f, 0.0f, 1.0);
-		glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[CUDA_FRAMEBUFFER]);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-		displaySceneFromGBuffer(shaderProg[SCREEN_SPACE_PENUMBRA_SIZE_ESTIMATION_SHADER]);
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
-		shadowParams.useHardShadowMap = false;
+}
 
-		computeEDT();
+//Box sum of the two moments from an RGBA float table read back from the GPU, in float as in PlausibleSoftShadow.frag
+void computeFloatBoxSum(float *table, int width, int *lower, int *upper, float *sum)
+{
 
-	} else {
+	for(int channel = 0; channel < 2; channel++)
+		sum[channel] = fetchFloatSAT(table, width, upper[0], upper[1], channel) + fetchFloatSAT(table, width, lower[0] - 1, lower[1] - 1, channel) - 
+			fetchFloatSAT(table, width, upper[0], lower[1] - 1, channel) - fetchFloatSAT(table, width, lower[0] - 1, upper[1], channel);
 
-		if(shadowParams.SSPCSS || shadowParams.SSSM) {
-		
-			shadowParams.useHardShadowMap = true;
-			glClearColor(0.0f, 0.0f, 0.0f, 1.0);
-			glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[PARTIAL_BLOCKER_SEARCH_MAP_FRAMEBUFFER]);
-			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-			displaySceneFromGBuffer(shaderProg[PARTIAL_BLOCKER_SEARCH_SHADER]);
-			glBindFramebuffer(GL_FRAMEBUFFER, 0);
-			shadowParams.useHardShadowMap = false;
-	
-		}
+}
+
+//Memory, build time and accuracy of the float and the fixed-point summed-area tables for growing shadow map sizes. Windows of 
+//65x65 texels spread over the map are averaged from each table and compared with the moments summed in double precision, and the
+//GPU fixed-point table is compared texel by texel with Filter::computeFixedPointSAT. A size is usable while the largest error 
+//stays below maxUsableError
+void benchmarkIntegerSAT()
+{
+
+	if(!(shadowParams.SAVSM || shadowParams.VSSM)) {
+		printf("The integer summed-area table is only used by SAVSM and VSSM\n");
+		return;
+	}
+
+	const int numberOfFrames = 16;
+	const int windowRadius = 32;
+	const float maxUsableError = 0.0001f;
+	int previousShadowMapWidth = fullShadowMapWidth;
+	int previousShadowMapHeight = fullShadowMapHeight;
+	bool previousSAT = shadowParams.SAT;
+	bool previousIntegerSAT = shadowParams.integerSAT;
+	int usableSize[2] = {0, 0};
+
+	shadowParams.SAT = true;
+	printf("%-12s%-13s%14s%18s%14s%12s\n", "Shadow map", "Table", "Memory (MB)", "Build time (ms)", "Max error", "Mismatches");
+	for(int size = 512; size <= 4096; size *= 2) {
+
+		for(int table = 0; table < 2; table++) {
+
+			shadowParams.integerSAT = (table == 1);
+			fullShadowMapWidth = fullShadowMapHeight = size;
+			allocateRenderTargets();
+			renderSoftShadows();
+
+			glFinish();
+			int startTime = glutGet(GLUT_ELAPSED_TIME);
+			for(int frame = 0; frame < numberOfFrames; frame++) {
+				if(table == 1) computeIntegerShadowMapSAT();
+				else computeShadowMapSAT();
+			}
+			glFinish();
+			float buildTime = (float)(glutGet(GLUT_ELAPSED_TIME) - startTime) / numberOfFrames;
+
+			int texels = shadowMapWidth * shadowMapHeight;
+			float *moments = (float*)malloc(texels * 4 * sizeof(float));
+			float *floatTable = NULL;
+			unsigned int *integerTable = NULL, *referenceTable = NULL;
+			glBindTexture(GL_TEXTURE_2D, textures[SHADOW_MAP_COLOR]);
+			glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_FLOAT, moments);
+			if(table == 1) {
+				integerTable = (unsigned int*)malloc(texels * 2 * sizeof(unsigned int));
+				referenceTable = (unsigned int*)malloc(texels * 2 * sizeof(unsigned int));
+				glBindTexture(GL_TEXTURE_2D, textures[INTEGER_SAT_SHADOW_MAP_COLOR]);
+				glGetTexImage(GL_TEXTURE_2D, 0, GL_RG_INTEGER, GL_UNSIGNED_INT, integerTable);
+				bilateralFilter->computeFixedPointSAT(moments, referenceTable, shadowMapWidth, shadowMapHeight);
+			} else {
+				floatTable = (float*)malloc(texels * 4 * sizeof(float));
+				glBindTexture(GL_TEXTURE_2D, textures[SAT_SHADOW_MAP_COLOR]);
+				glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_FLOAT, floatTable);
+			}
+			glBindTexture(GL_TEXTURE_2D, 0);
+
+			int mismatches = 0;
+			if(table == 1)
+				for(int value = 0; value < texels * 2; value++)
+					if(integerTable[value] != referenceTable[value]) mismatches++;
+
+			float maxError = 0.0;
+			float area = (float)((2 * windowRadius + 1) * (2 * windowRadius + 1));
+			for(int y = windowRadius; y < shadowMapHeight - windowRadius; y += 61) {
+				for(int x = windowRadius; x < shadowMapWidth - windowRadius; x += 61) {
+
+					int lower[2] = {x - windowRadius, y - windowRadius};
+					int upper[2] = {x + windowRadius, y + windowRadius};
+					double reference[2] = {0.0, 0.0};
+					for(int v = lower[1]; v <= upper[1]; v++)
+						for(int u = lower[0]; u <= upper[0]; u++)
+							for(int channel = 0; channel < 2; channel++)
+								reference[channel] += moments[(v * shadowMapWidth + u) * 4 + channel];
+
+					float boxSum[2];
+					if(table == 1) bilateralFilter->computeFixedPointBoxSum(integerTable, shadowMapWidth, lower, upper, boxSum);
+					else computeFloatBoxSum(floatTable, shadowMapWidth, lower, upper, boxSum);
+					for(int channel = 0; channel < 2; channel++)
+						maxError = glm::max(maxError, (float)fabs(boxSum[channel] / area - reference[channel] / area));
+
+				}
+			}
+
+			//both tables are ping-ponged with a second one of the same format, the float ones also carry a mip chain
+			float megabytes = 2.0f * texels * ((table == 1) ? 8.0f : 16.0f * 4.0f / 3.0f) / 1048576.0f;
+			if(maxError <= maxUsableError && mismatches == 0) usableSize[table] = shadowMapWidth;
+			char resolution[32];
+			sprintf(resolution, "%dx%d", shadowMapWidth, shadowMapHeight);
+			printf("%-12s%-13s%14f%18f%14e%12d\n", resolution, (table == 1) ? "Fixed point" : "Float", megabytes, buildTime, maxError, mismatches);
+
+			free(moments);
+			free(floatTable);
+			free(integerTable);
+			free(referenceTable);
 
-		glClearColor(0.0f, 0.0f, 0.0f, 1.0);
-		if(shadowParams.SSPCSS || shadowParams.SSSM) {
-			shadowParams.usePartialAverageBlockerDepthMap = true;
-			glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[HARD_SHADOW_FRAMEBUFFER]);
-		} else {
-			shadowParams.useHardShadowMap = true;
-			glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[PARTIAL_BLOCKER_SEARCH_MAP_FRAMEBUFFER]);
 		}
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-		displaySceneFromGBuffer(shaderProg[PARTIAL_SHADOW_FILTERING_SHADER]);
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
-		if(shadowParams.SSPCSS || shadowParams.SSSM) shadowParams.usePartialAverageBlockerDepthMap = false;
-		else shadowParams.useHardShadowMap = false;
-	
-		if(shadowParams.SSPCSS || shadowParams.SSSM) shadowParams.useHardShadowMap = true;
-		else shadowParams.usePartialAverageBlockerDepthMap = true;	
-		glClearColor(0.0f, 0.0f, 0.0f, 1.0);
-		glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[SOFT_SHADOW_FRAMEBUFFER]);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-		displaySceneFromGBuffer(shaderProg[SCREEN_SPACE_SOFT_SHADOW_SHADER]);
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
-		if(shadowParams.SSPCSS || shadowParams.SSSM) shadowParams.useHardShadowMap = false;
-		else shadowParams.usePartialAverageBlockerDepthMap = false;
 
 	}
+	printf("Largest usable shadow map (max error %g): float %d, fixed point %d\n", maxUsableError, usableSize[0], usableSize[1]);
+
+	fullShadowMapWidth = previousShadowMapWidth;
+	fullShadowMapHeight = previousShadowMapHeight;
+	shadowParams.SAT = previousSAT;
+	shadowParams.integerSAT = previousIntegerSAT;
+	renderTargetsDirty = true;
 
-	glDisable(GL_CULL_FACE);
-	glDisable(GL_POLYGON_OFFSET_FILL);
-	
 }
 
-void deferredShading()
+void compareRBSSMReference()
 {
-	
-	shadowParams.useSoftShadowMap = true;
-	glClearColor(0.63f, 0.82f, 0.96f, 1.0);
-	displaySceneFromGBuffer(shaderProg[PHONG_SHADING_SHADER]);
-	shadowParams.useSoftShadowMap = false;
+
+	if(!shadowParams.RBSSM) {
+		printf("The CPU reference covers RBSSM\n");
+		return;
+	}
+	if(packedGBuffer) {
+		printf("The CPU reference reads the unpacked G-buffer\n");
+		return;
+	}
+
+	bool previousPenumbraClassification = shadowParams.penumbraClassification;
+	int size = windowWidth * windowHeight;
+	float *vertexMap = (float*)malloc(size * 4 * sizeof(float));
+	float *normalMap = (float*)malloc(size * 4 * sizeof(float));
+	float *shadowMap = (float*)malloc(shadowMapWidth * shadowMapHeight * sizeof(float));
+	float *visibility = (float*)malloc(size * sizeof(float));
+	float *reference = (float*)malloc(size * sizeof(float));
+
+	//the penumbra mask leaves the classified pixels out of the RBSSM pass, so the whole image is filtered here
+	shadowParams.penumbraClassification = false;
+	shadowMapCache.invalidate();
+	int time = glutGet(GLUT_ELAPSED_TIME);
+	renderSoftShadows();
+	glFinish();
+	time = glutGet(GLUT_ELAPSED_TIME) - time;
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[SOFT_SHADOW_FRAMEBUFFER]);
+	glReadPixels(0, 0, windowWidth, windowHeight, GL_RED, GL_FLOAT, visibility);
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[GBUFFER_FRAMEBUFFER]);
+	glReadPixels(0, 0, windowWidth, windowHeight, GL_RGBA, GL_FLOAT, vertexMap);
+	glReadBuffer(GL_COLOR_ATTACHMENT1);
+	glReadPixels(0, 0, windowWidth, windowHeight, GL_RGBA, GL_FLOAT, normalMap);
+	glReadBuffer(GL_COLOR_ATTACHMENT0);
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[SHADOW_FRAMEBUFFER]);
+	glReadPixels(0, 0, shadowMapWidth, shadowMapHeight, GL_DEPTH_COMPONENT, GL_FLOAT, shadowMap);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	RBSSMReference rbssmReference;
+	rbssmReference.setGBuffer(vertexMap, normalMap, windowWidth, windowHeight);
+	rbssmReference.setShadowMap(shadowMap, shadowMapWidth, shadowMapHeight);
+	rbssmReference.setCamera(myGLGeometryViewer.getViewMatrix() * myGLGeometryViewer.getModelMatrix(), myGLGeometryViewer.normalMatrix, 
+		lightSource->getEye(), myGLGeometryViewer.zNear, myGLGeometryViewer.zFar);
+	rbssmReference.computeSoftShadows(shadowParams, reference);
+
+	//a tap that takes the other side of a discontinuity changes the result by one kernel weight, anything larger is a mismatch
+	float tolerance = (1.0f - shadowParams.shadowIntensity) / (shadowParams.kernelSize * shadowParams.kernelSize) + 0.0001f;
+	float maxError = 0.0f;
+	int mismatches = 0;
+	for(int pixel = 0; pixel < size; pixel++) {
+		float error = fabs(visibility[pixel] - reference[pixel]);
+		if(error > maxError) maxError = error;
+		if(error > tolerance) mismatches++;
+	}
+	printf("CPU RBSSM (kernel %d, maxSearch %d): %d filtered pixels, %d taps, %d discontinuity searches, GPU frame %d ms\n", shadowParams.kernelSize, 
+		shadowParams.maxSearch, rbssmReference.getNumberOfPixels(), rbssmReference.getNumberOfTaps(), rbssmReference.getNumberOfSearches(), time);
+	printf("Blocker search %f s, discontinuity search %f s, smoothing %f s\n", rbssmReference.getBlockerSearchTime(), 
+		rbssmReference.getDiscontinuitySearchTime(), rbssmReference.getSmoothingTime());
+	printf("RMS error %f, max error %f, %d pixels above the tolerance %f\n", computeVisibilityError(visibility, reference, size), maxError, mismatches, 
+		tolerance);
+
+	free(vertexMap);
+	free(normalMap);
+	free(shadowMap);
+	free(visibility);
+	free(reference);
+	shadowParams.penumbraClassification = previousPenumbraClassification;
 
 }
 
 void display()
 {
 	
-	if(shadowParams.monteCarlo)
-		renderMonteCarlo();
-	else if(shadowParams.adaptiveSampling)
-		renderAdaptiveLightSourceSampling();
-	else if(shadowParams.SSPCSS || shadowParams.SSABSS || shadowParams.SSSM || shadowParams.SSRBSSM || shadowParams.SSEDTSSM)
-		renderScreenSpaceSoftShadows();
-	else 
-		renderSoftShadows();
+	updateResolutionScale();
+	if(renderTargetsDirty || getRenderTargetUsage() != allocatedRenderTargetUsage)
+		allocateRenderTargets();
+
+	if(lightSamplingBenchmark) {
+		benchmarkLightSampling();
+		lightSamplingBenchmark = false;
+		allocateRenderTargets();
+	}
+
+	if(computePCSSValidation) {
+		validateComputePCSS();
+		computePCSSValidation = false;
+	}
+
+	if(lightFrustumBenchmark) {
+		benchmarkLightFrustum();
+		lightFrustumBenchmark = false;
+		allocateRenderTargets();
+	}
+
+	if(edgeAwareFilterBenchmark) {
+		benchmarkEdgeAwareFiltering();
+		edgeAwareFilterBenchmark = false;
+		allocateRenderTargets();
+	}
+
+	if(momentStorageBenchmark) {
+		benchmarkMomentStorage();
+		momentStorageBenchmark = false;
+		allocateRenderTargets();
+	}
+
+	if(integerSATBenchmark) {
+		benchmarkIntegerSAT();
+		integerSATBenchmark = false;
+		allocateRenderTargets();
+	}
+
+	if(RBSSMComparison) {
+		compareRBSSMReference();
+		RBSSMComparison = false;
+	}
+
+	if(boundedEDTBenchmark) {
+		benchmarkBoundedEDT();
+		boundedEDTBenchmark = false;
+		allocateRenderTargets();
+	}
+
+	if(distanceTransformBenchmark) {
+		benchmarkDistanceTransforms();
+		distanceTransformBenchmark = false;
+		allocateRenderTargets();
+	}
+
+	if(visibilityDownsamplingBenchmark) {
+		benchmarkVisibilityDownsampling();
+		visibilityDownsamplingBenchmark = false;
+		allocateRenderTargets();
+	}
 
+	renderVisibility();
 	deferredShading();
 	
 	glutSwapBuffers();
@@ -1203,6 +3753,14 @@ void specialKeyboard(int key, int x, int y)
 			shadowParams.kernelSize += 2;
 		if(changeBlockerSearchSizeOn)
 			shadowParams.blockerSearchSize += 2;
+		if(changeSamplesPerFrameOn && samplesPerFrame < uniformSampledLightSource->getNumberOfPointLights())
+			samplesPerFrame *= 2;
+		if(changeStreamingBatchSizeOn && streamingBatchSize < 64) {
+			streamingBatchSize *= 2;
+			renderTargetsDirty = true;
+		}
+		if(changeStreamingSamplesOn && streamingNumberOfSamples < 16384)
+			changeStreamingSamples(streamingNumberOfSamples * 2);
 		break;
 	case GLUT_KEY_DOWN:
 		if(cameraOn) {
@@ -1230,6 +3788,14 @@ void specialKeyboard(int key, int x, int y)
 			shadowParams.kernelSize -= 2;
 		if(changeBlockerSearchSizeOn)
 			shadowParams.blockerSearchSize -= 2;
+		if(changeSamplesPerFrameOn && samplesPerFrame > 1)
+			samplesPerFrame /= 2;
+		if(changeStreamingBatchSizeOn && streamingBatchSize > 1) {
+			streamingBatchSize /= 2;
+			renderTargetsDirty = true;
+		}
+		if(changeStreamingSamplesOn && streamingNumberOfSamples > 1)
+			changeStreamingSamples(streamingNumberOfSamples / 2);
 		break;
 	case GLUT_KEY_LEFT:
 		if(cameraOn) {
@@ -1318,6 +3884,9 @@ void specialKeyboard(int key, int x, int y)
 void resetShadowParameters() {
 	
 	shadowParams.monteCarlo = false;
+	shadowParams.progressiveMonteCarlo = false;
+	shadowParams.streamingMonteCarlo = false;
+	shadowParams.tiledAdaptiveSampling = false;
 	shadowParams.adaptiveSampling = false;
 	shadowParams.revectorizationBasedAdaptiveSampling = false;
 	shadowParams.adaptiveSamplingLowerAccuracy = false;
@@ -1364,6 +3933,26 @@ void transformationMenu(int id) {
 
 }
 
+void lightSamplingMenu(int id) {
+
+	switch(id) {
+	case 0:
+	case 1:
+	case 2:
+	case 3:
+	case 4:
+		changeLightSampling(id);
+		break;
+	case 5:
+		resetShadowParameters();
+		shadowParams.monteCarlo = true;
+		shadowParams.streamingMonteCarlo = true;
+		lightSamplingBenchmark = true;
+		break;
+	}
+
+}
+
 void otherFunctionsMenu(int id) {
 
 	switch(id)
@@ -1390,6 +3979,54 @@ void otherFunctionsMenu(int id) {
 			printf("Global Translation: %f %f %f\n", translationVector[0], translationVector[1], translationVector[2]);
 			printf("Global Rotation: %f %f %f\n", rotationAngles[0], rotationAngles[1], rotationAngles[2]);
 			break;
+		case 3:
+			shadowMapCache.setEnabled(!shadowMapCache.isEnabled());
+			break;
+		case 4:
+			dynamicResolution = !dynamicResolution;
+			resolutionScale = 1.0;
+			renderTargetsDirty = true;
+			break;
+		case 5:
+			shadowParams.penumbraClassification = !shadowParams.penumbraClassification;
+			break;
+		case 6:
+			useShaderPermutations = !useShaderPermutations;
+			break;
+		case 7:
+			//restarts the FPS interval so the uber-shader measurement holds no permutation frames
+			useShaderPermutations = false;
+			shaderPermutationBenchmark = true;
+			previousTime = glutGet(GLUT_ELAPSED_TIME);
+			frameCount = 0;
+			break;
+		case 8:
+			computePCSS = !computePCSS;
+			if(computePCSS && !GLEW_VERSION_4_3)
+				printf("Compute PCSS needs OpenGL 4.3, the fragment path is used\n");
+			break;
+		case 9:
+			computePCSSValidation = true;
+			break;
+		case 10:
+			visibilityDownsampling = (visibilityDownsampling == 4) ? 1 : visibilityDownsampling * 2;
+			renderTargetsDirty = true;
+			printf("Visibility resolution: 1/%d\n", visibilityDownsampling);
+			break;
+		case 11:
+			visibilityDownsamplingBenchmark = true;
+			break;
+		case 12:
+			fitLightFrustum = !fitLightFrustum;
+			break;
+		case 13:
+			lightFrustumBenchmark = true;
+			break;
+		case 14:
+			cascadedSoftShadows = !cascadedSoftShadows;
+			if(cascadedSoftShadows && !shadowParams.PCSS)
+				printf("Cascaded shadow maps are only used by PCSS, the other techniques keep a single shadow map\n");
+			break;
 	}
 
 }
@@ -1417,6 +4054,23 @@ void accurateSoftShadowMenu(int id) {
 	case 3:
 		shadowParams.adaptiveSamplingLowerAccuracy = true;
 		break;
+	case 4:
+		resetShadowParameters();
+		shadowParams.monteCarlo = true;
+		shadowParams.progressiveMonteCarlo = true;
+		historyCache.invalidate();
+		break;
+	case 5:
+		resetShadowParameters();
+		shadowParams.monteCarlo = true;
+		shadowParams.streamingMonteCarlo = true;
+		break;
+	case 6:
+		resetShadowParameters();
+		shadowParams.monteCarlo = true;
+		shadowParams.tiledAdaptiveSampling = true;
+		shadowParams.numberOfSamples = tiledLightSource->getNumberOfPointLights();
+		break;
 	}
 
 }
@@ -1459,6 +4113,21 @@ void plausibleSoftShadowMenu(int id) {
 		shadowParams.useHierarchicalShadowMap = false;
 		shadowParams.kernelSize = 15;
 		break;
+	case 7:
+		shadowParams.compactMoments = !shadowParams.compactMoments;
+		break;
+	case 8:
+		momentStorageBenchmark = true;
+		break;
+	case 9:
+		shadowParams.integerSAT = !shadowParams.integerSAT;
+		break;
+	case 10:
+		integerSATBenchmark = true;
+		break;
+	case 11:
+		RBSSMComparison = true;
+		break;
 	}
 }
 
@@ -1488,6 +4157,28 @@ void screenSpaceSoftShadowMenu(int id) {
 		resetShadowParameters();
 		shadowParams.SSEDTSSM = true;
 		break;
+	case 5:
+		guidedFilter = !guidedFilter;
+		break;
+	case 6:
+		edgeAwareFilterBenchmark = true;
+		break;
+	case 7:
+		boundedEDT = !boundedEDT;
+		break;
+	case 8:
+		boundedEDTBenchmark = true;
+		break;
+	case 9:
+		if(shadowParams.EDTSSM || shadowParams.SSEDTSSM) {
+			int technique = (shadowParams.SSEDTSSM) ? 1 : 0;
+			distanceTransformMethod[technique] = (distanceTransformMethod[technique] + 1) % 4;
+			printf("Distance transform: %s\n", distanceTransformMethodNames[distanceTransformMethod[technique]]);
+		}
+		break;
+	case 10:
+		distanceTransformBenchmark = true;
+		break;
 	}
 }
 
@@ -1500,6 +4191,20 @@ void softShadowParametersMenu(int id) {
 	case 1:
 		changeBlockerSearchSizeOn = !changeBlockerSearchSizeOn;
 		break;
+	case 2:
+		changeSamplesPerFrameOn = !changeSamplesPerFrameOn;
+		break;
+	case 3:
+		changeStreamingBatchSizeOn = !changeStreamingBatchSizeOn;
+		break;
+	case 4:
+		changeStreamingSamplesOn = !changeStreamingSamplesOn;
+		break;
+	case 5:
+		streamingBenchmark = true;
+		streamingBatchSize = 4;
+		renderTargetsDirty = true;
+		break;
 	}
 		
 }
@@ -1513,13 +4218,16 @@ void mainMenu(int id) {
 void createMenu() {
 
 	GLint accurateSoftShadowMenuID, plausibleSoftShadowMenuID, screenSpaceSoftShadowMenuID;
-	GLint transformationMenuID, softShadowParametersMenuID, otherFunctionsMenuID;
+	GLint transformationMenuID, softShadowParametersMenuID, lightSamplingMenuID, otherFunctionsMenuID;
 
 	accurateSoftShadowMenuID = glutCreateMenu(accurateSoftShadowMenu);
 		glutAddMenuEntry("Monte-Carlo Sampling", 0);
 		glutAddMenuEntry("Adaptive Light Source Sampling", 1);
 		glutAddMenuEntry("Revectorization-Based Adaptive Light Source Sampling", 2);
 		glutAddMenuEntry("Adaptive Light Source Sampling (Lower Accuracy)", 3);
+		glutAddMenuEntry("Progressive Monte-Carlo Sampling", 4);
+		glutAddMenuEntry("Streaming Monte-Carlo Sampling", 5);
+		glutAddMenuEntry("Tiled Adaptive Light Source Sampling", 6);
 		
 	plausibleSoftShadowMenuID = glutCreateMenu(plausibleSoftShadowMenu);
 		glutAddMenuEntry("Percentage-Closer Soft Shadow Mapping", 0);
@@ -1529,6 +4237,11 @@ void createMenu() {
 		glutAddMenuEntry("Moment Soft Shadow Mapping", 4);
 		glutAddMenuEntry("Revectorization-based Soft Shadow Mapping", 5);
 		glutAddMenuEntry("Euclidean Distance Transform Soft Shadow Mapping", 6);
+		glutAddMenuEntry("16-bit Moments [On/Off]", 7);
+		glutAddMenuEntry("Benchmark Moment Storage", 8);
+		glutAddMenuEntry("Integer Summed-Area Table [On/Off]", 9);
+		glutAddMenuEntry("Benchmark Integer Summed-Area Table", 10);
+		glutAddMenuEntry("Compare CPU RBSSM Reference", 11);
 	
 	screenSpaceSoftShadowMenuID = glutCreateMenu(screenSpaceSoftShadowMenu);
 		glutAddMenuEntry("Screen-Space Percentage-Closer Soft Shadow Mapping", 0);
@@ -1536,6 +4249,12 @@ void createMenu() {
 		glutAddMenuEntry("Separable Soft Shadow Mapping", 2);
 		glutAddMenuEntry("Screen-Space Revectorization-based Soft Shadow Mapping", 3);
 		glutAddMenuEntry("Screen-Space Euclidean Distance Transform Soft Shadow Mapping", 4);
+		glutAddMenuEntry("Guided Filter [On/Off]", 5);
+		glutAddMenuEntry("Benchmark Edge-Aware Filtering", 6);
+		glutAddMenuEntry("Bounded Euclidean Distance Transform [On/Off]", 7);
+		glutAddMenuEntry("Benchmark Bounded Euclidean Distance Transform", 8);
+		glutAddMenuEntry("Distance Transform [PBA/JFA/JFA+1/JFA+2]", 9);
+		glutAddMenuEntry("Benchmark Distance Transforms", 10);
 
 	transformationMenuID = glutCreateMenu(transformationMenu);
 		glutAddMenuEntry("Translation", 0);
@@ -1546,17 +4265,42 @@ void createMenu() {
 	softShadowParametersMenuID = glutCreateMenu(softShadowParametersMenu);
 		glutAddMenuEntry("Change Kernel Size", 0);
 		glutAddMenuEntry("Change Blocker Search Size", 1);
+		glutAddMenuEntry("Change Samples Per Frame", 2);
+		glutAddMenuEntry("Change Streaming Batch Size", 3);
+		glutAddMenuEntry("Change Streaming Light Samples", 4);
+		glutAddMenuEntry("Benchmark Streaming Batch Sizes", 5);
+
+	lightSamplingMenuID = glutCreateMenu(lightSamplingMenu);
+		glutAddMenuEntry("Regular Grid", 0);
+		glutAddMenuEntry("Stratified", 1);
+		glutAddMenuEntry("Halton", 2);
+		glutAddMenuEntry("Owen-Scrambled Sobol", 3);
+		glutAddMenuEntry("Blue Noise", 4);
+		glutAddMenuEntry("Benchmark Sampling Error", 5);
 
 	otherFunctionsMenuID = glutCreateMenu(otherFunctionsMenu);
 		glutAddMenuEntry("Animation [On/Off]", 0);
 		glutAddMenuEntry("Shadow Intensity [On/Off]", 1);
 		glutAddMenuEntry("Print Data", 2);
+		glutAddMenuEntry("Shadow Map Cache [On/Off]", 3);
+		glutAddMenuEntry("Dynamic Resolution [On/Off]", 4);
+		glutAddMenuEntry("Penumbra Classification [On/Off]", 5);
+		glutAddMenuEntry("Shader Permutations [On/Off]", 6);
+		glutAddMenuEntry("Benchmark Shader Permutations", 7);
+		glutAddMenuEntry("Compute PCSS [On/Off]", 8);
+		glutAddMenuEntry("Validate Compute PCSS", 9);
+		glutAddMenuEntry("Visibility Resolution [Full/Half/Quarter]", 10);
+		glutAddMenuEntry("Benchmark Visibility Resolution", 11);
+		glutAddMenuEntry("Fit Light Frustum [On/Off]", 12);
+		glutAddMenuEntry("Benchmark Light Frustum", 13);
+		glutAddMenuEntry("Cascaded PCSS [On/Off]", 14);
 		
 	glutCreateMenu(mainMenu);
 		glutAddSubMenu("Accurate Soft Shadow Mapping", accurateSoftShadowMenuID);
 		glutAddSubMenu("Plausible Soft Shadow Mapping", plausibleSoftShadowMenuID);
 		glutAddSubMenu("Screen-Space Soft Shadow Mapping", screenSpaceSoftShadowMenuID);
 		glutAddSubMenu("Soft Shadow Parameters", softShadowParametersMenuID);
+		glutAddSubMenu("Light Source Sampling", lightSamplingMenuID);
 		glutAddSubMenu("Transformation", transformationMenuID);
 		glutAddSubMenu("Other Functions", otherFunctionsMenuID);
 		glutAttachMenu(GLUT_RIGHT_BUTTON);
@@ -1571,10 +4315,8 @@ void initGL(char *configurationFile) {
 
 	if(textureArray[0] == 0)
 		glGenTextures(2, textureArray);
-	if(textures[0] == 0)
-		glGenTextures(30, textures);
 	if(frameBuffer[0] == 0)
-		glGenFramebuffers(20, frameBuffer);
+		glGenFramebuffers(24, frameBuffer);
 	if(sceneVBO[0] == 0)
 		glGenBuffers(5, sceneVBO);
 	if(sceneTextures[0] == 0)
@@ -1582,9 +4324,12 @@ void initGL(char *configurationFile) {
 	if(queryObject[0] == 0)
 		glGenQueries(1, queryObject);
 
+	double loadingTime = cpu_time();
 	scene = new Mesh();
-	sceneLoader = new SceneLoader(configurationFile, scene);
+	sceneLoader = new SceneLoader(configurationFile, scene, compressTextures);
 	sceneLoader->load();
+	geometryVersion++;
+	printf("Scene loaded in %f s (%d of %d textures from cache)\n", cpu_time() - loadingTime, sceneLoader->getNumberOfCachedTextures(), scene->getNumberOfTextures());
 	 
 	float centroid[3];
 	lightSource = new LightSource();
@@ -1597,13 +4342,32 @@ void initGL(char *configurationFile) {
 	lightSource->setUp(glm::vec3(0.0, 0.0, 1.0));
 	lightSource->setSize(16.0);
 	
-	uniformSampledLightSource = new UniformSampledLightSource(lightSource, 289.0);
+	uniformSampledLightSource = new UniformSampledLightSource(lightSource, 289, lightSamplingPattern);
+	streamingLightSource = new UniformSampledLightSource(lightSource, streamingNumberOfSamples, lightSamplingPattern);
 	quadTreeLightSource = new QuadTreeLightSource(lightSource);
+	tiledLightSource = new UniformSampledLightSource(lightSource, 289, REGULAR_GRID_SAMPLING);
+
+	//consecutive frames walk the light samples with a stride coprime to their number, so each subset is spread over the whole area light
+	int numberOfPointLights = uniformSampledLightSource->getNumberOfPointLights();
+	int stride = (int)(numberOfPointLights * 0.618f);
+	while(stride > 1) {
+		int a = numberOfPointLights, b = stride;
+		while(b != 0) { int t = a % b; a = b; b = t; }
+		if(a == 1) break;
+		stride--;
+	}
+	if(stride < 1) stride = 1;
+	for(int sample = 0; sample < numberOfPointLights; sample++)
+		progressiveSampleOrder[sample] = (sample * stride) % numberOfPointLights;
 
 	resetShadowParameters();
 	shadowParams.PCSS = true;
 	shadowParams.useHierarchicalShadowMap = false;
+	shadowParams.penumbraClassification = false;
+	shadowParams.cascadedShadowMaps = false;
 	shadowParams.SAT = false;
+	shadowParams.compactMoments = false;
+	shadowParams.integerSAT = false;
 	shadowParams.shadowMapWidth = shadowMapWidth;
 	shadowParams.shadowMapHeight = shadowMapHeight;
 	shadowParams.windowWidth = windowWidth;
@@ -1618,8 +4382,10 @@ void initGL(char *configurationFile) {
 	shadowParams.depthThreshold = sceneLoader->getDepthThreshold();
 	shadowParams.HSMAlpha = sceneLoader->getHSMAlpha();
 	shadowParams.HSMBeta = sceneLoader->getHSMBeta();
+	shadowParams.lightFrustumScale = 1.0;
 
 	bilateralFilter = new Filter();
+	distanceTransform = new DistanceTransform();
 	bilateralFilter->buildBilateralKernel(shadowParams.kernelSize);
 	bilateralFilter->setSigmaColor(1.0); //SanMiguel 1, sigma 10
 	bilateralFilter->setSigmaSpace(0.001); //SanMiguel 0.001
@@ -1627,121 +4393,31 @@ void initGL(char *configurationFile) {
 	myGLTextureViewer.loadQuad();
 	createMenu();
 
+	double uploadTime = cpu_time();
 	if(scene->textureFromImage())
 		for(int num = 0; num < scene->getNumberOfTextures(); num++)
-			myGLTextureViewer.loadRGBTexture(scene->getTexture()[num]->getData(), sceneTextures, num, scene->getTexture()[num]->getWidth(), scene->getTexture()[num]->getHeight());
-
-	myGLTextureViewer.createDepthComponentTextureArray(textureArray, 0, shadowMapWidth, shadowMapHeight, 289.0);
-	myGLTextureViewer.createRGBATextureArray(textureArray, 1, windowWidth, windowHeight, 50);
-	
-	myGLTextureViewer.loadRGBATexture((float*)NULL, textures, SHADOW_MAP_COLOR, shadowMapWidth, shadowMapHeight);
-	myGLTextureViewer.loadRGBATexture((float*)NULL, textures, TEMP_SHADOW_MAP_COLOR, shadowMapWidth, shadowMapHeight);
-	myGLTextureViewer.loadRGBATexture((float*)NULL, textures, SAT_SHADOW_MAP_COLOR, shadowMapWidth, shadowMapHeight);
-	myGLTextureViewer.loadRGBATexture((float*)NULL, textures, HIERARCHICAL_SHADOW_MAP_COLOR, shadowMapWidth, shadowMapHeight);
-	myGLTextureViewer.loadRGBATexture((float*)NULL, textures, SOFT_SHADOW_MAP_COLOR, windowWidth, windowHeight);
-	myGLTextureViewer.loadRGBATexture((float*)NULL, textures, HARD_SHADOW_MAP_COLOR, windowWidth, windowHeight, GL_NEAREST_MIPMAP_NEAREST);
-	myGLTextureViewer.loadRGBATexture((float*)NULL, textures, VERTEX_MAP_COLOR, windowWidth, windowHeight, GL_NEAREST);
-	myGLTextureViewer.loadRGBATexture((float*)NULL, textures, NORMAL_MAP_COLOR, windowWidth, windowHeight, GL_NEAREST);
-	myGLTextureViewer.loadRGBATexture((float*)NULL, textures, TEXTURE_MAP_COLOR, windowWidth, windowHeight, GL_NEAREST);
-	myGLTextureViewer.loadRGBATexture((float*)NULL, textures, PARTIAL_BLOCKER_SEARCH_MAP_COLOR, windowWidth, windowHeight, GL_NEAREST);
-	myGLTextureViewer.loadRGBATexture((float*)NULL, textures, QUAD_TREE_REPROJECTION_COLOR, windowWidth, windowHeight, GL_NEAREST);
-	myGLTextureViewer.loadRGBATexture((float*)NULL, textures, TEMP_VISIBILITY_MAP_COLOR, windowWidth, windowHeight, GL_NEAREST);
-	myGLTextureViewer.loadRGBATexture((float*)NULL, textures, VISIBILITY_MAP_COLOR, windowWidth, windowHeight, GL_NEAREST);
-	myGLTextureViewer.loadRGBATexture((float*)NULL, textures, CUDA_MAP_COLOR, windowWidth, windowHeight, GL_NEAREST);
-	myGLTextureViewer.loadRGBATexture((float*)NULL, textures, CUDA_POSITION_MAP_COLOR, windowWidth, windowHeight, GL_NEAREST);
-	
-	myGLTextureViewer.loadDepthComponentTexture(NULL, textures, SHADOW_MAP_DEPTH, shadowMapWidth, shadowMapHeight);
-	myGLTextureViewer.loadDepthComponentTexture(NULL, textures, TEMP_SHADOW_MAP_DEPTH, shadowMapWidth, shadowMapHeight);
-	myGLTextureViewer.loadDepthComponentTexture(NULL, textures, SAT_SHADOW_MAP_DEPTH, shadowMapWidth, shadowMapHeight);
-	myGLTextureViewer.loadDepthComponentTexture(NULL, textures, HIERARCHICAL_SHADOW_MAP_DEPTH, shadowMapWidth, shadowMapHeight);
-	myGLTextureViewer.loadDepthComponentTexture(NULL, textures, SOFT_SHADOW_MAP_DEPTH, windowWidth, windowHeight);
-	myGLTextureViewer.loadDepthComponentTexture(NULL, textures, HARD_SHADOW_MAP_DEPTH, windowWidth, windowHeight);
-	myGLTextureViewer.loadDepthComponentTexture(NULL, textures, GBUFFER_MAP_DEPTH, windowWidth, windowHeight);
-	myGLTextureViewer.loadDepthComponentTexture(NULL, textures, PARTIAL_BLOCKER_SEARCH_MAP_DEPTH, windowWidth, windowHeight);
-	myGLTextureViewer.loadDepthComponentTexture(NULL, textures, QUAD_TREE_REPROJECTION_DEPTH, windowWidth, windowHeight);
-	myGLTextureViewer.loadDepthComponentTexture(NULL, textures, VISIBILITY_MAP_DEPTH, windowWidth, windowHeight);
-	myGLTextureViewer.loadDepthComponentTexture(NULL, textures, CUDA_MAP_DEPTH, windowWidth, windowHeight);
-	
-	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[SHADOW_FRAMEBUFFER]);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, textures[SHADOW_MAP_DEPTH], 0);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[SHADOW_MAP_COLOR], 0);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[TEMP_SHADOW_FRAMEBUFFER]);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, textures[TEMP_SHADOW_MAP_DEPTH], 0);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[TEMP_SHADOW_MAP_COLOR], 0);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[SAT_SHADOW_FRAMEBUFFER]);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, textures[SAT_SHADOW_MAP_DEPTH], 0);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[SAT_SHADOW_MAP_COLOR], 0);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[SOFT_SHADOW_FRAMEBUFFER]);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, textures[SOFT_SHADOW_MAP_DEPTH], 0);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[SOFT_SHADOW_MAP_COLOR], 0);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[HARD_SHADOW_FRAMEBUFFER]);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, textures[HARD_SHADOW_MAP_DEPTH], 0);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[HARD_SHADOW_MAP_COLOR], 0);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[GBUFFER_FRAMEBUFFER]);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, textures[GBUFFER_MAP_DEPTH], 0);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[VERTEX_MAP_COLOR], 0);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, textures[NORMAL_MAP_COLOR], 0);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, textures[TEXTURE_MAP_COLOR], 0);
-	GLenum bufs[3];
-	bufs[0] = GL_COLOR_ATTACHMENT0;
-	bufs[1] = GL_COLOR_ATTACHMENT1;
-	bufs[2] = GL_COLOR_ATTACHMENT2;
-	glDrawBuffers(3,bufs);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[PARTIAL_BLOCKER_SEARCH_MAP_FRAMEBUFFER]);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, textures[PARTIAL_BLOCKER_SEARCH_MAP_DEPTH], 0);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[PARTIAL_BLOCKER_SEARCH_MAP_COLOR], 0);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[QUAD_TREE_REPROJECTION_FRAMEBUFFER]);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, textures[QUAD_TREE_REPROJECTION_DEPTH], 0);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[QUAD_TREE_REPROJECTION_COLOR], 0);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, textures[TEMP_VISIBILITY_MAP_COLOR], 0);
-	glDrawBuffers(2,bufs);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-	
-	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[VISIBILITY_FRAMEBUFFER]);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, textures[VISIBILITY_MAP_DEPTH], 0);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[VISIBILITY_MAP_COLOR], 0);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-	
-	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer[CUDA_FRAMEBUFFER]);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, textures[CUDA_MAP_DEPTH], 0);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[CUDA_MAP_COLOR], 0);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, textures[CUDA_POSITION_MAP_COLOR], 0);
-	GLenum CUDABufferTemp[2];
-	CUDABufferTemp[0] = GL_COLOR_ATTACHMENT0;
-	CUDABufferTemp[1] = GL_COLOR_ATTACHMENT1;
-	glDrawBuffers(2, CUDABufferTemp);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+			myGLTextureViewer.loadRGBTexture(scene->getTexture()[num], sceneTextures, num);
+	glFinish();
+	printf("Textures uploaded in %f s\n", cpu_time() - uploadTime);
 
 	cudaGLSetGLDevice(0);
-	cudaGraphicsGLRegisterImage( &CUDAGraphicsResource[0], textures[CUDA_MAP_COLOR], GL_TEXTURE_2D, 0);
-	cudaGraphicsGLRegisterImage( &CUDAGraphicsResource[1], textures[CUDA_POSITION_MAP_COLOR], GL_TEXTURE_2D, 0);
-
-	pba2DInitialization(windowWidth, windowHeight);
+	renderTargetPool.setTextureViewer(&myGLTextureViewer);
+	allocateRenderTargets();
 	
 }
 
 void releaseGL() {
 
 	glDeleteTextures(2, textureArray);
-	glDeleteTextures(30, textures);
+	renderTargetPool.clear();
 	glDeleteFramebuffers(20, frameBuffer);
 	glDeleteBuffers(5, sceneVBO);
 	glDeleteTextures(4, sceneTextures);
 	glDeleteQueries(1, queryObject);
+	free(tileLevels);
+	free(activeTiles);
+	free(tileFlags);
+	shaderPermutationCache.clear();
 	
 }
 
@@ -1759,6 +4435,14 @@ int main(int argc, char **argv) {
 	glutSpecialFunc(specialKeyboard);
 
 	glewInit();
+	for(int arg = 2; arg < argc; arg++) {
+		if(strcmp(argv[arg], "-bc1") == 0)
+			compressTextures = true;
+		else if(strcmp(argv[arg], "-packed") == 0)
+			packedGBuffer = true;
+	}
+	if(packedGBuffer)
+		setShaderDefines("#define PACKED_GBUFFER\n");
 	initGL(argv[1]);
 
 	initShader("Shaders/Scene", SCENE_SHADER);
@@ -1774,21 +4458,44 @@ int main(int argc, char **argv) {
 	initShader("Shaders/Moments/Moments", MOMENT_SHADER);
 	initShader("Shaders/Moments/SATHorizontalPass", SAT_HORIZONTAL_PASS_SHADER);
 	initShader("Shaders/Moments/SATVerticalPass", SAT_VERTICAL_PASS_SHADER);
+	initShader("Shaders/Moments/IntegerSATHorizontalPass", INTEGER_SAT_HORIZONTAL_PASS_SHADER);
+	initShader("Shaders/Moments/IntegerSATVerticalPass", INTEGER_SAT_VERTICAL_PASS_SHADER);
+	initShader("Shaders/ScreenSpace/JumpFloodingInitialization", JUMP_FLOODING_INITIALIZATION_SHADER);
+	initShader("Shaders/ScreenSpace/JumpFlooding", JUMP_FLOODING_SHADER);
+	initShader("Shaders/ScreenSpace/JumpFloodingEDT", JUMP_FLOODING_EDT_SHADER);
 	initShader("Shaders/Moments/PrepareMinMax", PREPARE_MIN_MAX_SHADER);
 	initShader("Shaders/Moments/MinMax", MIN_MAX_SHADER);
 	initShader("Shaders/ScreenSpace/PartialAverageBlockerDepth", PARTIAL_BLOCKER_SEARCH_SHADER);
 	initShader("Shaders/ScreenSpace/PartialShadowFiltering", PARTIAL_SHADOW_FILTERING_SHADER);
 	initShader("Shaders/ScreenSpace/ScreenSpacePenumbraSizeEstimation", SCREEN_SPACE_PENUMBRA_SIZE_ESTIMATION_SHADER);
 	initShader("Shaders/ScreenSpace/ScreenSpaceSoftShadow", SCREEN_SPACE_SOFT_SHADOW_SHADER);
+	initShader("Shaders/ScreenSpace/GuidedFilterMoments", GUIDED_FILTER_MOMENTS_SHADER);
+	initShader("Shaders/ScreenSpace/GuidedFilterSAT", GUIDED_FILTER_SAT_SHADER);
+	initShader("Shaders/ScreenSpace/GuidedFilterCoefficients", GUIDED_FILTER_COEFFICIENTS_SHADER);
+	bindGuidedFilterOutputs(shaderProg[GUIDED_FILTER_MOMENTS_SHADER]);
+	bindGuidedFilterOutputs(shaderProg[GUIDED_FILTER_SAT_SHADER]);
+	bindGuidedFilterOutputs(shaderProg[GUIDED_FILTER_COEFFICIENTS_SHADER]);
+	initShader("Shaders/ScreenSpace/GuidedShadowFiltering", GUIDED_SHADOW_FILTERING_SHADER);
 	initShader("Shaders/ScreenSpace/MeanFilter", MEAN_FILTER_SHADER);
 	initShader("Shaders/ScreenSpace/EdgeFilter", EDGE_FILTER_SHADER);
 	initShader("Shaders/QuadTree/Reprojection", QUAD_TREE_REPROJECTION_SHADER);
 	initShader("Shaders/QuadTree/Evaluation", QUAD_TREE_EVALUATION_SHADER);
 	initShader("Shaders/QuadTree/RevectorizationBasedReprojection", REVECTORIZATION_BASED_QUAD_TREE_REPROJECTION_SHADER);
+	initShader("Shaders/QuadTree/TileClassification", TILE_CLASSIFICATION_SHADER);
 	initShader("Shaders/SoftShadow/PlausibleSoftShadow", PLAUSIBLE_SOFT_SHADOW_SHADER);
 	initShader("Shaders/SoftShadow/RBSSM", RBSSM_SHADER);
 	initShader("Shaders/SoftShadow/AccurateSoftShadow", ACCURATE_SOFT_SHADOW_SHADER);
 	initShader("Shaders/SoftShadow/RevectorizationBasedAccurateSoftShadow", REVECTORIZATION_BASED_ACCURATE_SOFT_SHADOW_SHADER);
+	initShader("Shaders/SoftShadow/ProgressiveSoftShadow", PROGRESSIVE_SOFT_SHADOW_SHADER);
+	initShader("Shaders/SoftShadow/StreamingSoftShadow", STREAMING_SOFT_SHADOW_SHADER);
+	initShader("Shaders/SoftShadow/TiledSoftShadow", TILED_SOFT_SHADOW_SHADER);
+	initShader("Shaders/SoftShadow/PenumbraClassification", PENUMBRA_CLASSIFICATION_SHADER);
+	initShader("Shaders/SoftShadow/JointBilateralUpsampling", JOINT_BILATERAL_UPSAMPLING_SHADER);
+	initShader("Shaders/SoftShadow/LightFrustumReduction", LIGHT_FRUSTUM_REDUCTION_SHADER);
+	initShader("Shaders/SoftShadow/CascadeDepthReduction", CASCADE_DEPTH_REDUCTION_SHADER);
+	initShader("Shaders/SoftShadow/CascadeBoundsReduction", CASCADE_BOUNDS_REDUCTION_SHADER);
+	if(GLEW_VERSION_4_3)
+		initComputeShader("Shaders/SoftShadow/ComputePCSS", COMPUTE_PCSS_SHADER);
 	glUseProgram(0); 
 
 	glutMainLoop();
@@ -1797,8 +4504,11 @@ int main(int argc, char **argv) {
 	delete sceneLoader;
 	delete lightSource;
 	delete uniformSampledLightSource;
+	delete streamingLightSource;
+	delete tiledLightSource;
 	delete quadTreeLightSource;
 	delete bilateralFilter;
+	delete distanceTransform;
 	pba2DDeinitialization();
 	releaseGL();
 	return 0;